@@ -66,6 +66,7 @@ typedef enum ctx_type {
  * the weight of a certain node as linked list. 
  * 
  * This will be used when picking the nodes to send the request to. A linked list of these structs desribe the result.
+ * All entries of such a list are allocated as one array, so the list is freed with the first entry.
  */
 typedef struct weight {
   in3_node_t*        node;   /**< the node definition including the url */
@@ -130,6 +131,9 @@ typedef struct in3_ctx {
   /** state of the verification */
   in3_ret_t verification_state;
 
+  /** the time in ms (see `current_ms()`) when the context times out, which is set based on the timeout of the client (0 = no timeout) */
+  uint64_t deadline;
+
 } in3_ctx_t;
 
 /**
@@ -278,6 +282,21 @@ in3_request_t* in3_create_request(
     in3_ctx_t* ctx /**< [in] the request context. */
 );
 
+/**
+ * checks the response for the url with the given index as soon as it was received.
+ * 
+ * Transports sending to multiple nodes in parallel should call this function whenever a response is complete.
+ * If the client is configured with `use_first_response` the response will be verified immediately. 
+ * 
+ * - IN3_OK : the response was verified and the context is finished, so all other pending requests should be cancelled.
+ *            The responses of cancelled requests should be left empty.
+ * - IN3_WAITING : keep on waiting for the other responses.
+ */
+in3_ret_t in3_req_check_response(
+    in3_request_t* req,  /**< [in] the request. */
+    int            index /**< [in] the index of the url (and response) which was received. */
+);
+
 /**
  * frees a previuosly allocated request.
  */
@@ -287,6 +306,16 @@ void request_free(
     bool             response_free /**< [in] if true the responses will freed also, but usually this is done when the ctx is freed. */
 );
 
+/**
+ * finds the context which needs to be handled next.
+ *
+ * If the context is waiting for required contexts, the last required context which is not finished yet will be returned.
+ * Otherwise it returns the context itself.
+ */
+in3_ctx_t* in3_ctx_last_waiting(
+    in3_ctx_t* ctx /**< [in] the request context. */
+);
+
 /**
  * frees all resources allocated during the request.
  * 
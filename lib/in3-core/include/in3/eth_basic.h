@@ -44,11 +44,35 @@
 
 /** entry-function to execute the verification context. */
 in3_ret_t in3_verify_eth_basic(in3_vctx_t* v);
+/** the prepared signature of a transaction, which can be recovered without access to the context. */
+typedef struct {
+  bytes32_t                hash;       /**< the hash of the unsigned transaction */
+  uint8_t                  sig[65];    /**< r, s and the recovery id of the signature */
+  bytes_t                  public_key; /**< the expected public key or data=NULL if not set */
+  uint8_t*                 from;       /**< the expected sender or NULL if not set */
+  struct in3_sender_cache* cache;      /**< the cache of recovered senders or NULL */
+  bool                     prepared;   /**< true if all values could be verified and the signature is ready to be recovered */
+  char*                    error;      /**< the error after recovering or NULL if the signature matches */
+} tx_signature_t;
+
 /**
  * verifies internal tx-values.
  */
 in3_ret_t eth_verify_tx_values(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw);
 
+/**
+ * verifies the tx-values except the signature and prepares the signature to be recovered.
+ */
+in3_ret_t eth_prepare_tx_signature(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw, tx_signature_t* sig);
+
+/**
+ * recovers the signature and compares it with the public key and the sender.
+ *
+ * If the signature was already recovered, the public key is taken from the cache of recovered senders.
+ * This function does not allocate any memory and may be called from any thread.
+ */
+void eth_recover_tx_signature(tx_signature_t* sig);
+
 /**
  * verifies a transaction.
  */
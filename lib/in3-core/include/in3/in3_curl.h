@@ -60,4 +60,55 @@ in3_ret_t send_curl(in3_request_t* req);
  */
 void in3_register_curl();
 
+/**
+ * statistics of the curl connection pool.
+ */
+typedef struct in3_curl_stats {
+  uint64_t requests;    /**< number of finished transfers */
+  uint64_t reused;      /**< number of transfers using an already open connection */
+  uint64_t connections; /**< number of newly opened connections */
+} in3_curl_stats_t;
+
+/**
+ * a transport function using the connection pool of the client.
+ * 
+ * Instead of creating a new multi handle for each request, the pool keeps the multi handle and the easy handles per host, 
+ * so connections (including TLS-sessions) will be reused and multiplexed with http2 if the node supports it.
+ * If the client has no pool, it will fall back to `send_curl`.
+ */
+in3_ret_t send_curl_pooled(in3_request_t* req);
+
+/**
+ * creates a connection pool in the client and sets `send_curl_pooled` as transport.
+ * 
+ * The pool will be freed when the client is freed.
+ * 
+ * ```c
+ * in3_t* c = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+ * in3_use_curl_pool(c);
+ * ```
+ */
+in3_ret_t in3_use_curl_pool(in3_t* c);
+
+/**
+ * sets up an async transport using the connection pool of the client, which can be used with the scheduler.
+ *
+ * All requests are sent with the same multi handle, so many contexts can be executed within one thread.
+ * If the client has no pool yet, it will be created.
+ *
+ * ```c
+ * in3_async_transport_t transport;
+ * in3_curl_async_transport(c, &transport);
+ * in3_scheduler_t* scheduler = in3_scheduler_new(&transport);
+ * ```
+ */
+in3_ret_t in3_curl_async_transport(in3_t* c, in3_async_transport_t* transport);
+
+/**
+ * reads the statistics of the connection pool of the client.
+ * 
+ * returns IN3_EFIND if the client does not use a pool.
+ */
+in3_ret_t in3_curl_pool_stats(in3_t* c, in3_curl_stats_t* stats);
+
 #endif // in3_curl_h__
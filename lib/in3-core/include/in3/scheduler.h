@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+// @PUBLIC_HEADER
+/** @file
+ * scheduler executing many contexts within one thread.
+ *
+ * Instead of blocking until the response of one context has been received (like `in3_send_ctx`),
+ * the scheduler collects the requests of all contexts and sends them with one async transport.
+ * Whenever a request is finished, the context it belongs to will be resumed.
+ *
+ * ```c
+ * in3_async_transport_t transport;
+ * in3_curl_async_transport(c, &transport);
+ *
+ * in3_scheduler_t* scheduler = in3_scheduler_new(&transport);
+ * for (int i = 0; i < len; i++) in3_scheduler_add(scheduler, ctxs[i]);
+ * in3_scheduler_run(scheduler);
+ * in3_scheduler_free(scheduler);
+ * ```
+ *
+ * Single calls can also be collected and sent as one batch request (if `batch_size` is set),
+ * which reduces the number of requests and the overhead of the proofs.
+ *
+ * ```c
+ * scheduler->batch_size   = 20;
+ * scheduler->batch_window = 10;
+ * for (int i = 0; i < len; i++) in3_scheduler_call(scheduler, c, "eth_getBalance", params[i], on_balance, accounts + i);
+ * in3_scheduler_run(scheduler);
+ * ```
+ * */
+
+#include "client.h"
+#include "context.h"
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/** function called as soon as a context is finished. */
+typedef void (*in3_sched_done)(in3_ctx_t* ctx, in3_ret_t result, void* data);
+
+/** 
+ * function called with the result of a call added with `in3_scheduler_call`. 
+ * 
+ * If the call failed, the result is NULL and the error contains the message.
+ * The result will be freed after this function returns.
+ */
+typedef void (*in3_sched_result)(d_token_t* result, char* error, void* data);
+
+/** a call added to a batch */
+typedef struct in3_sched_call {
+  in3_sched_result callback; /**< the function called with the result */
+  void*            data;     /**< custom data passed to the callback */
+} in3_sched_call_t;
+
+/** calls collected within the batch window, which will be sent as one batch request */
+typedef struct in3_sched_batch {
+  in3_t*                  client;    /**< the client used for all calls */
+  sb_t                    payload;   /**< the json-array of all calls */
+  in3_sched_call_t*       calls;     /**< the calls */
+  int                     len;       /**< number of calls */
+  uint64_t                send_time; /**< the time in ms when the batch will be sent even if it is not full */
+  struct in3_sched_batch* next;      /**< next batch in the linked list */
+} in3_sched_batch_t;
+
+/** a context executed by the scheduler */
+typedef struct in3_sched_entry {
+  in3_ctx_t*         ctx;     /**< the context */
+  in3_request_t*     request; /**< the request sent for the context, which is not finished yet (NULL if there is none) */
+  in3_sched_batch_t* batch;   /**< the batch the context was created for (NULL if the context was added with `in3_scheduler_add`) */
+} in3_sched_entry_t;
+
+/** the scheduler holding all contexts which are not finished yet */
+typedef struct in3_scheduler {
+  in3_async_transport_t transport;    /**< the transport used to send the requests */
+  in3_sched_entry_t*    entries;      /**< the contexts not finished yet */
+  int                   len;          /**< number of entries */
+  int                   size;         /**< number of entries allocated */
+  in3_sched_done        done;         /**< if set, this function will be called whenever a context is finished */
+  void*                 data;         /**< custom data passed to the done-function */
+  in3_sched_batch_t*    batches;      /**< the batches still collecting calls */
+  uint16_t              batch_size;   /**< max number of calls sent as one batch (0 = no batching) */
+  uint32_t              batch_window; /**< the time in ms a batch waits for more calls before it is sent */
+} in3_scheduler_t;
+
+/**
+ * creates a new scheduler using the given transport.
+ */
+in3_scheduler_t* in3_scheduler_new(
+    in3_async_transport_t* transport /**< [in] the async transport (will be copied) */
+);
+
+/**
+ * frees the scheduler.
+ *
+ * All pending requests will be cancelled, but the contexts will not be freed.
+ * Calls which are not finished yet, will be reported as error.
+ */
+void in3_scheduler_free(
+    in3_scheduler_t* scheduler /**< [in] the scheduler */
+);
+
+/**
+ * adds a context to the scheduler.
+ *
+ * The context will be executed with the next call of `in3_scheduler_execute` and must not be freed before it is finished.
+ */
+in3_ret_t in3_scheduler_add(
+    in3_scheduler_t* scheduler, /**< [in] the scheduler */
+    in3_ctx_t*       ctx        /**< [in] the context */
+);
+
+/**
+ * adds a rpc-call, which will be executed with the other calls added within the batch window.
+ *
+ * The calls of the same client are collected and sent as one batch request as soon as
+ * `batch_size` calls are added, the `batch_window` is over or there is no other request pending.
+ * The results are verified and passed to the callback.
+ */
+in3_ret_t in3_scheduler_call(
+    in3_scheduler_t* scheduler, /**< [in] the scheduler */
+    in3_t*           c,         /**< [in] the client */
+    const char*      method,    /**< [in] the rpc method */
+    const char*      params,    /**< [in] the params as json-array (or NULL for no params) */
+    in3_sched_result callback,  /**< [in] the function called with the result */
+    void*            data       /**< [in] custom data passed to the callback */
+);
+
+/**
+ * executes all contexts which are not waiting for a response and waits for the responses.
+ *
+ * This function blocks max timeout ms (or until the next deadline of a context) and resumes all contexts whose requests are finished.
+ * It returns the number of contexts (and batches) which are not finished yet, so it should be called until it returns 0.
+ */
+int in3_scheduler_execute(
+    in3_scheduler_t* scheduler, /**< [in] the scheduler */
+    uint32_t         timeout    /**< [in] max time to wait for a response in ms */
+);
+
+/**
+ * executes all contexts until they are finished.
+ */
+void in3_scheduler_run(
+    in3_scheduler_t* scheduler /**< [in] the scheduler */
+);
+
+#endif
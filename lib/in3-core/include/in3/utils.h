@@ -109,6 +109,9 @@ bytes_t* sha3(const bytes_t* data);
 /** writes 32 bytes to the pointer. */
 int sha3_to(bytes_t* data, void* dst);
 
+/** hashes len independent buffers at once and writes 32 bytes for each of them to dst. */
+void sha3_multi(bytes_t** data, int len, uint8_t* dst);
+
 /** converts a long to 8 bytes */
 void long_to_bytes(uint64_t val, uint8_t* dst);
 
@@ -142,6 +145,11 @@ char* str_replace_pos(const char* orig, size_t pos, size_t len, const char* rep)
   */
 char* str_find(const char* haystack, const char* needle);
 
+/**
+ * current timestamp in milliseconds, used to measure response times and timeouts.
+ */
+uint64_t current_ms();
+
 /** changes to pointer (a) and it length (l) to remove leading 0 bytes.*/
 #define optimize_len(a, l)   \
   while (l > 1 && *a == 0) { \
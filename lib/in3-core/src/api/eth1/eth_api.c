@@ -223,7 +223,7 @@ static uint32_t write_tx(d_token_t* t, eth_tx_t* tx) {
   tx->nonce             = d_get_longk(t, K_NONCE);
   tx->data              = bytes((uint8_t*) tx + sizeof(eth_tx_t), b.len);
   tx->transaction_index = d_get_intk(t, K_TRANSACTION_INDEX);
-  memcpy(tx + sizeof(eth_tx_t), b.data, b.len); // copy the data right after the tx-struct.
+  memcpy(tx->data.data, b.data, b.len); // copy the data right after the tx-struct.
   copy_fixed(tx->block_hash, 32, d_to_bytes(d_getl(t, K_BLOCK_HASH, 32)));
   copy_fixed(tx->from, 20, d_to_bytes(d_getl(t, K_FROM, 20)));
   copy_fixed(tx->to, 20, d_to_bytes(d_getl(t, K_TO, 20)));
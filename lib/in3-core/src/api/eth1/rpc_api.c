@@ -46,7 +46,7 @@
 #include <string.h>
 #define RESPONSE_START()                                                             \
   do {                                                                               \
-    *response = _malloc(sizeof(in3_response_t));                                     \
+    *response = _calloc(1, sizeof(in3_response_t));                                  \
     sb_init(&response[0]->result);                                                   \
     sb_init(&response[0]->error);                                                    \
     sb_add_chars(&response[0]->result, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":"); \
@@ -150,8 +150,25 @@ static in3_ret_t in3_cacheClear(in3_ctx_t* ctx, in3_response_t** response) {
   return IN3_OK;
 }
 
+static bool is_intern_method(char* method) {
+  return method && (strcmp(method, "in3_abiEncode") == 0 ||
+                    strcmp(method, "in3_abiDecode") == 0 ||
+                    strcmp(method, "in3_checksumAddress") == 0 ||
+                    strcmp(method, "web3_sha3") == 0 ||
+                    strcmp(method, "in3_config") == 0 ||
+                    strcmp(method, "in3_cacheClear") == 0);
+}
+
 static in3_ret_t eth_handle_intern(in3_ctx_t* ctx, in3_response_t** response) {
-  if (ctx->len > 1) return IN3_ENOTSUP; // internal handling is only possible for single requests (at least for now)
+  if (ctx->len > 1) {
+    // internal handling is only possible for single requests (at least for now), and since verify() accepts
+    // any result for these methods, a batch containing them must never be sent to the nodes.
+    for (int i = 0; i < ctx->len; i++) {
+      if (is_intern_method(d_get_stringk(ctx->requests[i], K_METHOD)))
+        return ctx_set_error(ctx, "internal methods can not be used in a batch", IN3_ENOTSUP);
+    }
+    return parent_handle ? parent_handle(ctx, response) : IN3_OK;
+  }
   d_token_t* r      = ctx->requests[0];
   char*      method = d_get_stringk(r, K_METHOD);
   d_token_t* params = d_get(r, K_PARAMS);
@@ -170,13 +187,9 @@ static int verify(in3_vctx_t* v) {
   char* method = d_get_stringk(v->request, K_METHOD);
   if (!method) return vc_err(v, "no method in the request!");
 
-  if (strcmp(method, "in3_abiEncode") == 0 ||
-      strcmp(method, "in3_abiDecode") == 0 ||
-      strcmp(method, "in3_checksumAddress") == 0 ||
-      strcmp(method, "web3_sha3") == 0 ||
-      strcmp(method, "in3_config") == 0 ||
-      strcmp(method, "in3_cacheClear") == 0)
-    return IN3_OK;
+  // the results of internal methods are created by the client itself, which is only done for single requests.
+  if (is_intern_method(method))
+    return v->ctx->len == 1 ? IN3_OK : vc_err(v, "internal methods can not be verified in a batch");
 
   return parent_verify ? parent_verify(v) : IN3_ENOTSUP;
 }
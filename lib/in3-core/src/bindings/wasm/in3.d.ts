@@ -87,6 +87,11 @@ export declare interface IN3Config {
      * example: 100
      */
     maxBlockCache?: number
+    /**
+     * number of verified responses cached in memory. Immutable results are kept until evicted, all others only for cacheTimeout seconds.
+     * example: 100
+     */
+    maxResponseCache?: number
     /**
      * if the client sends a array of blockhashes the server will not deliver any signatures or blockheaders for these blocks, but only return a string with a number. This is automaticly updated by the cache, but can be overriden per request.
      */
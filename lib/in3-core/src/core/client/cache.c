@@ -37,6 +37,7 @@
 #include "../util/mem.h"
 #include "../util/utils.h"
 #include "context.h"
+#include "keys.h"
 #include "nodelist.h"
 #include "stdio.h"
 #include <inttypes.h>
@@ -44,9 +45,15 @@
 
 #define NODE_LIST_KEY "nodelist_%d"
 #define WHITTE_LIST_KEY "_0x%s"
-#define CACHE_VERSION 4
+#define CACHE_VERSION 6
 #define MAX_KEYLEN 200
 
+#ifndef RESPONSE_CACHE_FINALITY
+#define RESPONSE_CACHE_FINALITY 12 // number of blocks on top of a block before the responses referring to it are kept without timeout
+#endif
+#define RESPONSE_CACHE_MIN_BUCKETS 16
+#define BLOCK_CACHE_MIN_BUCKETS 16
+
 static void write_cache_key(char* key, chain_id_t chain_id, const address_t contract) {
   if (contract && contract) {
     char contract_[41];
@@ -208,3 +215,555 @@ in3_ret_t in3_cache_store_whitelist(in3_ctx_t* ctx, in3_chain_t* chain) {
   bb_free(bb);
   return IN3_OK;
 }
+
+typedef enum {
+  RC_IMMUTABLE, // the result can never change
+  RC_TX,        // the result will not change once the block of the transaction is final
+  RC_BLOCK,     // the result will not change if the block in the params is final
+  RC_TIMEOUT    // the result may change with every block
+} response_cache_type_t;
+
+typedef struct {
+  const char*           method;
+  response_cache_type_t type;
+  int                   block_param; // the index of the blocknumber in the params for RC_BLOCK
+} cacheable_method_t;
+
+static const cacheable_method_t cacheable_methods[] = {
+    {"eth_getBlockByHash", RC_IMMUTABLE, 0},
+    {"eth_getBlockTransactionCountByHash", RC_IMMUTABLE, 0},
+    {"eth_getUncleCountByBlockHash", RC_IMMUTABLE, 0},
+    {"eth_getTransactionByBlockHashAndIndex", RC_IMMUTABLE, 0},
+    {"eth_getUncleByBlockHashAndIndex", RC_IMMUTABLE, 0},
+    {"net_version", RC_IMMUTABLE, 0},
+    {"eth_getTransactionByHash", RC_TX, 0},
+    {"eth_getTransactionReceipt", RC_TX, 0},
+    {"eth_getBlockByNumber", RC_BLOCK, 0},
+    {"eth_getBlockTransactionCountByNumber", RC_BLOCK, 0},
+    {"eth_getUncleCountByBlockNumber", RC_BLOCK, 0},
+    {"eth_getTransactionByBlockNumberAndIndex", RC_BLOCK, 0},
+    {"eth_getUncleByBlockNumberAndIndex", RC_BLOCK, 0},
+    {"eth_getBalance", RC_BLOCK, 1},
+    {"eth_getCode", RC_BLOCK, 1},
+    {"eth_getTransactionCount", RC_BLOCK, 1},
+    {"eth_call", RC_BLOCK, 1},
+    {"eth_getStorageAt", RC_BLOCK, 2},
+    {"eth_blockNumber", RC_TIMEOUT, 0},
+    {"eth_gasPrice", RC_TIMEOUT, 0},
+    {"eth_estimateGas", RC_TIMEOUT, 0},
+    {"eth_getLogs", RC_TIMEOUT, 0}};
+
+static const cacheable_method_t* find_cacheable(const char* method) {
+  if (!method) return NULL;
+  for (size_t i = 0; i < sizeof(cacheable_methods) / sizeof(cacheable_method_t); i++) {
+    if (strcmp(cacheable_methods[i].method, method) == 0) return cacheable_methods + i;
+  }
+  return NULL;
+}
+
+static bool use_response_cache(in3_t* c) {
+  // responses with proofs or in binary format can not be served from the cache.
+  // without proof nothing was verified, so we would keep serving whatever a node sent.
+  return c->max_response_cache && !c->keep_in3 && !c->use_binary && c->proof != PROOF_NONE;
+}
+
+static uint32_t response_hash(const char* key) {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  for (; *key; key++) h = (h ^ (uint8_t) *key) * 16777619u;
+  return h;
+}
+
+static char* response_key(in3_t* c, d_token_t* request) {
+  // a response verified with a lower proof-level, less signatures or a lower finality must not be served to a request requiring more.
+  char tmp[64];
+  sprintf(tmp, "%u:%u:%u:%u:", (uint32_t) c->chain_id, (uint32_t) c->proof, (uint32_t) c->signature_count, (uint32_t) c->finality);
+  sb_t* sb = sb_new(tmp);
+  sb_add_chars(sb, d_get_stringk(request, K_METHOD));
+  // every param is serialized on its own, so the same values will result in the same key, no matter how they were formatted.
+  for (d_iterator_t it = d_iter(d_get(request, K_PARAMS)); it.left; d_iter_next(&it)) {
+    char* p = d_create_json(it.token);
+    sb_add_char(sb, ',');
+    sb_add_chars(sb, p);
+    _free(p);
+  }
+  char* key = sb->data;
+  _free(sb);
+  return key;
+}
+
+static in3_response_cache_t* response_cache(in3_t* c) {
+  if (c->response_cache) return c->response_cache;
+  in3_response_cache_t* cache = _calloc(1, sizeof(in3_response_cache_t));
+  cache->buckets_len          = RESPONSE_CACHE_MIN_BUCKETS;
+  while (cache->buckets_len < c->max_response_cache) cache->buckets_len <<= 1;
+  cache->buckets    = _calloc(cache->buckets_len, sizeof(in3_response_cache_entry_t*));
+  c->response_cache = cache;
+  return cache;
+}
+
+static void unlink_entry(in3_response_cache_t* cache, in3_response_cache_entry_t* e) {
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    cache->head = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+  else
+    cache->tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+static void push_entry(in3_response_cache_t* cache, in3_response_cache_entry_t* e) {
+  e->next = cache->head;
+  if (cache->head) cache->head->prev = e;
+  cache->head = e;
+  if (!cache->tail) cache->tail = e;
+}
+
+static void remove_entry(in3_response_cache_t* cache, in3_response_cache_entry_t* e) {
+  in3_response_cache_entry_t** p = cache->buckets + (e->hash & (cache->buckets_len - 1));
+  while (*p != e) p = &(*p)->bucket_next;
+  *p = e->bucket_next;
+  unlink_entry(cache, e);
+  cache->stats.entries--;
+  _free(e->key);
+  _free(e->result);
+  _free(e);
+}
+
+static in3_response_cache_entry_t* find_entry(in3_response_cache_t* cache, const char* key, uint32_t hash) {
+  for (in3_response_cache_entry_t* e = cache->buckets[hash & (cache->buckets_len - 1)]; e; e = e->bucket_next) {
+    if (e->hash != hash || strcmp(e->key, key)) continue;
+    if (e->expires && e->expires <= (uint64_t) _time()) {
+      remove_entry(cache, e);
+      return NULL;
+    }
+    // mark it as recently used
+    unlink_entry(cache, e);
+    push_entry(cache, e);
+    return e;
+  }
+  return NULL;
+}
+
+static bool is_final(d_token_t* block, uint64_t current_block) {
+  if (!block || (d_type(block) != T_INTEGER && d_type(block) != T_BYTES)) return false;
+  uint64_t n = d_long(block);
+  return n && current_block && n + RESPONSE_CACHE_FINALITY <= current_block;
+}
+
+in3_ret_t in3_cache_get_response(in3_ctx_t* ctx) {
+  in3_t* c = ctx->client;
+  if (!use_response_cache(c)) return IN3_EFIND;
+  in3_response_cache_t*        cache     = response_cache(c);
+  in3_response_cache_entry_t** entries   = _malloc(sizeof(in3_response_cache_entry_t*) * ctx->len);
+  int                          cacheable = 0, found = 0;
+
+  for (int i = 0; i < ctx->len; i++) {
+    entries[i] = NULL;
+    if (!find_cacheable(d_get_stringk(ctx->requests[i], K_METHOD))) continue;
+    char* key = response_key(c, ctx->requests[i]);
+    cacheable++;
+    if ((entries[i] = find_entry(cache, key, response_hash(key)))) found++;
+    _free(key);
+  }
+
+  // we can only skip sending, if all requests are found, but only the requests not found are counted as misses.
+  if (!cacheable || found < ctx->len) {
+    cache->stats.misses += cacheable - found;
+    _free(entries);
+    return IN3_EFIND;
+  }
+
+  cache->stats.hits += found;
+  in3_response_t* r = _calloc(1, sizeof(in3_response_t));
+  sb_init(&r->result);
+  sb_init(&r->error);
+  if (ctx->len > 1) sb_add_char(&r->result, '[');
+  for (int i = 0; i < ctx->len; i++) {
+    char* id = d_create_json(d_get(ctx->requests[i], K_ID));
+    if (i) sb_add_char(&r->result, ',');
+    sb_add_chars(&r->result, "{\"id\":");
+    sb_add_chars(&r->result, id ? id : "null");
+    sb_add_chars(&r->result, ",\"jsonrpc\":\"2.0\",\"result\":");
+    sb_add_chars(&r->result, entries[i]->result);
+    sb_add_char(&r->result, '}');
+    _free(id);
+  }
+  if (ctx->len > 1) sb_add_char(&r->result, ']');
+  ctx->raw_response = r;
+  _free(entries);
+  return IN3_OK;
+}
+
+void in3_cache_add_response(in3_ctx_t* ctx) {
+  in3_t* c = ctx->client;
+  if (!use_response_cache(c) || !ctx->responses) return;
+  in3_response_cache_t* cache = response_cache(c);
+
+  for (int i = 0; i < ctx->len; i++) {
+    d_token_t*                request = ctx->requests[i];
+    d_token_t*                result  = d_get(ctx->responses[i], K_RESULT);
+    const cacheable_method_t* m       = find_cacheable(d_get_stringk(request, K_METHOD));
+
+    // errors or null (like a pending transaction) are not cached.
+    if (!m || !result || d_type(result) == T_NULL || d_get(ctx->responses[i], K_ERROR)) continue;
+
+    // only results which were verified with a proof are cached.
+    d_token_t* in3 = d_get(ctx->responses[i], K_IN3);
+    if (!d_get(in3, K_PROOF)) continue;
+
+    uint64_t current_block = d_get_longk(in3, K_CURRENT_BLOCK);
+    bool     immutable     = m->type == RC_IMMUTABLE;
+    if (m->type == RC_TX) immutable = is_final(d_get(result, K_BLOCK_NUMBER), current_block);
+    if (m->type == RC_BLOCK) immutable = is_final(d_get_at(d_get(request, K_PARAMS), m->block_param), current_block);
+    if (!immutable && !c->cache_timeout) continue;
+
+    char*                       key  = response_key(c, request);
+    uint32_t                    hash = response_hash(key);
+    in3_response_cache_entry_t* e    = find_entry(cache, key, hash);
+    if (e) remove_entry(cache, e);
+    while (cache->tail && cache->stats.entries >= c->max_response_cache) remove_entry(cache, cache->tail);
+
+    e              = _calloc(1, sizeof(in3_response_cache_entry_t));
+    e->key         = key;
+    e->hash        = hash;
+    e->result      = d_create_json(result);
+    e->expires     = immutable ? 0 : (uint64_t) _time() + c->cache_timeout;
+    e->bucket_next = cache->buckets[hash & (cache->buckets_len - 1)];
+    cache->buckets[hash & (cache->buckets_len - 1)] = e;
+    push_entry(cache, e);
+    cache->stats.entries++;
+  }
+}
+
+void in3_cache_free_responses(in3_t* c) {
+  in3_response_cache_t* cache = c->response_cache;
+  if (!cache) return;
+  while (cache->head) remove_entry(cache, cache->head);
+  _free(cache->buckets);
+  _free(cache);
+  c->response_cache = NULL;
+}
+
+in3_ret_t in3_client_response_cache_stats(in3_t* c, in3_response_cache_stats_t* stats) {
+  if (!c || !stats) return IN3_EINVAL;
+  if (c->response_cache)
+    *stats = c->response_cache->stats;
+  else
+    memset(stats, 0, sizeof(in3_response_cache_stats_t));
+  return IN3_OK;
+}
+
+static in3_block_cache_t* block_cache(in3_t* c, in3_chain_t* chain) {
+  if (chain->block_cache) return chain->block_cache;
+  in3_block_cache_t* cache = _calloc(1, sizeof(in3_block_cache_t));
+  cache->buckets_len       = BLOCK_CACHE_MIN_BUCKETS;
+  while (cache->buckets_len < c->max_block_cache) cache->buckets_len <<= 1;
+  cache->by_hash     = _calloc(cache->buckets_len, sizeof(in3_block_cache_entry_t*));
+  cache->by_number   = _calloc(cache->buckets_len, sizeof(in3_block_cache_entry_t*));
+  chain->block_cache = cache;
+  return cache;
+}
+
+static inline in3_block_cache_entry_t** hash_bucket(in3_block_cache_t* cache, uint8_t* hash) {
+  return cache->by_hash + (bytes_to_int(hash, 4) & (cache->buckets_len - 1));
+}
+
+static inline in3_block_cache_entry_t** number_bucket(in3_block_cache_t* cache, uint64_t number) {
+  return cache->by_number + (number & (cache->buckets_len - 1));
+}
+
+static void unlink_header(in3_block_cache_t* cache, in3_block_cache_entry_t* e) {
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    cache->head = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+  else
+    cache->tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+static void push_header(in3_block_cache_t* cache, in3_block_cache_entry_t* e) {
+  e->next = cache->head;
+  if (cache->head) cache->head->prev = e;
+  cache->head = e;
+  if (!cache->tail) cache->tail = e;
+}
+
+static void remove_header(in3_block_cache_t* cache, in3_block_cache_entry_t* e) {
+  in3_block_cache_entry_t** p = hash_bucket(cache, e->hash);
+  while (*p != e) p = &(*p)->hash_next;
+  *p = e->hash_next;
+  p  = number_bucket(cache, e->number);
+  while (*p != e) p = &(*p)->number_next;
+  *p = e->number_next;
+  unlink_header(cache, e);
+  cache->len--;
+  _free(e->header.data);
+  _free(e);
+}
+
+// finds the header by hash if passed, otherwise by number. Without a header, the most recently added one with this number is returned.
+static in3_block_cache_entry_t* find_header(in3_block_cache_t* cache, bytes_t* header, uint64_t number, uint8_t* hash) {
+  in3_block_cache_entry_t* e = NULL;
+  if (hash) {
+    for (e = *hash_bucket(cache, hash); e; e = e->hash_next) {
+      if (e->number == number && memcmp(e->hash, hash, 32) == 0 && (!header || b_cmp(&e->header, header))) break;
+    }
+  } else {
+    for (e = *number_bucket(cache, number); e; e = e->number_next) {
+      if (e->number == number && (!header || b_cmp(&e->header, header))) break;
+    }
+  }
+
+  // mark it as recently used
+  if (e) {
+    unlink_header(cache, e);
+    push_header(cache, e);
+  }
+  return e;
+}
+
+bool in3_cache_is_verified_header(in3_t* c, in3_chain_t* chain, bytes_t* header, uint64_t number, bytes_t* hash, uint16_t signatures, uint16_t finality) {
+  in3_block_cache_t* cache = chain ? chain->block_cache : NULL;
+  if (!c->max_block_cache || !cache || !header || (hash && hash->len != 32)) return false;
+  in3_block_cache_entry_t* e = find_header(cache, header, number, hash ? hash->data : NULL);
+  return e && e->signatures >= signatures && e->finality >= finality;
+}
+
+void in3_cache_add_header(in3_t* c, in3_chain_t* chain, bytes_t* header, uint64_t number, bytes32_t hash, uint16_t signatures, uint16_t finality) {
+  if (!c->max_block_cache || !chain) return;
+  in3_block_cache_t*       cache = block_cache(c, chain);
+  in3_block_cache_entry_t* e     = find_header(cache, header, number, hash);
+  if (e) {
+    // keep the strongest verification
+    if (e->signatures < signatures) e->signatures = signatures;
+    if (e->finality < finality) e->finality = finality;
+    return;
+  }
+
+  // remove the least recently used headers
+  while (cache->tail && cache->len >= c->max_block_cache) remove_header(cache, cache->tail);
+
+  e             = _calloc(1, sizeof(in3_block_cache_entry_t));
+  e->header     = bytes(_malloc(header->len), header->len);
+  e->number     = number;
+  e->signatures = signatures;
+  e->finality   = finality;
+  memcpy(e->header.data, header->data, header->len);
+  memcpy(e->hash, hash, 32);
+
+  in3_block_cache_entry_t** hb = hash_bucket(cache, e->hash);
+  in3_block_cache_entry_t** nb = number_bucket(cache, number);
+  e->hash_next                 = *hb;
+  e->number_next               = *nb;
+  *hb                          = e;
+  *nb                          = e;
+  push_header(cache, e);
+  cache->len++;
+}
+
+bytes_t* in3_cache_get_header(in3_t* c, in3_chain_t* chain, uint64_t number, bytes_t* hash) {
+  in3_block_cache_t* cache = chain ? chain->block_cache : NULL;
+  if (!c->max_block_cache || !cache || (hash && hash->len != 32)) return NULL;
+  in3_block_cache_entry_t* e = find_header(cache, NULL, number, hash ? hash->data : NULL);
+  return e ? &e->header : NULL;
+}
+
+uint16_t in3_cache_verified_hashes(in3_t* c, in3_chain_t* chain, uint16_t signatures, uint16_t finality, bytes_t** dst) {
+  in3_block_cache_t* cache = chain ? chain->block_cache : NULL;
+  uint16_t           len   = 0;
+  *dst                     = NULL;
+  if (!c->max_block_cache || !cache || !cache->len) return 0;
+
+  // the hashes are stored right behind the bytes_t-structs, so they stay valid even if the cache changes.
+  bytes_t* hashes = _malloc(cache->len * (sizeof(bytes_t) + 32));
+  uint8_t* data   = (uint8_t*) (hashes + cache->len);
+  for (in3_block_cache_entry_t* e = cache->tail; e && len < 0xFFFF; e = e->prev) {
+    if (e->signatures < signatures || e->finality < finality) continue;
+    hashes[len] = bytes(data + len * 32, 32);
+    memcpy(hashes[len++].data, e->hash, 32);
+  }
+
+  if (len)
+    *dst = hashes;
+  else
+    _free(hashes);
+  return len;
+}
+
+void in3_cache_free_headers(in3_chain_t* chain) {
+  in3_block_cache_t* cache = chain->block_cache;
+  if (!cache) return;
+  while (cache->head) remove_header(cache, cache->head);
+  _free(cache->by_hash);
+  _free(cache->by_number);
+  _free(cache);
+  chain->block_cache = NULL;
+}
+
+static void unlink_code(in3_code_cache_t* cache, in3_code_cache_entry_t* e) {
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    cache->head = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+  else
+    cache->tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+static void push_code(in3_code_cache_t* cache, in3_code_cache_entry_t* e) {
+  e->next = cache->head;
+  if (cache->head) cache->head->prev = e;
+  cache->head = e;
+  if (!cache->tail) cache->tail = e;
+}
+
+static void evict_code(in3_code_cache_t* cache, in3_code_cache_entry_t* e) {
+  unlink_code(cache, e);
+  cache->size -= e->code.len;
+  // code still used by a context will be freed when it is released
+  if (e->refs)
+    e->evicted = true;
+  else
+    _free(e);
+}
+
+static void release_code(cache_entry_t* entry) {
+  // the code is allocated right behind the entry
+  in3_code_cache_entry_t* e = ((in3_code_cache_entry_t*) entry->value.data) - 1;
+  if (!--e->refs && e->evicted) _free(e);
+}
+
+in3_code_cache_entry_t* in3_cache_get_code(in3_t* c, const bytes32_t hash) {
+  in3_code_cache_t* cache = c->code_cache;
+  if (!c->max_code_cache || !cache) return NULL;
+  for (in3_code_cache_entry_t* e = cache->head; e; e = e->next) {
+    if (memcmp(e->hash, hash, 32)) continue;
+    unlink_code(cache, e);
+    push_code(cache, e);
+    return e;
+  }
+  return NULL;
+}
+
+in3_code_cache_entry_t* in3_cache_add_code(in3_t* c, const bytes32_t hash, bytes_t code) {
+  if (!c->max_code_cache || code.len > c->max_code_cache) return NULL;
+  if (!c->code_cache) c->code_cache = _calloc(1, sizeof(in3_code_cache_t));
+  in3_code_cache_t*       cache = c->code_cache;
+  in3_code_cache_entry_t* e     = in3_cache_get_code(c, hash);
+  if (e) return e;
+
+  while (cache->tail && cache->size + code.len > c->max_code_cache) evict_code(cache, cache->tail);
+
+  // the entry, the code and the bitmap of jumpdests are allocated as one block
+  uint32_t bitmap_len = (code.len + 7) / 8;
+  e                   = _malloc(sizeof(in3_code_cache_entry_t) + code.len + bitmap_len);
+  e->code             = bytes((uint8_t*) (e + 1), code.len);
+  e->jumpdests        = e->code.data + code.len;
+  e->refs             = 0;
+  e->evicted          = false;
+  e->prev = e->next = NULL;
+  memcpy(e->hash, hash, 32);
+  memcpy(e->code.data, code.data, code.len);
+  memset(e->jumpdests, 0, bitmap_len);
+  push_code(cache, e);
+  cache->size += code.len;
+  return e;
+}
+
+cache_entry_t* in3_cache_use_code(cache_entry_t** cache, bytes_t key, in3_code_cache_entry_t* entry) {
+  cache_entry_t* en = in3_cache_add_entry(cache, key, entry->code);
+  en->must_free     = false;
+  en->release       = release_code;
+  entry->refs++;
+  return en;
+}
+
+uint8_t* in3_cache_code_jumpdests(cache_entry_t* entry) {
+  return entry->release == release_code ? (((in3_code_cache_entry_t*) entry->value.data) - 1)->jumpdests : NULL;
+}
+
+void in3_cache_free_code(in3_t* c) {
+  in3_code_cache_t* cache = c->code_cache;
+  if (!cache) return;
+  while (cache->head) evict_code(cache, cache->head);
+  _free(cache);
+  c->code_cache = NULL;
+}
+
+#ifdef MULTITHREADING
+#define LOCK_SENDERS(cache) pthread_mutex_lock(&(cache)->lock)
+#define UNLOCK_SENDERS(cache) pthread_mutex_unlock(&(cache)->lock)
+#else
+#define LOCK_SENDERS(cache)
+#define UNLOCK_SENDERS(cache)
+#endif
+
+static in3_sender_cache_entry_t* sender_slot(in3_sender_cache_t* cache, const bytes32_t hash) {
+  // the hash is a keccak-hash, so its first bytes are good enough to pick the slot.
+  return cache->entries + bytes_to_int(hash, 4) % cache->len;
+}
+
+in3_sender_cache_t* in3_cache_senders(in3_t* c) {
+  if (c->sender_cache && c->sender_cache->len != c->max_sender_cache) in3_cache_free_senders(c);
+  if (c->sender_cache || !c->max_sender_cache) return c->sender_cache;
+  in3_sender_cache_t* cache = _calloc(1, sizeof(in3_sender_cache_t));
+  cache->entries            = _calloc(c->max_sender_cache, sizeof(in3_sender_cache_entry_t));
+  cache->len                = c->max_sender_cache;
+#ifdef MULTITHREADING
+  pthread_mutex_init(&cache->lock, NULL);
+#endif
+  c->sender_cache = cache;
+  return cache;
+}
+
+bool in3_cache_get_sender(in3_sender_cache_t* cache, const bytes32_t hash, const uint8_t* sig, uint8_t* public_key) {
+  in3_sender_cache_entry_t* e = sender_slot(cache, hash);
+  LOCK_SENDERS(cache);
+  bool found = e->used && !memcmp(e->hash, hash, 32) && !memcmp(e->sig, sig, 65);
+  if (found) {
+    memcpy(public_key, e->public_key, 64);
+    cache->stats.hits++;
+  } else
+    cache->stats.misses++;
+  UNLOCK_SENDERS(cache);
+  return found;
+}
+
+void in3_cache_add_sender(in3_sender_cache_t* cache, const bytes32_t hash, const uint8_t* sig, const uint8_t* public_key) {
+  in3_sender_cache_entry_t* e = sender_slot(cache, hash);
+  LOCK_SENDERS(cache);
+  if (!e->used) cache->stats.entries++;
+  memcpy(e->hash, hash, 32);
+  memcpy(e->sig, sig, 65);
+  memcpy(e->public_key, public_key, 64);
+  e->used = true;
+  UNLOCK_SENDERS(cache);
+}
+
+void in3_cache_free_senders(in3_t* c) {
+  in3_sender_cache_t* cache = c->sender_cache;
+  if (!cache) return;
+#ifdef MULTITHREADING
+  pthread_mutex_destroy(&cache->lock);
+#endif
+  _free(cache->entries);
+  _free(cache);
+  c->sender_cache = NULL;
+}
+
+in3_ret_t in3_client_sender_cache_stats(in3_t* c, in3_sender_cache_stats_t* stats) {
+  if (!c || !stats) return IN3_EINVAL;
+  if (c->sender_cache)
+    *stats = c->sender_cache->stats;
+  else
+    memset(stats, 0, sizeof(in3_sender_cache_stats_t));
+  return IN3_OK;
+}
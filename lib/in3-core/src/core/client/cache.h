@@ -42,6 +42,9 @@
 #include "../util/bytes.h"
 #include "client.h"
 #include "context.h"
+#ifdef MULTITHREADING
+#include <pthread.h>
+#endif
 
 #ifndef CACHE_H
 #define CACHE_H
@@ -88,4 +91,250 @@ in3_ret_t in3_cache_store_whitelist(
     in3_ctx_t*   ctx, /**< the current incubed context */
     in3_chain_t* chain /**< the chain upating to cache */);
 
+/** a verified response kept in memory. */
+typedef struct in3_response_cache_entry {
+  char*                            key;         /**< the chain, method and params of the request */
+  char*                            result;      /**< the verified result as json */
+  uint32_t                         hash;        /**< the hash of the key */
+  uint64_t                         expires;     /**< the time in seconds when the entry expires (0 = never) */
+  struct in3_response_cache_entry* prev;        /**< the entry used more recently */
+  struct in3_response_cache_entry* next;        /**< the entry used less recently */
+  struct in3_response_cache_entry* bucket_next; /**< the next entry within the same bucket */
+} in3_response_cache_entry_t;
+
+/** the least recently used cache of verified responses. */
+typedef struct in3_response_cache {
+  in3_response_cache_entry_t** buckets;     /**< the entries hashed by their key */
+  uint32_t                     buckets_len; /**< the number of buckets (a power of 2) */
+  in3_response_cache_entry_t*  head;        /**< the most recently used entry */
+  in3_response_cache_entry_t*  tail;        /**< the least recently used entry, which will be removed first */
+  in3_response_cache_stats_t   stats;       /**< the counters */
+} in3_response_cache_t;
+
+/**
+ * serves the requests of the context from the cache of verified responses.
+ * 
+ * Only if all requests are found, the raw_response of the context will be set and IN3_OK returned.
+ * Immutable results are kept until they are evicted, all other results only for `cache_timeout` seconds.
+ */
+in3_ret_t in3_cache_get_response(
+    in3_ctx_t* ctx /**< the current incubed context */);
+
+/**
+ * stores the verified results of the context in the cache of verified responses.
+ * 
+ * If the cache is full, the least recently used entry will be removed.
+ */
+void in3_cache_add_response(
+    in3_ctx_t* ctx /**< the current incubed context */);
+
+/**
+ * frees the cache of verified responses.
+ */
+void in3_cache_free_responses(
+    in3_t* c /**< the incubed client */);
+
+/** a verified blockheader kept in memory. */
+typedef struct in3_block_cache_entry {
+  bytes32_t                     hash;        /**< the blockhash */
+  uint64_t                      number;      /**< the blocknumber */
+  bytes_t                       header;      /**< the rlp-encoded blockheader */
+  uint16_t                      signatures;  /**< the number of signatures the header was verified with */
+  uint16_t                      finality;    /**< the finality (in percent) the header was verified with */
+  struct in3_block_cache_entry* prev;        /**< the entry used more recently */
+  struct in3_block_cache_entry* next;        /**< the entry used less recently */
+  struct in3_block_cache_entry* hash_next;   /**< the next entry within the same bucket of the hash index */
+  struct in3_block_cache_entry* number_next; /**< the next entry within the same bucket of the number index */
+} in3_block_cache_entry_t;
+
+/** the least recently used cache of verified blockheaders of a chain, indexed by blockhash and by blocknumber. */
+typedef struct in3_block_cache {
+  in3_block_cache_entry_t** by_hash;     /**< the entries hashed by their blockhash */
+  in3_block_cache_entry_t** by_number;   /**< the entries hashed by their blocknumber */
+  uint32_t                  buckets_len; /**< the number of buckets of each index (a power of 2) */
+  uint32_t                  len;         /**< the number of cached headers */
+  in3_block_cache_entry_t*  head;        /**< the most recently used entry */
+  in3_block_cache_entry_t*  tail;        /**< the least recently used entry, which will be removed first */
+} in3_block_cache_t;
+
+/**
+ * checks if the blockheader was already verified with at least the given number of signatures and finality.
+ * 
+ * If the expected blockhash is passed, the header is searched by hash, otherwise by number.
+ * Since the cached header is compared byte by byte, the header does not need to be hashed again.
+ */
+bool in3_cache_is_verified_header(
+    in3_t*       c,          /**< the incubed client */
+    in3_chain_t* chain,      /**< the chain of the header */
+    bytes_t*     header,     /**< the rlp-encoded blockheader */
+    uint64_t     number,     /**< the blocknumber of the header */
+    bytes_t*     hash,       /**< the expected blockhash (may be NULL) */
+    uint16_t     signatures, /**< the number of signatures required */
+    uint16_t     finality /**< the finality (in percent) required */);
+
+/**
+ * stores a verified blockheader in the cache of the chain.
+ * 
+ * If the cache reached `max_block_cache`, the least recently used header will be replaced.
+ */
+void in3_cache_add_header(
+    in3_t*       c,          /**< the incubed client */
+    in3_chain_t* chain,      /**< the chain of the header */
+    bytes_t*     header,     /**< the rlp-encoded blockheader */
+    uint64_t     number,     /**< the blocknumber of the header */
+    bytes32_t    hash,       /**< the blockhash */
+    uint16_t     signatures, /**< the number of signatures the header was verified with */
+    uint16_t     finality /**< the finality (in percent) the header was verified with */);
+
+/**
+ * returns the cached blockheader with the given number or NULL if it is not cached.
+ * 
+ * If the blockhash is passed, only a header with this hash is returned, otherwise the most recently added header with this number.
+ * The header stays valid as long as it is in the cache, so it must not be used after the next header was added.
+ */
+bytes_t* in3_cache_get_header(
+    in3_t*       c,      /**< the incubed client */
+    in3_chain_t* chain,  /**< the chain of the header */
+    uint64_t     number, /**< the blocknumber */
+    bytes_t*     hash /**< the expected blockhash (may be NULL) */);
+
+/**
+ * creates the list of blockhashes, which were verified with at least the given number of signatures and finality.
+ * 
+ * Those are sent as `verifiedHashes`, so the server does not need to send the proof for those blocks again.
+ * The list is allocated as one block, which must be freed by the caller.
+ * 
+ * @returns the number of hashes.
+ */
+uint16_t in3_cache_verified_hashes(
+    in3_t*       c,          /**< the incubed client */
+    in3_chain_t* chain,      /**< the chain */
+    uint16_t     signatures, /**< the number of signatures required */
+    uint16_t     finality,   /**< the finality (in percent) required */
+    bytes_t**    dst /**< the resulting list of hashes */);
+
+/**
+ * frees the cache of verified blockheaders of the chain.
+ */
+void in3_cache_free_headers(
+    in3_chain_t* chain /**< the chain */);
+
+/** a verified contract code kept in memory. */
+typedef struct in3_code_cache_entry {
+  bytes32_t                    hash;      /**< the codehash */
+  bytes_t                      code;      /**< the code, which is allocated together with the entry */
+  uint8_t*                     jumpdests; /**< bitmap of the valid jump destinations, one bit per byte of the code, which must be filled by the evm */
+  uint32_t                     refs;      /**< the number of request contexts currently using the code */
+  bool                         evicted;   /**< true if the entry was removed from the cache, but is still used */
+  struct in3_code_cache_entry* prev;      /**< the entry used more recently */
+  struct in3_code_cache_entry* next;      /**< the entry used less recently */
+} in3_code_cache_entry_t;
+
+/** the least recently used cache of contract code. */
+typedef struct in3_code_cache {
+  in3_code_cache_entry_t* head; /**< the most recently used entry */
+  in3_code_cache_entry_t* tail; /**< the least recently used entry, which will be removed first */
+  uint32_t                size; /**< the number of bytes of all cached code */
+} in3_code_cache_t;
+
+/**
+ * finds the code with the given codehash in the code cache.
+ * 
+ * @returns the entry or NULL if not found.
+ */
+in3_code_cache_entry_t* in3_cache_get_code(
+    in3_t*          c,   /**< the incubed client */
+    const bytes32_t hash /**< the codehash */);
+
+/**
+ * adds verified code to the code cache.
+ * 
+ * Least recently used entries are removed, until the code fits into `max_code_cache` bytes.
+ * The jumpdests of the new entry are zeroed and need to be filled by the caller.
+ * 
+ * @returns the new entry or NULL if the cache is disabled or the code is too big.
+ */
+in3_code_cache_entry_t* in3_cache_add_code(
+    in3_t*          c,    /**< the incubed client */
+    const bytes32_t hash, /**< the codehash, which must be verified */
+    bytes_t         code /**< the code, which will be copied */);
+
+/**
+ * adds the code as entry to the cache of the context without copying it.
+ * 
+ * The code will not be freed before the context releases it.
+ */
+cache_entry_t* in3_cache_use_code(
+    cache_entry_t**         cache, /**< the cache of the request context */
+    bytes_t                 key,   /**< the key of the new entry */
+    in3_code_cache_entry_t* entry /**< the code cache entry */);
+
+/**
+ * returns the bitmap of jump destinations, if the entry of the request context shares the code with the code cache.
+ */
+uint8_t* in3_cache_code_jumpdests(
+    cache_entry_t* entry /**< the entry of the request context */);
+
+/**
+ * frees the code cache.
+ */
+void in3_cache_free_code(
+    in3_t* c /**< the incubed client */);
+
+/** a recovered public key of a transaction kept in memory. */
+typedef struct in3_sender_cache_entry {
+  bytes32_t hash;           /**< the hash of the unsigned transaction */
+  uint8_t   sig[65];        /**< r, s and the recovery id of the signature */
+  uint8_t   public_key[64]; /**< the recovered public key */
+  bool      used;           /**< true if the entry holds a public key */
+} in3_sender_cache_entry_t;
+
+/** the cache of recovered public keys, where each signature can only be stored in the slot picked by its hash. */
+typedef struct in3_sender_cache {
+  in3_sender_cache_entry_t* entries; /**< the slots */
+  uint32_t                  len;     /**< the number of slots */
+  in3_sender_cache_stats_t  stats;   /**< the counters */
+#ifdef MULTITHREADING
+  pthread_mutex_t lock; /**< protects the entries and the counters, since the signatures of a block are recovered by multiple threads */
+#endif
+} in3_sender_cache_t;
+
+/**
+ * returns the cache of recovered senders or NULL if `max_sender_cache` is not set.
+ * 
+ * The cache is created or resized if needed, so this must be called before the signatures are recovered by other threads.
+ */
+in3_sender_cache_t* in3_cache_senders(
+    in3_t* c /**< the incubed client */);
+
+/**
+ * finds the public key recovered from the signature.
+ * 
+ * This function does not allocate memory and may be called from any thread.
+ * 
+ * @returns true if the public key was found and copied to `public_key`.
+ */
+bool in3_cache_get_sender(
+    in3_sender_cache_t* cache,   /**< the cache of recovered senders */
+    const bytes32_t     hash,    /**< the hash of the unsigned transaction */
+    const uint8_t*      sig,     /**< r, s and the recovery id (65 bytes) */
+    uint8_t*            public_key /**< [out] the public key (64 bytes) */);
+
+/**
+ * stores the public key recovered from the signature, replacing the entry in its slot.
+ * 
+ * This function does not allocate memory and may be called from any thread.
+ */
+void in3_cache_add_sender(
+    in3_sender_cache_t* cache,   /**< the cache of recovered senders */
+    const bytes32_t     hash,    /**< the hash of the unsigned transaction */
+    const uint8_t*      sig,     /**< r, s and the recovery id (65 bytes) */
+    const uint8_t*      public_key /**< the recovered public key (64 bytes) */);
+
+/**
+ * frees the cache of recovered senders.
+ */
+void in3_cache_free_senders(
+    in3_t* c /**< the incubed client */);
+
 #endif
@@ -153,6 +153,25 @@ typedef struct in3_node {
   bool             whitelisted; /**< boolean indicating if node exists in whiteList */
 } in3_node_t;
 
+/**
+ * the state of the circuit breaker of a node.
+ */
+typedef enum {
+  NODE_STATE_CLOSED    = 0, /**< the node works and will be used */
+  NODE_STATE_OPEN      = 1, /**< the node failed and will not be used until the backoff (blacklisted_until) expired */
+  NODE_STATE_HALF_OPEN = 2  /**< the backoff expired and a single request is sent to probe if the node works again */
+} in3_node_state_t;
+
+/**
+ * the class of error a node failed with.
+ */
+typedef enum {
+  NODE_ERROR_TRANSPORT        = 0, /**< the node could not be reached or did not send a response */
+  NODE_ERROR_TIMEOUT          = 1, /**< the node did not respond in time */
+  NODE_ERROR_INVALID_RESPONSE = 2, /**< the response could not be parsed or has an invalid structure */
+  NODE_ERROR_INVALID_PROOF    = 3  /**< the verification of the response failed */
+} in3_node_error_t;
+
 /**
  * Weight or reputation of a node.
  * 
@@ -161,10 +180,18 @@ typedef struct in3_node {
  * These weights will also be stored in the cache (if available)
  */
 typedef struct in3_node_weight {
-  uint32_t response_count;      /**< counter for responses */
-  uint32_t total_response_time; /**< total of all response times */
-  uint64_t blacklisted_until;   /**< if >0 this node is blacklisted until k. k is a unix timestamp */
-  float    weight;              /**< current weight*/
+  uint32_t response_count;         /**< counter for responses */
+  uint32_t total_response_time;    /**< total of all response times */
+  uint32_t failure_count;          /**< counter for failures (transport errors, invalid responses or failed verifications) */
+  uint32_t transport_error_count;  /**< counter for failures because of transport errors */
+  uint32_t timeout_count;          /**< counter for failures because of timeouts */
+  uint32_t invalid_response_count; /**< counter for failures because of invalid responses */
+  uint32_t invalid_proof_count;    /**< counter for failures because of failed verifications */
+  float    avg_response_time;      /**< the decayed average of the response times in ms, which is used to prefer faster nodes */
+  uint64_t blacklisted_until;      /**< if >0 this node is blacklisted until k. k is a unix timestamp */
+  float    weight;                 /**< current weight*/
+  uint16_t consecutive_failures;   /**< number of failures since the last verified response, which is used for the exponential backoff */
+  uint8_t  state;                  /**< the state of the circuit breaker (see in3_node_state_t) */
 } in3_node_weight_t;
 
 /**
@@ -212,6 +239,19 @@ typedef struct in3_whitelist {
   bool      needs_update; /**< if true the nodelist should be updated and will trigger a `in3_nodeList`-request before the next request is send. */
 } in3_whitelist_t;
 
+/**
+ * a fenwick tree over the weights of the nodes of a chain.
+ * 
+ * It is kept in the chain in order to pick nodes in O(log n) and will be updated whenever the weight of a node changes.
+ */
+typedef struct in3_node_sampler {
+  double*  tree;        /**< the partial sums of the weights (using 1-based indexes) */
+  float*   weights;     /**< the weight of each node as used in the tree, 0 if the node can not be picked */
+  int      len;         /**< number of nodes in the tree */
+  uint64_t next_expiry; /**< the time when the next blacklisted node can be picked again (0 if there is none) */
+  bool     dirty;       /**< if true the tree needs to be rebuilt before picking the next nodes */
+} in3_node_sampler_t;
+
 /**
  * Chain definition inside incubed.
  * 
@@ -230,6 +270,9 @@ typedef struct in3_chain {
   bytes32_t          registry_id;     /**< the identifier of the registry */
   uint8_t            version;         /**< version of the chain */
   in3_whitelist_t*   whitelist;       /**< if set the whitelist of the addresses. */
+  in3_node_sampler_t sampler;         /**< the sampler used to pick the nodes based on their weights */
+
+  struct in3_block_cache* block_cache; /**< the verified blockheaders cached in memory, if max_block_cache is set. */
 } in3_chain_t;
 
 /** 
@@ -314,8 +357,10 @@ typedef struct in3_signer {
  * if the error has a length>0 the response will be rejected
  */
 typedef struct n3_response {
-  sb_t error;  /**< a stringbuilder to add any errors! */
-  sb_t result; /**< a stringbuilder to add the result */
+  sb_t     error;     /**< a stringbuilder to add any errors! */
+  sb_t     result;    /**< a stringbuilder to add the result */
+  uint32_t time;      /**< the time in ms it took to receive the response. (will be set by the transport and is used to update the stats of the node) */
+  bool     timed_out; /**< must be set by the transport, if the request was not finished within the timeout of the request. */
 } in3_response_t;
 
 /** request-object. 
@@ -327,12 +372,37 @@ typedef struct n3_request {
   char**          urls;     /**< array of urls */
   int             urls_len; /**< number of urls */
   in3_response_t* results;  /** the responses*/
+  struct in3_ctx* ctx;      /**< the context this request was created for. (may be NULL if the request was created manually) */
+  uint32_t        timeout;  /**< the time in ms left until the deadline of the context, which all responses must be received within (0 = no timeout) */
 } in3_request_t;
 
 /** the transport function to be implemented by the transport provider.
  */
 typedef in3_ret_t (*in3_transport_send)(in3_request_t* request);
 
+/** function freeing the custom data of a transport (like a connection pool) when the client is freed.
+ */
+typedef void (*in3_transport_free)(void* transport_data);
+
+/**
+ * a transport handling many requests at the same time without blocking.
+ *
+ * This is used by the scheduler (see `scheduler.h`) in order to drive many contexts within one thread.
+ */
+typedef struct in3_async_transport {
+  /** starts sending the request, but returns without waiting for the responses. */
+  in3_ret_t (*send)(void* data, in3_request_t* request);
+
+  /** waits max timeout ms until a request is finished, which means either one response was verified or all responses were received. returns the finished request or NULL if none was finished. */
+  in3_request_t* (*wait)(void* data, uint32_t timeout);
+
+  /** stops all transfers of a request which was sent, but is not finished yet. */
+  void (*cancel)(void* data, in3_request_t* request);
+
+  /** custom data passed to all functions (like a connection pool) */
+  void* data;
+} in3_async_transport_t;
+
 /**
  * Filter type used internally when managing filters.
  */
@@ -385,6 +455,15 @@ typedef struct in3_t_ {
   /** number of number of blocks cached  in memory */
   uint32_t max_block_cache;
 
+  /** number of verified responses cached in memory (0 = no cache). Only responses verified with a proof are cached. */
+  uint32_t max_response_cache;
+
+  /** number of recovered public keys of transactions cached in memory (0 = no cache) */
+  uint32_t max_sender_cache;
+
+  /** number of threads used to recover the signatures of the transactions of a block (0 or 1 = only the calling thread) */
+  uint8_t verify_threads;
+
   /** the type of proof used */
   in3_proof_t proof;
 
@@ -406,7 +485,7 @@ typedef struct in3_t_ {
   /** the max number of attempts before giving up*/
   uint16_t max_attempts;
 
-  /** specifies the number of milliseconds before the request times out. increasing may be helpful if the device uses a slow connection. */
+  /** specifies the number of milliseconds before the request times out. increasing may be helpful if the device uses a slow connection. (0 = no timeout) */
   uint32_t timeout;
 
   /** servers to filter for the given chain. The chain-id based on EIP-155.*/
@@ -424,6 +503,12 @@ typedef struct in3_t_ {
   /** the transporthandler sending requests */
   in3_transport_send transport;
 
+  /** custom data used by the transport, like a connection pool, which is kept as long as the client lives. */
+  void* transport_data;
+
+  /** if set, this function will be called with the transport_data when freeing the client. */
+  in3_transport_free transport_free;
+
   /** includes the code when sending eth_call-requests */
   uint8_t include_code;
 
@@ -436,6 +521,9 @@ typedef struct in3_t_ {
   /** if true the in3-section with the proof will also returned*/
   uint8_t keep_in3;
 
+  /** if true the first verified response will be used and the pending requests to the other nodes will be cancelled (only if the transport supports it). */
+  uint8_t use_first_response;
+
   /** chain spec and nodeList definitions*/
   in3_chain_t* chains;
 
@@ -448,6 +536,15 @@ typedef struct in3_t_ {
   /** used to identify the capabilities of the node. */
   in3_node_props_t node_props;
 
+  /** the verified responses cached in memory, if max_response_cache is set. */
+  struct in3_response_cache* response_cache;
+
+  /** the verified contract code cached in memory, if max_code_cache is set. */
+  struct in3_code_cache* code_cache;
+
+  /** the recovered public keys of transactions cached in memory, if max_sender_cache is set. */
+  struct in3_sender_cache* sender_cache;
+
 } in3_t;
 
 /** creates a new Incubes configuration and returns the pointer.
@@ -582,6 +679,49 @@ in3_ret_t in3_client_remove_node(
     chain_id_t chain_id, /**< [in] the chain id. */
     address_t  address);  /**< [in] public address of the signer. */
 
+/** 
+ * reads the stats recorded for a node.
+ * 
+ * The response times are measured by the transport, so a transport which does not set the time in the response will only update the failure_count.
+ */
+in3_ret_t in3_client_node_stats(
+    in3_t*             client,   /**< [in] the pointer to the incubed client config. */
+    chain_id_t         chain_id, /**< [in] the chain id. */
+    address_t          address,  /**< [in] public address of the signer. */
+    in3_node_weight_t* stats);   /**< [out] the stats of the node. */
+
+/** the counters of the cache of verified responses */
+typedef struct in3_response_cache_stats {
+  uint64_t hits;    /**< number of requests served from the cache */
+  uint64_t misses;  /**< number of cacheable requests not found in the cache (requests found, but sent together with missing ones, are neither hits nor misses) */
+  uint32_t entries; /**< number of responses currently in the cache */
+} in3_response_cache_stats_t;
+
+/** 
+ * reads the counters of the cache of verified responses.
+ * 
+ * The cache is only used if `max_response_cache` is set.
+ */
+in3_ret_t in3_client_response_cache_stats(
+    in3_t*                      client, /**< [in] the pointer to the incubed client config. */
+    in3_response_cache_stats_t* stats); /**< [out] the counters of the cache. */
+
+/** the counters of the cache of recovered senders */
+typedef struct in3_sender_cache_stats {
+  uint64_t hits;    /**< number of signatures, which did not need to be recovered */
+  uint64_t misses;  /**< number of signatures, which had to be recovered */
+  uint32_t entries; /**< number of public keys currently in the cache */
+} in3_sender_cache_stats_t;
+
+/** 
+ * reads the counters of the cache of recovered senders.
+ * 
+ * The cache is only used if `max_sender_cache` is set.
+ */
+in3_ret_t in3_client_sender_cache_stats(
+    in3_t*                    client, /**< [in] the pointer to the incubed client config. */
+    in3_sender_cache_stats_t* stats); /**< [out] the counters of the cache. */
+
 /** removes all nodes from the nodelist */
 in3_ret_t in3_client_clear_nodes(
     in3_t*     client,    /**< [in] the pointer to the incubed client config. */
@@ -86,6 +86,8 @@ void initChain(in3_chain_t* chain, chain_id_t chain_id, char* contract, char* re
   chain->type            = type;
   chain->version         = version;
   chain->whitelist       = NULL;
+  chain->block_cache     = NULL;
+  memset(&chain->sampler, 0, sizeof(in3_node_sampler_t));
   if (wl_contract) {
     chain->whitelist                 = _malloc(sizeof(in3_whitelist_t));
     chain->whitelist->addresses.data = NULL;
@@ -115,11 +117,9 @@ static void initNode(in3_chain_t* chain, int node_index, char* address, char* ur
   memcpy(node->url, url, strlen(url) + 1);
   node->whitelisted = false;
 
-  in3_node_weight_t* weight   = chain->weights + node_index;
-  weight->blacklisted_until   = 0;
-  weight->response_count      = 0;
-  weight->total_response_time = 0;
-  weight->weight              = 1;
+  in3_node_weight_t* weight = chain->weights + node_index;
+  memset(weight, 0, sizeof(in3_node_weight_t));
+  weight->weight = 1;
 }
 
 static void init_ipfs(in3_chain_t* chain) {
@@ -171,18 +171,26 @@ static in3_ret_t in3_client_init(in3_t* c, chain_id_t chain_id) {
   c->cache_timeout        = 0;
   c->use_binary           = 0;
   c->use_http             = 0;
+  c->use_first_response   = 0;
   c->include_code         = 0;
   c->chain_id             = chain_id ? chain_id : ETH_CHAIN_ID_MAINNET; // mainnet
   c->key                  = NULL;
   c->finality             = 0;
   c->max_attempts         = 3;
   c->max_block_cache      = 0;
+  c->max_response_cache   = 0;
+  c->response_cache       = NULL;
+  c->code_cache           = NULL;
   c->max_code_cache       = 0;
+  c->max_sender_cache     = 0;
+  c->sender_cache         = NULL;
   c->min_deposit          = 0;
   c->node_limit           = 0;
   c->proof                = PROOF_STANDARD;
   c->replace_latest_block = 0;
   c->request_count        = 1;
+  c->timeout              = 0;
+  c->verify_threads       = 0;
   c->chains_length        = chain_id ? 1 : 5;
   c->chains               = _malloc(sizeof(in3_chain_t) * c->chains_length);
   c->filters              = NULL;
@@ -237,7 +245,9 @@ in3_ret_t in3_client_register_chain(in3_t* c, chain_id_t chain_id, in3_chain_typ
     chain->weights         = NULL;
     chain->init_addresses  = NULL;
     chain->whitelist       = NULL;
+    chain->block_cache     = NULL;
     chain->last_block      = 0;
+    memset(&chain->sampler, 0, sizeof(in3_node_sampler_t));
     c->chains_length++;
 
   } else {
@@ -300,11 +310,10 @@ in3_ret_t in3_client_add_node(in3_t* c, chain_id_t chain_id, char* url, in3_node
   node->url   = _malloc(strlen(url) + 1);
   memcpy(node->url, url, strlen(url) + 1);
 
-  in3_node_weight_t* weight   = chain->weights + node_index;
-  weight->blacklisted_until   = 0;
-  weight->response_count      = 0;
-  weight->total_response_time = 0;
-  weight->weight              = 1;
+  in3_node_weight_t* weight = chain->weights + node_index;
+  memset(weight, 0, sizeof(in3_node_weight_t));
+  weight->weight = 1;
+  in3_nodelist_invalidate(chain);
   return IN3_OK;
 }
 in3_ret_t in3_client_remove_node(in3_t* c, chain_id_t chain_id, address_t address) {
@@ -328,6 +337,7 @@ in3_ret_t in3_client_remove_node(in3_t* c, chain_id_t chain_id, address_t addres
     memmove(chain->weights + node_index, chain->weights + node_index + 1, sizeof(in3_node_weight_t) * (chain->nodelist_length - 1 - node_index));
   }
   chain->nodelist_length--;
+  in3_nodelist_invalidate(chain);
   if (!chain->nodelist_length) {
     _free(chain->nodelist);
     _free(chain->weights);
@@ -336,6 +346,18 @@ in3_ret_t in3_client_remove_node(in3_t* c, chain_id_t chain_id, address_t addres
   }
   return IN3_OK;
 }
+in3_ret_t in3_client_node_stats(in3_t* c, chain_id_t chain_id, address_t address, in3_node_weight_t* stats) {
+  in3_chain_t* chain = in3_find_chain(c, chain_id);
+  if (!chain) return IN3_EFIND;
+  for (int i = 0; i < chain->nodelist_length; i++) {
+    if (memcmp(chain->nodelist[i].address->data, address, 20) == 0) {
+      *stats = chain->weights[i];
+      return IN3_OK;
+    }
+  }
+  return IN3_EFIND;
+}
+
 in3_ret_t in3_client_clear_nodes(in3_t* c, chain_id_t chain_id) {
   in3_chain_t* chain = in3_find_chain(c, chain_id);
   if (!chain) return IN3_EFIND;
@@ -353,8 +375,10 @@ void in3_free(in3_t* a) {
     in3_nodelist_clear(a->chains + i);
     b_free(a->chains[i].contract);
     whitelist_free(a->chains[i].whitelist);
+    in3_cache_free_headers(a->chains + i);
   }
   if (a->signer) _free(a->signer);
+  if (a->transport_data && a->transport_free) a->transport_free(a->transport_data);
   _free(a->chains);
 
   if (a->filters != NULL) {
@@ -366,6 +390,9 @@ void in3_free(in3_t* a) {
     _free(a->filters->array);
     _free(a->filters);
   }
+  in3_cache_free_responses(a);
+  in3_cache_free_code(a);
+  in3_cache_free_senders(a);
   _free(a);
 }
 
@@ -427,12 +454,22 @@ in3_ret_t in3_configure(in3_t* c, char* config) {
       c->include_code = d_int(iter.token) ? true : false;
     else if (iter.token->key == key("maxAttempts"))
       c->max_attempts = d_int(iter.token);
+    else if (iter.token->key == key("timeout"))
+      c->timeout = (uint32_t) d_long(iter.token);
     else if (iter.token->key == key("keepIn3"))
       c->keep_in3 = d_int(iter.token);
+    else if (iter.token->key == key("useFirstResponse"))
+      c->use_first_response = d_int(iter.token) ? true : false;
     else if (iter.token->key == key("maxBlockCache"))
       c->max_block_cache = d_int(iter.token);
+    else if (iter.token->key == key("maxResponseCache"))
+      c->max_response_cache = d_int(iter.token);
     else if (iter.token->key == key("maxCodeCache"))
       c->max_code_cache = d_int(iter.token);
+    else if (iter.token->key == key("maxSenderCache"))
+      c->max_sender_cache = d_int(iter.token);
+    else if (iter.token->key == key("verifyThreads"))
+      c->verify_threads = (uint8_t) d_int(iter.token);
     else if (iter.token->key == key("minDeposit"))
       c->min_deposit = d_long(iter.token);
     else if (iter.token->key == key("nodeLimit"))
@@ -526,6 +563,9 @@ in3_ret_t in3_configure(in3_t* c, char* config) {
       }
   }
 
+  // the config may change the weights of the nodes (like the minDeposit), so the sampler needs to be updated.
+  for (int i = 0; i < c->chains_length; i++) in3_nodelist_invalidate(c->chains + i);
+
 cleanup:
   json_free(cnf);
   return res;
@@ -37,6 +37,7 @@
 #include "../util/log.h"
 #include "../util/mem.h"
 #include "../util/stringbuilder.h"
+#include "../util/utils.h"
 #include "client.h"
 #include "keys.h"
 #include <stdio.h>
@@ -48,6 +49,7 @@ in3_ctx_t* ctx_new(in3_t* client, char* req_data) {
   if (!ctx) return NULL;
   ctx->client             = client;
   ctx->verification_state = IN3_WAITING;
+  ctx->deadline           = client->timeout ? current_ms() + client->timeout : 0;
 
   if (req_data != NULL) {
     ctx->request_context = parse_json(req_data);
@@ -81,6 +81,11 @@ static void response_free(in3_ctx_t* ctx) {
           ctx->requests_configs[i].signers = NULL;
         }
       }
+      if (ctx->requests_configs[i].verified_hashes) {
+        _free(ctx->requests_configs[i].verified_hashes);
+        ctx->requests_configs[i].verified_hashes        = NULL;
+        ctx->requests_configs[i].verified_hashes_length = 0;
+      }
     }
   }
 }
@@ -129,6 +134,9 @@ static in3_ret_t configure_request(in3_ctx_t* ctx, in3_request_config_t* conf, d
       }
       in3_ctx_free_nodes(signer_nodes);
     }
+
+    // blockheaders we already verified don't need to be proven again.
+    conf->verified_hashes_length = in3_cache_verified_hashes(ctx->client, in3_find_chain(ctx->client, conf->chain_id), conf->signers_length, conf->finality, &conf->verified_hashes);
   }
 
   if (request) {
@@ -241,12 +249,12 @@ static in3_ret_t ctx_parse_response(in3_ctx_t* ctx, char* response_data, int len
   return IN3_OK;
 }
 
-static void blacklist_node(node_weight_t* node_weight) {
+static void blacklist_node(in3_ctx_t* ctx, in3_chain_t* chain, node_weight_t* node_weight, in3_node_error_t error) {
   if (node_weight) {
-    // blacklist the node
-    node_weight->weight->blacklisted_until = _time() + 3600000;
-    node_weight->weight                    = NULL; // setting the weight to NULL means we reject the response.
-    in3_log_info("Blacklisting node for empty response: %s\n", node_weight->node->url);
+    // blacklist the node with a backoff depending on the error and the failures in a row.
+    in3_nodelist_node_failed(ctx->client, chain, node_weight->weight, error);
+    node_weight->weight = NULL; // setting the weight to NULL means we reject the response.
+    in3_log_info("Blacklisting node for error %i: %s\n", error, node_weight->node->url);
   }
 }
 
@@ -262,70 +270,166 @@ static void check_autoupdate(const in3_ctx_t* ctx, in3_chain_t* chain, d_token_t
 
 static inline bool is_blacklisted(const node_weight_t* node_weight) { return node_weight && node_weight->weight == NULL; }
 
-static in3_ret_t find_valid_result(in3_ctx_t* ctx, int nodes_count, in3_response_t* response, in3_chain_t* chain, in3_verifier_t* verifier) {
-  node_weight_t* node = ctx->nodes;
+static inline bool is_timed_out(const in3_ctx_t* ctx) { return ctx->deadline && current_ms() >= ctx->deadline; }
+
+static in3_ret_t verify_response(in3_ctx_t* ctx, node_weight_t* node, in3_response_t* response, in3_chain_t* chain, in3_verifier_t* verifier) {
+  if (response->error.len || !response->result.len) {
+    // we keep the error of the transport, so it can be reported if no node delivers a valid response.
+    if (response->error.len) ctx_set_error(ctx, response->error.data, IN3_ERPC);
+    blacklist_node(ctx, chain, node, response->timed_out ? NODE_ERROR_TIMEOUT : NODE_ERROR_TRANSPORT);
+    return IN3_ERPC;
+  }
+
+  // we need to clean up the previos responses if set
+  if (ctx->responses) _free(ctx->responses);
+  if (ctx->response_context) json_free(ctx->response_context);
+  ctx->responses        = NULL;
+  ctx->response_context = NULL;
+
+  // parse the result
+  in3_ret_t res = ctx_parse_response(ctx, response->result.data, response->result.len);
+  if (res < 0) {
+    blacklist_node(ctx, chain, node, NODE_ERROR_INVALID_RESPONSE);
+    return res;
+  }
 
   // find the verifier
   in3_vctx_t vc;
   vc.ctx   = ctx;
   vc.chain = chain;
 
-  // blacklist nodes for missing response
-  for (int n = 0; n < nodes_count; n++) {
-    // since nodes_count was detected before, this should not happen!
+  // check each request
+  for (int i = 0; i < ctx->len; i++) {
+    vc.request = ctx->requests[i];
+    vc.result  = d_get(ctx->responses[i], K_RESULT);
+    vc.config  = ctx->requests_configs + i;
 
-    if (response[n].error.len || !response[n].result.len)
-      blacklist_node(node);
-    else {
-      // we need to clean up the previos responses if set
-      if (ctx->responses) _free(ctx->responses);
-      if (ctx->response_context) json_free(ctx->response_context);
+    if ((vc.proof = d_get(ctx->responses[i], K_IN3))) {
 
-      // parse the result
-      in3_ret_t res = ctx_parse_response(ctx, response[n].result.data, response[n].result.len);
-      if (res < 0)
-        blacklist_node(node);
-      else {
-        // check each request
-        for (int i = 0; i < ctx->len; i++) {
-          vc.request = ctx->requests[i];
-          vc.result  = d_get(ctx->responses[i], K_RESULT);
-          vc.config  = ctx->requests_configs + i;
-
-          if ((vc.proof = d_get(ctx->responses[i], K_IN3))) {
-
-            // vc.proof is temporary set to the in3-section. It will be updated to real proof in the next lines.
-            check_autoupdate(ctx, chain, vc.proof);
-
-            vc.last_validator_change = d_get_longk(vc.proof, K_LAST_VALIDATOR_CHANGE);
-            vc.currentBlock          = d_get_longk(vc.proof, K_CURRENT_BLOCK);
-            vc.proof                 = d_get(vc.proof, K_PROOF);
-          }
+      // vc.proof is temporary set to the in3-section. It will be updated to real proof in the next lines.
+      check_autoupdate(ctx, chain, vc.proof);
 
-          if (verifier) {
-            res = ctx->verification_state = verifier->verify(&vc);
-            if (res == IN3_WAITING)
-              return res;
-            else if (res < 0) {
-              blacklist_node(node);
-              break;
-            }
-          } else
-            ctx->verification_state = IN3_OK;
-        }
-      }
+      vc.last_validator_change = d_get_longk(vc.proof, K_LAST_VALIDATOR_CHANGE);
+      vc.currentBlock          = d_get_longk(vc.proof, K_CURRENT_BLOCK);
+      vc.proof                 = d_get(vc.proof, K_PROOF);
     }
 
-    // !node_weight is valid, because it means this is a internaly handled response
-    if (!node || !is_blacklisted(node))
-      return IN3_OK; // this reponse was successfully verified, so let us keep it.
+    if (verifier) {
+      res = ctx->verification_state = verifier->verify(&vc);
+      if (res == IN3_WAITING)
+        return res;
+      else if (res < 0) {
+        blacklist_node(ctx, chain, node, NODE_ERROR_INVALID_PROOF);
+        return res;
+      }
+    } else
+      ctx->verification_state = IN3_OK;
+  }
 
-    node = node->next;
+  // a verified response closes the circuit breaker of the node and may be served from the cache next time.
+  if (node) {
+    in3_nodelist_node_verified(ctx->client, chain, node->weight);
+    in3_cache_add_response(ctx);
+  }
+  return IN3_OK;
+}
+
+// the responses of half open nodes are verified, even if they are not needed for the result, because only this closes their circuit again.
+static void verify_probes(in3_ctx_t* ctx, node_weight_t* node, int index, int nodes_count, in3_response_t* response, in3_chain_t* chain, in3_verifier_t* verifier) {
+  // keep the verified result
+  d_token_t** responses        = ctx->responses;
+  json_ctx_t* response_context = ctx->response_context;
+  char*       error            = ctx->error;
+
+  for (node = node->next, index++; node && index < nodes_count; node = node->next, index++) {
+    // cancelled requests have neither a result nor an error
+    if (is_blacklisted(node) || node->weight->state != NODE_STATE_HALF_OPEN || (!response[index].result.len && !response[index].error.len)) continue;
+    ctx->responses        = NULL;
+    ctx->response_context = NULL;
+    ctx->error            = NULL;
+
+    // if the verification needs more data, the node stays half open until the probe expires.
+    verify_response(ctx, node, response + index, chain, verifier);
+    if (ctx->responses) _free(ctx->responses);
+    if (ctx->response_context) json_free(ctx->response_context);
+    if (ctx->error) _free(ctx->error);
+  }
+
+  ctx->responses          = responses;
+  ctx->response_context   = response_context;
+  ctx->error              = error;
+  ctx->verification_state = IN3_OK;
+}
+
+static in3_ret_t find_valid_result(in3_ctx_t* ctx, int nodes_count, in3_response_t* response, in3_chain_t* chain, in3_verifier_t* verifier) {
+  node_weight_t* node = ctx->nodes;
+
+  // blacklist nodes for missing response
+  for (int n = 0; n < nodes_count; n++, node = node ? node->next : NULL) {
+    // skip nodes, which were already rejected while receiving the responses
+    if (is_blacklisted(node)) continue;
+
+    if (verify_response(ctx, node, response + n, chain, verifier) == IN3_WAITING)
+      return IN3_WAITING;
+
+    // !node_weight is valid, because it means this is a internaly handled response
+    if (!node) return IN3_OK;
+    if (!is_blacklisted(node)) {
+      // this reponse was successfully verified, so let us keep it, but not the errors of the nodes we rejected before.
+      if (ctx->error) _free(ctx->error);
+      ctx->error = NULL;
+      verify_probes(ctx, node, n, nodes_count, response, chain, verifier);
+      return IN3_OK;
+    }
   }
   // no valid response found
   return IN3_EINVAL;
 }
 
+static void update_response_times(const in3_ctx_t* ctx, in3_response_t* response) {
+  in3_chain_t*   chain = in3_find_chain(ctx->client, ctx->requests_configs->chain_id ? ctx->requests_configs->chain_id : ctx->client->chain_id);
+  node_weight_t* node  = ctx->nodes;
+  for (int n = 0; node; n++, node = node->next) {
+    // rejected nodes, errors or responses without a measured time (like requests never sent) will not be counted.
+    // cancelled requests are counted with the time they were running.
+    if (is_blacklisted(node) || response[n].error.len || !response[n].time) continue;
+    in3_node_weight_add_response(node->weight, response[n].time);
+    if (chain) in3_nodelist_update_weight(ctx->client, chain, node->weight);
+  }
+}
+
+in3_ret_t in3_req_check_response(in3_request_t* req, int index) {
+  in3_ctx_t* ctx = req->ctx;
+
+  // this only works if configured and we are not already waiting for a subrequest triggered by a verification.
+  if (!ctx || !ctx->client->use_first_response || !ctx->nodes) return IN3_WAITING;
+  if (ctx->response_context && ctx->verification_state == IN3_WAITING) return IN3_WAITING;
+  if (ctx->response_context && ctx->verification_state == IN3_OK) return IN3_OK;
+
+  in3_chain_t*    chain    = in3_find_chain(ctx->client, ctx->requests_configs->chain_id ? ctx->requests_configs->chain_id : ctx->client->chain_id);
+  in3_verifier_t* verifier = chain ? in3_get_verifier(chain->type) : NULL;
+  node_weight_t*  node     = ctx->nodes;
+  for (int n = 0; n < index && node; n++) node = node->next;
+  if (!chain || !verifier || !node || is_blacklisted(node)) return IN3_WAITING;
+
+  in3_ret_t res = verify_response(ctx, node, req->results + index, chain, verifier);
+  if (res == IN3_OK && !is_blacklisted(node)) return IN3_OK;
+  if (res == IN3_WAITING) return res;
+
+  // the response was rejected, so we remove the error since the other responses may still be valid.
+  if (ctx->error) {
+    in3_log_debug("rejected response from %s : %s\n", req->urls[index], ctx->error);
+    _free(ctx->error);
+    ctx->error = NULL;
+  }
+  if (ctx->responses) _free(ctx->responses);
+  if (ctx->response_context) json_free(ctx->response_context);
+  ctx->responses          = NULL;
+  ctx->response_context   = NULL;
+  ctx->verification_state = IN3_WAITING;
+  return IN3_WAITING;
+}
+
 static char* convert_to_http_url(char* src_url) {
   const int l = strlen(src_url);
   if (strncmp(src_url, "https://", 8) == 0) {
@@ -378,12 +482,22 @@ in3_request_t* in3_create_request(in3_ctx_t* ctx) {
   request->payload       = payload->data;
   request->urls_len      = nodes_count;
   request->urls          = urls;
+  request->ctx           = ctx;
+  request->timeout       = 0;
+
+  // the transport may only use the time left until the deadline
+  if (ctx->deadline) {
+    const uint64_t now = current_ms();
+    request->timeout   = ctx->deadline > now ? (uint32_t)(ctx->deadline - now) : 1;
+  }
 
   if (!nodes_count) nodes_count = 1; // at least one result, because for internal response we don't need nodes, but a result big enough.
   request->results = _malloc(sizeof(in3_response_t) * nodes_count);
   for (int n = 0; n < nodes_count; n++) {
     sb_init(&request->results[n].error);
     sb_init(&request->results[n].result);
+    request->results[n].time      = 0;
+    request->results[n].timed_out = false;
   }
 
   // we set the raw_response
@@ -395,6 +509,9 @@ in3_request_t* in3_create_request(in3_ctx_t* ctx) {
 }
 
 void request_free(in3_request_t* req, const in3_ctx_t* ctx, bool free_response) {
+  // the responses are kept for the verification, so we use the measured times to update the stats of the nodes.
+  if (!free_response && req->ctx == ctx) update_response_times(ctx, req->results);
+
   // free resources
   free_urls(req->urls, req->urls_len, ctx->client->use_http);
 
@@ -456,7 +573,7 @@ in3_ret_t in3_send_ctx(in3_ctx_t* ctx) {
             if (!data.data) return ctx_set_error(ctx, "missing data to sign", IN3_ECONFIG);
             if (!from.data) return ctx_set_error(ctx, "missing account to sign", IN3_ECONFIG);
 
-            ctx->raw_response = _malloc(sizeof(in3_response_t));
+            ctx->raw_response = _calloc(1, sizeof(in3_response_t));
             sb_init(&ctx->raw_response[0].error);
             sb_init(&ctx->raw_response[0].result);
             in3_log_trace("... request to sign ");
@@ -489,6 +606,9 @@ in3_ret_t ctx_add_required(in3_ctx_t* parent, in3_ctx_t* ctx) {
   //  printf(" ++ add required %s > %s\n", ctx_name(parent), ctx_name(ctx));
   ctx->required    = parent->required;
   parent->required = ctx;
+
+  // the required context must be finished within the deadline of the parent
+  if (parent->deadline && (!ctx->deadline || parent->deadline < ctx->deadline)) ctx->deadline = parent->deadline;
   return in3_ctx_execute(ctx);
 }
 
@@ -507,6 +627,12 @@ in3_ret_t ctx_remove_required(in3_ctx_t* parent, in3_ctx_t* ctx) {
   return IN3_EFIND;
 }
 
+in3_ctx_t* in3_ctx_last_waiting(in3_ctx_t* ctx) {
+  // the required contexts need to be finished first, so we follow them as long as they are not finished.
+  while (ctx->required && in3_ctx_state(ctx->required) != CTX_SUCCESS) ctx = ctx->required;
+  return ctx;
+}
+
 in3_ctx_state_t in3_ctx_state(in3_ctx_t* ctx) {
   if (ctx == NULL) return CTX_SUCCESS;
   in3_ctx_state_t required_state = in3_ctx_state(ctx->required);
@@ -548,6 +674,11 @@ in3_ret_t in3_ctx_execute(in3_ctx_t* ctx) {
       if (verifier == NULL)
         return ctx_set_error(ctx, "No Verifier found", IN3_EFIND);
 
+      // do we already have a verified response?
+      if (!ctx->raw_response && !ctx->response_context && !ctx->nodes && in3_cache_get_response(ctx) == IN3_OK) {
+        in3_log_debug("served %i request(s) from the response cache\n", ctx->len);
+      }
+
       // do we need to handle it internaly?
       if (!ctx->raw_response && !ctx->response_context && verifier->pre_handle && (ret = verifier->pre_handle(ctx, &ctx->raw_response)) < 0)
         return ctx_set_error(ctx, "The request could not be handled", ret);
@@ -565,8 +696,8 @@ in3_ret_t in3_ctx_execute(in3_ctx_t* ctx) {
           return ret == IN3_WAITING ? ret : ctx_set_error(ctx, "could not find any node", ret);
       }
 
-      // if we still don't have an response, we keep on waiting
-      if (!ctx->raw_response) return IN3_WAITING;
+      // if we still don't have an response, we keep on waiting, but only until the deadline.
+      if (!ctx->raw_response) return is_timed_out(ctx) ? ctx_set_error(ctx, "timeout: no response received within the timeout", IN3_ETIMEOUT) : IN3_WAITING;
 
       // ok, we have a response, then we try to evaluate the responses
       // verify responses and return the node with the correct result.
@@ -581,6 +712,10 @@ in3_ret_t in3_ctx_execute(in3_ctx_t* ctx) {
       // we count this is an attempt
       ctx->attempt++;
 
+      // there is no time left for another attempt
+      if (is_timed_out(ctx))
+        return ctx_set_error(ctx, "timeout: no valid response received within the timeout", IN3_ETIMEOUT);
+
       // should we retry?
       if (ctx->attempt < ctx->client->max_attempts - 1) {
         in3_log_debug("Retrying send request...\n");
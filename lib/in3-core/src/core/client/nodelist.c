@@ -46,6 +46,35 @@
 
 #define DAY 24 * 2600
 
+#define DEFAULT_RESPONSE_TIME 500.0f // the response time in ms we expect from nodes without any recorded responses
+#define RESPONSE_TIME_DECAY   0.125f // the factor a new response time changes the average, like the srtt in tcp
+#define MIN_TOTAL_WEIGHT      1e-6   // if the total weight of the sampler is below, there are no nodes left to pick
+#define BACKOFF_TIME          10     // the backoff in s after a failure, which is doubled with every failure in a row
+#define BACKOFF_PROOF_TIME    3600   // the backoff in s after a invalid proof, since this is a sign of a broken or malicious node
+#define BACKOFF_MAX_TIME      86400  // the max backoff in s
+#define PROBE_TIME            60     // the time in s a half open node is reserved for the single probe request
+
+static inline float node_response_time(const in3_node_weight_t* weight) {
+  return weight->response_count ? max(weight->avg_response_time, 1.0f) : DEFAULT_RESPONSE_TIME;
+}
+
+static inline float node_weight(const in3_node_t* node, const in3_node_weight_t* weight) {
+  return weight->weight * node->capacity * (DEFAULT_RESPONSE_TIME / node_response_time(weight));
+}
+
+/** checks the whitelist and deposit of the node, but not if it is blacklisted. */
+static bool node_usable(const in3_t* c, const in3_chain_t* chain, int index) {
+  const in3_node_t* node = chain->nodelist + index;
+  if (chain->whitelist && !node->whitelisted) return false;
+  return node->deposit >= c->min_deposit;
+}
+
+/** the weight used in the sampler, which is 0 for all nodes which can not be picked. */
+static float node_pick_weight(const in3_t* c, const in3_chain_t* chain, int index, uint64_t now) {
+  if (!node_usable(c, chain, index) || chain->weights[index].blacklisted_until > now) return 0;
+  return node_weight(chain->nodelist + index, chain->weights + index);
+}
+
 static void free_nodeList(in3_node_t* nodelist, int count) {
   // clean chain..
   for (int i = 0; i < count; i++) {
@@ -140,6 +169,7 @@ static in3_ret_t fill_chain(in3_chain_t* chain, in3_ctx_t* ctx, d_token_t* resul
     chain->nodelist        = newList;
     chain->nodelist_length = len;
     chain->weights         = weights;
+    in3_nodelist_invalidate(chain);
   } else {
     free_nodeList(newList, len);
     _free(weights);
@@ -152,6 +182,7 @@ void in3_client_run_chain_whitelisting(in3_chain_t* chain) {
   if (!chain->whitelist)
     return;
 
+  in3_nodelist_invalidate(chain);
   for (int j = 0; j < chain->nodelist_length; ++j)
     chain->nodelist[j].whitelisted = false;
 
@@ -278,12 +309,8 @@ static in3_ret_t update_whitelist(in3_t* c, in3_chain_t* chain, in3_ctx_t* paren
 }
 
 void in3_ctx_free_nodes(node_weight_t* node) {
-  node_weight_t* last_node = NULL;
-  while (node) {
-    last_node = node;
-    node      = node->next;
-    _free(last_node);
-  }
+  // the nodes of a list are allocated as one array, so freeing the first frees all of them.
+  if (node) _free(node);
 }
 
 in3_ret_t update_nodes(in3_t* c, in3_chain_t* chain) {
@@ -325,7 +352,9 @@ node_weight_t* in3_node_list_fill_weight(in3_t* c, chain_id_t chain_id, in3_node
   node_weight_t*     first      = NULL;
   *total_found                  = 0;
   const in3_chain_t* chain      = in3_find_chain(c, chain_id);
-  if (!chain) return NULL;
+  if (!chain || len <= 0) return NULL;
+  node_weight_t* list = _malloc(len * sizeof(node_weight_t));
+  if (!list) return NULL;
 
   for (int i = 0; i < len; i++) {
     nodeDef = all_nodes + i;
@@ -341,17 +370,13 @@ node_weight_t* in3_node_list_fill_weight(in3_t* c, chain_id_t chain_id, in3_node
 
     weightDef = weights + i;
     if (weightDef->blacklisted_until > (uint64_t) now) continue;
-    current = _malloc(sizeof(node_weight_t));
-    if (!current) {
-      // TODO clean up memory
-      return NULL;
-    }
+    current = list + found;
     if (!first) first = current;
     current->node   = nodeDef;
     current->weight = weightDef;
     current->next   = NULL;
     current->s      = weight_sum;
-    current->w      = weightDef->weight * nodeDef->capacity * (500 / (weightDef->response_count ? (weightDef->total_response_time / weightDef->response_count) : 500));
+    current->w      = node_weight(nodeDef, weightDef);
     weight_sum += current->w;
     found++;
     if (prev) prev->next = current;
@@ -359,9 +384,17 @@ node_weight_t* in3_node_list_fill_weight(in3_t* c, chain_id_t chain_id, in3_node
   }
   *total_weight = weight_sum;
   *total_found  = found;
+  if (!first) _free(list);
   return first;
 }
 
+void in3_node_weight_add_response(in3_node_weight_t* weight, uint32_t time) {
+  // the first response initializes the average, afterwards older response times decay.
+  weight->avg_response_time = weight->response_count ? weight->avg_response_time + RESPONSE_TIME_DECAY * ((float) time - weight->avg_response_time) : (float) time;
+  weight->response_count++;
+  weight->total_response_time += time;
+}
+
 in3_ret_t in3_node_list_get(in3_ctx_t* ctx, chain_id_t chain_id, bool update, in3_node_t** nodelist, int* nodelist_length, in3_node_weight_t** weights) {
   in3_ret_t    res   = IN3_EFIND;
   in3_chain_t* chain = in3_find_chain(ctx->client, chain_id);
@@ -396,92 +429,235 @@ in3_ret_t in3_node_list_get(in3_ctx_t* ctx, chain_id_t chain_id, bool update, in
   return IN3_OK;
 }
 
+static void sampler_add(in3_node_sampler_t* sampler, int index, double delta) {
+  for (int i = index + 1; i <= sampler->len; i += i & (-i)) sampler->tree[i] += delta;
+}
+
+static double sampler_prefix(const in3_node_sampler_t* sampler, int len) {
+  double total = 0;
+  for (int i = len; i > 0; i -= i & (-i)) total += sampler->tree[i];
+  return total;
+}
+static double sampler_total(const in3_node_sampler_t* sampler) { return sampler_prefix(sampler, sampler->len); }
+
+/** finds the index of the node where the sum of all weights before is <= r and r < sum + weight. */
+static int sampler_find(const in3_node_sampler_t* sampler, double r) {
+  int pos = 0, step = 1;
+  while (step * 2 <= sampler->len) step *= 2;
+  for (; step; step >>= 1) {
+    if (pos + step <= sampler->len && sampler->tree[pos + step] <= r) {
+      pos += step;
+      r -= sampler->tree[pos];
+    }
+  }
+  return pos;
+}
+
+static void sampler_build_tree(in3_node_sampler_t* sampler) {
+  for (int i = 1; i <= sampler->len; i++) sampler->tree[i] = sampler->weights[i - 1];
+  for (int i = 1; i <= sampler->len; i++) {
+    const int parent = i + (i & (-i));
+    if (parent <= sampler->len) sampler->tree[parent] += sampler->tree[i];
+  }
+}
+
+static in3_ret_t sampler_rebuild(const in3_t* c, in3_chain_t* chain, uint64_t now) {
+  in3_node_sampler_t* sampler = &chain->sampler;
+  if (sampler->len != chain->nodelist_length || !sampler->tree) {
+    if (sampler->tree) _free(sampler->tree);
+    if (sampler->weights) _free(sampler->weights);
+    sampler->len     = chain->nodelist_length;
+    sampler->tree    = _calloc(sampler->len + 1, sizeof(double));
+    sampler->weights = _calloc(sampler->len ? sampler->len : 1, sizeof(float));
+    if (!sampler->tree || !sampler->weights) {
+      sampler->len = 0;
+      return IN3_ENOMEM;
+    }
+  }
+
+  sampler->next_expiry = 0;
+  for (int i = 0; i < sampler->len; i++) {
+    const uint64_t until = chain->weights[i].blacklisted_until;
+    sampler->weights[i]  = node_pick_weight(c, chain, i, now);
+    if (until > now && (!sampler->next_expiry || until < sampler->next_expiry)) sampler->next_expiry = until;
+  }
+  sampler_build_tree(sampler);
+  sampler->dirty = false;
+  return IN3_OK;
+}
+
+void in3_nodelist_invalidate(in3_chain_t* chain) {
+  chain->sampler.dirty = true;
+}
+
+void in3_nodelist_update_weight(in3_t* c, in3_chain_t* chain, in3_node_weight_t* weight) {
+  in3_node_sampler_t* sampler = &chain->sampler;
+  const int           index   = weight - chain->weights;
+  if (sampler->dirty || !sampler->tree || index < 0 || index >= sampler->len) return;
+
+  const _time_t  _now = _time();
+  const uint64_t now  = (uint64_t) max(0, _now);
+  const float    w    = node_pick_weight(c, chain, index, now);
+  sampler_add(sampler, index, (double) w - sampler->weights[index]);
+  sampler->weights[index] = w;
+  if (weight->blacklisted_until > now && (!sampler->next_expiry || weight->blacklisted_until < sampler->next_expiry))
+    sampler->next_expiry = weight->blacklisted_until;
+}
+
+void in3_nodelist_node_failed(in3_t* c, in3_chain_t* chain, in3_node_weight_t* weight, in3_node_error_t error) {
+  const _time_t  _now = _time();
+  const uint64_t now  = (uint64_t) max(0, _now);
+
+  weight->failure_count++;
+  switch (error) {
+    case NODE_ERROR_TRANSPORT:
+      weight->transport_error_count++;
+      break;
+    case NODE_ERROR_TIMEOUT:
+      weight->timeout_count++;
+      break;
+    case NODE_ERROR_INVALID_RESPONSE:
+      weight->invalid_response_count++;
+      break;
+    case NODE_ERROR_INVALID_PROOF:
+      weight->invalid_proof_count++;
+      break;
+  }
+
+  // the backoff is doubled with every failure in a row until the node delivers a verified response again.
+  uint64_t backoff = error == NODE_ERROR_INVALID_PROOF ? BACKOFF_PROOF_TIME : BACKOFF_TIME;
+  if (weight->consecutive_failures < 0xFFFF) weight->consecutive_failures++;
+  for (int i = 1; i < weight->consecutive_failures && backoff < BACKOFF_MAX_TIME; i++) backoff *= 2;
+
+  weight->state             = NODE_STATE_OPEN;
+  weight->blacklisted_until = max(weight->blacklisted_until, now + min(backoff, BACKOFF_MAX_TIME));
+  if (chain) in3_nodelist_update_weight(c, chain, weight);
+}
+
+void in3_nodelist_node_verified(in3_t* c, in3_chain_t* chain, in3_node_weight_t* weight) {
+  weight->consecutive_failures = 0;
+  if (weight->state == NODE_STATE_CLOSED) return;
+
+  // the probe was successful, so the node can be used again.
+  weight->state             = NODE_STATE_CLOSED;
+  weight->blacklisted_until = 0;
+  if (chain) in3_nodelist_update_weight(c, chain, weight);
+}
+
+/** makes the node with the shortest backoff available to probe it. */
+static bool probe_next_node(in3_t* c, in3_chain_t* chain, uint64_t now) {
+  int next = -1;
+  for (int i = 0; i < chain->nodelist_length; i++) {
+    // nodes in half open state are already probed by another request
+    const in3_node_weight_t* w = chain->weights + i;
+    if (w->blacklisted_until > now && w->state != NODE_STATE_HALF_OPEN && node_usable(c, chain, i) && (next < 0 || w->blacklisted_until < chain->weights[next].blacklisted_until))
+      next = i;
+  }
+  if (next < 0) return false;
+
+  in3_log_debug("no nodes available, probing the node with the shortest backoff: %s\n", chain->nodelist[next].url);
+  chain->weights[next].blacklisted_until = now;
+  chain->weights[next].state             = NODE_STATE_OPEN;
+  in3_nodelist_update_weight(c, chain, chain->weights + next);
+  return true;
+}
+
 in3_ret_t in3_node_list_pick_nodes(in3_ctx_t* ctx, node_weight_t** nodes, int request_count, in3_node_props_t props) {
 
   // get all nodes from the nodelist
   _time_t            now       = _time();
   in3_node_t*        all_nodes = NULL;
   in3_node_weight_t* weights   = NULL;
-  float              total_weight;
-  int                all_nodes_len, total_found;
+  int                all_nodes_len;
 
   in3_ret_t res = in3_node_list_get(ctx, ctx->client->chain_id, false, &all_nodes, &all_nodes_len, &weights);
   if (res < 0)
     return ctx_set_error(ctx, "could not find the chain", res);
 
-  // filter out nodes
-  node_weight_t* found = in3_node_list_fill_weight(ctx->client, ctx->client->chain_id, all_nodes, weights, all_nodes_len, now, &total_weight, &total_found, props);
+  // the sampler is only rebuilt if the nodelist changed or blacklisted nodes are available again.
+  in3_chain_t*        chain   = in3_find_chain(ctx->client, ctx->client->chain_id);
+  in3_node_sampler_t* sampler = &chain->sampler;
+  if ((sampler->dirty || !sampler->tree || sampler->len != all_nodes_len || (sampler->next_expiry && sampler->next_expiry <= (uint64_t) now)) && (res = sampler_rebuild(ctx->client, chain, now)) < 0)
+    return ctx_set_error(ctx, "could not create the sampler", res);
 
-  if (total_found == 0) {
-    // no node available, so we should check if we can retry some blacklisted
-    int blacklisted = 0;
-    for (int i = 0; i < all_nodes_len; i++) {
-      if (weights[i].blacklisted_until > (uint64_t) now) blacklisted++;
-    }
+  // if no node is available, we don't use all blacklisted nodes again, but only probe the next one.
+  if (sampler_total(sampler) <= MIN_TOTAL_WEIGHT && !probe_next_node(ctx->client, chain, now))
+    return ctx_set_error(ctx, "No nodes found that match the criteria", IN3_EFIND);
 
-    // if morethan 50% of the nodes are blacklisted, we remove the mark and try again
-    if (blacklisted > all_nodes_len / 2) {
-      for (int i = 0; i < all_nodes_len; i++)
-        weights[i].blacklisted_until = 0;
-      found = in3_node_list_fill_weight(ctx->client, ctx->client->chain_id, all_nodes, weights, all_nodes_len, now, &total_weight, &total_found, props);
+#ifdef FILTER_NODES
+  bool filtered = false;
+#else
+  UNUSED_VAR(props);
+#endif
+  int            added = 0;
+  float          s     = 0;
+  node_weight_t* first = NULL;
+  node_weight_t* last  = NULL;
+
+  // all picked nodes are stored in one array, which is linked as list and freed with the first node.
+  node_weight_t* picked = _malloc(max(min(request_count, all_nodes_len), 1) * sizeof(node_weight_t));
+  if (!picked) return ctx_set_error(ctx, "could not allocate the nodes", IN3_ENOMEM);
+
+  // each draw removes the picked node or the rest left by rounding errors from the tree, so we pick without replacement and never need more than two draws per node.
+  for (int i = 0; added < request_count && i < 2 * all_nodes_len; i++) {
+    const double total = sampler_total(sampler);
+    if (total <= MIN_TOTAL_WEIGHT) break;
+
+    const int index = sampler_find(sampler, total * ((double) (_rand() % 10000)) / 10000.0);
+    if (index >= all_nodes_len) continue; // rounding errors may let us miss the last node, so we simply draw again.
+    if (sampler->weights[index] <= 0) {
+      // a node without weight may only be hit because of rounding errors, so we remove the rest and draw again.
+      sampler_add(sampler, index, sampler_prefix(sampler, index) - sampler_prefix(sampler, index + 1));
+      continue;
     }
+    sampler_add(sampler, index, -(double) sampler->weights[index]);
 
-    if (total_found == 0)
-      return ctx_set_error(ctx, "No nodes found that match the criteria", IN3_EFIND);
-  }
-
-  int filled_len = total_found < request_count ? total_found : request_count;
-  if (total_found == filled_len) {
-    *nodes = found;
-    return IN3_OK;
-  }
-
-  float          r;
-  int            added   = 0;
-  node_weight_t* last    = NULL;
-  node_weight_t* first   = NULL;
-  node_weight_t* next    = NULL;
-  node_weight_t* current = NULL;
-
-  // we want ot make sure this loop is run only max 10xthe number of requested nodes
-  for (int i = 0; added < filled_len && i < filled_len * 10; i++) {
-    // pick a random number
-    r = total_weight * ((float) (_rand() % 10000)) / 10000.0;
-
-    // find the first node matching it.
-    current = found;
-    while (current) {
-      if (current->s <= r && current->s + current->w >= r) break;
-      current = current->next;
+#ifdef FILTER_NODES
+    // fixme: this compile time check will be redundant once the registry contract is deployed with correct node prop values
+    if (!in3_node_props_match(props, all_nodes[index].props)) {
+      filtered = true;
+      continue;
     }
+#endif
 
-    if (current) {
-      // check if we already added it,
-      next = first;
-      while (next) {
-        if (next->node == current->node) break;
-        next = next->next;
-      }
-
-      if (!next) {
-        added++;
-        next         = _calloc(1, sizeof(node_weight_t));
-        next->s      = current->s;
-        next->w      = current->w;
-        next->weight = current->weight;
-        next->node   = current->node;
-
-        if (last) last->next = next;
-        if (!first) first = next;
-      }
+    // in case the weights have been changed directly, we use the current weight.
+    sampler->weights[index] = node_pick_weight(ctx->client, chain, index, now);
+    if (sampler->weights[index] <= 0) continue;
+    const float w = sampler->weights[index];
+
+    // a node with a expired backoff is used for exactly one request, which will decide whether it can be used again.
+    if (weights[index].state != NODE_STATE_CLOSED) {
+      weights[index].state             = NODE_STATE_HALF_OPEN;
+      weights[index].blacklisted_until = now + PROBE_TIME;
+      sampler->weights[index]          = 0;
+      if (!sampler->next_expiry || weights[index].blacklisted_until < sampler->next_expiry) sampler->next_expiry = weights[index].blacklisted_until;
     }
+
+    node_weight_t* next = picked + added;
+    next->node   = all_nodes + index;
+    next->weight = weights + index;
+    next->s      = s;
+    next->w      = w;
+    next->next   = NULL;
+    s += next->w;
+    added++;
+
+    if (last) last->next = next;
+    if (!first) first = next;
+    last = next;
   }
 
-  *nodes = first;
-  in3_ctx_free_nodes(found);
+  // put the picked nodes back into the tree
+#ifdef FILTER_NODES
+  if (filtered)
+    sampler_build_tree(sampler);
+  else
+#endif
+    for (node_weight_t* n = first; n; n = n->next) sampler_add(sampler, n->node - all_nodes, sampler->weights[n->node - all_nodes]);
 
-  // select them based on random
-  return res;
+  if (!first) _free(picked);
+  *nodes = first;
+  return first ? IN3_OK : ctx_set_error(ctx, "No nodes found that match the criteria", IN3_EFIND);
 }
 
 /** removes all nodes and their weights from the nodelist */
@@ -492,6 +668,9 @@ void in3_nodelist_clear(in3_chain_t* chain) {
   }
   _free(chain->nodelist);
   _free(chain->weights);
+  if (chain->sampler.tree) _free(chain->sampler.tree);
+  if (chain->sampler.weights) _free(chain->sampler.weights);
+  memset(&chain->sampler, 0, sizeof(in3_node_sampler_t));
 }
 
 void in3_node_props_set(in3_node_props_t* node_props, in3_node_props_type_t type, uint8_t value) {
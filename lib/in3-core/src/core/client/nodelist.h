@@ -71,6 +71,17 @@ in3_ret_t in3_node_list_pick_nodes(in3_ctx_t* ctx, node_weight_t** nodes, int re
  * forces the client to update the nodelist
  */
 in3_ret_t update_nodes(in3_t* c, in3_chain_t* chain);
+
+// stats
+void in3_node_weight_add_response(in3_node_weight_t* weight, uint32_t time);
+
+// sampler
+void in3_nodelist_invalidate(in3_chain_t* chain);
+void in3_nodelist_update_weight(in3_t* c, in3_chain_t* chain, in3_node_weight_t* weight);
+
+// circuit breaker
+void in3_nodelist_node_failed(in3_t* c, in3_chain_t* chain, in3_node_weight_t* weight, in3_node_error_t error);
+void in3_nodelist_node_verified(in3_t* c, in3_chain_t* chain, in3_node_weight_t* weight);
 // weights
 void in3_ctx_free_nodes(node_weight_t* c);
 int  ctx_nodes_len(node_weight_t* root);
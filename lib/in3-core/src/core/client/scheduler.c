@@ -0,0 +1,312 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#include "scheduler.h"
+#include "../util/mem.h"
+#include "../util/stringbuilder.h"
+#include "../util/utils.h"
+#include "keys.h"
+
+in3_scheduler_t* in3_scheduler_new(in3_async_transport_t* transport) {
+  in3_scheduler_t* scheduler = _calloc(1, sizeof(in3_scheduler_t));
+  scheduler->transport       = *transport;
+  return scheduler;
+}
+
+static void finish_request(in3_sched_entry_t* entry) {
+  // the responses are kept as raw_response in the context, which will verify them with the next execute.
+  request_free(entry->request, entry->request->ctx, false);
+  entry->request = NULL;
+}
+
+static void batch_free(in3_sched_batch_t* batch) {
+  _free(batch->payload.data);
+  _free(batch->calls);
+  _free(batch);
+}
+
+/** passes the results of the batch context to the callbacks and frees the context and the batch. */
+static void finish_batch(in3_sched_batch_t* batch, in3_ctx_t* ctx, char* error) {
+  for (int i = 0; i < batch->len; i++) {
+    d_token_t* response = !error && !ctx->error && ctx->responses && i < ctx->len ? ctx->responses[i] : NULL;
+    d_token_t* rpc_err  = response ? d_get(response, K_ERROR) : NULL;
+    if (response && !rpc_err)
+      batch->calls[i].callback(d_get(response, K_RESULT), NULL, batch->calls[i].data);
+    else if (rpc_err)
+      batch->calls[i].callback(NULL, d_type(rpc_err) == T_OBJECT ? d_get_stringk(rpc_err, K_MESSAGE) : d_string(rpc_err), batch->calls[i].data);
+    else
+      batch->calls[i].callback(NULL, error ? error : (ctx->error ? ctx->error : "no response"), batch->calls[i].data);
+  }
+  if (ctx) ctx_free(ctx);
+  batch_free(batch);
+}
+
+void in3_scheduler_free(in3_scheduler_t* scheduler) {
+  for (int i = 0; i < scheduler->len; i++) {
+    if (scheduler->entries[i].request) {
+      scheduler->transport.cancel(scheduler->transport.data, scheduler->entries[i].request);
+      finish_request(scheduler->entries + i);
+    }
+    if (scheduler->entries[i].batch) finish_batch(scheduler->entries[i].batch, scheduler->entries[i].ctx, "the scheduler was freed");
+  }
+  while (scheduler->batches) {
+    in3_sched_batch_t* batch = scheduler->batches;
+    scheduler->batches       = batch->next;
+    finish_batch(batch, NULL, "the scheduler was freed");
+  }
+  _free(scheduler->entries);
+  _free(scheduler);
+}
+
+static void add_entry(in3_scheduler_t* scheduler, in3_ctx_t* ctx, in3_sched_batch_t* batch) {
+  if (scheduler->len == scheduler->size) {
+    const int size     = scheduler->size ? scheduler->size * 2 : 8;
+    scheduler->entries = scheduler->entries
+                             ? _realloc(scheduler->entries, size * sizeof(in3_sched_entry_t), scheduler->size * sizeof(in3_sched_entry_t))
+                             : _malloc(size * sizeof(in3_sched_entry_t));
+    scheduler->size    = size;
+  }
+  scheduler->entries[scheduler->len].ctx       = ctx;
+  scheduler->entries[scheduler->len].batch     = batch;
+  scheduler->entries[scheduler->len++].request = NULL;
+}
+
+in3_ret_t in3_scheduler_add(in3_scheduler_t* scheduler, in3_ctx_t* ctx) {
+  if (!ctx) return IN3_EINVAL;
+  add_entry(scheduler, ctx, NULL);
+  return IN3_OK;
+}
+
+/** creates the context for the batch, which will be executed like all other contexts. */
+static void send_batch(in3_scheduler_t* scheduler, in3_sched_batch_t* batch) {
+  for (in3_sched_batch_t** p = &scheduler->batches; *p; p = &(*p)->next) {
+    if (*p == batch) {
+      *p = batch->next;
+      break;
+    }
+  }
+
+  // the context uses the payload without copying it, so the batch is freed together with the context.
+  sb_add_char(&batch->payload, ']');
+  in3_ctx_t* ctx = ctx_new(batch->client, batch->payload.data);
+  if (ctx)
+    add_entry(scheduler, ctx, batch);
+  else
+    finish_batch(batch, NULL, "could not create the context");
+}
+
+/** sends all batches which are due, or all if force is true and returns the time in ms when the next batch is due. */
+static uint64_t send_batches(in3_scheduler_t* scheduler, uint64_t now, bool force) {
+  uint64_t next = 0;
+  for (in3_sched_batch_t *batch = scheduler->batches, *n; batch; batch = n) {
+    n = batch->next;
+    if (force || batch->send_time <= now)
+      send_batch(scheduler, batch);
+    else if (!next || batch->send_time < next)
+      next = batch->send_time;
+  }
+  return next;
+}
+
+in3_ret_t in3_scheduler_call(in3_scheduler_t* scheduler, in3_t* c, const char* method, const char* params, in3_sched_result callback, void* data) {
+  if (!c || !method || !callback) return IN3_EINVAL;
+  const int size = scheduler->batch_size ? scheduler->batch_size : 1;
+
+  // all calls of the same client are collected in one batch.
+  in3_sched_batch_t* batch = scheduler->batches;
+  while (batch && batch->client != c) batch = batch->next;
+  if (!batch) {
+    batch              = _calloc(1, sizeof(in3_sched_batch_t));
+    batch->client      = c;
+    batch->calls       = _malloc(size * sizeof(in3_sched_call_t));
+    batch->send_time   = current_ms() + scheduler->batch_window;
+    batch->next        = scheduler->batches;
+    scheduler->batches = batch;
+    sb_init(&batch->payload);
+    sb_add_char(&batch->payload, '[');
+  }
+
+  if (batch->len) sb_add_char(&batch->payload, ',');
+  sb_add_chars(&batch->payload, "{\"method\":\"");
+  sb_add_chars(&batch->payload, method);
+  sb_add_chars(&batch->payload, "\",\"params\":");
+  sb_add_chars(&batch->payload, params ? params : "[]");
+  sb_add_char(&batch->payload, '}');
+  batch->calls[batch->len].callback = callback;
+  batch->calls[batch->len++].data   = data;
+
+  if (batch->len >= size) send_batch(scheduler, batch);
+  return IN3_OK;
+}
+
+/** executes the context until it needs to wait for a response and sends the request. */
+static in3_ret_t send_next(in3_scheduler_t* scheduler, in3_sched_entry_t* entry) {
+  in3_ret_t res;
+
+  // like in3_send_ctx, we stop if the context keeps on waiting even though the response is set.
+  for (int n = 0; n < 10; n++) {
+    if ((res = in3_ctx_execute(entry->ctx)) != IN3_WAITING) return res;
+
+    // if the response is already set, we only need to execute it again.
+    in3_ctx_t* ctx = in3_ctx_last_waiting(entry->ctx);
+    if (ctx->raw_response) continue;
+
+    // signing does not need the transport, so we handle it right away.
+    if (ctx->type == CT_SIGN) {
+      if ((res = in3_send_ctx(ctx)) != IN3_OK)
+        return ctx_set_error(entry->ctx, ctx->error ? ctx->error : "error handling subrequest", res);
+      continue;
+    }
+
+    in3_request_t* request = in3_create_request(ctx);
+    if (request == NULL) return IN3_ENOMEM;
+    if ((res = scheduler->transport.send(scheduler->transport.data, request)) < 0) {
+      request_free(request, ctx, false);
+      return ctx_set_error(entry->ctx, "could not send the request", res);
+    }
+
+    entry->request = request;
+    return IN3_WAITING;
+  }
+  return ctx_set_error(entry->ctx, "Looks like the response is not valid or not set, since we are calling the execute over and over", IN3_ERPC);
+}
+
+/**
+ * runs each call of a batch, which was rejected by the verifier, as its own context.
+ * This is needed for methods handled by the client itself, which only works for single requests.
+ */
+static void split_batch(in3_scheduler_t* scheduler, in3_sched_batch_t* batch, in3_ctx_t* ctx) {
+  for (int i = 0; i < batch->len; i++) {
+    in3_sched_batch_t* single = _calloc(1, sizeof(in3_sched_batch_t));
+    char*              json   = d_create_json(ctx->requests[i]);
+    single->client            = batch->client;
+    single->calls             = _malloc(sizeof(in3_sched_call_t));
+    single->calls[0]          = batch->calls[i];
+    single->len               = 1;
+    sb_init(&single->payload);
+    sb_add_char(&single->payload, '[');
+    sb_add_chars(&single->payload, json);
+    _free(json);
+    send_batch(scheduler, single);
+  }
+  ctx_free(ctx);
+  batch_free(batch);
+}
+
+/** executes the entry with the given index and removes it if it is finished. */
+static bool execute_entry(in3_scheduler_t* scheduler, int index) {
+  const in3_ret_t res = send_next(scheduler, scheduler->entries + index);
+  if (res == IN3_WAITING) return false;
+
+  // the callbacks may add new contexts, so we must not keep a pointer to the entries.
+  in3_ctx_t*         ctx    = scheduler->entries[index].ctx;
+  in3_sched_batch_t* batch  = scheduler->entries[index].batch;
+  scheduler->entries[index] = scheduler->entries[--scheduler->len];
+  if (batch && res == IN3_ENOTSUP && batch->len > 1 && ctx->requests)
+    split_batch(scheduler, batch, ctx);
+  else if (batch)
+    finish_batch(batch, ctx, NULL);
+  else if (scheduler->done)
+    scheduler->done(ctx, res, scheduler->data);
+  return true;
+}
+
+static int find_entry(const in3_scheduler_t* scheduler, const in3_request_t* request) {
+  for (int i = 0; i < scheduler->len; i++) {
+    if (scheduler->entries[i].request == request) return i;
+  }
+  return -1;
+}
+
+static void cancel_request(in3_scheduler_t* scheduler, in3_sched_entry_t* entry) {
+  in3_request_t* request = entry->request;
+  scheduler->transport.cancel(scheduler->transport.data, request);
+
+  // all nodes which did not respond yet, are treated as timeout.
+  for (int i = 0; i < request->urls_len; i++) {
+    if (!request->results[i].error.len && !request->results[i].result.len)
+      sb_add_chars(&request->results[i].error, "timeout: no response received within the timeout");
+  }
+  finish_request(entry);
+}
+
+static int count_batches(const in3_scheduler_t* scheduler) {
+  int len = 0;
+  for (in3_sched_batch_t* batch = scheduler->batches; batch; batch = batch->next) len++;
+  return len;
+}
+
+int in3_scheduler_execute(in3_scheduler_t* scheduler, uint32_t timeout) {
+  const uint64_t now           = current_ms();
+  uint64_t       next_deadline = send_batches(scheduler, now, false);
+
+  // execute all contexts which are not waiting for a response.
+  for (int i = 0; i < scheduler->len; i++) {
+    in3_sched_entry_t* entry = scheduler->entries + i;
+    if (entry->request) {
+      // the transport should stop by itself, but if it does not, we cancel the request as soon as the deadline is reached.
+      const uint64_t deadline = entry->request->ctx->deadline;
+      if (!deadline || deadline > now) {
+        if (deadline && (!next_deadline || deadline < next_deadline)) next_deadline = deadline;
+        continue;
+      }
+      cancel_request(scheduler, entry);
+    }
+    if (execute_entry(scheduler, i)) i--;
+  }
+
+  // without pending requests there is nothing to wait for, so the batches will be sent with the next call.
+  if (!scheduler->len) return count_batches(scheduler);
+
+  // we don't wait longer than the next deadline or the next batch.
+  if (next_deadline && next_deadline - now < timeout) timeout = (uint32_t)(next_deadline - now);
+
+  // resume the contexts as soon as their requests are finished.
+  for (in3_request_t* request = scheduler->transport.wait(scheduler->transport.data, timeout); request;
+       request                = scheduler->transport.wait(scheduler->transport.data, 0)) {
+    const int i = find_entry(scheduler, request);
+    if (i < 0) continue;
+    finish_request(scheduler->entries + i);
+    execute_entry(scheduler, i);
+  }
+
+  return scheduler->len + count_batches(scheduler);
+}
+
+void in3_scheduler_run(in3_scheduler_t* scheduler) {
+  while (in3_scheduler_execute(scheduler, 1000)) {
+    // if no context is running, no more calls can be added, so there is no reason to wait for the batch window.
+    if (!scheduler->len) send_batches(scheduler, 0, true);
+  }
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#include "parallel.h"
+
+#ifdef MULTITHREADING
+#include <pthread.h>
+
+typedef struct {
+  in3_task_t      task;
+  void*           data;
+  unsigned int    len;
+  unsigned int    next; /**< the next index to be picked */
+  pthread_mutex_t lock;
+} job_t;
+
+static void* run_job(void* p) {
+  job_t* job = p;
+  for (;;) {
+    pthread_mutex_lock(&job->lock);
+    unsigned int index = job->next++;
+    pthread_mutex_unlock(&job->lock);
+    if (index >= job->len) return NULL;
+    job->task(job->data, index);
+  }
+}
+
+void in3_parallel_for(unsigned int len, unsigned int threads, in3_task_t task, void* data) {
+  if (threads > len) threads = len;
+  if (threads > IN3_MAX_THREADS) threads = IN3_MAX_THREADS;
+  if (threads <= 1) {
+    for (unsigned int i = 0; i < len; i++) task(data, i);
+    return;
+  }
+
+  pthread_t    workers[IN3_MAX_THREADS];
+  unsigned int started = 0;
+  job_t        job     = {.task = task, .data = data, .len = len, .next = 0};
+  pthread_mutex_init(&job.lock, NULL);
+
+  // if a thread can not be created, the remaining ones simply pick more tasks.
+  while (started < threads - 1 && pthread_create(workers + started, NULL, run_job, &job) == 0) started++;
+  run_job(&job);
+  for (unsigned int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+  pthread_mutex_destroy(&job.lock);
+}
+
+#else
+#include "mem.h"
+
+void in3_parallel_for(unsigned int len, unsigned int threads, in3_task_t task, void* data) {
+  UNUSED_VAR(threads);
+  for (unsigned int i = 0; i < len; i++) task(data, i);
+}
+
+#endif
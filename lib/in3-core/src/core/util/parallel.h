@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+/** @file
+ * runs independent tasks on a pool of threads.
+ *
+ * This is only available if the library is built with `-DMULTITHREADING`, otherwise all tasks are executed in the calling thread.
+ * */
+
+#ifndef IN3_PARALLEL_H
+#define IN3_PARALLEL_H
+
+/** the max number of threads used for one call of in3_parallel_for */
+#define IN3_MAX_THREADS 64
+
+/**
+ * a task, which will be called for each index.
+ */
+typedef void (*in3_task_t)(void* data, unsigned int index);
+
+/**
+ * calls the task for each index from 0 to len-1 using up to `threads` threads (including the calling thread) and returns after all of them are done.
+ *
+ * The indexes are picked by the threads as soon as they are idle, so the order of execution is not defined.
+ * Since the memory functions in TEST-mode are not threadsafe, tasks must not allocate memory.
+ */
+void in3_parallel_for(unsigned int len, unsigned int threads, in3_task_t task, void* data);
+
+#endif
@@ -45,7 +45,9 @@ void in3_cache_free(cache_entry_t* cache) {
   cache_entry_t* p = NULL;
   while (cache) {
     if (cache->key.data) _free(cache->key.data);
-    if (cache->must_free)
+    if (cache->release)
+      cache->release(cache);
+    else if (cache->must_free)
       _free(cache->value.data);
     p     = cache;
     cache = cache->next;
@@ -58,6 +60,7 @@ cache_entry_t* in3_cache_add_entry(cache_entry_t** cache, bytes_t key, bytes_t v
   entry->key           = key;
   entry->value         = value;
   entry->must_free     = 1;
+  entry->release       = NULL;
   entry->next          = cache ? *cache : NULL;
   if (cache) *cache = entry;
   return entry;
@@ -54,6 +54,8 @@ typedef struct cache_entry {
   uint8_t             buffer[4]; /**< the buffer is used to store extra data, which will be cleaned when freed. */
   bool                must_free; /**< if true, the cache-entry will be freed when the request context is cleaned up. */
   struct cache_entry* next;      /**< pointer to the next entry.*/
+  /** if set, this function is called instead of freeing the value, which is used for values shared with other contexts. */
+  void (*release)(struct cache_entry* entry);
 } cache_entry_t;
 
 /**
@@ -39,6 +39,9 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef __ZEPHYR__
+#include <sys/time.h>
+#endif
 
 void uint256_set(uint8_t* src, wlen_t src_len, uint8_t dst[32]) {
   if (src_len < 32) memset(dst, 0, 32 - src_len);
@@ -144,6 +147,20 @@ int sha3_to(bytes_t* data, void* dst) {
   return 0;
 }
 
+void sha3_multi(bytes_t** data, int len, uint8_t* dst) {
+  // the buffers are passed in chunks, so we don't need to allocate the pointer-arrays.
+  const unsigned char* ptr[32];
+  size_t               ptr_len[32];
+  for (int i = 0; i < len; i += 32, dst += 32 * 32) {
+    int n = len - i < 32 ? len - i : 32;
+    for (int j = 0; j < n; j++) {
+      ptr[j]     = data[i + j]->data;
+      ptr_len[j] = data[i + j]->len;
+    }
+    keccak_256_multi(n, ptr, ptr_len, dst);
+  }
+}
+
 bytes_t* sha3(bytes_t* data) {
   bytes_t*        out = NULL;
   struct SHA3_CTX ctx;
@@ -268,3 +285,13 @@ char* str_find(char* haystack, const char* needle) {
   }
   return NULL;
 }
+
+uint64_t current_ms() {
+#ifdef __ZEPHYR__
+  return k_uptime_get();
+#else
+  struct timeval te;
+  gettimeofday(&te, NULL);
+  return te.tv_sec * 1000L + te.tv_usec / 1000;
+#endif
+}
@@ -36,6 +36,17 @@
 #include "secp256k1.h"
 #include "rfc6979.h"
 #include "memzero.h"
+#ifdef SECP256K1_64BIT
+#include "secp256k1_64.h"
+#endif
+
+// the scratch values of the point multiplication are static to save stack,
+// which is only possible as long as no other thread multiplies at the same time.
+#ifdef MULTITHREADING
+#define SCRATCH
+#else
+#define SCRATCH static
+#endif
 
 // Set cp2 = cp1
 void point_copy(const curve_point *cp1, curve_point *cp2)
@@ -432,13 +443,13 @@ void point_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_po
 	assert (bn_is_less(k, &curve->order));
 
 	int i, j;
-	static CONFIDENTIAL bignum256 a;
+	SCRATCH CONFIDENTIAL bignum256 a;
 	uint32_t *aptr = NULL;
 	uint32_t abits;
 	int ashift;
 	uint32_t is_even = (k->val[0] & 1) - 1;
 	uint32_t bits, sign, nsign;
-	static CONFIDENTIAL jacobian_curve_point jres;
+	SCRATCH CONFIDENTIAL jacobian_curve_point jres;
 	curve_point pmult[8];
 	const bignum256 *prime = &curve->prime;
 
@@ -553,10 +564,10 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *
 	assert (bn_is_less(k, &curve->order));
 
 	int i, j;
-	static CONFIDENTIAL bignum256 a;
+	SCRATCH CONFIDENTIAL bignum256 a;
 	uint32_t is_even = (k->val[0] & 1) - 1;
 	uint32_t lowbits;
-	static CONFIDENTIAL jacobian_curve_point jres;
+	SCRATCH CONFIDENTIAL jacobian_curve_point jres;
 	const bignum256 *prime = &curve->prime;
 
 	// is_even = 0xffffffff if k is even, 0 otherwise.
@@ -1027,6 +1038,12 @@ int ecdsa_verify(const ecdsa_curve *curve, HasherType hasher_sign, const uint8_t
 // returns 0 if the key is successfully recovered
 int ecdsa_recover_pub_from_sig (const ecdsa_curve *curve, uint8_t *pub_key, const uint8_t *sig, const uint8_t *digest, int recid)
 {
+#ifdef SECP256K1_64BIT
+	// only public values are used here, so we can use the faster variable time implementation.
+	if (curve == &secp256k1) {
+		return secp256k1_recover_pub_from_sig(pub_key, sig, digest, recid);
+	}
+#endif
 	bignum256 r, s, e;
 	curve_point cp, cp2;
 
@@ -0,0 +1,642 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ *
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ *
+ *
+ * COMMERCIAL LICENSE USAGE
+ *
+ * Licensees holding a valid commercial license may use this file in accordance
+ * with the commercial license agreement provided with the Software or, alternatively,
+ * in accordance with the terms contained in a written agreement between you and
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *
+ * AGPL LICENSE USAGE
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available
+ * complete source code of licensed works and modifications, which include larger
+ * works using a licensed work, under the same license. Copyright and license notices
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#include "secp256k1_64.h"
+
+#ifdef SECP256K1_64BIT
+#include <stdbool.h>
+#include <string.h>
+
+typedef unsigned __int128 uint128_t;
+
+/** a field element mod p as 4 limbs (little endian), which may be anything below 2^256 until it is normalized. */
+typedef struct {
+  uint64_t n[4];
+} fe_t;
+
+/** a scalar mod n as 4 limbs (little endian). */
+typedef struct {
+  uint64_t d[4];
+} sc_t;
+
+/** a point in affine coordinates. */
+typedef struct {
+  fe_t x, y;
+} ge_t;
+
+/** a point in jacobian coordinates (x = X/Z^2, y = Y/Z^3). */
+typedef struct {
+  fe_t x, y, z;
+  bool infinity;
+} gej_t;
+
+#define FE_C 0x1000003D1ULL           // 2^256 - p
+#define FE_P0 0xFFFFFFFEFFFFFC2FULL   // the lowest limb of p, all others are 0xFF..
+#define WINDOW_R 5                    // window of the wNAF for R
+#define WINDOW_G 7                    // window of the wNAF for G, which uses the static table
+#define TABLE_SIZE(w) (1 << ((w) -2)) // number of odd multiples in the table of a window
+#define WNAF_MAX 132                  // max length of a wNAF of a 129 bit number
+
+static const fe_t fe_one  = {{1, 0, 0, 0}};
+static const fe_t fe_zero = {{0, 0, 0, 0}};
+static const fe_t fe_b    = {{7, 0, 0, 0}};
+static const fe_t fe_beta = {{0xc1396c28719501eeULL, 0x9cf0497512f58995ULL, 0x6e64479eac3434e9ULL, 0x7ae96a2b657c0710ULL}}; // beta^3 = 1 mod p
+
+static const sc_t sc_n            = {{0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL}};
+static const sc_t sc_n_half       = {{0xdfe92f46681b20a0ULL, 0x5d576e7357a4501dULL, 0xffffffffffffffffULL, 0x7fffffffffffffffULL}};
+static const sc_t sc_nc           = {{0x402da1732fc9bebfULL, 0x4551231950b75fc4ULL, 0x0000000000000001ULL, 0x0000000000000000ULL}}; // 2^256 - n
+static const sc_t sc_minus_lambda = {{0xe0cfc810b51283cfULL, 0xa880b9fc8ec739c2ULL, 0x5ad9e3fd77ed9ba4ULL, 0xac9c52b33fa3cf1fULL}}; // lambda*P = (beta*x, y)
+static const sc_t sc_minus_b1     = {{0x6f547fa90abfe4c3ULL, 0xe4437ed6010e8828ULL, 0x0000000000000000ULL, 0x0000000000000000ULL}};
+static const sc_t sc_minus_b2     = {{0xd765cda83db1562cULL, 0x8a280ac50774346dULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL}};
+static const sc_t sc_g1           = {{0xe893209a45dbb031ULL, 0x3daa8a1471e8ca7fULL, 0xe86c90e49284eb15ULL, 0x3086d221a7d46bcdULL}}; // round(2^384 * b2 / n)
+static const sc_t sc_g2           = {{0x1571b4ae8ac47f71ULL, 0x221208ac9df506c6ULL, 0x6f547fa90abfe4c4ULL, 0xe4437ed6010e8828ULL}}; // round(2^384 * -b1 / n)
+
+// the odd multiples 1*G, 3*G, .. 63*G
+static const ge_t g_table[TABLE_SIZE(WINDOW_G)] = {
+    {{{0x59f2815b16f81798ULL, 0x029bfcdb2dce28d9ULL, 0x55a06295ce870b07ULL, 0x79be667ef9dcbbacULL}}, {{0x9c47d08ffb10d4b8ULL, 0xfd17b448a6855419ULL, 0x5da4fbfc0e1108a8ULL, 0x483ada7726a3c465ULL}}}, /* 1*G */
+    {{{0x8601f113bce036f9ULL, 0xb531c845836f99b0ULL, 0x49344f85f89d5229ULL, 0xf9308a019258c310ULL}}, {{0x6cb9fd7584b8e672ULL, 0x6500a99934c2231bULL, 0x0fe337e62a37f356ULL, 0x388f7b0f632de814ULL}}}, /* 3*G */
+    {{{0xcba8d569b240efe4ULL, 0xe88b84bddc619ab7ULL, 0x55b4a7250a5c5128ULL, 0x2f8bde4d1a072093ULL}}, {{0xdca87d3aa6ac62d6ULL, 0xf788271bab0d6840ULL, 0xd4dba9dda6c9c426ULL, 0xd8ac222636e5e3d6ULL}}}, /* 5*G */
+    {{{0xe92bddedcac4f9bcULL, 0x3d419b7e0330e39cULL, 0xa398f365f2ea7a0eULL, 0x5cbdf0646e5db4eaULL}}, {{0xa5082628087264daULL, 0xa813d0b813fde7b5ULL, 0xa3178d6d861a54dbULL, 0x6aebca40ba255960ULL}}}, /* 7*G */
+    {{{0xc35f110dfc27ccbeULL, 0xe09796974c57e714ULL, 0x09ad178a9f559abdULL, 0xacd484e2f0c7f653ULL}}, {{0x05cc262ac64f9c37ULL, 0xadd888a4375f8e0fULL, 0x64380971763b61e9ULL, 0xcc338921b0a7d9fdULL}}}, /* 9*G */
+    {{{0xbbec17895da008cbULL, 0x5649980be5c17891ULL, 0x5ef4246b70c65aacULL, 0x774ae7f858a9411eULL}}, {{0x301d74c9c953c61bULL, 0x372db1e2dff9d6a8ULL, 0x0243dd56d7b7b365ULL, 0xd984a032eb6b5e19ULL}}}, /* 11*G */
+    {{{0xdeeddf8f19405aa8ULL, 0xb075fbc6610e58cdULL, 0xc7d1d205c3748651ULL, 0xf28773c2d975288bULL}}, {{0x29b5cb52db03ed81ULL, 0x3a1a06da521fa91fULL, 0x758212eb65cdaf47ULL, 0x0ab0902e8d880a89ULL}}}, /* 13*G */
+    {{{0x44adbcf8e27e080eULL, 0x31e5946f3c85f79eULL, 0x5a465ae3095ff411ULL, 0xd7924d4f7d43ea96ULL}}, {{0xc504dc9ff6a26b58ULL, 0xea40af2bd896d3a5ULL, 0x83842ec228cc6defULL, 0x581e2872a86c72a6ULL}}}, /* 15*G */
+    {{{0x66e4faa04a2d4a34ULL, 0xeb9898ae79b97687ULL, 0xa420fee807eacf21ULL, 0xdefdea4cdb677750ULL}}, {{0xcfb199f69e56eb77ULL, 0xced1f4a04a95c0f6ULL, 0xe997b0ead2a93daeULL, 0x4211ab0694635168ULL}}}, /* 17*G */
+    {{{0x7475656138385b6cULL, 0xf06acfebd7e86d27ULL, 0x93ef5cff444f4979ULL, 0x2b4ea0a797a443d2ULL}}, {{0xb570c854e5c09b7aULL, 0x1a01f60c50269763ULL, 0xb343083b5a1c8613ULL, 0x85e89bc037945d93ULL}}}, /* 19*G */
+    {{{0x81340aef25be59d5ULL, 0x1d9ad40271f81071ULL, 0x4f93fa332ce33330ULL, 0x352bbf4a4cdd1256ULL}}, {{0x67bd3d8bcf81998cULL, 0x4a1b3b2e71b1039cULL, 0xd59c18259dda3e1fULL, 0x321eb4075348f534ULL}}}, /* 21*G */
+    {{{0xdc9cdadd4ecacc3fULL, 0xe42ab8dfeff5ff29ULL, 0x0230010559879124ULL, 0x2fa2104d6b38d11bULL}}, {{0x423ba76b532b7d67ULL, 0x181d70ecfc882648ULL, 0xb64569335bd5dd80ULL, 0x02de1068295dd865ULL}}}, /* 23*G */
+    {{{0x69ca0cd7f5453714ULL, 0x263c3d84e09572e2ULL, 0xab21a9b066edda83ULL, 0x9248279b09b4d68dULL}}, {{0xe54a32ce97cb3402ULL, 0x3fc0de2a887912ffULL, 0x5d1aa71bdea2b1ffULL, 0x73016f7bf234aadeULL}}}, /* 25*G */
+    {{{0x7e996d443dee8729ULL, 0x2f570e144bf615c0ULL, 0x8e70132fb0beb752ULL, 0xdaed4f2be3a8bf27ULL}}, {{0xab40e52290be1c55ULL, 0x3f83c230f3afa726ULL, 0xd4a1aca87ef8d700ULL, 0xa69dce4a7d6c98e8ULL}}}, /* 27*G */
+    {{{0xe6a3b5e87d22e7dbULL, 0x11ecd9e9fdf281b0ULL, 0x8acf28d7cbb19f90ULL, 0xc44d12c7065d812eULL}}, {{0xa039063f0e0e6482ULL, 0x0e106e861edf61c5ULL, 0x76c45926c982fdacULL, 0x2119a460ce326cdcULL}}}, /* 29*G */
+    {{{0xb61c65cbd269e6b4ULL, 0x152b695336c28063ULL, 0xc89a20cfded60853ULL, 0x6a245bf6dc698504ULL}}, {{0xfd5e6348100d8a82ULL, 0x8b33ba48d0423b6eULL, 0x8b3f5126f16a24adULL, 0xe022cf42c2bd4a70ULL}}}, /* 31*G */
+    {{{0xf95ae57f0d0bd6a5ULL, 0xce13300b0bec1146ULL, 0xc077e3d2fe541084ULL, 0x1697ffa6fd9de627ULL}}, {{0xadee9d63d01b2396ULL, 0xa2cf15009e498ae7ULL, 0x27561506e4557433ULL, 0xb9c398f186806f5dULL}}}, /* 33*G */
+    {{{0xf982345ef27a7479ULL, 0x9deb8360ffb7f61dULL, 0x986d0f07e834cb0dULL, 0x605bdb019981718bULL}}, {{0x3b01e1e9056b8c49ULL, 0xc26bfae84fb14db4ULL, 0x81a78d93ec96fe23ULL, 0x02972d2de4f8d206ULL}}}, /* 35*G */
+    {{{0xfe31c7e9d87ff33dULL, 0xdcb01c354959b10cULL, 0x7402fdc45a215e10ULL, 0x62d14dab4150bf49ULL}}, {{0x35f5642483b25eafULL, 0x01aa132967ab4722ULL, 0x98088a1950eed0dbULL, 0x80fc06bd8cc5b010ULL}}}, /* 37*G */
+    {{{0x5e555c2f86308b6fULL, 0x2c50e9f56b9b8b42ULL, 0xde5b4b06c408e56bULL, 0x80c60ad0040f27daULL}}, {{0x1aa01f56430bd57aULL, 0xa65eed4cbe7024ebULL, 0x26e66bad7fe72f70ULL, 0x1c38303f1cc5c30fULL}}}, /* 39*G */
+    {{{0x9d5eabb0fa03c8fbULL, 0x4cc5dc9487d84704ULL, 0xaa74c6348cc54d34ULL, 0x7a9375ad6167ad54ULL}}, {{0x02d499ec224dc7f7ULL, 0xbdc59ea10c70ce2bULL, 0x09559e0d79269046ULL, 0x0d0e3fa9eca87269ULL}}}, /* 41*G */
+    {{{0x4bb51f459bc3ffc9ULL, 0xbb408ec39b68df50ULL, 0x907a9ed045447a79ULL, 0xd528ecd9b696b54cULL}}, {{0x063465b521409933ULL, 0xbc4345405c520dbcULL, 0x9966f21881fd656eULL, 0xeecf41253136e5f9ULL}}}, /* 43*G */
+    {{{0x87231808f8b45963ULL, 0x5266115e4a7ecb13ULL, 0xea25f514e8ecdad0ULL, 0x049370a4b5f43412ULL}}, {{0xb653052a12949c9aULL, 0x54c3f3afbb5b6764ULL, 0x8b3081b0512fd62aULL, 0x758f3f41afd6ed42ULL}}}, /* 45*G */
+    {{{0xf1c13eb1fc345d74ULL, 0x881d811e0e1498e2ULL, 0xd73df930d64702efULL, 0x77f230936ee88cbbULL}}, {{0xbe8eb3c7671c60d6ULL, 0x96c95330d97077cbULL, 0x0a08266e9ba1b378ULL, 0x958ef42a7886b640ULL}}}, /* 47*G */
+    {{{0xeb28531b7739f530ULL, 0x58c80074ab9d4dbaULL, 0xea44887e5c7c0bceULL, 0xf2dac991cc4ce4b9ULL}}, {{0x1a117dba703a3c37ULL, 0x9eb5fbeb0598e4fdULL, 0x4da1f32dec2531dfULL, 0xe0dedc9b3b2f8dadULL}}}, /* 49*G */
+    {{{0xbcba4850c690d45bULL, 0x5a216cdfc9dae3deULL, 0x1b4be8fbbe252012ULL, 0x463b3d9f662621fbULL}}, {{0x1cb377b01af7307eULL, 0xc622e27c970a1de3ULL, 0x43114306dd8622d7ULL, 0x5ed430d78c296c35ULL}}}, /* 51*G */
+    {{{0xa32496b49998f247ULL, 0x6b98fac14328a2d1ULL, 0x09232d4aff3b5997ULL, 0xf16f804244e46e2aULL}}, {{0xd6579962c4e31df6ULL, 0x2a6c53c26e5cce26ULL, 0x13d206fcdf4e33d9ULL, 0xcedabd9b82203f7eULL}}}, /* 53*G */
+    {{{0x369e15f7151d41d1ULL, 0x5d245315ace27c65ULL, 0xb0352b7a14311af5ULL, 0xcaf754272dc84563ULL}}, {{0xc32f908318a04476ULL, 0x5f4fa9b7962232a5ULL, 0xa41b643fa5e46057ULL, 0xcb474660ef35f5f2ULL}}}, /* 55*G */
+    {{{0x24497bc86f082120ULL, 0x44a09c07cb86d7c1ULL, 0xf85d0f1709979d8bULL, 0x2600ca4b282cb986ULL}}, {{0x4b0be9475a7e4b40ULL, 0x5ac6be74ab5f0ef4ULL, 0xa693b03fcddbb45dULL, 0x4119b88753c15bd6ULL}}}, /* 57*G */
+    {{{0xc602a7746998e435ULL, 0x01c48685e24f7dc8ULL, 0x338ec53cd12220bcULL, 0x7635ca72d7e8432cULL}}, {{0xd9e76f302c5b9c61ULL, 0x4ecfc061d57048baULL, 0x3d1d5e590f78e6d7ULL, 0x091b649609489d61ULL}}}, /* 59*G */
+    {{{0xc1a50743bf56cc18ULL, 0xb7f2b33479d468fbULL, 0xdbbf4a87deee8a66ULL, 0x754e3239f325570cULL}}, {{0x0c5d98093c536683ULL, 0x23ee33d0197a695dULL, 0xb3cd0ed304ea49a0ULL, 0x0673fb86e5bda30fULL}}}, /* 61*G */
+    {{{0x9fe2694691d9b9e8ULL, 0x330800661d1c952fULL, 0xff57859c82d570f0ULL, 0xe3e6bd1071a1e96aULL}}, {{0x67002af4920e37f5ULL, 0xa5a2283993e90c41ULL, 0x40c0aa58379a3cb6ULL, 0x59c9e0bba394e76fULL}}}, /* 63*G */
+};
+
+// -- field arithmetic mod p --
+
+// adds carry * 2^256, which is carry * FE_C mod p.
+static inline void fe_carry(fe_t* r, uint64_t carry) {
+  while (carry) {
+    uint128_t t = (uint128_t) carry * FE_C;
+    for (int i = 0; i < 4; i++) {
+      t += r->n[i];
+      r->n[i] = (uint64_t) t;
+      t >>= 64;
+    }
+    carry = (uint64_t) t;
+  }
+}
+
+static inline void fe_add(fe_t* r, const fe_t* a, const fe_t* b) {
+  uint128_t t = 0;
+  for (int i = 0; i < 4; i++) {
+    t += (uint128_t) a->n[i] + b->n[i];
+    r->n[i] = (uint64_t) t;
+    t >>= 64;
+  }
+  fe_carry(r, (uint64_t) t);
+}
+
+static inline void fe_sub(fe_t* r, const fe_t* a, const fe_t* b) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) {
+    uint128_t t = (uint128_t) a->n[i] - b->n[i] - borrow;
+    r->n[i]     = (uint64_t) t;
+    borrow      = (uint64_t)(t >> 64) & 1;
+  }
+  // a borrow added 2^256, which is FE_C too much mod p.
+  while (borrow) {
+    uint128_t t = (uint128_t) r->n[0] - FE_C;
+    r->n[0]     = (uint64_t) t;
+    borrow      = (uint64_t)(t >> 64) & 1;
+    for (int i = 1; i < 4; i++) {
+      t       = (uint128_t) r->n[i] - borrow;
+      r->n[i] = (uint64_t) t;
+      borrow  = (uint64_t)(t >> 64) & 1;
+    }
+  }
+}
+
+static void fe_mul(fe_t* r, const fe_t* a, const fe_t* b) {
+  uint64_t t[8] = {0};
+  for (int i = 0; i < 4; i++) {
+    uint128_t c = 0;
+    for (int j = 0; j < 4; j++) {
+      c += (uint128_t) a->n[i] * b->n[j] + t[i + j];
+      t[i + j] = (uint64_t) c;
+      c >>= 64;
+    }
+    t[i + 4] = (uint64_t) c;
+  }
+  // r = low + high * 2^256 = low + high * FE_C
+  uint128_t c = 0;
+  for (int i = 0; i < 4; i++) {
+    c += (uint128_t) t[i + 4] * FE_C + t[i];
+    r->n[i] = (uint64_t) c;
+    c >>= 64;
+  }
+  fe_carry(r, (uint64_t) c);
+}
+
+static inline void fe_sqr(fe_t* r, const fe_t* a) {
+  fe_mul(r, a, a);
+}
+
+static inline void fe_sqr_n(fe_t* r, const fe_t* a, int n) {
+  *r = *a;
+  while (n--) fe_sqr(r, r);
+}
+
+static inline void fe_negate(fe_t* r, const fe_t* a) {
+  fe_sub(r, &fe_zero, a);
+}
+
+// reduces the value to be less than p.
+static inline void fe_normalize(fe_t* r) {
+  if (r->n[3] == UINT64_MAX && r->n[2] == UINT64_MAX && r->n[1] == UINT64_MAX && r->n[0] >= FE_P0) {
+    r->n[0] -= FE_P0;
+    r->n[1] = r->n[2] = r->n[3] = 0;
+  }
+}
+
+static inline bool fe_is_zero(const fe_t* a) {
+  fe_t t = *a;
+  fe_normalize(&t);
+  return !(t.n[0] | t.n[1] | t.n[2] | t.n[3]);
+}
+
+static inline bool fe_equal(const fe_t* a, const fe_t* b) {
+  fe_t t;
+  fe_sub(&t, a, b);
+  return fe_is_zero(&t);
+}
+
+static void fe_from_be(fe_t* r, const uint8_t* data) {
+  for (int i = 0; i < 4; i++) {
+    uint64_t v = 0;
+    for (int j = 0; j < 8; j++) v = (v << 8) | data[(3 - i) * 8 + j];
+    r->n[i] = v;
+  }
+}
+
+static void fe_to_be(const fe_t* a, uint8_t* data) {
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 8; j++) data[(3 - i) * 8 + j] = a->n[i] >> (56 - j * 8);
+  }
+}
+
+// computes a^(p-2) (the inverse) or a^((p+1)/4) (the square root) with the addition chain also used by libsecp256k1, where xN = a^(2^N - 1).
+static void fe_pow(fe_t* r, const fe_t* a, bool sqrt) {
+  fe_t x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t;
+  fe_sqr(&x2, a);
+  fe_mul(&x2, &x2, a);
+  fe_sqr(&x3, &x2);
+  fe_mul(&x3, &x3, a);
+  fe_sqr_n(&x6, &x3, 3);
+  fe_mul(&x6, &x6, &x3);
+  fe_sqr_n(&x9, &x6, 3);
+  fe_mul(&x9, &x9, &x3);
+  fe_sqr_n(&x11, &x9, 2);
+  fe_mul(&x11, &x11, &x2);
+  fe_sqr_n(&x22, &x11, 11);
+  fe_mul(&x22, &x22, &x11);
+  fe_sqr_n(&x44, &x22, 22);
+  fe_mul(&x44, &x44, &x22);
+  fe_sqr_n(&x88, &x44, 44);
+  fe_mul(&x88, &x88, &x44);
+  fe_sqr_n(&x176, &x88, 88);
+  fe_mul(&x176, &x176, &x88);
+  fe_sqr_n(&x220, &x176, 44);
+  fe_mul(&x220, &x220, &x44);
+  fe_sqr_n(&x223, &x220, 3);
+  fe_mul(&x223, &x223, &x3);
+  fe_sqr_n(&t, &x223, 23);
+  fe_mul(&t, &t, &x22);
+  if (sqrt) {
+    fe_sqr_n(&t, &t, 6);
+    fe_mul(&t, &t, &x2);
+    fe_sqr_n(r, &t, 2);
+  } else {
+    fe_sqr_n(&t, &t, 5);
+    fe_mul(&t, &t, a);
+    fe_sqr_n(&t, &t, 3);
+    fe_mul(&t, &t, &x2);
+    fe_sqr_n(&t, &t, 2);
+    fe_mul(r, &t, a);
+  }
+}
+
+// -- scalar arithmetic mod n --
+
+static inline bool sc_less(const sc_t* a, const sc_t* b) {
+  for (int i = 3; i >= 0; i--) {
+    if (a->d[i] != b->d[i]) return a->d[i] < b->d[i];
+  }
+  return false;
+}
+
+static inline bool sc_is_zero(const sc_t* a) {
+  return !(a->d[0] | a->d[1] | a->d[2] | a->d[3]);
+}
+
+// r = a - b and returns the borrow.
+static inline uint64_t sc_sub_raw(sc_t* r, const sc_t* a, const sc_t* b) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) {
+    uint128_t t = (uint128_t) a->d[i] - b->d[i] - borrow;
+    r->d[i]     = (uint64_t) t;
+    borrow      = (uint64_t)(t >> 64) & 1;
+  }
+  return borrow;
+}
+
+// r = a + b and returns the carry.
+static inline uint64_t sc_add_raw(sc_t* r, const sc_t* a, const sc_t* b) {
+  uint128_t t = 0;
+  for (int i = 0; i < 4; i++) {
+    t += (uint128_t) a->d[i] + b->d[i];
+    r->d[i] = (uint64_t) t;
+    t >>= 64;
+  }
+  return (uint64_t) t;
+}
+
+static void sc_from_be(sc_t* r, const uint8_t* data) {
+  fe_from_be((fe_t*) r, data);
+}
+
+static inline void sc_add(sc_t* r, const sc_t* a, const sc_t* b) {
+  // if the sum overflows, adding 2^256 - n removes the 2^256 and subtracts n.
+  if (sc_add_raw(r, a, b))
+    sc_add_raw(r, r, &sc_nc);
+  else if (!sc_less(r, &sc_n))
+    sc_sub_raw(r, r, &sc_n);
+}
+
+static inline void sc_negate(sc_t* r, const sc_t* a) {
+  if (sc_is_zero(a))
+    *r = *a;
+  else
+    sc_sub_raw(r, &sc_n, a);
+}
+
+static void sc_mul_512(uint64_t t[8], const sc_t* a, const sc_t* b) {
+  memset(t, 0, 8 * sizeof(uint64_t));
+  for (int i = 0; i < 4; i++) {
+    uint128_t c = 0;
+    for (int j = 0; j < 4; j++) {
+      c += (uint128_t) a->d[i] * b->d[j] + t[i + j];
+      t[i + j] = (uint64_t) c;
+      c >>= 64;
+    }
+    t[i + 4] = (uint64_t) c;
+  }
+}
+
+static void sc_mul(sc_t* r, const sc_t* a, const sc_t* b) {
+  uint64_t t[8];
+  sc_mul_512(t, a, b);
+  // replace the high part by high * (2^256 - n) until nothing is left above 2^256.
+  while (t[4] | t[5] | t[6] | t[7]) {
+    uint64_t m[8] = {0};
+    for (int i = 0; i < 4; i++) {
+      uint128_t c = 0;
+      for (int j = 0; j < 3; j++) {
+        c += (uint128_t) t[i + 4] * sc_nc.d[j] + m[i + j];
+        m[i + j] = (uint64_t) c;
+        c >>= 64;
+      }
+      m[i + 3] = (uint64_t) c;
+    }
+    uint128_t c = 0;
+    for (int i = 0; i < 8; i++) {
+      c += (uint128_t) m[i] + (i < 4 ? t[i] : 0);
+      t[i] = (uint64_t) c;
+      c >>= 64;
+    }
+  }
+  memcpy(r->d, t, 4 * sizeof(uint64_t));
+  if (!sc_less(r, &sc_n)) sc_sub_raw(r, r, &sc_n);
+}
+
+// halves a mod n.
+static inline void sc_half(sc_t* a) {
+  uint64_t carry = (a->d[0] & 1) ? sc_add_raw(a, a, &sc_n) : 0;
+  for (int i = 0; i < 3; i++) a->d[i] = (a->d[i] >> 1) | (a->d[i + 1] << 63);
+  a->d[3] = (a->d[3] >> 1) | (carry << 63);
+}
+
+static inline void sc_shift_right(sc_t* a) {
+  for (int i = 0; i < 3; i++) a->d[i] = (a->d[i] >> 1) | (a->d[i + 1] << 63);
+  a->d[3] >>= 1;
+}
+
+static inline bool sc_is_one(const sc_t* a) {
+  return a->d[0] == 1 && !(a->d[1] | a->d[2] | a->d[3]);
+}
+
+// r = a - b mod n
+static inline void sc_sub(sc_t* r, const sc_t* a, const sc_t* b) {
+  if (sc_sub_raw(r, a, b)) sc_add_raw(r, r, &sc_n);
+}
+
+// inverts a (which must not be 0) with the binary extended euclidean algorithm, which is not constant time.
+static void sc_inverse(sc_t* r, const sc_t* a) {
+  sc_t u = *a, v = sc_n, x1 = {{1, 0, 0, 0}}, x2 = {{0, 0, 0, 0}};
+  while (!sc_is_one(&u) && !sc_is_one(&v)) {
+    while (!(u.d[0] & 1)) {
+      sc_shift_right(&u);
+      sc_half(&x1);
+    }
+    while (!(v.d[0] & 1)) {
+      sc_shift_right(&v);
+      sc_half(&x2);
+    }
+    if (sc_less(&u, &v)) {
+      sc_sub_raw(&v, &v, &u);
+      sc_sub(&x2, &x2, &x1);
+    } else {
+      sc_sub_raw(&u, &u, &v);
+      sc_sub(&x1, &x1, &x2);
+    }
+  }
+  *r = sc_is_one(&u) ? x1 : x2;
+}
+
+// r = round(a * b / 2^384)
+static void sc_mul_shift_384(sc_t* r, const sc_t* a, const sc_t* b) {
+  uint64_t t[8];
+  sc_mul_512(t, a, b);
+  r->d[0] = t[6];
+  r->d[1] = t[7];
+  r->d[2] = r->d[3] = 0;
+  if (t[5] >> 63 && !++r->d[0]) r->d[1]++;
+}
+
+// splits k into r1 + r2 * lambda, where both are about 128 bits (or the negative of it).
+static void sc_split_lambda(sc_t* r1, sc_t* r2, const sc_t* k) {
+  sc_t c1, c2;
+  sc_mul_shift_384(&c1, k, &sc_g1);
+  sc_mul_shift_384(&c2, k, &sc_g2);
+  sc_mul(&c1, &c1, &sc_minus_b1);
+  sc_mul(&c2, &c2, &sc_minus_b2);
+  sc_add(r2, &c1, &c2);
+  sc_mul(r1, r2, &sc_minus_lambda);
+  sc_add(r1, r1, k);
+}
+
+// writes the wNAF of the scalar and returns its length.
+// if the scalar is above n/2, its negative is used, so the point needs to be negated.
+static int sc_wnaf(int8_t* wnaf, const sc_t* s, int w, bool* negated) {
+  sc_t k = *s;
+  int  len = 0;
+  *negated = sc_less(&sc_n_half, &k);
+  if (*negated) sc_negate(&k, &k);
+
+  while (!sc_is_zero(&k)) {
+    int digit = 0;
+    if (k.d[0] & 1) {
+      digit = (int) (k.d[0] & ((1 << w) - 1));
+      if (digit >= (1 << (w - 1))) digit -= 1 << w;
+      // remove the digit, so the lowest w bits become 0.
+      sc_t d = {{(uint64_t)(digit < 0 ? -digit : digit), 0, 0, 0}};
+      if (digit < 0)
+        sc_add_raw(&k, &k, &d);
+      else
+        sc_sub_raw(&k, &k, &d);
+    }
+    wnaf[len++] = (int8_t) digit;
+    sc_shift_right(&k);
+  }
+  return len;
+}
+
+// -- group operations --
+
+static void gej_double(gej_t* r, const gej_t* a) {
+  if (a->infinity) {
+    r->infinity = true;
+    return;
+  }
+  // dbl-2009-l
+  fe_t A, B, C, D, E, F, t;
+  fe_sqr(&A, &a->x);
+  fe_sqr(&B, &a->y);
+  fe_sqr(&C, &B);
+  fe_add(&t, &a->x, &B);
+  fe_sqr(&t, &t);
+  fe_sub(&t, &t, &A);
+  fe_sub(&t, &t, &C);
+  fe_add(&D, &t, &t);
+  fe_add(&E, &A, &A);
+  fe_add(&E, &E, &A);
+  fe_sqr(&F, &E);
+  fe_mul(&r->z, &a->y, &a->z);
+  fe_add(&r->z, &r->z, &r->z);
+  fe_add(&t, &D, &D);
+  fe_sub(&r->x, &F, &t);
+  fe_sub(&t, &D, &r->x);
+  fe_mul(&t, &E, &t);
+  fe_add(&C, &C, &C);
+  fe_add(&C, &C, &C);
+  fe_add(&C, &C, &C);
+  fe_sub(&r->y, &t, &C);
+  r->infinity = false;
+}
+
+// r = a + b, where bz may be NULL, if b is affine.
+static void gej_add(gej_t* r, const gej_t* a, const fe_t* bx, const fe_t* by, const fe_t* bz) {
+  if (a->infinity) {
+    r->x        = *bx;
+    r->y        = *by;
+    r->z        = bz ? *bz : fe_one;
+    r->infinity = false;
+    return;
+  }
+  fe_t z1z1, u1, u2, s1, s2, h, rr, h2, h3, t;
+  fe_sqr(&z1z1, &a->z);
+  if (bz) {
+    fe_t z2z2;
+    fe_sqr(&z2z2, bz);
+    fe_mul(&u1, &a->x, &z2z2);
+    fe_mul(&s1, &a->y, bz);
+    fe_mul(&s1, &s1, &z2z2);
+  } else {
+    u1 = a->x;
+    s1 = a->y;
+  }
+  fe_mul(&u2, bx, &z1z1);
+  fe_mul(&s2, by, &a->z);
+  fe_mul(&s2, &s2, &z1z1);
+  fe_sub(&h, &u2, &u1);
+  fe_sub(&rr, &s2, &s1);
+  if (fe_is_zero(&h)) {
+    if (fe_is_zero(&rr))
+      gej_double(r, a);
+    else
+      r->infinity = true;
+    return;
+  }
+  fe_sqr(&h2, &h);
+  fe_mul(&h3, &h2, &h);
+  fe_mul(&u1, &u1, &h2);
+  fe_mul(&r->z, &a->z, &h);
+  if (bz) fe_mul(&r->z, &r->z, bz);
+  fe_sqr(&t, &rr);
+  fe_sub(&t, &t, &h3);
+  fe_sub(&t, &t, &u1);
+  fe_sub(&r->x, &t, &u1);
+  fe_sub(&t, &u1, &r->x);
+  fe_mul(&t, &t, &rr);
+  fe_mul(&s1, &s1, &h3);
+  fe_sub(&r->y, &t, &s1);
+  r->infinity = false;
+}
+
+// -- recovery --
+
+int secp256k1_recover_pub_from_sig(uint8_t* pub_key, const uint8_t* sig, const uint8_t* digest, int recid) {
+  sc_t r, s, e, k[4];
+  sc_from_be(&r, sig);
+  sc_from_be(&s, sig + 32);
+  if (sc_is_zero(&r) || !sc_less(&r, &sc_n) || sc_is_zero(&s) || !sc_less(&s, &sc_n)) return 1;
+
+  // R = (x, y) with x = r (+ n) and the parity of y taken from the recid
+  ge_t R;
+  fe_t t;
+  sc_t x = r;
+  if ((recid & 2) && (sc_add_raw(&x, &x, &sc_n) || (x.d[3] == UINT64_MAX && x.d[2] == UINT64_MAX && x.d[1] == UINT64_MAX && x.d[0] >= FE_P0))) return 1;
+  memcpy(R.x.n, x.d, sizeof(R.x.n));
+  fe_sqr(&t, &R.x);
+  fe_mul(&t, &t, &R.x);
+  fe_add(&t, &t, &fe_b);
+  fe_pow(&R.y, &t, true);
+  fe_t y2;
+  fe_sqr(&y2, &R.y);
+  if (!fe_equal(&y2, &t)) return 1; // x is not on the curve
+  fe_normalize(&R.y);
+  if ((R.y.n[0] & 1) != (uint64_t)(recid & 1)) {
+    fe_negate(&R.y, &R.y);
+    fe_normalize(&R.y);
+  }
+
+  // Pub = r^-1 * (s*R - e*G) = u1*G + u2*R with u1 = -e/r and u2 = s/r
+  sc_from_be(&e, digest);
+  if (!sc_less(&e, &sc_n)) sc_sub_raw(&e, &e, &sc_n);
+  sc_negate(&e, &e);
+  sc_inverse(&r, &r);
+  sc_mul(&e, &e, &r);
+  sc_mul(&s, &s, &r);
+
+  // both factors are split into 2 halfs of 128 bit, so we need to go through only 128 bits for the four points G, lambda*G, R, lambda*R.
+  int8_t wnaf[4][WNAF_MAX];
+  bool   negated[4];
+  int    len[4], max_len = 0;
+  sc_split_lambda(k, k + 1, &e);
+  sc_split_lambda(k + 2, k + 3, &s);
+  for (int i = 0; i < 4; i++) {
+    len[i] = sc_wnaf(wnaf[i], k + i, i < 2 ? WINDOW_G : WINDOW_R, negated + i);
+    if (len[i] > max_len) max_len = len[i];
+  }
+
+  // the odd multiples of R and lambda*R
+  gej_t r_table[TABLE_SIZE(WINDOW_R)], r2;
+  fe_t  lambda_x[TABLE_SIZE(WINDOW_R)];
+  r_table[0] = (gej_t){.x = R.x, .y = R.y, .z = fe_one, .infinity = false};
+  gej_double(&r2, r_table);
+  for (int i = 1; i < TABLE_SIZE(WINDOW_R); i++) gej_add(r_table + i, r_table + i - 1, &r2.x, &r2.y, &r2.z);
+  for (int i = 0; i < TABLE_SIZE(WINDOW_R); i++) fe_mul(lambda_x + i, &r_table[i].x, &fe_beta);
+
+  gej_t res = {.infinity = true};
+  for (int bit = max_len - 1; bit >= 0; bit--) {
+    gej_double(&res, &res);
+    for (int i = 0; i < 4; i++) {
+      int digit = bit < len[i] ? wnaf[i][bit] : 0;
+      if (!digit) continue;
+      int        index = (digit < 0 ? -digit : digit) >> 1;
+      const fe_t *px, *py, *pz;
+      fe_t       lx, ny;
+      if (i < 2) {
+        px = &g_table[index].x;
+        py = &g_table[index].y;
+        pz = NULL;
+      } else {
+        px = i == 3 ? lambda_x + index : &r_table[index].x;
+        py = &r_table[index].y;
+        pz = &r_table[index].z;
+      }
+      if (i == 1) {
+        fe_mul(&lx, px, &fe_beta);
+        px = &lx;
+      }
+      if ((digit < 0) != negated[i]) {
+        fe_negate(&ny, py);
+        py = &ny;
+      }
+      gej_add(&res, &res, px, py, pz);
+    }
+  }
+  if (res.infinity) return 1;
+
+  // back to affine coordinates
+  fe_t zi, zi2;
+  fe_pow(&zi, &res.z, false);
+  fe_sqr(&zi2, &zi);
+  fe_mul(&res.x, &res.x, &zi2);
+  fe_mul(&res.y, &res.y, &zi2);
+  fe_mul(&res.y, &res.y, &zi);
+  fe_normalize(&res.x);
+  fe_normalize(&res.y);
+  pub_key[0] = 0x04;
+  fe_to_be(&res.x, pub_key + 1);
+  fe_to_be(&res.y, pub_key + 33);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ *
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ *
+ *
+ * COMMERCIAL LICENSE USAGE
+ *
+ * Licensees holding a valid commercial license may use this file in accordance
+ * with the commercial license agreement provided with the Software or, alternatively,
+ * in accordance with the terms contained in a written agreement between you and
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further
+ * information please contact slock.it at in3@slock.it.
+ *
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *
+ * AGPL LICENSE USAGE
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available
+ * complete source code of licensed works and modifications, which include larger
+ * works using a licensed work, under the same license. Copyright and license notices
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+/** @file
+ * public key recovery for secp256k1 using 64bit limbs.
+ *
+ * This is only available if the library is built with `-DSECP256K1_64BIT`, which requires a compiler supporting `__int128`.
+ * The field and scalar arithmetic uses 4 limbs of 64 bit and the recovery computes `u1*G + u2*R` in one pass,
+ * splitting both scalars with the GLV endomorphism and walking them as wNAF.
+ *
+ * The result is the same as with `ecdsa_recover_pub_from_sig`, but all operations are variable time,
+ * so this must only be used with public data and never for signing.
+ * */
+
+#ifndef SECP256K1_64_H
+#define SECP256K1_64_H
+
+#include <stdint.h>
+
+/**
+ * recovers the uncompressed public key (65 bytes, starting with 0x04) from a secp256k1 signature.
+ *
+ * @returns 0 on success or 1 if the signature is invalid.
+ */
+int secp256k1_recover_pub_from_sig(
+    uint8_t*       pub_key, /**< [out] the public key (65 bytes) */
+    const uint8_t* sig,     /**< r and s (64 bytes) */
+    const uint8_t* digest,  /**< the signed hash (32 bytes) */
+    int            recid /**< the recovery id (0-3) */);
+
+#endif
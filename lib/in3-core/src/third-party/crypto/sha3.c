@@ -23,6 +23,20 @@
 #include "sha3.h"
 #include "memzero.h"
 
+/* number of messages keccak_256_multi hashes in parallel, which depends on the SIMD registers the compiler targets. */
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define KECCAK_LANES 8
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define KECCAK_LANES 4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define KECCAK_LANES 2
+#else
+#define KECCAK_LANES 1
+#endif
+
 #define I64(x) x##LL
 #define ROTL64(qword, n) ((qword) << (n) ^ ((qword) >> (64 - (n))))
 #define le2me_64(x) (x)
@@ -93,117 +107,224 @@ void sha3_512_Init(SHA3_CTX *ctx)
 	keccak_Init(ctx, 512);
 }
 
-/* Keccak theta() transformation */
-static void keccak_theta(uint64_t *A)
-{
-	unsigned int x;
-	uint64_t C[5], D[5];
-
-	for (x = 0; x < 5; x++) {
-		C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
-	}
-	D[0] = ROTL64(C[1], 1) ^ C[4];
-	D[1] = ROTL64(C[2], 1) ^ C[0];
-	D[2] = ROTL64(C[3], 1) ^ C[1];
-	D[3] = ROTL64(C[4], 1) ^ C[2];
-	D[4] = ROTL64(C[0], 1) ^ C[3];
-
-	for (x = 0; x < 5; x++) {
-		A[x]      ^= D[x];
-		A[x + 5]  ^= D[x];
-		A[x + 10] ^= D[x];
-		A[x + 15] ^= D[x];
-		A[x + 20] ^= D[x];
-	}
-}
+/*
+ * Keccak-f[1600] is written once as an unrolled round over 25 named lanes (rows b, g, k, m, s
+ * and columns a, e, i, o, u). The round is instantiated for 64 bit words as well as for SIMD
+ * registers, which hold the same lane of several independent states.
+ *
+ * Lanes 1, 2, 8, 12, 17 and 20 are kept complemented while the rounds are running
+ * ("lane complementing"), which leaves only one NOT per row in chi.
+ * XOR, AND, OR, NOT, ROL, CONST, LOAD and STORE must be defined before using the macros.
+ */
+#define KECCAK_DECLARE(V, A)             \
+	V A##ba, A##be, A##bi, A##bo, A##bu; \
+	V A##ga, A##ge, A##gi, A##go, A##gu; \
+	V A##ka, A##ke, A##ki, A##ko, A##ku; \
+	V A##ma, A##me, A##mi, A##mo, A##mu; \
+	V A##sa, A##se, A##si, A##so, A##su;
+
+#define KECCAK_LOAD(A, st)     \
+	A##ba = LOAD(st, 0);       \
+	A##be = NOT(LOAD(st, 1));  \
+	A##bi = NOT(LOAD(st, 2));  \
+	A##bo = LOAD(st, 3);       \
+	A##bu = LOAD(st, 4);       \
+	A##ga = LOAD(st, 5);       \
+	A##ge = LOAD(st, 6);       \
+	A##gi = LOAD(st, 7);       \
+	A##go = NOT(LOAD(st, 8));  \
+	A##gu = LOAD(st, 9);       \
+	A##ka = LOAD(st, 10);      \
+	A##ke = LOAD(st, 11);      \
+	A##ki = NOT(LOAD(st, 12)); \
+	A##ko = LOAD(st, 13);      \
+	A##ku = LOAD(st, 14);      \
+	A##ma = LOAD(st, 15);      \
+	A##me = LOAD(st, 16);      \
+	A##mi = NOT(LOAD(st, 17)); \
+	A##mo = LOAD(st, 18);      \
+	A##mu = LOAD(st, 19);      \
+	A##sa = NOT(LOAD(st, 20)); \
+	A##se = LOAD(st, 21);      \
+	A##si = LOAD(st, 22);      \
+	A##so = LOAD(st, 23);      \
+	A##su = LOAD(st, 24);
+
+#define KECCAK_STORE(A, st)    \
+	STORE(st, 0, A##ba);       \
+	STORE(st, 1, NOT(A##be));  \
+	STORE(st, 2, NOT(A##bi));  \
+	STORE(st, 3, A##bo);       \
+	STORE(st, 4, A##bu);       \
+	STORE(st, 5, A##ga);       \
+	STORE(st, 6, A##ge);       \
+	STORE(st, 7, A##gi);       \
+	STORE(st, 8, NOT(A##go));  \
+	STORE(st, 9, A##gu);       \
+	STORE(st, 10, A##ka);      \
+	STORE(st, 11, A##ke);      \
+	STORE(st, 12, NOT(A##ki)); \
+	STORE(st, 13, A##ko);      \
+	STORE(st, 14, A##ku);      \
+	STORE(st, 15, A##ma);      \
+	STORE(st, 16, A##me);      \
+	STORE(st, 17, NOT(A##mi)); \
+	STORE(st, 18, A##mo);      \
+	STORE(st, 19, A##mu);      \
+	STORE(st, 20, NOT(A##sa)); \
+	STORE(st, 21, A##se);      \
+	STORE(st, 22, A##si);      \
+	STORE(st, 23, A##so);      \
+	STORE(st, 24, A##su);
+
+#define KECCAK_ROUND(A, E, rc)                                  \
+	Ca = XOR(XOR(XOR(XOR(A##ba, A##ga), A##ka), A##ma), A##sa); \
+	Ce = XOR(XOR(XOR(XOR(A##be, A##ge), A##ke), A##me), A##se); \
+	Ci = XOR(XOR(XOR(XOR(A##bi, A##gi), A##ki), A##mi), A##si); \
+	Co = XOR(XOR(XOR(XOR(A##bo, A##go), A##ko), A##mo), A##so); \
+	Cu = XOR(XOR(XOR(XOR(A##bu, A##gu), A##ku), A##mu), A##su); \
+	Da = XOR(Cu, ROL(Ce, 1));                                   \
+	De = XOR(Ca, ROL(Ci, 1));                                   \
+	Di = XOR(Ce, ROL(Co, 1));                                   \
+	Do = XOR(Ci, ROL(Cu, 1));                                   \
+	Du = XOR(Co, ROL(Ca, 1));                                   \
+	Ba = XOR(A##ba, Da);                                        \
+	Be = ROL(XOR(A##ge, De), 44);                               \
+	Bi = ROL(XOR(A##ki, Di), 43);                               \
+	Bo = ROL(XOR(A##mo, Do), 21);                               \
+	Bu = ROL(XOR(A##su, Du), 14);                               \
+	E##ba = XOR(XOR(Ba, OR(Be, Bi)), CONST(rc));                \
+	E##be = XOR(Be, OR(NOT(Bi), Bo));                           \
+	E##bi = XOR(Bi, AND(Bo, Bu));                               \
+	E##bo = XOR(Bo, OR(Bu, Ba));                                \
+	E##bu = XOR(Bu, AND(Ba, Be));                               \
+	Ba = ROL(XOR(A##bo, Do), 28);                               \
+	Be = ROL(XOR(A##gu, Du), 20);                               \
+	Bi = ROL(XOR(A##ka, Da), 3);                                \
+	Bo = ROL(XOR(A##me, De), 45);                               \
+	Bu = ROL(XOR(A##si, Di), 61);                               \
+	E##ga = XOR(Ba, OR(Be, Bi));                                \
+	E##ge = XOR(Be, AND(Bi, Bo));                               \
+	E##gi = XOR(Bi, OR(Bo, NOT(Bu)));                           \
+	E##go = XOR(Bo, OR(Bu, Ba));                                \
+	E##gu = XOR(Bu, AND(Ba, Be));                               \
+	Ba = ROL(XOR(A##be, De), 1);                                \
+	Be = ROL(XOR(A##gi, Di), 6);                                \
+	Bi = ROL(XOR(A##ko, Do), 25);                               \
+	Bo = ROL(XOR(A##mu, Du), 8);                                \
+	Bu = ROL(XOR(A##sa, Da), 18);                               \
+	E##ka = XOR(Ba, OR(Be, Bi));                                \
+	E##ke = XOR(Be, AND(Bi, Bo));                               \
+	E##ki = XOR(Bi, AND(NOT(Bo), Bu));                          \
+	E##ko = XOR(NOT(Bo), OR(Bu, Ba));                           \
+	E##ku = XOR(Bu, AND(Ba, Be));                               \
+	Ba = ROL(XOR(A##bu, Du), 27);                               \
+	Be = ROL(XOR(A##ga, Da), 36);                               \
+	Bi = ROL(XOR(A##ke, De), 10);                               \
+	Bo = ROL(XOR(A##mi, Di), 15);                               \
+	Bu = ROL(XOR(A##so, Do), 56);                               \
+	E##ma = XOR(Ba, AND(Be, Bi));                               \
+	E##me = XOR(Be, OR(Bi, Bo));                                \
+	E##mi = XOR(Bi, OR(NOT(Bo), Bu));                           \
+	E##mo = XOR(NOT(Bo), AND(Bu, Ba));                          \
+	E##mu = XOR(Bu, OR(Ba, Be));                                \
+	Ba = ROL(XOR(A##bi, Di), 62);                               \
+	Be = ROL(XOR(A##go, Do), 55);                               \
+	Bi = ROL(XOR(A##ku, Du), 39);                               \
+	Bo = ROL(XOR(A##ma, Da), 41);                               \
+	Bu = ROL(XOR(A##se, De), 2);                                \
+	E##sa = XOR(Ba, AND(NOT(Be), Bi));                          \
+	E##se = XOR(NOT(Be), OR(Bi, Bo));                           \
+	E##si = XOR(Bi, AND(Bo, Bu));                               \
+	E##so = XOR(Bo, OR(Bu, Ba));                                \
+	E##su = XOR(Bu, AND(Ba, Be));                               \
+
+
+#define KECCAK_PERMUTE(V, st)                                       \
+	KECCAK_DECLARE(V, A)                                            \
+	KECCAK_DECLARE(V, E)                                            \
+	V   Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du, Ba, Be, Bi, Bo, Bu; \
+	int round;                                                      \
+	KECCAK_LOAD(A, st)                                              \
+	for (round = 0; round < NumberOfRounds; round += 2) {           \
+		KECCAK_ROUND(A, E, keccak_round_constants[round])              \
+		KECCAK_ROUND(E, A, keccak_round_constants[round + 1])          \
+	}                                                               \
+	KECCAK_STORE(A, st)
+
+#define XOR(a, b) ((a) ^ (b))
+#define AND(a, b) ((a) & (b))
+#define OR(a, b) ((a) | (b))
+#define NOT(a) (~(a))
+#define ROL(a, n) ROTL64(a, n)
+#define CONST(c) (c)
+#define LOAD(st, i) (st)[i]
+#define STORE(st, i, v) (st)[i] = (v)
 
-/* Keccak pi() transformation */
-static void keccak_pi(uint64_t *A)
+static void sha3_permutation(uint64_t *state)
 {
-	uint64_t A1;
-	A1 = A[1];
-	A[ 1] = A[ 6];
-	A[ 6] = A[ 9];
-	A[ 9] = A[22];
-	A[22] = A[14];
-	A[14] = A[20];
-	A[20] = A[ 2];
-	A[ 2] = A[12];
-	A[12] = A[13];
-	A[13] = A[19];
-	A[19] = A[23];
-	A[23] = A[15];
-	A[15] = A[ 4];
-	A[ 4] = A[24];
-	A[24] = A[21];
-	A[21] = A[ 8];
-	A[ 8] = A[16];
-	A[16] = A[ 5];
-	A[ 5] = A[ 3];
-	A[ 3] = A[18];
-	A[18] = A[17];
-	A[17] = A[11];
-	A[11] = A[ 7];
-	A[ 7] = A[10];
-	A[10] = A1;
-	/* note: A[ 0] is left as is */
+	KECCAK_PERMUTE(uint64_t, state)
 }
 
-/* Keccak chi() transformation */
-static void keccak_chi(uint64_t *A)
-{
-	int i;
-	for (i = 0; i < 25; i += 5) {
-		uint64_t A0 = A[0 + i], A1 = A[1 + i];
-		A[0 + i] ^= ~A1 & A[2 + i];
-		A[1 + i] ^= ~A[2 + i] & A[3 + i];
-		A[2 + i] ^= ~A[3 + i] & A[4 + i];
-		A[3 + i] ^= ~A[4 + i] & A0;
-		A[4 + i] ^= ~A0 & A1;
-	}
-}
+#undef XOR
+#undef AND
+#undef OR
+#undef NOT
+#undef ROL
+#undef CONST
+#undef LOAD
+#undef STORE
+
+#if USE_KECCAK && KECCAK_LANES > 1
+/* the multi-buffer state keeps the same lane of all states next to each other: state[i * KECCAK_LANES + lane] */
+#if KECCAK_LANES == 8
+#define XOR(a, b) _mm512_xor_si512(a, b)
+#define AND(a, b) _mm512_and_si512(a, b)
+#define OR(a, b) _mm512_or_si512(a, b)
+#define NOT(a) _mm512_xor_si512(a, _mm512_set1_epi64(-1))
+#define ROL(a, n) _mm512_rol_epi64(a, n)
+#define CONST(c) _mm512_set1_epi64((long long) (c))
+#define LOAD(st, i) _mm512_loadu_si512((const void*) ((st) + 8 * (i)))
+#define STORE(st, i, v) _mm512_storeu_si512((void*) ((st) + 8 * (i)), v)
+#define KECCAK_VECTOR __m512i
+#elif KECCAK_LANES == 4
+#define XOR(a, b) _mm256_xor_si256(a, b)
+#define AND(a, b) _mm256_and_si256(a, b)
+#define OR(a, b) _mm256_or_si256(a, b)
+#define NOT(a) _mm256_xor_si256(a, _mm256_set1_epi64x(-1))
+#define ROL(a, n) _mm256_or_si256(_mm256_slli_epi64(a, n), _mm256_srli_epi64(a, 64 - (n)))
+#define CONST(c) _mm256_set1_epi64x((long long) (c))
+#define LOAD(st, i) _mm256_loadu_si256((const __m256i*) ((st) + 4 * (i)))
+#define STORE(st, i, v) _mm256_storeu_si256((__m256i*) ((st) + 4 * (i)), v)
+#define KECCAK_VECTOR __m256i
+#else
+#define XOR(a, b) veorq_u64(a, b)
+#define AND(a, b) vandq_u64(a, b)
+#define OR(a, b) vorrq_u64(a, b)
+#define NOT(a) veorq_u64(a, vdupq_n_u64(~(uint64_t) 0))
+#define ROL(a, n) vorrq_u64(vshlq_n_u64(a, n), vshrq_n_u64(a, 64 - (n)))
+#define CONST(c) vdupq_n_u64(c)
+#define LOAD(st, i) vld1q_u64((st) + 2 * (i))
+#define STORE(st, i, v) vst1q_u64((st) + 2 * (i), v)
+#define KECCAK_VECTOR uint64x2_t
+#endif
 
-static void sha3_permutation(uint64_t *state)
+static void keccak_permutation_multi(uint64_t *state)
 {
-	int round;
-	for (round = 0; round < NumberOfRounds; round++)
-	{
-		keccak_theta(state);
-
-		/* apply Keccak rho() transformation */
-		state[ 1] = ROTL64(state[ 1],  1);
-		state[ 2] = ROTL64(state[ 2], 62);
-		state[ 3] = ROTL64(state[ 3], 28);
-		state[ 4] = ROTL64(state[ 4], 27);
-		state[ 5] = ROTL64(state[ 5], 36);
-		state[ 6] = ROTL64(state[ 6], 44);
-		state[ 7] = ROTL64(state[ 7],  6);
-		state[ 8] = ROTL64(state[ 8], 55);
-		state[ 9] = ROTL64(state[ 9], 20);
-		state[10] = ROTL64(state[10],  3);
-		state[11] = ROTL64(state[11], 10);
-		state[12] = ROTL64(state[12], 43);
-		state[13] = ROTL64(state[13], 25);
-		state[14] = ROTL64(state[14], 39);
-		state[15] = ROTL64(state[15], 41);
-		state[16] = ROTL64(state[16], 45);
-		state[17] = ROTL64(state[17], 15);
-		state[18] = ROTL64(state[18], 21);
-		state[19] = ROTL64(state[19],  8);
-		state[20] = ROTL64(state[20], 18);
-		state[21] = ROTL64(state[21],  2);
-		state[22] = ROTL64(state[22], 61);
-		state[23] = ROTL64(state[23], 56);
-		state[24] = ROTL64(state[24], 14);
-
-		keccak_pi(state);
-		keccak_chi(state);
-
-		/* apply iota(state, round) */
-		*state ^= keccak_round_constants[round];
-	}
+	KECCAK_PERMUTE(KECCAK_VECTOR, state)
 }
 
+#undef XOR
+#undef AND
+#undef OR
+#undef NOT
+#undef ROL
+#undef CONST
+#undef LOAD
+#undef STORE
+#undef KECCAK_VECTOR
+#endif /* USE_KECCAK && KECCAK_LANES > 1 */
+
 /**
  * The core transformation. Process the specified block of data.
  *
@@ -378,6 +499,75 @@ void keccak_512(const unsigned char* data, size_t len, unsigned char* digest)
 	keccak_Update(&ctx, data, len);
 	keccak_Final(&ctx, digest);
 }
+
+/**
+ * Calculate the keccak-256 hashes of independent messages.
+ * The messages are spread over the lanes of the multi-buffer permutation
+ * and as soon as a message is finished, the next one takes over its lane.
+ *
+ * @param count number of messages
+ * @param data the messages
+ * @param len the length of each message
+ * @param digest receives the 32 byte hash of each message
+ */
+void keccak_256_multi(size_t count, const unsigned char* const* data, const size_t* len, unsigned char* digest)
+{
+#if KECCAK_LANES > 1
+	uint64_t state[25 * KECCAK_LANES], block[SHA3_256_BLOCK_LENGTH / 8], word;
+	size_t msg[KECCAK_LANES], pos[KECCAK_LANES], next = 0, left = count, lane, i;
+
+	if (count < 2) {
+		if (count) keccak_256(data[0], len[0], digest);
+		return;
+	}
+
+	/* a lane without a message points to count */
+	memset(state, 0, sizeof(state));
+	for (lane = 0; lane < KECCAK_LANES; lane++) {
+		msg[lane] = next < count ? next++ : count;
+		pos[lane] = 0;
+	}
+
+	while (left) {
+		for (lane = 0; lane < KECCAK_LANES; lane++) {
+			size_t rest;
+			if (msg[lane] == count) continue;
+			rest = len[msg[lane]] - pos[lane];
+			if (rest >= SHA3_256_BLOCK_LENGTH)
+				memcpy(block, data[msg[lane]] + pos[lane], SHA3_256_BLOCK_LENGTH);
+			else {
+				/* the final block with the keccak padding */
+				memset(block, 0, SHA3_256_BLOCK_LENGTH);
+				if (rest) memcpy(block, data[msg[lane]] + pos[lane], rest);
+				((unsigned char*)block)[rest] |= 0x01;
+				((unsigned char*)block)[SHA3_256_BLOCK_LENGTH - 1] |= 0x80;
+			}
+			for (i = 0; i < SHA3_256_BLOCK_LENGTH / 8; i++)
+				state[i * KECCAK_LANES + lane] ^= le2me_64(block[i]);
+			pos[lane] += SHA3_256_BLOCK_LENGTH;
+		}
+
+		keccak_permutation_multi(state);
+
+		for (lane = 0; lane < KECCAK_LANES; lane++) {
+			/* only after the padded block the position is behind the message */
+			if (msg[lane] == count || pos[lane] <= len[msg[lane]]) continue;
+			for (i = 0; i < sha3_256_hash_size / 8; i++) {
+				word = state[i * KECCAK_LANES + lane];
+				me64_to_le_str(digest + msg[lane] * sha3_256_hash_size + i * 8, &word, 8);
+			}
+			for (i = 0; i < 25; i++) state[i * KECCAK_LANES + lane] = 0;
+			msg[lane] = next < count ? next++ : count;
+			pos[lane] = 0;
+			left--;
+		}
+	}
+#else
+	size_t i;
+	for (i = 0; i < count; i++)
+		keccak_256(data[i], len[i], digest + i * sha3_256_hash_size);
+#endif
+}
 #endif /* USE_KECCAK */
 
 void sha3_256(const unsigned char* data, size_t len, unsigned char* digest)
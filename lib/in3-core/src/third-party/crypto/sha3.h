@@ -78,6 +78,8 @@ void sha3_Final(SHA3_CTX *ctx, unsigned char* result);
 void keccak_Final(SHA3_CTX *ctx, unsigned char* result);
 void keccak_256(const unsigned char* data, size_t len, unsigned char* digest);
 void keccak_512(const unsigned char* data, size_t len, unsigned char* digest);
+/* hashes count independent messages at once and writes 32 bytes for each of them to digest */
+void keccak_256_multi(size_t count, const unsigned char* const* data, const size_t* len, unsigned char* digest);
 #endif
 
 void sha3_256(const unsigned char* data, size_t len, unsigned char* digest);
@@ -34,15 +34,58 @@
 
 #include "in3_curl.h"
 #include "../../core/client/client.h"
+#include "../../core/client/context.h"
 #include "../../core/util/log.h"
+#include "../../core/util/mem.h"
 #include "../../core/util/utils.h"
 #include <curl/curl.h>
+#include <stdio.h>
 #include <string.h>
 
 #ifndef CURL_MAX_PARALLEL
 #define CURL_MAX_PARALLEL 50
 #endif
 
+#ifndef CURL_MAX_IDLE_HANDLES
+#define CURL_MAX_IDLE_HANDLES 8 // max number of idle easy handles kept per host
+#endif
+
+/** a list of idle easy handles which were used for the same host. */
+typedef struct curl_host {
+  char*             host;                        /**< scheme, host and port of the url */
+  CURL*             idle[CURL_MAX_IDLE_HANDLES]; /**< easy handles ready to be reused */
+  int               idle_len;                    /**< number of idle handles */
+  struct curl_host* next;                        /**< next host in the linked list */
+} curl_host_t;
+
+/** a running transfer */
+typedef struct curl_transfer {
+  CURL*                handle;  /**< the easy handle */
+  curl_host_t*         host;    /**< the host the handle will be returned to */
+  uint64_t             start;   /**< the time in ms when the transfer was started */
+  struct curl_request* request; /**< the request this transfer belongs to */
+} curl_transfer_t;
+
+/** a request sent with the pool, which has one transfer for each url */
+typedef struct curl_request {
+  in3_request_t*       req;       /**< the request */
+  curl_transfer_t*     transfers; /**< the transfers (one for each url) */
+  int                  started;   /**< number of transfers started */
+  int                  running;   /**< number of transfers still running */
+  uint64_t             deadline;  /**< the time in ms when all transfers must be finished (0 = no timeout) */
+  bool                 verified;  /**< true if one of the responses was verified */
+  struct curl_request* next;      /**< next request in the linked list */
+} curl_request_t;
+
+/** the connection pool kept in the client as transport_data */
+typedef struct curl_pool {
+  CURLM*             multi;    /**< the multi handle holding the connection cache */
+  struct curl_slist* headers;  /**< the http-headers used for all requests */
+  curl_host_t*       hosts;    /**< linked list of hosts */
+  curl_request_t*    requests; /**< linked list of requests sent, but not yet finished */
+  in3_curl_stats_t   stats;    /**< statistics */
+} curl_pool_t;
+
 /*
 struct MemoryStruct {
   char *memory = NULL;
@@ -55,86 +98,37 @@ static size_t WriteMemoryCallback(void* contents, size_t size, size_t nmemb, voi
   return size * nmemb;
 }
 
-static void readDataNonBlocking(CURLM* cm, const char* url, const char* payload, struct curl_slist* headers, in3_response_t* r) {
-  CURL*     curl;
-  CURLMcode res;
-
-  curl = curl_easy_init();
-  if (curl) {
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) strlen(payload));
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*) r);
+static void add_timeout_error(in3_response_t* r, CURL* handle, const char* url, bool reused) {
+  double dns = 0, connect = 0, tls = 0;
+  char   time[30];
+  curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME, &dns);
+  curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME, &connect);
+  curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME, &tls);
 
-    /* Perform the request, res will get the return code */
-    res = curl_multi_add_handle(cm, curl);
-    if (res != CURLM_OK) {
-      sb_add_chars(&r->error, "curl_multi_add_handle() failed:");
-      sb_add_chars(&r->error, (char*) curl_easy_strerror(res));
-    }
-  } else
-    sb_add_chars(&r->error, "no curl:");
+  // the times are 0 if the phase has not been finished, but a reused connection does not need to connect.
+  r->timed_out = true;
+  sb_add_chars(&r->error, "timeout while ");
+  if (!reused && dns <= 0)
+    sb_add_chars(&r->error, "resolving the host of ");
+  else if (!reused && connect <= 0)
+    sb_add_chars(&r->error, "connecting to ");
+  else if (!reused && tls <= 0 && strncmp(url, "https:", 6) == 0)
+    sb_add_chars(&r->error, "the tls handshake with ");
+  else
+    sb_add_chars(&r->error, "reading the response from ");
+  sb_add_chars(&r->error, url);
+  sprintf(time, " after %u ms", r->time);
+  sb_add_chars(&r->error, time);
 }
 
-in3_ret_t send_curl_nonblocking(const char** urls, int urls_len, char* payload, in3_response_t* result) {
-  CURLM*   cm;
-  CURLMsg* msg;
-  int      transfers   = 0;
-  int      msgs_left   = -1;
-  int      still_alive = 1;
-
-  cm = curl_multi_init();
-  curl_multi_setopt(cm, CURLMOPT_MAXCONNECTS, (long) CURL_MAX_PARALLEL);
-
-  struct curl_slist* headers = NULL;
-  headers                    = curl_slist_append(headers, "Accept: application/json");
-  headers                    = curl_slist_append(headers, "Content-Type: application/json");
-  headers                    = curl_slist_append(headers, "charsets: utf-8");
-  for (transfers = 0; transfers < min(CURL_MAX_PARALLEL, urls_len); transfers++)
-    readDataNonBlocking(cm, urls[transfers], payload, headers, result + transfers);
-
-  do {
-    curl_multi_perform(cm, &still_alive);
-
-    while ((msg = curl_multi_info_read(cm, &msgs_left))) {
-      if (msg->msg == CURLMSG_DONE) {
-        char* url;
-        CURL* e = msg->easy_handle;
-        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &url);
-        // fprintf(stderr, "R: %d - %s <%s>\n",
-        //        msg->data.result, curl_easy_strerror(msg->data.result), url);
-        curl_multi_remove_handle(cm, e);
-        curl_easy_cleanup(e);
-      } else {
-        // fprintf(stderr, "E: CURLMsg (%d)\n", msg->msg);
-        sb_add_chars(&result->error, "E: CURLMsg");
-      }
-      if (transfers < urls_len) {
-        readDataNonBlocking(cm, urls[transfers], payload, headers, result + transfers);
-        transfers++;
-      }
-    }
-
-    if (still_alive)
-      curl_multi_wait(cm, NULL, 0, 1000, NULL);
-
-  } while (still_alive || (transfers < urls_len));
-
-  curl_slist_free_all(headers);
-  curl_multi_cleanup(cm);
-
-  for (int i = 0; i < urls_len; i++) {
-    if ((result + i)->error.len) {
-      in3_log_debug("curl: failed for %s\n", urls[i]);
-      return IN3_ETRANS; // return error if even one failed
-    }
-  }
-  return IN3_OK;
+static void set_timeout(CURL* handle, uint32_t timeout) {
+  // the connect timeout covers the dns lookup, the tcp connect and the tls handshake, the timeout the whole transfer.
+  curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, (long) timeout);
+  curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, (long) timeout);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
 }
 
-static void readDataBlocking(const char* url, char* payload, in3_response_t* r) {
+static void readDataBlocking(const char* url, char* payload, in3_response_t* r, uint32_t timeout) {
   CURL*    curl;
   CURLcode res;
 
@@ -154,11 +148,16 @@ static void readDataBlocking(const char* url, char* payload, in3_response_t* r)
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*) r);
+    set_timeout(curl, timeout);
 
     /* Perform the request, res will get the return code */
-    res = curl_easy_perform(curl);
+    const uint64_t start = current_ms();
+    res                  = curl_easy_perform(curl);
+    r->time              = (uint32_t)(current_ms() - start);
     /* Check for errors */
-    if (res != CURLE_OK) {
+    if (res == CURLE_OPERATION_TIMEDOUT)
+      add_timeout_error(r, curl, url, false);
+    else if (res != CURLE_OK) {
       sb_add_chars(&r->error, "curl_easy_perform() failed:");
       sb_add_chars(&r->error, (char*) curl_easy_strerror(res));
     }
@@ -170,28 +169,340 @@ static void readDataBlocking(const char* url, char* payload, in3_response_t* r)
     sb_add_chars(&r->error, "no curl:");
 }
 
-in3_ret_t send_curl_blocking(const char** urls, int urls_len, char* payload, in3_response_t* result) {
-  int i;
-  for (i = 0; i < urls_len; i++)
-    readDataBlocking(urls[i], payload, result + i);
-  for (i = 0; i < urls_len; i++) {
-    if ((result + i)->error.len) {
-      in3_log_debug("curl: failed for %s\n", urls[i]);
+static curl_host_t* pool_get_host(curl_pool_t* pool, const char* url) {
+  // the host is defined by the scheme, the hostname and the port.
+  const char* start = strstr(url, "://");
+  const char* end   = start ? strchr(start + 3, '/') : NULL;
+  const int   len   = end ? (int) (end - url) : (int) strlen(url);
+
+  for (curl_host_t* h = pool->hosts; h; h = h->next) {
+    if ((int) strlen(h->host) == len && strncmp(h->host, url, len) == 0) return h;
+  }
+
+  curl_host_t* h = _calloc(1, sizeof(curl_host_t));
+  h->host        = _strdupn(url, len);
+  h->next        = pool->hosts;
+  pool->hosts    = h;
+  return h;
+}
+
+static void pool_release_handle(curl_pool_t* pool, curl_transfer_t* t) {
+  curl_multi_remove_handle(pool->multi, t->handle);
+  if (t->host->idle_len < CURL_MAX_IDLE_HANDLES)
+    t->host->idle[t->host->idle_len++] = t->handle;
+  else
+    curl_easy_cleanup(t->handle);
+  t->handle = NULL;
+}
+
+static void pool_add_transfer(curl_pool_t* pool, curl_transfer_t* t, const char* url, const char* payload, in3_response_t* r, uint64_t deadline) {
+  // transfers started later may only use the time left.
+  const uint64_t now = current_ms();
+  if (deadline && deadline <= now) {
+    r->timed_out = true;
+    sb_add_chars(&r->error, "timeout before sending the request to ");
+    sb_add_chars(&r->error, url);
+    return;
+  }
+
+  t->host   = pool_get_host(pool, url);
+  t->handle = t->host->idle_len ? t->host->idle[--t->host->idle_len] : curl_easy_init();
+  if (!t->handle) {
+    sb_add_chars(&r->error, "no curl:");
+    return;
+  }
+
+  t->start = now;
+  set_timeout(t->handle, deadline ? (uint32_t)(deadline - now) : 0);
+  curl_easy_setopt(t->handle, CURLOPT_URL, url);
+  curl_easy_setopt(t->handle, CURLOPT_POSTFIELDS, payload);
+  curl_easy_setopt(t->handle, CURLOPT_POSTFIELDSIZE, (long) strlen(payload));
+  curl_easy_setopt(t->handle, CURLOPT_HTTPHEADER, pool->headers);
+  curl_easy_setopt(t->handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+  curl_easy_setopt(t->handle, CURLOPT_WRITEDATA, (void*) r);
+  curl_easy_setopt(t->handle, CURLOPT_PRIVATE, (void*) t);
+  curl_easy_setopt(t->handle, CURLOPT_TCP_KEEPALIVE, 1L);
+#ifdef CURL_HTTP_VERSION_2TLS
+  // use http2 if the server supports it and wait for a existing connection in order to multiplex the requests.
+  curl_easy_setopt(t->handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+  curl_easy_setopt(t->handle, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+  CURLMcode res = curl_multi_add_handle(pool->multi, t->handle);
+  if (res != CURLM_OK) {
+    sb_add_chars(&r->error, "curl_multi_add_handle() failed:");
+    sb_add_chars(&r->error, (char*) curl_multi_strerror(res));
+    curl_easy_cleanup(t->handle);
+    t->handle = NULL;
+  }
+}
+
+static in3_ret_t check_results(in3_request_t* req) {
+  for (int i = 0; i < req->urls_len; i++) {
+    if (req->results[i].error.len) {
+      in3_log_debug("curl: failed for %s\n", req->urls[i]);
       return IN3_ETRANS; // return error if even one failed
     }
   }
   return IN3_OK;
 }
 
+static inline bool request_done(const curl_request_t* r) { return r->verified || (!r->running && r->started == r->req->urls_len); }
+
+static void pool_start_transfers(curl_pool_t* pool, curl_request_t* r) {
+  // once a response is verified, there is no need to ask the remaining nodes.
+  while (!r->verified && r->running < CURL_MAX_PARALLEL && r->started < r->req->urls_len) {
+    curl_transfer_t* t = r->transfers + r->started;
+    t->request         = r;
+    pool_add_transfer(pool, t, r->req->urls[r->started], r->req->payload, r->req->results + r->started, r->deadline);
+    r->started++;
+    if (t->handle) r->running++;
+  }
+}
+
+static curl_request_t* pool_send(curl_pool_t* pool, in3_request_t* req) {
+  curl_request_t* r = _calloc(1, sizeof(curl_request_t));
+  r->req            = req;
+  r->transfers      = _calloc(req->urls_len ? req->urls_len : 1, sizeof(curl_transfer_t));
+  r->deadline       = req->timeout ? current_ms() + req->timeout : 0;
+  r->next           = pool->requests;
+  pool->requests    = r;
+  pool_start_transfers(pool, r);
+  return r;
+}
+
+static void pool_cancel(curl_pool_t* pool, curl_request_t* r) {
+  // the handles are kept since they can still be reused.
+  // the responses of cancelled transfers stay empty, but the time they were running is used for the stats,
+  // since the node was at least this slow. Otherwise slow nodes would never get a response time.
+  const uint64_t now = current_ms();
+  for (int i = 0; i < r->started; i++) {
+    if (!r->transfers[i].handle) continue;
+    r->req->results[i].time = (uint32_t)(now - r->transfers[i].start);
+    pool_release_handle(pool, r->transfers + i);
+  }
+  r->running = 0;
+}
+
+static void pool_remove(curl_pool_t* pool, curl_request_t* r) {
+  pool_cancel(pool, r);
+  for (curl_request_t** p = &pool->requests; *p; p = &(*p)->next) {
+    if (*p == r) {
+      *p = r->next;
+      break;
+    }
+  }
+  _free(r->transfers);
+  _free(r);
+}
+
+static void pool_finish_transfer(curl_pool_t* pool, CURLMsg* msg) {
+  curl_transfer_t* t        = NULL;
+  long             connects = 0;
+  curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**) &t);
+  curl_easy_getinfo(msg->easy_handle, CURLINFO_NUM_CONNECTS, &connects);
+
+  curl_request_t* cr  = t->request;
+  in3_request_t*  req = cr->req;
+  const int       i   = t - cr->transfers;
+  in3_response_t* r   = req->results + i;
+  r->time             = (uint32_t)(current_ms() - t->start);
+  if (msg->data.result == CURLE_OPERATION_TIMEDOUT)
+    add_timeout_error(r, msg->easy_handle, req->urls[i], !connects);
+  else if (msg->data.result != CURLE_OK) {
+    sb_add_chars(&r->error, "curl: ");
+    sb_add_chars(&r->error, (char*) curl_easy_strerror(msg->data.result));
+  }
+
+  // a transfer without new connects was using a connection from the cache or multiplexed it.
+  pool->stats.requests++;
+  if (connects)
+    pool->stats.connections += connects;
+  else
+    pool->stats.reused++;
+
+  pool_release_handle(pool, t);
+  cr->running--;
+
+  // as soon as one response is verified, we don't need to wait for the others.
+  if (in3_req_check_response(req, i) == IN3_OK)
+    cr->verified = true;
+  else
+    pool_start_transfers(pool, cr);
+}
+
+static bool pool_read(curl_pool_t* pool) {
+  CURLMsg* msg;
+  int      msgs_left = -1, still_alive = 0;
+  curl_multi_perform(pool->multi, &still_alive);
+
+  // we read all messages, so the responses already received will be used for the stats even if the request is verified.
+  while ((msg = curl_multi_info_read(pool->multi, &msgs_left))) {
+    if (msg->msg == CURLMSG_DONE) pool_finish_transfer(pool, msg);
+  }
+
+  bool done = false;
+  for (curl_request_t* r = pool->requests; r; r = r->next) {
+    if (r->verified && r->running) pool_cancel(pool, r);
+    if (request_done(r)) done = true;
+  }
+  return done || !still_alive;
+}
+
+static void pool_perform(curl_pool_t* pool, uint32_t timeout) {
+  // only if no request could be finished, we wait for the sockets.
+  if (pool_read(pool)) return;
+  curl_multi_wait(pool->multi, NULL, 0, timeout, NULL);
+  pool_read(pool);
+}
+
+IN3_EXPORT_TEST in3_ret_t send_curl_pool(curl_pool_t* pool, in3_request_t* req) {
+  curl_request_t* r = pool_send(pool, req);
+  while (!request_done(r)) pool_perform(pool, 1000);
+
+  const bool verified = r->verified;
+  pool_remove(pool, r);
+  return verified ? IN3_OK : check_results(req);
+}
+
+static in3_ret_t curl_async_send(void* data, in3_request_t* req) {
+  pool_send(data, req);
+  return IN3_OK;
+}
+
+static curl_request_t* pool_next_done(curl_pool_t* pool) {
+  curl_request_t* r = pool->requests;
+  while (r && !request_done(r)) r = r->next;
+  return r;
+}
+
+static in3_request_t* curl_async_wait(void* data, uint32_t timeout) {
+  curl_pool_t*    pool = data;
+  curl_request_t* r    = pool_next_done(pool);
+  if (!r) {
+    pool_perform(pool, timeout);
+    if (!(r = pool_next_done(pool))) return NULL;
+  }
+
+  in3_request_t* req = r->req;
+  pool_remove(pool, r);
+  return req;
+}
+
+static void curl_async_cancel(void* data, in3_request_t* req) {
+  curl_pool_t* pool = data;
+  for (curl_request_t* r = pool->requests; r; r = r->next) {
+    if (r->req == req) {
+      pool_remove(pool, r);
+      return;
+    }
+  }
+}
+
+IN3_EXPORT_TEST curl_pool_t* curl_pool_new() {
+  curl_pool_t* pool = _calloc(1, sizeof(curl_pool_t));
+  pool->multi       = curl_multi_init();
+  pool->headers     = curl_slist_append(pool->headers, "Accept: application/json");
+  pool->headers     = curl_slist_append(pool->headers, "Content-Type: application/json");
+  pool->headers     = curl_slist_append(pool->headers, "charsets: utf-8");
+  curl_multi_setopt(pool->multi, CURLMOPT_MAXCONNECTS, (long) CURL_MAX_PARALLEL);
+#ifdef CURLPIPE_MULTIPLEX
+  curl_multi_setopt(pool->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+  return pool;
+}
+
+IN3_EXPORT_TEST void curl_pool_free(void* data) {
+  curl_pool_t* pool = data;
+  while (pool->requests) pool_remove(pool, pool->requests);
+  while (pool->hosts) {
+    curl_host_t* h = pool->hosts;
+    pool->hosts    = h->next;
+    for (int i = 0; i < h->idle_len; i++) curl_easy_cleanup(h->idle[i]);
+    _free(h->host);
+    _free(h);
+  }
+  curl_multi_cleanup(pool->multi);
+  curl_slist_free_all(pool->headers);
+  _free(pool);
+}
+
+in3_ret_t send_curl_nonblocking(const char** urls, int urls_len, char* payload, in3_response_t* result) {
+  in3_request_t req = {.payload = payload, .urls = (char**) urls, .urls_len = urls_len, .results = result, .ctx = NULL};
+  curl_pool_t*  pool = curl_pool_new();
+  in3_ret_t     res  = send_curl_pool(pool, &req);
+  curl_pool_free(pool);
+  return res;
+}
+
+static in3_ret_t send_curl_blocking_req(in3_request_t* req) {
+  const uint64_t deadline = req->timeout ? current_ms() + req->timeout : 0;
+  for (int i = 0; i < req->urls_len; i++) {
+    // the nodes are asked one after the other, so each one only gets the time left.
+    const uint64_t now = current_ms();
+    if (deadline && deadline <= now) {
+      req->results[i].timed_out = true;
+      sb_add_chars(&req->results[i].error, "timeout before sending the request to ");
+      sb_add_chars(&req->results[i].error, req->urls[i]);
+      continue;
+    }
+    readDataBlocking(req->urls[i], req->payload, req->results + i, deadline ? (uint32_t)(deadline - now) : 0);
+
+    // if the response is already verified, we don't need to ask the next node.
+    if (in3_req_check_response(req, i) == IN3_OK) return IN3_OK;
+  }
+  return check_results(req);
+}
+
+in3_ret_t send_curl_blocking(const char** urls, int urls_len, char* payload, in3_response_t* result) {
+  in3_request_t req = {.payload = payload, .urls = (char**) urls, .urls_len = urls_len, .results = result, .ctx = NULL};
+  return send_curl_blocking_req(&req);
+}
+
 in3_ret_t send_curl(in3_request_t* req) {
-//  char** urls, int urls_len, char* payload, in3_response_t* result
 #ifdef CURL_BLOCKING
-  return send_curl_blocking((const char**) req->urls, req->urls_len, req->payload, req->results);
+  return send_curl_blocking_req(req);
 #else
-  return send_curl_nonblocking((const char**) req->urls, req->urls_len, req->payload, req->results);
+  curl_pool_t* pool = curl_pool_new();
+  in3_ret_t    res  = send_curl_pool(pool, req);
+  curl_pool_free(pool);
+  return res;
 #endif
 }
 
+in3_ret_t send_curl_pooled(in3_request_t* req) {
+  // without a pool in the client, we simply fall back to the default
+  if (!req->ctx || req->ctx->client->transport_free != curl_pool_free) return send_curl(req);
+  return send_curl_pool(req->ctx->client->transport_data, req);
+}
+
+in3_ret_t in3_use_curl_pool(in3_t* c) {
+  if (c->transport_data) {
+    if (c->transport_free == curl_pool_free) return IN3_OK;
+    return IN3_ECONFIG; // some other transport already uses the data
+  }
+  c->transport_data = curl_pool_new();
+  c->transport_free = curl_pool_free;
+  c->transport      = send_curl_pooled;
+  return IN3_OK;
+}
+
+in3_ret_t in3_curl_async_transport(in3_t* c, in3_async_transport_t* transport) {
+  in3_ret_t res = in3_use_curl_pool(c);
+  if (res < 0) return res;
+  transport->send   = curl_async_send;
+  transport->wait   = curl_async_wait;
+  transport->cancel = curl_async_cancel;
+  transport->data   = c->transport_data;
+  return IN3_OK;
+}
+
+in3_ret_t in3_curl_pool_stats(in3_t* c, in3_curl_stats_t* stats) {
+  if (c->transport_free != curl_pool_free || !c->transport_data) return IN3_EFIND;
+  *stats = ((curl_pool_t*) c->transport_data)->stats;
+  return IN3_OK;
+}
+
 /**
  * registers curl as a default transport.
  */
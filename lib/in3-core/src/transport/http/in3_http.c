@@ -43,25 +43,88 @@
 #include <ws2tcpip.h>
 // clang-format on
 #else
+#include <errno.h>      /* errno, EINPROGRESS */
+#include <fcntl.h>      /* fcntl, O_NONBLOCK */
 #include <netdb.h>      /* struct hostent, gethostbyname */
 #include <netinet/in.h> /* struct sockaddr_in, struct sockaddr */
+#include <sys/select.h> /* select */
 #include <sys/socket.h> /* socket, connect */
+#include <sys/time.h>   /* struct timeval */
 #endif
 #include "../../core/client/client.h"
+#include "../../core/client/context.h"
 #include "../../core/util/mem.h"
+#include "../../core/util/utils.h"
 #include "in3_http.h"
 
+#ifndef _WIN32
+static struct timeval time_left(uint64_t deadline) {
+  const uint64_t now  = current_ms();
+  const uint64_t left = deadline > now ? deadline - now : 1;
+  return (struct timeval){.tv_sec = left / 1000, .tv_usec = (left % 1000) * 1000};
+}
+
+static void add_timeout_error(in3_response_t* r, const char* phase, const char* url) {
+  r->timed_out = true;
+  sb_add_chars(&r->error, "timeout while ");
+  sb_add_chars(&r->error, phase);
+  sb_add_chars(&r->error, url);
+}
+
+/** limits the next read or write to the time left, so they fail with EAGAIN once the deadline is reached. */
+static void set_socket_timeout(int sockfd, uint64_t deadline) {
+  if (!deadline) return;
+  struct timeval tv = time_left(deadline);
+  setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+/** connects the socket, but waits no longer than the deadline (0 = no timeout). returns 0 on success, -2 if it timed out. */
+static int connect_until(int sockfd, struct sockaddr_in* addr, uint64_t deadline) {
+  if (!deadline) return connect(sockfd, (struct sockaddr*) addr, sizeof(*addr));
+
+  const int flags = fcntl(sockfd, F_GETFL, 0);
+  fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
+  int res = connect(sockfd, (struct sockaddr*) addr, sizeof(*addr));
+  if (res < 0 && errno == EINPROGRESS) {
+    fd_set         fds;
+    struct timeval tv = time_left(deadline);
+    FD_ZERO(&fds);
+    FD_SET(sockfd, &fds);
+    res = select(sockfd + 1, NULL, &fds, NULL, &tv);
+    if (res == 0) return -2;
+    if (res > 0) {
+      int       err = 0;
+      socklen_t len = sizeof(err);
+      res           = getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err ? -1 : 0;
+    }
+  }
+  fcntl(sockfd, F_SETFL, flags);
+  return res;
+}
+#endif
+
 in3_ret_t send_http(in3_request_t* req) {
+  const uint64_t deadline = req->timeout ? current_ms() + req->timeout : 0;
   for (int n = 0; n < req->urls_len; n++) {
     struct hostent*    server;
     struct sockaddr_in serv_addr;
     int                received, bytes, sent, total;
     char *             message = alloca(strlen(req->payload) + 200), response[4096], *url = req->urls[n], host[256];
+    uint64_t           start   = current_ms();
 
     (void) received;
     (void) bytes;
     (void) sent;
 
+    // the nodes are asked one after the other, so each one only gets the time left.
+    if (deadline && deadline <= start) {
+      req->results[n].timed_out = true;
+      sb_add_chars(&req->results[n].error, "timeout before sending the request to ");
+      sb_add_chars(&req->results[n].error, url);
+      continue;
+    }
+
     // parse url
     if (strncmp(url, "http://", 7)) {
       sb_add_chars(&req->results[n].error, "invalid url must sart with http");
@@ -153,33 +216,50 @@ in3_ret_t send_http(in3_request_t* req) {
     serv_addr.sin_port   = htons(portno);
     memcpy(&serv_addr.sin_addr.s_addr, server->h_addr_list[0], server->h_length);
     /* connect the socket */
-    if (connect(sockfd, (struct sockaddr*) &serv_addr, sizeof(serv_addr)) < 0) {
-      sb_add_chars(&req->results[n].error, "ERROR connecting");
+    int connected = connect_until(sockfd, &serv_addr, deadline);
+    if (connected < 0) {
+      if (connected == -2)
+        add_timeout_error(req->results + n, "connecting to ", url);
+      else
+        sb_add_chars(&req->results[n].error, "ERROR connecting");
+      close(sockfd);
       continue;
     }
     /* send the request */
 
     sent = 0;
     do {
+      set_socket_timeout(sockfd, deadline);
       bytes = write(sockfd, message + sent, total - sent);
       if (bytes < 0) {
-        sb_add_chars(&req->results[n].error, "ERROR writing message to socket");
-        continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          add_timeout_error(req->results + n, "sending the request to ", url);
+        else
+          sb_add_chars(&req->results[n].error, "ERROR writing message to socket");
+        break;
       }
       if (bytes == 0)
         break;
       sent += bytes;
     } while (sent < total);
+    if (req->results[n].error.len) {
+      close(sockfd);
+      continue;
+    }
     /* receive the response */
     memset(response, 0, sizeof(response));
     total    = sizeof(response) - 1;
     received = 0;
     do {
       memset(response, 0, sizeof(response));
+      set_socket_timeout(sockfd, deadline);
       bytes = recv(sockfd, response, 1024, 0);
       if (bytes < 0) {
-        sb_add_chars(&req->results[n].error, "ERROR reading response from socket");
-        continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          add_timeout_error(req->results + n, "reading the response from ", url);
+        else
+          sb_add_chars(&req->results[n].error, "ERROR reading response from socket");
+        break;
       }
       if (bytes == 0)
         break;
@@ -187,8 +267,9 @@ in3_ret_t send_http(in3_request_t* req) {
       received += bytes;
     } while (1);
 
-    if (received == total) {
-      sb_add_chars(&req->results[n].error, "ERROR storing complete response from socket");
+    if (req->results[n].error.len || received == total) {
+      if (!req->results[n].error.len) sb_add_chars(&req->results[n].error, "ERROR storing complete response from socket");
+      close(sockfd);
       continue;
     }
 
@@ -225,6 +306,10 @@ in3_ret_t send_http(in3_request_t* req) {
 
     memmove(res, body, req->results[n].result.len - (body - res) + 1);
     req->results[n].result.len -= body - res;
+    req->results[n].time = (uint32_t)(current_ms() - start);
+
+    // if the response is already verified, we don't need to ask the other nodes.
+    if (in3_req_check_response(req, n) == IN3_OK) break;
   }
 
   return 0;
@@ -150,7 +150,7 @@ in3_ret_t eth_verify_account_proof(in3_vctx_t* vc) {
   }
 
   // verify header
-  bytes_t* header = d_get_bytesk(vc->proof, K_BLOCK);
+  bytes_t* header = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), NULL);
   if (!header) return vc_err(vc, "no blockheader");
   if (eth_verify_blockheader(vc, header, NULL)) return vc_err(vc, "invalid blockheader");
 
@@ -52,7 +52,7 @@
 
 #define RESPONSE_START()                                                             \
   do {                                                                               \
-    *response = _malloc(sizeof(in3_response_t));                                     \
+    *response = _calloc(1, sizeof(in3_response_t));                                  \
     sb_init(&response[0]->result);                                                   \
     sb_init(&response[0]->error);                                                    \
     sb_add_chars(&response[0]->result, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":"); \
@@ -109,8 +109,20 @@ in3_ret_t in3_verify_eth_basic(in3_vctx_t* vc) {
     return in3_verify_eth_nano(vc);
 }
 
+// methods which are handled by the client and must never be sent to a node.
+static bool is_intern_method(char* method) {
+  return method && (!strcmp(method, "eth_sendTransaction") || !strcmp(method, "eth_newFilter") || !strcmp(method, "eth_chainId") || !strcmp(method, "eth_newBlockFilter") || !strcmp(method, "eth_newPendingTransactionFilter") || !strcmp(method, "eth_uninstallFilter") || !strcmp(method, "eth_getFilterChanges"));
+}
+
 in3_ret_t eth_handle_intern(in3_ctx_t* ctx, in3_response_t** response) {
-  if (ctx->len > 1) return IN3_ENOTSUP; // internal handling is only possible for single requests (at least for now)
+  if (ctx->len > 1) {
+    // internal handling is only possible for single requests (at least for now), so only batches without such methods are sent to the nodes.
+    for (int i = 0; i < ctx->len; i++) {
+      if (is_intern_method(d_get_stringk(ctx->requests[i], K_METHOD)))
+        return ctx_set_error(ctx, "internal methods can not be used in a batch", IN3_ENOTSUP);
+    }
+    return IN3_OK;
+  }
   d_token_t* req = ctx->requests[0];
 
   // check method
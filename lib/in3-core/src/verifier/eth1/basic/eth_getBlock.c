@@ -36,6 +36,7 @@
 #include "../../../core/client/keys.h"
 #include "../../../core/util/data.h"
 #include "../../../core/util/mem.h"
+#include "../../../core/util/parallel.h"
 #include "../../../verifier/eth1/nano/eth_nano.h"
 #include "../../../verifier/eth1/nano/merkle.h"
 #include "../../../verifier/eth1/nano/rlp.h"
@@ -67,6 +68,20 @@ static in3_ret_t eth_verify_uncles(in3_vctx_t* vc, bytes32_t uncle_hash, d_token
   return memcmp(hash2, uncle_hash, 32) ? vc_err(vc, "invalid uncles root") : IN3_OK;
 }
 
+// recovers one signature within a worker thread.
+static void recover_tx_signature(void* data, unsigned int index) {
+  tx_signature_t* sig = ((tx_signature_t*) data) + index;
+  if (sig->prepared) eth_recover_tx_signature(sig);
+}
+
+// adds the transaction with index 0 to the trie.
+static void add_first_tx(trie_builder_t* trie, bytes_t** path, bytes_t** tx, bool own_tx) {
+  trie_builder_add(trie, *path, *tx);
+  if (own_tx) b_free(*tx);
+  b_free(*path);
+  *path = *tx = NULL;
+}
+
 in3_ret_t eth_verify_eth_getBlock(in3_vctx_t* vc, bytes_t* block_hash, uint64_t blockNumber) {
 
   in3_ret_t  res = IN3_OK;
@@ -117,7 +132,14 @@ in3_ret_t eth_verify_eth_getBlock(in3_vctx_t* vc, bytes_t* block_hash, uint64_t
     if (!include_full_tx && (!tx_hashs || d_len(transactions) != d_len(tx_hashs)))
       return vc_err(vc, "no transactionhashes found!");
 
-    trie_t* trie = trie_new();
+    // the keys are the rlp-encoded indexes, which are sorted as 1..127, 0, 128.. ,
+    // so we keep the first transaction until we reach index 128.
+    trie_builder_t* trie         = trie_builder_new();
+    bytes_t *       first_path   = NULL, *first_tx = NULL;
+    bool            own_first_tx = false;
+
+    // the signatures are recovered after the loop, so they can be spread over the verify-threads.
+    tx_signature_t* sigs = d_len(transactions) ? _calloc(d_len(transactions), sizeof(tx_signature_t)) : NULL;
     for (i = 0, t = transactions + 1; i < d_len(transactions); i++, t = d_next(t)) {
       bool     is_raw_tx = d_type(t) == T_BYTES;
       bytes_t* path      = create_tx_path(i);
@@ -125,7 +147,7 @@ in3_ret_t eth_verify_eth_getBlock(in3_vctx_t* vc, bytes_t* block_hash, uint64_t
       bytes_t* h         = (full_proof || !include_full_tx) ? sha3(tx) : NULL;
 
       if (!is_raw_tx) {
-        if (eth_verify_tx_values(vc, t, tx))
+        if (eth_prepare_tx_signature(vc, t, tx, sigs + i))
           res = IN3_EUNKNOWN;
 
         if ((t2 = d_getl(t, K_BLOCK_HASH, 32)) && !b_cmp(d_bytes(t2), bhash))
@@ -143,18 +165,40 @@ in3_ret_t eth_verify_eth_getBlock(in3_vctx_t* vc, bytes_t* block_hash, uint64_t
           res = vc_err(vc, "Wrong Transactionhash");
         txh = d_next(txh);
       }
-      trie_set_value(trie, path, tx);
-      if (!is_raw_tx) b_free(tx);
-      b_free(path);
+      if (i == 0) {
+        first_path   = path;
+        first_tx     = tx;
+        own_first_tx = !is_raw_tx;
+      } else {
+        if (i == 128) add_first_tx(trie, &first_path, &first_tx, own_first_tx);
+        trie_builder_add(trie, path, tx);
+        if (!is_raw_tx) b_free(tx);
+        b_free(path);
+      }
       if (h) b_free(h);
     }
+    if (first_path) add_first_tx(trie, &first_path, &first_tx, own_first_tx);
+
+    if (sigs) {
+      in3_parallel_for(d_len(transactions), vc->ctx->client->verify_threads, recover_tx_signature, sigs);
+      // report the errors in the order of the transactions, no matter which thread found them
+      for (i = 0; i < d_len(transactions); i++) {
+        if (sigs[i].error) {
+          vc_err(vc, sigs[i].error);
+          res = IN3_EUNKNOWN;
+        }
+      }
+      _free(sigs);
+    }
 
-    bytes_t t_root = d_to_bytes(d_getl(vc->result, K_TRANSACTIONS_ROOT, 32));
+    bytes32_t root;
+    bytes_t   t_root = d_to_bytes(d_getl(vc->result, K_TRANSACTIONS_ROOT, 32));
+    trie_builder_root(trie, root);
 
-    if (t_root.len != 32 || memcmp(t_root.data, trie->root, 32))
+    if (t_root.len != 32 || memcmp(t_root.data, root, 32))
       res = vc_err(vc, "Wrong Transaction root");
 
-    trie_free(trie);
+    trie_builder_free(trie);
 
     // verify uncles
     if (res == IN3_OK && full_proof)
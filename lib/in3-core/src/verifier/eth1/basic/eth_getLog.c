@@ -216,14 +216,23 @@ in3_ret_t eth_verify_eth_getLog(in3_vctx_t* vc, int l_logs) {
       return vc_err(vc, "block number mismatch");
 
     // verify the blockheader of the log entry
-    bytes_t block = d_to_bytes(d_get(it.token, K_BLOCK)), tx_root, receipt_root;
-    int     bl    = i;
+    bytes_t* header = eth_get_proof_header(vc, d_get(it.token, K_BLOCK), NULL);
+    bytes_t  block  = header ? *header : bytes(NULL, 0), tx_root, receipt_root;
+    int      bl     = i;
     if (!block.len || eth_verify_blockheader(vc, &block, NULL) < 0) return vc_err(vc, "invalid blockheader");
     sha3_to(&block, receipts[i].block_hash);
     rlp_decode(&block, 0, &block);
-    if (rlp_decode(&block, BLOCKHEADER_RECEIPT_ROOT, &receipt_root) != 1) return vc_err(vc, "invalid receipt root");
-    if (rlp_decode(&block, BLOCKHEADER_TRANSACTIONS_ROOT, &tx_root) != 1) return vc_err(vc, "invalid tx root");
-    if (rlp_decode(&block, BLOCKHEADER_NUMBER, &receipts[i].block_number) != 1) return vc_err(vc, "invalid block number");
+
+    // decode the header fields with one pass
+    bytes_t fields[BLOCKHEADER_NUMBER + 1];
+    uint8_t types[BLOCKHEADER_NUMBER + 1];
+    if (rlp_decode_items(&block, fields, types, BLOCKHEADER_NUMBER + 1) <= BLOCKHEADER_NUMBER) return vc_err(vc, "invalid blockheader");
+    if (types[BLOCKHEADER_RECEIPT_ROOT] != 1) return vc_err(vc, "invalid receipt root");
+    if (types[BLOCKHEADER_TRANSACTIONS_ROOT] != 1) return vc_err(vc, "invalid tx root");
+    if (types[BLOCKHEADER_NUMBER] != 1) return vc_err(vc, "invalid block number");
+    receipt_root             = fields[BLOCKHEADER_RECEIPT_ROOT];
+    tx_root                  = fields[BLOCKHEADER_TRANSACTIONS_ROOT];
+    receipts[i].block_number = fields[BLOCKHEADER_NUMBER];
 
     // verify all receipts
     for (d_iterator_t receipt = d_iter(d_get(it.token, K_RECEIPTS)); receipt.left; d_iter_next(&receipt)) {
@@ -270,7 +279,6 @@ in3_ret_t eth_verify_eth_getLog(in3_vctx_t* vc, int l_logs) {
   uint64_t prev_blk = 0;
   for (d_iterator_t it = d_iter(vc->result); it.left; d_iter_next(&it)) {
     receipt_t* r = NULL;
-    i            = 0;
     for (int n = 0; n < l_logs; n++) {
       if (bytes_cmp(d_to_bytes(d_get(it.token, K_TRANSACTION_HASH)), bytes(receipts[n].tx_hash, 32))) {
         r = receipts + n;
@@ -285,14 +293,20 @@ in3_ret_t eth_verify_eth_getLog(in3_vctx_t* vc, int l_logs) {
     if (rlp_decode(&tmp, 3, &logddata) != 2) return vc_err(vc, "invalid log-data");
     if (rlp_decode(&logddata, d_get_intk(it.token, K_TRANSACTION_LOG_INDEX), &logddata) != 2) return vc_err(vc, "invalid log index");
 
-    // check address
-    if (!rlp_decode(&logddata, 0, &tmp) || !bytes_cmp(tmp, d_to_bytes(d_getl(it.token, K_ADDRESS, 20)))) return vc_err(vc, "invalid address");
-    if (!rlp_decode(&logddata, 2, &tmp) || !bytes_cmp(tmp, d_to_bytes(d_get(it.token, K_DATA)))) return vc_err(vc, "invalid data");
-    if (rlp_decode(&logddata, 1, &tops) != 2) return vc_err(vc, "invalid topics");
+    // check address, data and topics
+    bytes_t log_fields[3];
+    uint8_t log_types[3];
+    if (rlp_decode_items(&logddata, log_fields, log_types, 3) != 3) return vc_err(vc, "invalid log-data");
+    if (log_types[0] != 1 || !bytes_cmp(log_fields[0], d_to_bytes(d_getl(it.token, K_ADDRESS, 20)))) return vc_err(vc, "invalid address");
+    if (log_types[2] != 1 || !bytes_cmp(log_fields[2], d_to_bytes(d_get(it.token, K_DATA)))) return vc_err(vc, "invalid data");
+    if (log_types[1] != 2) return vc_err(vc, "invalid topics");
+    tops = log_fields[1];
     if (rlp_decode_len(&tops) != d_len(topics)) return vc_err(vc, "invalid topics len");
 
+    // walk through the topics with a cursor, so each one is only decoded once.
+    rlp_iterator_t iter = rlp_iter(&tops);
     for (d_iterator_t t = d_iter(topics); t.left; d_iter_next(&t)) {
-      if (!rlp_decode(&tops, i++, &tmp) || !bytes_cmp(tmp, *d_bytesl(t.token, 32))) return vc_err(vc, "invalid topic");
+      if (rlp_iter_next(&iter, &tmp) != 1 || !bytes_cmp(tmp, *d_bytesl(t.token, 32))) return vc_err(vc, "invalid topic");
     }
 
     if (d_get_longk(it.token, K_BLOCK_NUMBER) != bytes_to_long(r->block_number.data, r->block_number.len)) return vc_err(vc, "invalid blocknumber");
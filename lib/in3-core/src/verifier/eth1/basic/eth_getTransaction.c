@@ -32,6 +32,7 @@
  * with this program. If not, see <https://www.gnu.org/licenses/>.
  *******************************************************************************/
 
+#include "../../../core/client/cache.h"
 #include "../../../core/client/context.h"
 #include "../../../core/client/keys.h"
 #include "../../../core/util/data.h"
@@ -43,20 +44,23 @@
 #include "../../../verifier/eth1/nano/merkle.h"
 #include "../../../verifier/eth1/nano/rlp.h"
 #include "../../../verifier/eth1/nano/serialize.h"
+#include "eth_basic.h"
 #include <string.h>
 
 static uint8_t* secp256k1n_2 = (uint8_t*) "\x7F\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x5D\x57\x6E\x73\x57\xA4\x50\x1D\xDF\xE9\x2F\x46\x68\x1B\x20\xA0";
 
-in3_ret_t eth_verify_tx_values(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw) {
+in3_ret_t eth_prepare_tx_signature(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw, tx_signature_t* sig) {
   d_token_t* t = NULL;
-  uint8_t    hash[32], pubkey[65], sdata[64];
-  bytes_t    pubkey_bytes = {.len = 64, .data = ((uint8_t*) &pubkey) + 1};
+  uint8_t    hash[32];
 
   bytes_t* r        = d_get_byteskl(tx, K_R, 32);
   bytes_t* s        = d_get_byteskl(tx, K_S, 32);
   uint32_t v        = d_get_intk(tx, K_V);
   uint32_t chain_id = v > 35 ? (v - 35) / 2 : 0;
 
+  sig->prepared = false;
+  sig->error    = NULL;
+
   // check transaction hash
   if (sha3_to(raw ? raw : d_get_bytesk(tx, K_RAW), &hash) == 0 && memcmp(hash, d_get_byteskl(tx, K_HASH, 32)->data, 32))
     return vc_err(vc, "wrong transactionHash");
@@ -82,15 +86,18 @@ in3_ret_t eth_verify_tx_values(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw) {
     return vc_err(vc, "invalid r/s-value of the signature");
 
   // combine r+s
-  memset(sdata, 0, 64);
-  memcpy(sdata + 32 - r->len, r->data, r->len);
-  memcpy(sdata + 64 - s->len, s->data, s->len);
+  memset(sig->sig, 0, 64);
+  memcpy(sig->sig + 32 - r->len, r->data, r->len);
+  memcpy(sig->sig + 64 - s->len, s->data, s->len);
+
+  // decode the fields of the raw transaction with one pass
+  bytes_t raw_list, item, fields[6];
+  if (rlp_decode(raw ? raw : d_get_bytesk(tx, K_RAW), 0, &raw_list) != 2 || rlp_decode_items(&raw_list, fields, NULL, 6) < 6)
+    return vc_err(vc, "invalid raw transaction");
 
   // calculate the  messagehash
   bytes_builder_t* bb = bb_new();
-  bytes_t          raw_list, item;
-  rlp_decode(raw ? raw : d_get_bytesk(tx, K_RAW), 0, &raw_list);
-  rlp_decode(&raw_list, 5, &item);
+  item                = fields[5];
   bb_write_raw_bytes(bb, raw_list.data, item.data + item.len - raw_list.data);
   if (chain_id) {
     uint8_t  chain_data[4];
@@ -105,19 +112,47 @@ in3_ret_t eth_verify_tx_values(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw) {
     rlp_encode_item(bb, &item);
   }
   rlp_encode_to_list(bb);
-  sha3_to(&bb->b, hash);
+  sha3_to(&bb->b, sig->hash);
   bb_free(bb);
 
-  // verify signature
-  if (ecdsa_recover_pub_from_sig(&secp256k1, pubkey, sdata, hash, (chain_id ? v - chain_id * 2 - 8 : v) - 27))
-    return vc_err(vc, "could not recover signature");
+  // the values to compare the recovered key with
+  t               = d_getl(tx, K_PUBLIC_KEY, 64);
+  sig->public_key = t ? d_to_bytes(t) : (bytes_t){.data = NULL, .len = 0};
+  t               = d_getl(tx, K_FROM, 20);
+  sig->from       = t ? t->data : NULL;
+  sig->sig[64]    = (chain_id ? v - chain_id * 2 - 8 : v) - 27;
+  sig->cache      = in3_cache_senders(vc->ctx->client);
+  sig->prepared   = true;
+  return IN3_OK;
+}
 
-  if ((t = d_getl(tx, K_PUBLIC_KEY, 64)) && memcmp(pubkey_bytes.data, t->data, t->len) != 0)
-    return vc_err(vc, "invalid public Key");
+void eth_recover_tx_signature(tx_signature_t* sig) {
+  uint8_t hash[32], pubkey[65];
+  bytes_t pubkey_bytes = {.len = 64, .data = ((uint8_t*) &pubkey) + 1};
 
-  if ((t = d_getl(tx, K_FROM, 20)) && sha3_to(&pubkey_bytes, &hash) == 0 && memcmp(hash + 12, t->data, 20))
-    return vc_err(vc, "invalid from address");
-  return IN3_OK;
+  // verify signature, unless the public key was already recovered before
+  if (!sig->cache || !in3_cache_get_sender(sig->cache, sig->hash, sig->sig, pubkey_bytes.data)) {
+    if (ecdsa_recover_pub_from_sig(&secp256k1, pubkey, sig->sig, sig->hash, sig->sig[64])) {
+      sig->error = "could not recover signature";
+      return;
+    }
+    if (sig->cache) in3_cache_add_sender(sig->cache, sig->hash, sig->sig, pubkey_bytes.data);
+  }
+
+  if (sig->public_key.data && memcmp(pubkey_bytes.data, sig->public_key.data, sig->public_key.len) != 0)
+    sig->error = "invalid public Key";
+  else if (sig->from && sha3_to(&pubkey_bytes, &hash) == 0 && memcmp(hash + 12, sig->from, 20))
+    sig->error = "invalid from address";
+  else
+    sig->error = NULL;
+}
+
+in3_ret_t eth_verify_tx_values(in3_vctx_t* vc, d_token_t* tx, bytes_t* raw) {
+  tx_signature_t sig;
+  in3_ret_t      res = eth_prepare_tx_signature(vc, tx, raw, &sig);
+  if (res != IN3_OK) return res;
+  eth_recover_tx_signature(&sig);
+  return sig.error ? vc_err(vc, sig.error) : IN3_OK;
 }
 
 in3_ret_t eth_verify_eth_getTransaction(in3_vctx_t* vc, bytes_t* tx_hash) {
@@ -130,11 +165,12 @@ in3_ret_t eth_verify_eth_getTransaction(in3_vctx_t* vc, bytes_t* tx_hash) {
   // this means result: null, which is ok, since we can not verify a transaction that does not exists
   if (!vc->proof) return vc_err(vc, "Proof is missing!");
 
-  bytes_t* blockHeader = d_get_bytesk(vc->proof, K_BLOCK);
+  bytes_t* block_hash  = d_get_byteskl(vc->result, K_BLOCK_HASH, 32);
+  bytes_t* blockHeader = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), block_hash);
   if (!blockHeader)
     return vc_err(vc, "No Block-Proof!");
 
-  res = eth_verify_blockheader(vc, blockHeader, d_get_byteskl(vc->result, K_BLOCK_HASH, 32));
+  res = eth_verify_blockheader(vc, blockHeader, block_hash);
   if (res == IN3_OK) {
     bytes_t*  path = create_tx_path(d_get_intk(vc->proof, K_TX_INDEX));
     bytes_t   root, raw_transaction = {.len = 0, .data = NULL};
@@ -180,7 +216,7 @@ in3_ret_t eth_verify_eth_getTransactionByBlock(in3_vctx_t* vc, d_token_t* blk, u
   // this means result: null, which is ok, since we can not verify a transaction that does not exists
   if (!vc->proof) return vc_err(vc, "Proof is missing!");
 
-  bytes_t* blockHeader = d_get_bytesk(vc->proof, K_BLOCK);
+  bytes_t* blockHeader = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), hash_);
   if (!blockHeader) return vc_err(vc, "No Block-Proof!");
 
   // verify that the block matches the block as described in the transaction
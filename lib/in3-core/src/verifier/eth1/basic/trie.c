@@ -35,6 +35,7 @@
 #include "trie.h"
 #include "../../../core/util/log.h"
 #include "../../../core/util/mem.h"
+#include "../../../core/util/utils.h"
 #include "../../../third-party/crypto/sha3.h"
 #include "../../../verifier/eth1/nano/merkle.h"
 #include "../../../verifier/eth1/nano/rlp.h"
@@ -70,6 +71,8 @@ trie_t* trie_new() {
   trie_t* t              = _calloc(1, sizeof(trie_t));
   t->hasher              = _sha3;
   t->codec               = &rlp_codec;
+  t->buckets             = _calloc(16, sizeof(trie_node_t*));
+  t->mask                = 15;
   bytes_builder_t* ll    = bb_new();
   bytes_t          empty = bytes(NULL, 0);
   t->codec->encode_add(ll, &empty);
@@ -84,23 +87,60 @@ void trie_free(trie_t* val) {
     t = (p = t)->next;
     _free(p);
   }
+  _free(val->buckets);
   _free(val);
 }
 
+// a node has a hash assigned only after it was stored.
+static bool is_stored(trie_node_t* n) {
+  for (int i = 0; i < 32; i++) {
+    if (n->hash[i]) return true;
+  }
+  return false;
+}
+
 static void free_node(trie_node_t* n) {
   if (!n) return;
   if (n->own_memory) {
     // check if the node has a hash assigned. In this case it is stored and we be cleaned up later.
-    int      l = 0;
-    uint8_t* p = n->hash;
-    for (; l < 32; l++, p++) {
-      if (*p) return;
-    }
-
+    if (is_stored(n)) return;
     _free(n->data.data);
   }
   _free(n);
 }
+
+// -- node store --
+
+// the hash is already uniformly distributed, so we simply take the first bytes as index.
+static inline uint32_t bucket_index(trie_t* t, uint8_t* hash) {
+  return (hash[0] | hash[1] << 8 | hash[2] << 16 | (uint32_t) hash[3] << 24) & t->mask;
+}
+
+static void store_remove(trie_t* t, trie_node_t* n) {
+  trie_node_t** p = t->buckets + bucket_index(t, n->hash);
+  while (*p && *p != n) p = &(*p)->hash_next;
+  if (*p) *p = n->hash_next;
+}
+
+static void store_add(trie_t* t, trie_node_t* n) {
+  if (t->nodes_len > t->mask) {
+    // grow the buckets and rehash all stored nodes.
+    uint32_t size = (t->mask + 1) * 2;
+    _free(t->buckets);
+    t->buckets = _calloc(size, sizeof(trie_node_t*));
+    t->mask    = size - 1;
+    for (trie_node_t* p = t->nodes; p; p = p->next) {
+      if (p == n) continue;
+      uint32_t i    = bucket_index(t, p->hash);
+      p->hash_next  = t->buckets[i];
+      t->buckets[i] = p;
+    }
+  }
+  uint32_t i    = bucket_index(t, n->hash);
+  n->hash_next  = t->buckets[i];
+  t->buckets[i] = n;
+}
+
 // -- trie_node --
 
 static bytes_t trie_node_get_item(trie_node_t* t, int index) {
@@ -242,30 +282,27 @@ static node_key_t update_db(trie_t* t, trie_node_t* n, int top) {
   if (n->data.len < 32 && !top)
     return node_key(n);
   else {
-    // do we already have it?
-    trie_node_t* p = t->nodes;
-    while (p) {
-      if (p == n) break;
-      p = p->next;
-    }
-
-    // we only add the node if we don't have it yet.
-    if (p == NULL) {
+    // do we already have it? Then the hash changes and the node must move to another bucket.
+    if (is_stored(n))
+      store_remove(t, n);
+    else {
       n->next  = t->nodes;
       t->nodes = n;
+      t->nodes_len++;
     }
     // update and return the hash
     _sha3(&n->data, n->hash);
+    store_add(t, n);
     return hash_key(n->hash);
   }
 }
 
 static trie_node_t* get_node(trie_t* t, node_key_t key) {
   if (key.node) return key.node;
-  trie_node_t* n = t->nodes;
+  trie_node_t* n = t->buckets[bucket_index(t, key.hash)];
   while (n != NULL) {
     if (memcmp(n->hash, key.hash, 32) == 0) return n;
-    n = n->next;
+    n = n->hash_next;
   }
   return NULL;
 }
@@ -413,6 +450,192 @@ void trie_set_value(trie_t* t, bytes_t* key, bytes_t* value) {
   memcpy(t->root, root, 32);
 }
 
+// -- trie_builder --
+
+trie_builder_t* trie_builder_new() {
+  trie_builder_t* b = _calloc(1, sizeof(trie_builder_t));
+  b->hasher         = _sha3;
+  b->multi_hasher   = sha3_multi;
+  return b;
+}
+
+static void free_branch(trie_builder_branch_t* branch) {
+  for (int i = 0; i < 16; i++) {
+    if (branch->children[i].data) _free(branch->children[i].data);
+  }
+  if (branch->value.data) _free(branch->value.data);
+}
+
+void trie_builder_free(trie_builder_t* b) {
+  for (int i = 0; i < b->len; i++) free_branch(b->stack + i);
+  if (b->key) _free(b->key);
+  if (b->value.data) _free(b->value.data);
+  _free(b);
+}
+
+// adds the reference to a child node, which is embedded if it is smaller than a hash.
+static void add_node_ref(trie_builder_t* b, bytes_builder_t* bb, bytes_t* node) {
+  if (node->len < 32)
+    bb_write_raw_bytes(bb, node->data, node->len);
+  else {
+    uint8_t hash[32];
+    bytes_t tmp = bytes(hash, 32);
+    b->hasher(node, hash);
+    rlp_encode_item(bb, &tmp);
+  }
+}
+
+// takes the content of the builder as node.
+static bytes_t finish_node(bytes_builder_t* bb) {
+  bytes_t node = bytes(NULL, 0);
+  finish_rlp(bb, &node);
+  return node;
+}
+
+static bytes_t create_leaf(uint8_t* nibbles, bytes_t* value) {
+  bytes_builder_t* bb   = bb_new();
+  bytes_t          path = bytes(NULL, 0);
+  trie_node_value_from_nibbles(NODE_LEAF, nibbles, &path);
+  rlp_encode_item(bb, &path);
+  rlp_encode_item(bb, value);
+  _free(path.data);
+  return finish_node(bb);
+}
+
+// puts an extension with the given nibbles in front of the node, if needed.
+static bytes_t create_ext(trie_builder_t* b, uint8_t* nibbles, int len, bytes_t node) {
+  if (len == 0) return node;
+  uint8_t          tmp[65];
+  bytes_builder_t* bb   = bb_new();
+  bytes_t          path = bytes(NULL, 0);
+  memcpy(tmp, nibbles, len);
+  tmp[len] = 0xFF;
+  trie_node_value_from_nibbles(NODE_EXT, tmp, &path);
+  rlp_encode_item(bb, &path);
+  add_node_ref(b, bb, &node);
+  _free(path.data);
+  _free(node.data);
+  return finish_node(bb);
+}
+
+static void open_branch(trie_builder_t* b, int depth) {
+  trie_builder_branch_t* branch = b->stack + b->len++;
+  memset(branch, 0, sizeof(trie_builder_branch_t));
+  branch->depth = depth;
+}
+
+// the branch takes ownership of the node.
+static void set_branch_child(trie_builder_branch_t* branch, int index, bytes_t node) {
+  branch->children[index] = node;
+}
+
+// encodes the branch. All children, which are not embedded, are hashed at once.
+static bytes_t close_branch(trie_builder_t* b, trie_builder_branch_t* branch) {
+  bytes_t *refs[16], empty = bytes(NULL, 0), tmp;
+  uint8_t  hashes[16 * 32], *hash = hashes;
+  int      len = 0, i;
+  for (i = 0; i < 16; i++) {
+    if (branch->children[i].len >= 32) refs[len++] = branch->children + i;
+  }
+  if (len) b->multi_hasher(refs, len, hashes);
+
+  bytes_builder_t* bb = bb_new();
+  for (i = 0; i < 16; i++) {
+    bytes_t* child = branch->children + i;
+    if (!child->data)
+      rlp_encode_item(bb, &empty);
+    else if (child->len < 32)
+      bb_write_raw_bytes(bb, child->data, child->len);
+    else {
+      tmp = bytes(hash, 32);
+      rlp_encode_item(bb, &tmp);
+      hash += 32;
+    }
+    if (child->data) _free(child->data);
+  }
+  rlp_encode_item(bb, &branch->value);
+  if (branch->value.data) _free(branch->value.data);
+  return finish_node(bb);
+}
+
+// writes the last key into the deepest open branch.
+static void insert_last_key(trie_builder_t* b) {
+  trie_builder_branch_t* branch = b->stack + b->len - 1;
+  uint8_t*               rest   = b->key + branch->depth;
+  if (*rest == 0xFF)
+    branch->value = b->value;
+  else {
+    set_branch_child(branch, *rest, create_leaf(rest + 1, &b->value));
+    _free(b->value.data);
+  }
+  b->value = bytes(NULL, 0);
+}
+
+// closes the deepest open branch and writes it into its parent, which is created at depth if there is none.
+static void collapse_branch(trie_builder_t* b, int depth) {
+  int     child_depth = b->stack[b->len - 1].depth;
+  bytes_t node        = close_branch(b, b->stack + --b->len);
+  if (!b->len || b->stack[b->len - 1].depth < depth) open_branch(b, depth);
+  trie_builder_branch_t* parent = b->stack + b->len - 1;
+  set_branch_child(parent, b->key[parent->depth], create_ext(b, b->key + parent->depth + 1, child_depth - parent->depth - 1, node));
+}
+
+int trie_builder_add(trie_builder_t* b, bytes_t* key, bytes_t* value) {
+  if (key == NULL || value == NULL || value->len == 0 || key->len > 32) return 0;
+  uint8_t* path = trie_path_to_nibbles(*key, false);
+
+  if (b->key) {
+    // the common prefix with the last key is the depth of the branch both keys share.
+    int depth = trie_matching_nibbles(b->key, path);
+    if (path[depth] == 0xFF || (b->key[depth] != 0xFF && b->key[depth] > path[depth])) {
+      _free(path);
+      return -1;
+    }
+
+    // all branches deeper than the common prefix will never change again.
+    if (!b->len || b->stack[b->len - 1].depth < depth) open_branch(b, depth);
+    insert_last_key(b);
+    while (b->stack[b->len - 1].depth > depth) collapse_branch(b, depth);
+    _free(b->key);
+  }
+
+  b->key        = path;
+  b->value.data = _malloc(value->len);
+  b->value.len  = value->len;
+  memcpy(b->value.data, value->data, value->len);
+  return 0;
+}
+
+void trie_builder_root(trie_builder_t* b, bytes32_t dst) {
+  bytes_t node = bytes(NULL, 0);
+  if (!b->key) {
+    // empty trie
+    bytes_builder_t* bb = bb_new();
+    rlp_encode_item(bb, &node);
+    b->hasher(&bb->b, dst);
+    bb_free(bb);
+    return;
+  }
+
+  if (!b->len) {
+    node = create_leaf(b->key, &b->value);
+    _free(b->value.data);
+    b->value = bytes(NULL, 0);
+  } else {
+    insert_last_key(b);
+    while (b->len > 1) collapse_branch(b, -1);
+    int depth = b->stack->depth;
+    b->len    = 0;
+    node      = create_ext(b, b->key, depth, close_branch(b, b->stack));
+  }
+
+  // the root is always hashed, even if it is smaller.
+  b->hasher(&node, dst);
+  _free(node.data);
+  _free(b->key);
+  b->key = NULL;
+}
+
 #ifdef TRIETEST
 static void hexprint(uint8_t* a, int l) {
   (void) a; // unused param if compiled without debug
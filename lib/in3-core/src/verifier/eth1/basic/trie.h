@@ -43,6 +43,11 @@
  */
 typedef void (*in3_hasher_t)(bytes_t* src, uint8_t* dst);
 
+/**
+ *  hash-function for independent buffers, which writes 32 bytes for each of them.
+ */
+typedef void (*in3_multi_hasher_t)(bytes_t** src, int len, uint8_t* dst);
+
 /**
  *  codec to organize the encoding of the nodes
  */
@@ -71,6 +76,7 @@ typedef struct trie_node {
   uint8_t           own_memory; /**< if true this is a embedded node with own memory */
   trie_node_type_t  type;       /**< type of the node */
   struct trie_node* next;       /**< used as linked list */
+  struct trie_node* hash_next;  /**< next node in the same bucket of the node store */
 } trie_node_t;
 
 /**
@@ -90,12 +96,39 @@ typedef struct trie_codec {
  * This is a Patricia Merkle Tree.
  */
 typedef struct trie {
-  in3_hasher_t  hasher; /**< hash-function. */
-  trie_codec_t* codec;  /**< encoding of the nocds. */
-  bytes32_t     root;   /**< The root-hash. */
-  trie_node_t*  nodes;  /**< linked list of containes nodes */
+  in3_hasher_t  hasher;    /**< hash-function. */
+  trie_codec_t* codec;     /**< encoding of the nocds. */
+  bytes32_t     root;      /**< The root-hash. */
+  trie_node_t*  nodes;     /**< linked list of containes nodes */
+  trie_node_t** buckets;   /**< the stored nodes indexed by their hash */
+  uint32_t      nodes_len; /**< number of stored nodes */
+  uint32_t      mask;      /**< number of buckets - 1 */
 } trie_t;
 
+/**
+ * a branch which is still open while building a trie from sorted keys.
+ */
+typedef struct {
+  int     depth;        /**< the nibble-position this branch splits at */
+  bytes_t children[16]; /**< the encoded child nodes, which are hashed together when the branch is closed */
+  bytes_t value;        /**< the value of a key ending in this branch */
+} trie_builder_branch_t;
+
+/**
+ * builds the root of a trie from keys added in ascending order.
+ *
+ * Only the branches on the path of the last key are kept open, all other nodes are
+ * encoded and hashed exactly once as soon as the next key passes them.
+ */
+typedef struct {
+  in3_hasher_t          hasher;       /**< hash-function. */
+  in3_multi_hasher_t    multi_hasher; /**< hash-function for the children of a branch. */
+  trie_builder_branch_t stack[64];    /**< the open branches, ordered by depth */
+  int                   len;          /**< number of open branches */
+  uint8_t*              key;          /**< the nibbles of the last key, which is not written yet */
+  bytes_t               value;        /**< the value of the last key */
+} trie_builder_t;
+
 /**
  *  creates a new Merkle Trie.
  */
@@ -112,6 +145,30 @@ void trie_free(trie_t* val);
  */
 void trie_set_value(trie_t* t, bytes_t* key, bytes_t* value);
 
+/**
+ *  creates a new builder for a trie with sorted keys.
+ */
+trie_builder_t* trie_builder_new();
+
+/**
+ * adds a value to the builder.
+ *
+ * The keys must be added in ascending order (compared as bytes).
+ * returns 0 or -1 if the key is not greater than the last one.
+ */
+int trie_builder_add(trie_builder_t* b, bytes_t* key, bytes_t* value);
+
+/**
+ * writes all remaining nodes and the root-hash to dst.
+ * After this the builder is empty and can be reused.
+ */
+void trie_builder_root(trie_builder_t* b, bytes32_t dst);
+
+/**
+ * frees all resources of the builder.
+ */
+void trie_builder_free(trie_builder_t* b);
+
 #ifdef TEST
 void trie_dump(trie_t* trie, uint8_t with_hash);
 #endif
@@ -38,40 +38,133 @@
 #include "big.h"
 #include "gas.h"
 #ifdef EVM_GAS
-/**
- * sets a variable value to 32byte word.
- */
+
+// FNV-1a
+static uint32_t hash_bytes(const uint8_t* data, int len) {
+  uint32_t h = 2166136261u;
+  for (int i = 0; i < len; i++) h = (h ^ data[i]) * 16777619u;
+  return h;
+}
+
+static uint32_t storage_hash(account_t* ac, const uint8_t* key) {
+  return hash_bytes(key, 32) ^ ((uint32_t) (uintptr_t) ac * 2654435761u);
+}
+
+// the accounts are created by the root evm, subcalls get them with evm_checkpoint.
+static evm_accounts_t* get_accounts(evm_t* evm) {
+  if (!evm->accounts) {
+    evm_accounts_t* st = _calloc(1, sizeof(evm_accounts_t));
+    st->account_mask   = 15;
+    st->storage_mask   = 15;
+    st->account_map    = _calloc(16, sizeof(account_t*));
+    st->storage_map    = _calloc(16, sizeof(storage_t*));
+    evm->accounts      = st;
+    evm->checkpoint    = 0;
+    evm->journal_pos   = 0;
+  }
+  return evm->accounts;
+}
+
+static void grow_accounts(evm_accounts_t* st) {
+  uint32_t    mask = st->account_mask * 2 + 1;
+  account_t** map  = _calloc(mask + 1, sizeof(account_t*));
+  for (account_t* ac = st->list; ac; ac = ac->next) {
+    uint32_t h    = hash_bytes(ac->address, 20) & mask;
+    ac->hash_next = map[h];
+    map[h]        = ac;
+  }
+  _free(st->account_map);
+  st->account_map  = map;
+  st->account_mask = mask;
+}
+
+static void grow_storage(evm_accounts_t* st) {
+  uint32_t    mask = st->storage_mask * 2 + 1;
+  storage_t** map  = _calloc(mask + 1, sizeof(storage_t*));
+  for (account_t* ac = st->list; ac; ac = ac->next) {
+    for (storage_t* s = ac->storage; s; s = s->next) {
+      uint32_t h   = storage_hash(ac, s->key) & mask;
+      s->hash_next = map[h];
+      map[h]       = s;
+    }
+  }
+  _free(st->storage_map);
+  st->storage_map  = map;
+  st->storage_mask = mask;
+}
+
+static journal_entry_t* add_journal(evm_accounts_t* st, account_t* ac, storage_t* s, uint32_t checkpoint, bool created) {
+  if (st->journal_len == st->journal_size) {
+    uint32_t size    = st->journal_size ? st->journal_size * 2 : 16;
+    st->journal      = st->journal
+                          ? _realloc(st->journal, size * sizeof(journal_entry_t), st->journal_size * sizeof(journal_entry_t))
+                          : _malloc(size * sizeof(journal_entry_t));
+    st->journal_size = size;
+  }
+  journal_entry_t* e = st->journal + st->journal_len++;
+  e->account         = ac;
+  e->storage         = s;
+  e->checkpoint      = checkpoint;
+  e->created         = created;
+  return e;
+}
+
+// since the account may be changed by the caller, we record its values once for each checkpoint.
+static void journal_account(evm_accounts_t* st, account_t* ac) {
+  if (!st->checkpoint || ac->checkpoint == st->checkpoint) return;
+  journal_entry_t* e = add_journal(st, ac, NULL, ac->checkpoint, false);
+  memcpy(e->value, ac->balance, 32);
+  memcpy(e->nonce, ac->nonce, 32);
+  e->code        = ac->code;
+  ac->checkpoint = st->checkpoint;
+}
+
+static void journal_storage(evm_accounts_t* st, storage_t* s) {
+  if (!st->checkpoint || s->checkpoint == st->checkpoint) return;
+  memcpy(add_journal(st, s->account, s, s->checkpoint, false)->value, s->value, 32);
+  s->checkpoint = st->checkpoint;
+}
+
+static void remove_storage(evm_accounts_t* st, storage_t* s) {
+  storage_t** p = &s->account->storage;
+  while (*p != s) p = &(*p)->next;
+  *p = s->next;
+  for (p = st->storage_map + (storage_hash(s->account, s->key) & st->storage_mask); *p != s;) p = &(*p)->hash_next;
+  *p = s->hash_next;
+  st->storage_len--;
+  _free(s);
+}
+
+static void remove_account(evm_accounts_t* st, account_t* ac) {
+  while (ac->storage) remove_storage(st, ac->storage);
+  account_t** p = &st->list;
+  while (*p != ac) p = &(*p)->next;
+  *p = ac->next;
+  for (p = st->account_map + (hash_bytes(ac->address, 20) & st->account_mask); *p != ac;) p = &(*p)->hash_next;
+  *p = ac->hash_next;
+  st->accounts_len--;
+  _free(ac);
+}
 
 account_t* evm_get_account(evm_t* evm, address_t adr, wlen_t create) {
   if (!adr) return NULL;
-  account_t* ac = evm->accounts;
+  evm_accounts_t* st = get_accounts(evm);
+  uint32_t        h  = hash_bytes(adr, 20);
 
   // check if we already have the account.
-  while (ac) {
-    if (memcmp(ac->address, adr, 20) == 0) return ac;
-    ac = ac->next;
-  }
-
-  // if this is a internal call take it from the parent
-  if (evm->parent) {
-    ac = evm_get_account(evm->parent, adr, create);
-
-    if (ac) {
-      // clone and add account
-      account_t* a = _malloc(sizeof(account_t));
-      memcpy(a, ac, sizeof(account_t));
-      a->storage    = NULL;
-      a->next       = evm->accounts;
-      evm->accounts = a;
-      return a;
+  for (account_t* ac = st->account_map[h & st->account_mask]; ac; ac = ac->hash_next) {
+    if (memcmp(ac->address, adr, 20) == 0) {
+      journal_account(st, ac);
+      return ac;
     }
   }
 
   // get balance, nonce and code
-  uint8_t *balance, *nonce, *code_size;
-  int      l_balance   = evm->env(evm, EVM_ENV_BALANCE, adr, 20, &balance, 0, 0);
-  int      l_code_size = evm->env(evm, EVM_ENV_CODE_SIZE, adr, 20, &code_size, 0, 0);
-  int      l_nonce     = evm->env(evm, EVM_ENV_NONCE, adr, 20, &nonce, 0, 0);
+  account_t* ac = NULL;
+  uint8_t *  balance, *nonce, *code_size;
+  int        l_balance   = evm->env(evm, EVM_ENV_BALANCE, adr, 20, &balance, 0, 0);
+  int        l_code_size = evm->env(evm, EVM_ENV_CODE_SIZE, adr, 20, &code_size, 0, 0);
+  int        l_nonce     = evm->env(evm, EVM_ENV_NONCE, adr, 20, &nonce, 0, 0);
 
   if (l_balance >= 0) optimize_len(balance, l_balance);
   if (l_nonce >= 0) optimize_len(nonce, l_nonce);
@@ -88,14 +181,22 @@ account_t* evm_get_account(evm_t* evm, address_t adr, wlen_t create) {
     if (ac->code.len)
       evm->env(evm, EVM_ENV_CODE_COPY, adr, 20, &ac->code.data, 0, 0);
 
-    // add to accounts
-    ac->storage   = NULL;
-    ac->next      = evm->accounts;
-    evm->accounts = ac;
-
     // set balance & nonce
     uint256_set(balance, l_balance, ac->balance);
     uint256_set(nonce, l_nonce, ac->nonce);
+
+    // add to accounts
+    if (st->accounts_len > st->account_mask) grow_accounts(st);
+    h                  = h & st->account_mask;
+    ac->next           = st->list;
+    ac->hash_next      = st->account_map[h];
+    ac->checkpoint     = st->checkpoint;
+    st->list           = ac;
+    st->account_map[h] = ac;
+    st->accounts_len++;
+
+    // if a subcall is reverted, the account is removed again
+    if (st->checkpoint) add_journal(st, ac, NULL, 0, true);
   }
   return ac;
 }
@@ -121,136 +222,126 @@ account_t* evm_create_account(evm_t* evm, uint8_t* data, uint32_t l_data, addres
 storage_t* evm_get_storage(evm_t* evm, address_t adr, uint8_t* s_key, wlen_t s_key_len, wlen_t create) {
   account_t* ac = evm_get_account(evm, adr, create);
   if (!ac) return NULL;
-
-  storage_t* s = ac->storage;
+  evm_accounts_t* st = evm->accounts;
 
   // create full word key
   uint8_t key_data[32], *data;
   uint256_set(s_key, s_key_len, key_data);
+  uint32_t h = storage_hash(ac, key_data);
 
   // find existing entry
-  while (s) {
-    if (memcmp(s->key, key_data, 32) == 0) return s;
-    s = s->next;
-  }
-
-  // not found?, but if we have parents, we try to copy the entry from there first
-  if (evm->parent) {
-    storage_t* parent_s = evm_get_storage(evm->parent, adr, s_key, s_key_len, create);
-    if (parent_s) {
-      // clone and add account
-      s = _malloc(sizeof(storage_t));
-      memcpy(s, parent_s, sizeof(storage_t));
-      s->next     = ac->storage;
-      ac->storage = s;
+  for (storage_t* s = st->storage_map[h & st->storage_mask]; s; s = s->hash_next) {
+    if (s->account == ac && memcmp(s->key, key_data, 32) == 0) {
+      journal_storage(st, s);
       return s;
     }
   }
 
   // get storage value from env
-  int l = evm->env(evm, EVM_ENV_STORAGE, s_key, s_key_len, &data, 0, 0);
+  storage_t* s = NULL;
+  int        l = evm->env(evm, EVM_ENV_STORAGE, s_key, s_key_len, &data, 0, 0);
 
   // if it does not exist and we have a value, we set it
   if (create || l > 1 || (l == 1 && *data)) {
     // create with key
     s = _malloc(sizeof(storage_t));
     memcpy(s->key, key_data, 32);
+    uint256_set(data, l < 0 ? 0 : l, s->value);
 
     // add to account
-    s->next     = ac->storage;
-    ac->storage = s;
-
-    // set the value
-    uint256_set(data, l, s->value);
+    if (st->storage_len > st->storage_mask) grow_storage(st);
+    h                  = h & st->storage_mask;
+    s->account         = ac;
+    s->checkpoint      = st->checkpoint;
+    s->next            = ac->storage;
+    s->hash_next       = st->storage_map[h];
+    ac->storage        = s;
+    st->storage_map[h] = s;
+    st->storage_len++;
+
+    // if a subcall is reverted, the storage is removed again
+    if (st->checkpoint) add_journal(st, ac, s, 0, true);
   }
   return s;
 }
 
-void copy_state(evm_t* dst, evm_t* src) {
+void evm_checkpoint(evm_t* evm, evm_t* parent) {
+  evm_accounts_t* st = get_accounts(parent);
+  evm->accounts      = st;
+  evm->journal_pos   = st->journal_len;
+  evm->checkpoint    = st->checkpoint = ++st->checkpoints;
+}
+
+void evm_commit(evm_t* evm, evm_t* parent) {
 
   // first move all logs
-  if (src->logs) {
-    logs_t* last = src->logs;
+  if (evm->logs) {
+    logs_t* last = evm->logs;
     while (last->next) last = last->next;
 
-    last->next = dst->logs;
-    dst->logs  = src->logs;
-    src->logs  = NULL;
+    last->next   = parent->logs;
+    parent->logs = evm->logs;
+    evm->logs    = NULL;
   }
 
-  account_t *sa = src->accounts, *prv = NULL;
-  while (sa) {
-    // find the account in the dst-state
-    account_t *a = dst->accounts, *da = NULL;
-    while (a) {
-      if (memcmp(a->address, sa->address, 20) == 0) {
-        da = a;
-        break;
-      }
-      a = a->next;
-    }
-    if (!da) {
-      // the account does not exist yet, so we simply move it
+  // the changes are now part of the parents checkpoint
+  evm_accounts_t* st = evm->accounts;
+  st->checkpoint     = parent->checkpoint;
 
-      // remove from src
-      if (prv == NULL)
-        src->accounts = sa->next;
-      else
-        prv->next = sa->next;
+  // the root evm is never reverted, so we don't need the journal anymore
+  if (!st->checkpoint) st->journal_len = 0;
+}
 
-      // add to dst
-      sa->next      = dst->accounts;
-      dst->accounts = sa;
+void evm_revert(evm_t* evm, evm_t* parent) {
+  evm_accounts_t* st = evm->accounts;
 
-      // next item...
-      sa = prv == NULL ? src->accounts : prv->next;
-      continue;
+  // undo all changes in reverse order
+  while (st->journal_len > evm->journal_pos) {
+    journal_entry_t* e = st->journal + --st->journal_len;
+    if (e->created) {
+      if (e->storage)
+        remove_storage(st, e->storage);
+      else
+        remove_account(st, e->account);
+    } else if (e->storage) {
+      memcpy(e->storage->value, e->value, 32);
+      e->storage->checkpoint = e->checkpoint;
     } else {
-      // clone data
-      memcpy(da->balance, sa->balance, 32);
-      memcpy(da->nonce, sa->nonce, 32);
-      da->code = sa->code;
-
-      // clone storage
-      storage_t *ss = sa->storage, *ps = NULL, *ds, *s;
-      while (ss) {
-        // find the storage in the parent
-        ds = NULL;
-        s  = da->storage;
-        while (s) {
-          if (memcmp(s->key, ss->key, 32) == 0) {
-            ds = s;
-            break;
-          }
-          s = s->next;
-        }
-
-        if (ds)
-          memcpy(ds->value, ss->value, 32);
-        else {
-          // move the storage to the parent
-          // remove from src
-          if (ps == NULL)
-            sa->storage = ss->next;
-          else
-            ps->next = ss->next;
-
-          // add to dst
-          ss->next    = da->storage;
-          da->storage = ss;
-
-          // next item...
-          ss = ps == NULL ? sa->storage : ps->next;
-          continue;
-        }
-
-        ps = ss;
-        ss = ss->next;
-      }
+      memcpy(e->account->balance, e->value, 32);
+      memcpy(e->account->nonce, e->nonce, 32);
+      e->account->code       = e->code;
+      e->account->checkpoint = e->checkpoint;
+    }
+  }
+  st->checkpoint = parent->checkpoint;
+}
+
+void evm_clear_storage(evm_t* evm, account_t* ac) {
+  evm_accounts_t* st = get_accounts(evm);
+  for (storage_t* s = ac->storage; s; s = s->next) {
+    journal_storage(st, s);
+    memset(s->value, 0, 32);
+  }
+}
+
+void evm_free_accounts(evm_t* evm) {
+  evm_accounts_t* st = evm->accounts;
+  if (!st) return;
+  while (st->list) {
+    account_t* ac = st->list;
+    while (ac->storage) {
+      storage_t* s = ac->storage;
+      ac->storage  = s->next;
+      _free(s);
     }
-    prv = sa;
-    sa  = sa->next;
+    st->list = ac->next;
+    _free(ac);
   }
+  if (st->journal) _free(st->journal);
+  _free(st->account_map);
+  _free(st->storage_map);
+  _free(st);
+  evm->accounts = NULL;
 }
 
 /**
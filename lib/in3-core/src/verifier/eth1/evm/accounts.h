@@ -41,8 +41,20 @@ account_t* evm_get_account(evm_t* evm, address_t adr, wlen_t create);
 /** get account storage */
 storage_t* evm_get_storage(evm_t* evm, address_t adr, uint8_t* s_key, wlen_t s_key_len, wlen_t create);
 
-/** copy state. */
-void copy_state(evm_t* dst, evm_t* src);
+/** starts a subcall by sharing the accounts of the parent and creating a new checkpoint. */
+void evm_checkpoint(evm_t* evm, evm_t* parent);
+
+/** keeps all changes of the subcall and moves its logs to the parent. */
+void evm_commit(evm_t* evm, evm_t* parent);
+
+/** reverts all changes since the checkpoint of the subcall. */
+void evm_revert(evm_t* evm, evm_t* parent);
+
+/** sets the storage of the account to zero. */
+void evm_clear_storage(evm_t* evm, account_t* ac);
+
+/** frees all accounts. */
+void evm_free_accounts(evm_t* evm);
 
 int transfer_value(evm_t* current, address_t from_account, address_t to_account, uint8_t* value, wlen_t value_len, uint32_t base_gas);
 
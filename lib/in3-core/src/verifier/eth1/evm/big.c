@@ -35,9 +35,24 @@
 #include "big.h"
 #include "../../../core/util/utils.h"
 #include "../../../third-party/tommath/tommath.h"
+#include "word.h"
 #include <stdlib.h>
 #include <string.h>
 
+// reads a big endian value of up to 64 bytes into 8 limbs
+static void big_to_limbs(const uint8_t* data, uint32_t len, uint64_t* limbs) {
+  memset(limbs, 0, 8 * sizeof(uint64_t));
+  for (uint32_t i = 0; i < len; i++) limbs[i >> 3] |= (uint64_t) data[len - 1 - i] << ((i & 7) << 3);
+}
+
+// writes n limbs as big endian without leading zeros and returns the length, which is 0 for the value 0
+static uint32_t big_from_limbs(const uint64_t* limbs, int n, uint8_t* dst) {
+  uint32_t l = n * 8;
+  while (l && !(uint8_t)(limbs[(l - 1) >> 3] >> (((l - 1) & 7) << 3))) l--;
+  for (uint32_t i = 0; i < l; i++) dst[l - 1 - i] = limbs[i >> 3] >> ((i & 7) << 3);
+  return l;
+}
+
 uint8_t big_is_zero(uint8_t* data, wlen_t l) {
   optimize_len(data, l);
   return l == 1 && !*data;
@@ -179,6 +194,27 @@ int big_mul(uint8_t* a, wlen_t la, uint8_t* b, wlen_t lb, uint8_t* res, wlen_t m
     return lr;
   }
 
+  if (la <= 32 && lb <= 32) {
+    // multiply with 64-bit limbs
+    uint64_t limbs[8];
+    uint8_t  out[64];
+    word_t   wa, wb;
+    word_from_bytes(&wa, a, la);
+    word_from_bytes(&wb, b, lb);
+    word_mul_wide(&wa, &wb, limbs);
+    wlen_t l = big_from_limbs(limbs, 8, out);
+    if (!l) {
+      *res = 0;
+      return 1;
+    }
+    if (l > max) {
+      memcpy(res, out + l - max, max);
+      return max;
+    }
+    memcpy(res, out, l);
+    return l;
+  }
+
   uint8_t     out[66], *p = out;
   uint32_t    val = 0;
   int_fast8_t i = la + lb, xs = la - 1, ys, x, y;
@@ -245,6 +281,17 @@ int big_exp(uint8_t* a, wlen_t la, uint8_t* b, wlen_t lb, uint8_t* res) {
     }
     if (p != res) memmove(res, p, l);
     return l;
+  } else if (la <= 32 && lb <= 32) {
+    word_t wa, wb, wr;
+    word_from_bytes(&wa, a, la);
+    word_from_bytes(&wb, b, lb);
+    word_exp(&wa, &wb, &wr);
+    wlen_t l = big_from_limbs(wr.limbs, 4, res);
+    if (!l) {
+      *res = 0;
+      return 1;
+    }
+    return l;
   } else {
     uint8_t mod[33];
     memset(mod + 1, 0, 32);
@@ -297,6 +344,28 @@ int big_divmod(uint8_t* n, wlen_t ln, uint8_t* d, wlen_t ld, uint8_t* q, wlen_t*
   optimize_len(n, ln);
   optimize_len(d, ld);
 
+  if (ln <= 64 && ld <= 32 && (ld >= 8 || ln >= 9)) {
+    // divide with 64-bit limbs, unless both values fit into a long, which is handled below
+    uint64_t un[8], qn[8];
+    word_t   wd, wr;
+    big_to_limbs(n, ln, un);
+    word_from_bytes(&wd, d, ld);
+    word_divmod_wide(un, (ln + 7) >> 3, &wd, q ? qn : NULL, remain ? &wr : NULL);
+    if (q) {
+      if (!(*qlen = big_from_limbs(qn, (ln + 7) >> 3, q))) {
+        *q    = 0;
+        *qlen = 1;
+      }
+    }
+    if (remain) {
+      if (!(*remain_len = big_from_limbs(wr.limbs, 4, remain))) {
+        *remain     = 0;
+        *remain_len = 1;
+      }
+    }
+    return 0;
+  }
+
   if (ld < 8) {
     // we can use long here
     uint64_t ur = 0, ud = bytes_to_long(d, ld);
@@ -527,3 +596,47 @@ int big_mod(uint8_t* a, wlen_t la, uint8_t* b, wlen_t lb, wlen_t sig, uint8_t* r
   TRY(big_divmod(a, la, b, lb, tmp, &l2, res, &l));
   return l;
 }
+
+uint32_t big_modexp(uint8_t* base, uint32_t l_base, uint8_t* exp, uint32_t l_exp, uint8_t* mod, uint32_t l_mod, uint8_t* res) {
+  while (l_base && !*base) {
+    base++;
+    l_base--;
+  }
+  while (l_mod && !*mod) {
+    mod++;
+    l_mod--;
+  }
+
+  if (l_mod <= 32 && l_base <= 64) {
+    // montgomery modexp with 64-bit limbs
+    uint64_t limbs[8];
+    word_t   wb, wm, wr;
+    big_to_limbs(base, l_base, limbs);
+    word_from_bytes(&wm, mod, l_mod);
+    word_divmod_wide(limbs, 8, &wm, NULL, &wb);
+    word_modexp(&wb, exp, l_exp, &wm, &wr);
+    return big_from_limbs(wr.limbs, 4, res);
+  }
+
+  // larger inputs are handled by tommath
+  mp_int m_base, m_exp, m_mod, m_res;
+  mp_init(&m_base);
+  mp_init(&m_exp);
+  mp_init(&m_mod);
+  mp_init(&m_res);
+
+  mp_import(&m_base, l_base, 1, sizeof(uint8_t), 1, 0, base);
+  mp_import(&m_exp, l_exp, 1, sizeof(uint8_t), 1, 0, exp);
+  mp_import(&m_mod, l_mod, 1, sizeof(uint8_t), 1, 0, mod);
+
+  m_base.sign = m_exp.sign = m_mod.sign = 0;
+  mp_exptmod(&m_base, &m_exp, &m_mod, &m_res);
+  size_t ml;
+  mp_export(res, &ml, 1, sizeof(uint8_t), 1, 0, &m_res);
+
+  mp_clear(&m_base);
+  mp_clear(&m_exp);
+  mp_clear(&m_mod);
+  mp_clear(&m_res);
+  return ml;
+}
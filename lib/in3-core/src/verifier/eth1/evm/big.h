@@ -55,4 +55,13 @@ int     big_div(uint8_t* a, wlen_t la, uint8_t* b, wlen_t lb, wlen_t sig, uint8_
 int     big_mod(uint8_t* a, wlen_t la, uint8_t* b, wlen_t lb, wlen_t sig, uint8_t* res);
 int     big_exp(uint8_t* a, wlen_t la, uint8_t* b, wlen_t lb, uint8_t* res);
 int     big_log256(uint8_t* a, wlen_t len);
+int     big_divmod(uint8_t* n, wlen_t ln, uint8_t* d, wlen_t ld, uint8_t* q, wlen_t* qlen, uint8_t* remain, wlen_t* remain_len);
+
+/**
+ * calculates base ^ exp % mod for big endian values of any length and returns the length of the result
+ * without leading zeros (0 if the result is 0). res needs at least l_mod bytes.
+ *
+ * moduli of up to 32 bytes use 64-bit limbs and montgomery multiplication, larger inputs use tommath.
+ */
+uint32_t big_modexp(uint8_t* base, uint32_t l_base, uint8_t* exp, uint32_t l_exp, uint8_t* mod, uint32_t l_mod, uint8_t* res);
 #endif
\ No newline at end of file
@@ -48,7 +48,7 @@ void evm_free(evm_t* evm) {
   if (evm->return_data.data) _free(evm->return_data.data);
   if (evm->stack.b.data) _free(evm->stack.b.data);
   if (evm->memory.b.data) _free(evm->memory.b.data);
-  if (evm->invalid_jumpdest) _free(evm->invalid_jumpdest);
+  if (evm->own_jumpdests) _free(evm->jumpdests);
 
 #ifdef EVM_GAS
   logs_t* l = NULL;
@@ -60,20 +60,8 @@ void evm_free(evm_t* evm) {
     _free(l);
   }
 
-  account_t* ac = NULL;
-  storage_t* s  = NULL;
-
-  while (evm->accounts) {
-    ac = evm->accounts;
-    s  = NULL;
-    while (ac->storage) {
-      s           = ac->storage;
-      ac->storage = s->next;
-      _free(s);
-    }
-    evm->accounts = ac->next;
-    _free(ac);
-  }
+  // the accounts are shared with all subcalls, so only the root evm frees them.
+  if (!evm->parent) evm_free_accounts(evm);
 #endif
 }
 
@@ -97,10 +85,12 @@ int evm_prepare_evm(evm_t*      evm,
   evm->memory.bsize  = 32;
   memset(evm->memory.b.data, 0, 32);
 
-  evm->stack_size       = 0;
-  evm->invalid_jumpdest = NULL;
+  evm->stack_size    = 0;
+  evm->jumpdests     = NULL;
+  evm->own_jumpdests = false;
 
   evm->pos   = 0;
+  evm->depth = 0;
   evm->state = EVM_STATE_INIT;
 
   evm->last_returned.data = NULL;
@@ -130,12 +120,14 @@ int evm_prepare_evm(evm_t*      evm,
   evm->address = address;
 
 #ifdef EVM_GAS
-  evm->accounts = NULL;
-  evm->gas      = 0;
-  evm->logs     = NULL;
-  evm->parent   = NULL;
-  evm->refund   = 0;
-  evm->init_gas = 0;
+  evm->accounts    = NULL;
+  evm->gas         = 0;
+  evm->logs        = NULL;
+  evm->parent      = NULL;
+  evm->refund      = 0;
+  evm->init_gas    = 0;
+  evm->checkpoint  = 0;
+  evm->journal_pos = 0;
 #endif
 
   // if the address is NULL this is a CREATE-CALL, so don't try to fetch the code here.
@@ -169,10 +161,21 @@ int evm_sub_call(evm_t*    parent,
                  uint32_t out_offset, uint32_t out_len
 
 ) {
+  // if the max depth is reached the call fails without executing or using any gas for the call itself.
+  // the input is already read from memory, but the output-range still needs to be paid and the return data is reset.
+  if (parent->depth >= EVM_CALL_DEPTH_LIMIT) {
+    if (out_len && mem_check(parent, out_offset + out_len, true) < 0) return EVM_ERROR_OUT_OF_GAS;
+    if (parent->last_returned.data) _free(parent->last_returned.data);
+    parent->last_returned.data = NULL;
+    parent->last_returned.len  = 0;
+    return evm_stack_push_int(parent, 0);
+  }
+
   // create a new evm
   evm_t evm;
   int   res = evm_prepare_evm(&evm, address, code_address, origin, caller, parent->env, parent->env_ptr, mode), success = 0;
 
+  evm.depth           = parent->depth + 1;
   evm.properties      = parent->properties;
   evm.chain_id        = parent->chain_id;
   evm.call_data.data  = data;
@@ -254,6 +257,11 @@ int evm_call(void*     vc,
   evm.call_data.data = data;
   evm.call_data.len  = l_data;
   if (res == 0) res = evm_run(&evm, address);
+
+  // if code was missing, the evm only ran in order to collect the addresses, so the result is ignored.
+  int env_res = in3_finish_env(vc);
+  if (env_res < 0) res = env_res;
+
   if (res == 0 && evm.return_data.data)
     *result = b_dup(&evm.return_data);
   evm_free(&evm);
@@ -32,9 +32,12 @@
  * with this program. If not, see <https://www.gnu.org/licenses/>.
  *******************************************************************************/
 
+#include "../../../core/client/cache.h"
 #include "../../../core/client/keys.h"
 #include "../../../core/client/verifier.h"
 #include "../../../core/util/mem.h"
+#include "../../../core/util/stringbuilder.h"
+#include "evm.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -42,7 +45,8 @@ static in3_ret_t find_code_in_accounts(in3_vctx_t* vc, address_t address, bytes_
   d_token_t* accounts = d_get(vc->proof, K_ACCOUNTS);
   if (!accounts) return IN3_EFIND;
   for (d_iterator_t iter = d_iter(accounts); iter.left; d_iter_next(&iter)) {
-    if (memcmp(d_get_byteskl(iter.token, K_ADDRESS, 20)->data, address, 20) == 0) {
+    bytes_t* adr = d_get_byteskl(iter.token, K_ADDRESS, 20);
+    if (adr && memcmp(adr->data, address, 20) == 0) {
       // even if we don't have a code, we still set the code_hash, since we need it later to verify
       *code_hash    = d_get_bytesk(iter.token, K_CODE_HASH);
       bytes_t* code = d_get_bytesk(iter.token, K_CODE);
@@ -61,16 +65,20 @@ static in3_ret_t find_code_in_accounts(in3_vctx_t* vc, address_t address, bytes_
   return IN3_EFIND;
 }
 
-static in3_ctx_t* find_pending_code_request(in3_vctx_t* vc, address_t address) {
+static in3_ctx_t* find_pending_code_request(in3_vctx_t* vc, address_t address, int* index) {
   // ok, we need a request, do we have a useable?
-  in3_ctx_t* ctx = vc->ctx->required;
-  while (ctx) {
-    if (strcmp(d_get_stringk(ctx->requests[0], K_METHOD), "eth_getCode") == 0) {
+  // since missing code is requested as batch, we need to check all requests of the context.
+  for (in3_ctx_t* ctx = vc->ctx->required; ctx; ctx = ctx->required) {
+    for (int i = 0; i < ctx->len; i++) {
+      char* method = d_get_stringk(ctx->requests[i], K_METHOD);
+      if (!method || strcmp(method, "eth_getCode")) continue;
       // the first param of the eth_getCode is the address
-      bytes_t adr = d_to_bytes(d_get_at(d_get(ctx->requests[0], K_PARAMS), 0));
-      if (adr.len == 20 && memcmp(adr.data, address, 20) == 0) return ctx;
+      bytes_t adr = d_to_bytes(d_get_at(d_get(ctx->requests[i], K_PARAMS), 0));
+      if (adr.len == 20 && memcmp(adr.data, address, 20) == 0) {
+        *index = i;
+        return ctx;
+      }
     }
-    ctx = ctx->required;
   }
   return NULL;
 }
@@ -83,13 +91,14 @@ static in3_ret_t in3_get_code_from_client(in3_vctx_t* vc, char* cache_key, addre
   if (res != IN3_EFIND) return res;
 
   // ok, we need a request, do we have a useable?
-  in3_ctx_t* ctx = find_pending_code_request(vc, address);
+  int        i   = 0;
+  in3_ctx_t* ctx = find_pending_code_request(vc, address, &i);
 
   // if we have found one, we verify the result and return the bytes.
   if (ctx)
     switch (in3_ctx_state(ctx)) {
       case CTX_SUCCESS: {
-        d_token_t* rpc_result = d_get(ctx->responses[0], K_RESULT);
+        d_token_t* rpc_result = d_get(ctx->responses[i], K_RESULT);
         if (!ctx->error && rpc_result) {
           bytes32_t calculated_code_hash;
           bytes_t   code = d_to_bytes(rpc_result);
@@ -114,25 +123,42 @@ static in3_ret_t in3_get_code_from_client(in3_vctx_t* vc, char* cache_key, addre
             vc->ctx->client->cache->set_item(vc->ctx->client->cache->cptr, cache_key, *target);
           return IN3_OK;
         } else
-          return vc_err(vc, ctx->error);
+          return vc_err(vc, ctx->error ? ctx->error : "could not get the code");
       }
       case CTX_ERROR:
         return IN3_ERPC;
       default:
         return IN3_WAITING;
     }
+  else
+    // the code will be requested together with all other missing code after the evm has run (see `in3_request_code`)
+    return IN3_EFIND;
+}
+
+static bytes_t* find_code_hash(in3_vctx_t* vc, address_t address) {
+  for (d_iterator_t iter = d_iter(d_get(vc->proof, K_ACCOUNTS)); iter.left; d_iter_next(&iter)) {
+    // accounts without an address are skipped
+    bytes_t* adr = d_get_byteskl(iter.token, K_ADDRESS, 20);
+    if (adr && memcmp(adr->data, address, 20) == 0)
+      return d_get_byteskl(iter.token, K_CODE_HASH, 32);
+  }
+  return NULL;
+}
+
+static cache_entry_t* add_code_entry(in3_vctx_t* vc, address_t address, bytes_t* code, bool must_free, in3_code_cache_entry_t* shared) {
+  bytes_t key = bytes(_malloc(20), 20);
+  memcpy(key.data, address, 20);
+  cache_entry_t* entry;
+  if (shared)
+    entry = in3_cache_use_code(&vc->ctx->cache, key, shared);
   else {
-    // for subrequests, we always need to allocate the request string, which will be freed when releasing the subrequest.
-    char* req = _malloc(200);
-
-    // we can use the cache_key, since it contains the hexencoded string with a "C"-prefix.
-    snprintX(req, 200, "{\"method\":\"eth_getCode\",\"jsonrpc\":\"2.0\",\"id\":1,\"params\":[\"0x%s\",\"latest\"]}", cache_key + 1);
-    in3_proof_t old_proof  = vc->ctx->client->proof;
-    vc->ctx->client->proof = PROOF_NONE; // we don't need proof since we have the codehash!
-    res                    = ctx_add_required(vc->ctx, ctx_new(vc->ctx->client, req));
-    vc->ctx->client->proof = old_proof;
-    return res;
+    entry            = in3_cache_add_entry(&vc->ctx->cache, key, *code);
+    entry->must_free = must_free;
   }
+
+  // we also store the length into the 4 bytes buffer, so we can reference it later on.
+  int_to_bytes(entry->value.len, entry->buffer);
+  return entry;
 }
 
 in3_ret_t in3_get_code(in3_vctx_t* vc, address_t address, cache_entry_t** target) {
@@ -144,6 +170,15 @@ in3_ret_t in3_get_code(in3_vctx_t* vc, address_t address, cache_entry_t** target
     }
   }
 
+  // hot contracts are kept in memory, so we don't need to read or verify them again.
+  in3_t*                  c         = vc->ctx->client;
+  bytes_t*                code_hash = c->max_code_cache ? find_code_hash(vc, address) : NULL;
+  in3_code_cache_entry_t* shared    = code_hash ? in3_cache_get_code(c, code_hash->data) : NULL;
+  if (shared) {
+    *target = add_code_entry(vc, address, NULL, false, shared);
+    return IN3_OK;
+  }
+
   // the cache key is always "C"+the hexaddress (without prefix)
   char key_str[43];
   key_str[0] = 'C';
@@ -154,8 +189,8 @@ in3_ret_t in3_get_code(in3_vctx_t* vc, address_t address, cache_entry_t** target
   in3_ret_t res;
 
   // not cached yet
-  if (vc->ctx->client->cache)
-    code = vc->ctx->client->cache->get_item(vc->ctx->client->cache->cptr, key_str);
+  if (c->cache)
+    code = c->cache->get_item(c->cache->cptr, key_str);
 
   if (code)
     must_free = 1;
@@ -165,14 +200,56 @@ in3_ret_t in3_get_code(in3_vctx_t* vc, address_t address, cache_entry_t** target
   }
 
   if (code) {
-    bytes_t key = bytes(_malloc(20), 20);
-    memcpy(key.data, address, 20);
-    *target              = in3_cache_add_entry(&vc->ctx->cache, key, *code);
-    (*target)->must_free = must_free;
-
-    // we also store the length into the 4 bytes buffer, so we can reference it later on.
-    int_to_bytes(code->len, (*target)->buffer);
+    // only code matching the codehash may be shared
+    if (code_hash) {
+      bytes32_t calculated_hash;
+      sha3_to(code, calculated_hash);
+      if (memcmp(calculated_hash, code_hash->data, 32) == 0 && (shared = in3_cache_add_code(c, calculated_hash, *code))) {
+        evm_analyse_jumpdests(shared->code, shared->jumpdests);
+        if (must_free) b_free(code);
+      }
+    }
+    *target = add_code_entry(vc, address, code, must_free, shared);
     return IN3_OK;
   }
   return IN3_EFIND;
-}
\ No newline at end of file
+}
+
+in3_ret_t in3_request_code(in3_vctx_t* vc, uint8_t* addresses, int len) {
+  // for subrequests, we always need to allocate the request string, which will be freed when releasing the subrequest.
+  sb_t* sb = sb_new("[");
+  char  tmp[128], hex[41];
+  for (int i = 0; i < len; i++) {
+    bytes_to_hex(addresses + i * 20, 20, hex);
+    snprintX(tmp, sizeof(tmp), "%s{\"method\":\"eth_getCode\",\"jsonrpc\":\"2.0\",\"id\":%i,\"params\":[\"0x%s\",\"latest\"]}", i ? "," : "", i + 1, hex);
+    sb_add_chars(sb, tmp);
+  }
+  sb_add_char(sb, ']');
+  char* req = sb->data;
+  _free(sb);
+
+  in3_proof_t old_proof  = vc->ctx->client->proof;
+  vc->ctx->client->proof = PROOF_NONE; // we don't need proof since we have the codehash!
+  in3_ret_t res          = ctx_add_required(vc->ctx, ctx_new(vc->ctx->client, req));
+  vc->ctx->client->proof = old_proof;
+
+  // even if the request is already finished, the evm needs to run again.
+  return res == IN3_OK ? IN3_WAITING : res;
+}
+
+uint8_t* in3_get_jumpdests(in3_vctx_t* vc, cache_entry_t* code) {
+  // code shared with the code cache was already analysed
+  uint8_t* jumpdests = in3_cache_code_jumpdests(code);
+  if (jumpdests) return jumpdests;
+
+  // the analysis is stored as "J"+address, so all evms of the context can use it.
+  for (cache_entry_t* en = vc->ctx->cache; en; en = en->next) {
+    if (en->key.len == 21 && en->key.data[0] == 'J' && memcmp(en->key.data + 1, code->key.data, 20) == 0) return en->value.data;
+  }
+  bytes_t key = bytes(_malloc(21), 21);
+  key.data[0] = 'J';
+  memcpy(key.data + 1, code->key.data, 20);
+  bytes_t value = bytes(_calloc((code->value.len + 7) / 8, 1), (code->value.len + 7) / 8);
+  evm_analyse_jumpdests(code->value, value.data);
+  return in3_cache_add_entry(&vc->ctx->cache, key, value)->value.data;
+}
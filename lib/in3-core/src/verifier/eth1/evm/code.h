@@ -46,4 +46,17 @@
  */
 in3_ret_t in3_get_code(in3_vctx_t* vc, address_t address, cache_entry_t** target);
 
+/**
+ * requests the code of all given addresses (20 bytes each) with one batched `eth_getCode` subrequest.
+ * Once it is finished, `in3_get_code` takes the code from its response.
+ * returns IN3_WAITING or the error, if the request could not be created.
+ */
+in3_ret_t in3_request_code(in3_vctx_t* vc, uint8_t* addresses, int len);
+
+/**
+ * returns the bitmap of valid jump destinations for the code as returned by `in3_get_code`.
+ * The analysis is only done once per code and context or, if the code is shared with the code cache, once per code.
+ */
+uint8_t* in3_get_jumpdests(in3_vctx_t* vc, cache_entry_t* code);
+
 #endif
\ No newline at end of file
@@ -34,75 +34,282 @@
 
 #include "../../../core/client/keys.h"
 #include "../../../core/client/verifier.h"
+#include "../../../core/util/mem.h"
+#include "../../../core/util/utils.h"
+#include "../nano/eth_nano.h"
 #include "big.h"
 #include "code.h"
 #include "evm.h"
+#include <string.h>
 
-static d_token_t* get_account(in3_vctx_t* vc, d_token_t* accounts, uint8_t* address) {
-  int        i;
-  d_token_t* t = NULL;
+/** an account of the proof with its values decoded once. */
+typedef struct {
+  uint8_t*       address;   /**< the address (20 bytes) */
+  bytes_t        balance;   /**< the balance */
+  bytes_t        nonce;     /**< the nonce */
+  bytes_t*       code_hash; /**< the code hash or NULL if not part of the proof */
+  cache_entry_t* code;      /**< the code entry of the context once it was requested */
+} proof_account_t;
 
-  if (!accounts) {
+/** a storage value of the proof. */
+typedef struct {
+  uint32_t account; /**< index + 1 of the account (0 marks an empty slot in the table) */
+  uint8_t  key[32]; /**< the key as 32 bytes bigendian */
+  bytes_t  value;   /**< the value */
+} proof_slot_t;
+
+/**
+ * the proof of an eth_call indexed by address and by storage key.
+ *
+ * it is built with the first lookup and stored in the cache of the context, so all evms (including subcalls) share it.
+ * Since it points into the response, it is freed again after the call (see `in3_finish_env`).
+ * Code, which is not available yet, is collected here while the evm keeps on running with empty code,
+ * so all of it can be fetched with one request.
+ */
+typedef struct {
+  d_token_t*       accounts;      /**< the accounts of the proof or NULL if there are none */
+  uint32_t         accounts_len;  /**< number of accounts */
+  uint32_t         account_mask;  /**< size - 1 of the account table */
+  uint32_t         slot_mask;     /**< size - 1 of the slot table */
+  proof_account_t* account_list;  /**< the accounts in the order of the proof */
+  proof_slot_t*    slots;         /**< the slot table (open addressing) */
+  uint32_t*        account_table; /**< the account table with index + 1 into account_list (open addressing) */
+  uint8_t*         missing;       /**< the addresses (20 bytes each) of the code, which needs to be fetched */
+  uint32_t         missing_len;   /**< number of missing addresses */
+  bool             waiting;       /**< true if code was requested, but the response is still pending */
+  size_t           error_len;     /**< the length of the error of the context before the evm started, so errors of a run with missing code can be removed again */
+} proof_index_t;
+
+// used as code as long as the real code is not available.
+static uint8_t       no_code[1];
+static cache_entry_t empty_code = {.value = {.data = no_code, .len = 0}};
+
+// FNV-1a
+static uint32_t hash_bytes(const uint8_t* data, int len) {
+  uint32_t h = 2166136261u;
+  for (int i = 0; i < len; i++) h = (h ^ data[i]) * 16777619u;
+  return h;
+}
+
+static uint32_t slot_hash(uint32_t account, const uint8_t* key) {
+  return hash_bytes(key, 32) ^ (account * 2654435761u);
+}
+
+// copies the value to 32 bytes bigendian, returns false if it is too big.
+static bool to_key(const uint8_t* data, int len, uint8_t* key) {
+  while (len > 32 && !*data) {
+    data++;
+    len--;
+  }
+  if (len > 32 || len < 0) return false;
+  memset(key, 0, 32 - len);
+  memcpy(key + 32 - len, data, len);
+  return true;
+}
+
+static uint32_t table_mask(uint32_t len) {
+  uint32_t size = 4;
+  while (size < len * 2) size <<= 1;
+  return size - 1;
+}
+
+static proof_index_t* create_index(d_token_t* accounts) {
+  d_iterator_t iter;
+  uint32_t     n = 0, slots = 0;
+  for (iter = d_iter(accounts); iter.left; d_iter_next(&iter), n++) slots += d_len(d_get(iter.token, K_STORAGE_PROOF));
+
+  // everything is stored in one block, so it is freed with the context
+  uint32_t account_mask = table_mask(n), slot_mask = table_mask(slots);
+  size_t   size         = sizeof(proof_index_t) + n * sizeof(proof_account_t) + (slot_mask + 1) * sizeof(proof_slot_t) + (account_mask + 1) * sizeof(uint32_t);
+  uint8_t* data         = _calloc(1, size);
+
+  proof_index_t* index = (proof_index_t*) data;
+  index->accounts      = accounts;
+  index->account_mask  = account_mask;
+  index->slot_mask     = slot_mask;
+  index->account_list  = (proof_account_t*) (data + sizeof(proof_index_t));
+  index->slots         = (proof_slot_t*) (index->account_list + n);
+  index->account_table = (uint32_t*) (index->slots + slot_mask + 1);
+
+  for (iter = d_iter(accounts); iter.left; d_iter_next(&iter)) {
+    bytes_t* address = d_get_byteskl(iter.token, K_ADDRESS, 20);
+    if (!address) continue;
+
+    // if an address is listed twice, the first one wins.
+    uint32_t h = hash_bytes(address->data, 20) & account_mask;
+    while (index->account_table[h] && memcmp(index->account_list[index->account_table[h] - 1].address, address->data, 20)) h = (h + 1) & account_mask;
+    if (index->account_table[h]) continue;
+
+    proof_account_t* ac     = index->account_list + index->accounts_len;
+    ac->address             = address->data;
+    ac->balance             = d_to_bytes(d_get(iter.token, K_BALANCE));
+    ac->nonce               = d_to_bytes(d_get(iter.token, K_NONCE));
+    ac->code_hash           = d_get_byteskl(iter.token, K_CODE_HASH, 32);
+    index->account_table[h] = ++index->accounts_len;
+
+    for (d_iterator_t sp = d_iter(d_get(iter.token, K_STORAGE_PROOF)); sp.left; d_iter_next(&sp)) {
+      bytes_t      k = d_to_bytes(d_get(sp.token, K_KEY));
+      proof_slot_t slot;
+      if (!k.data || !to_key(k.data, k.len, slot.key)) continue;
+      slot.account = index->accounts_len;
+      slot.value   = d_to_bytes(d_get(sp.token, K_VALUE));
+
+      h = slot_hash(slot.account, slot.key) & slot_mask;
+      while (index->slots[h].account && (index->slots[h].account != slot.account || memcmp(index->slots[h].key, slot.key, 32))) h = (h + 1) & slot_mask;
+      if (!index->slots[h].account) index->slots[h] = slot;
+    }
+  }
+  return index;
+}
+
+// the index is stored in the cache of the context with the key 'P'
+static bool is_index(cache_entry_t* en) {
+  return en->key.len == 1 && *en->key.data == 'P';
+}
+
+static proof_index_t* get_index(in3_vctx_t* vc) {
+  for (cache_entry_t **p = &vc->ctx->cache, *en = *p; en; p = &en->next, en = *p) {
+    if (is_index(en)) {
+      // we move it to the front, since it is used for every lookup
+      if (p != &vc->ctx->cache) {
+        *p             = en->next;
+        en->next       = vc->ctx->cache;
+        vc->ctx->cache = en;
+      }
+      return (proof_index_t*) en->value.data;
+    }
+  }
+
+  proof_index_t* index = create_index(d_get(vc->proof, K_ACCOUNTS));
+  index->error_len     = vc->ctx->error ? strlen(vc->ctx->error) : 0;
+  bytes_t        k     = bytes(_malloc(1), 1);
+  *k.data              = 'P';
+  in3_cache_add_entry(&vc->ctx->cache, k, bytes((uint8_t*) index, sizeof(proof_index_t)));
+  return index;
+}
+
+int in3_finish_env(void* ptr) {
+  in3_vctx_t* vc = ptr;
+  if (!vc || !vc->ctx) return IN3_OK;
+  for (cache_entry_t **p = &vc->ctx->cache, *en = *p; en; p = &en->next, en = *p) {
+    if (is_index(en)) {
+      proof_index_t* index = (proof_index_t*) en->value.data;
+      in3_ret_t      res   = index->waiting ? IN3_WAITING : IN3_OK;
+
+      // with missing code the evm took branches the real code may not take, so the errors of this run are removed.
+      // new errors are always put in front of the existing ones.
+      if ((index->waiting || index->missing) && vc->ctx->error && strlen(vc->ctx->error) > index->error_len) {
+        char* error    = vc->ctx->error;
+        vc->ctx->error = index->error_len ? _strdupn(error + strlen(error) - index->error_len, index->error_len) : NULL;
+        _free(error);
+      }
+
+      if (index->missing) {
+        res = in3_request_code(vc, index->missing, index->missing_len);
+        _free(index->missing);
+      }
+      *p       = en->next;
+      en->next = NULL;
+      in3_cache_free(en);
+      return res;
+    }
+  }
+  return IN3_OK;
+}
+
+static void add_missing(proof_index_t* index, uint8_t* address) {
+  for (uint32_t i = 0; i < index->missing_len; i++) {
+    if (memcmp(index->missing + i * 20, address, 20) == 0) return;
+  }
+  index->missing = index->missing
+                       ? _realloc(index->missing, (index->missing_len + 1) * 20, index->missing_len * 20)
+                       : _malloc(20);
+  memcpy(index->missing + index->missing_len++ * 20, address, 20);
+}
+
+static proof_account_t* get_account(in3_vctx_t* vc, proof_index_t* index, uint8_t* address) {
+  if (!index->accounts) {
     vc_err(vc, "no accounts");
     return NULL;
   }
-  for (i = 0, t = accounts + 1; i < d_len(accounts); i++, t = d_next(t)) {
-    if (memcmp(d_get_byteskl(t, K_ADDRESS, 20)->data, address, 20) == 0)
-      return t;
+  for (uint32_t h = hash_bytes(address, 20) & index->account_mask; index->account_table[h]; h = (h + 1) & index->account_mask) {
+    proof_account_t* ac = index->account_list + index->account_table[h] - 1;
+    if (memcmp(ac->address, address, 20) == 0) return ac;
   }
   vc_err(vc, "The account could not be found!");
   return NULL;
 }
 
-int in3_get_env(void* evm_ptr, uint16_t evm_key, uint8_t* in_data, int in_len, uint8_t** out_data, int offset, int len) {
-  bytes_t*  res = NULL;
-  in3_ret_t ret = IN3_OK;
+static bytes_t* get_storage(proof_index_t* index, proof_account_t* ac, uint8_t* key_data, int key_len) {
+  uint8_t  key[32];
+  uint32_t account = ac - index->account_list + 1;
+  if (!to_key(key_data, key_len, key)) return NULL;
+  for (uint32_t h = slot_hash(account, key) & index->slot_mask; index->slots[h].account; h = (h + 1) & index->slot_mask) {
+    if (index->slots[h].account == account && memcmp(index->slots[h].key, key, 32) == 0) return &index->slots[h].value;
+  }
+  return NULL;
+}
+
+// the code entries are kept in the index, so we don't need to search the context cache again.
+static in3_ret_t get_code(in3_vctx_t* vc, proof_index_t* index, uint8_t* address, cache_entry_t** entry) {
+  proof_account_t* ac = NULL;
+  for (uint32_t h = hash_bytes(address, 20) & index->account_mask; index->account_table[h] && !ac; h = (h + 1) & index->account_mask) {
+    if (memcmp(index->account_list[index->account_table[h] - 1].address, address, 20) == 0) ac = index->account_list + index->account_table[h] - 1;
+  }
+  if (ac && ac->code) {
+    *entry = ac->code;
+    return IN3_OK;
+  }
+  in3_ret_t ret = in3_get_code(vc, address, entry);
+  if (ret == IN3_OK && ac) ac->code = *entry;
 
-  d_token_t *t, *t2;
-  int        i;
+  // instead of stopping, we keep on running with empty code in order to find all missing code within one run.
+  if (ret == IN3_EFIND || ret == IN3_WAITING) {
+    if (ret == IN3_WAITING)
+      index->waiting = true;
+    else
+      add_missing(index, address);
+    *entry = &empty_code;
+    return IN3_OK;
+  }
+  return ret;
+}
+
+int in3_get_env(void* evm_ptr, uint16_t evm_key, uint8_t* in_data, int in_len, uint8_t** out_data, int offset, int len) {
+  in3_ret_t        ret = IN3_OK;
+  proof_account_t* ac;
+  bytes_t*         b;
 
   evm_t* evm = evm_ptr;
   if (!evm) return EVM_ERROR_INVALID_ENV;
   in3_vctx_t* vc = evm->env_ptr;
   if (!vc) return EVM_ERROR_INVALID_ENV;
+  proof_index_t* index = get_index(vc);
 
   switch (evm_key) {
     case EVM_ENV_BLOCKHEADER:
-      if (!(res = d_get_bytesk(vc->proof, K_BLOCK)))
+      if (!(b = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), NULL)))
         return EVM_ERROR_INVALID_ENV;
-      *out_data = res->data;
-      return res->len;
+      *out_data = b->data;
+      return b->len;
 
     case EVM_ENV_BALANCE:
-      if (!(t = get_account(vc, d_get(vc->proof, K_ACCOUNTS), in_data)) || !(t = d_get(t, K_BALANCE)))
+      if (!(ac = get_account(vc, index, in_data)) || !ac->balance.data)
         return EVM_ERROR_INVALID_ENV;
-      bytes_t b1 = d_to_bytes(t);
-      *out_data  = b1.data;
-      return b1.len;
+      *out_data = ac->balance.data;
+      return ac->balance.len;
 
     case EVM_ENV_NONCE:
-      if (!(t = get_account(vc, d_get(vc->proof, K_ACCOUNTS), in_data)) || !(t = d_get(t, K_NONCE)))
+      if (!(ac = get_account(vc, index, in_data)) || !ac->nonce.data)
         return EVM_ERROR_INVALID_ENV;
-      bytes_t b2 = d_to_bytes(t);
-      *out_data  = b2.data;
-      return b2.len;
+      *out_data = ac->nonce.data;
+      return ac->nonce.len;
 
     case EVM_ENV_STORAGE:
-      if (!(t = get_account(vc, d_get(vc->proof, K_ACCOUNTS), evm->address)) || !(t = d_get(t, K_STORAGE_PROOF)))
+      if (!(ac = get_account(vc, index, evm->address)) || !(b = get_storage(index, ac, in_data, in_len)) || !b->data)
         return EVM_ERROR_INVALID_ENV;
-
-      for (i = 0, t2 = t + 1; i < d_len(t); i++, t2 = d_next(t2)) {
-        bytes_t k = d_to_bytes(d_get(t2, K_KEY));
-        if (!k.data) return EVM_ERROR_INVALID_ENV;
-
-        if (big_cmp(in_data, in_len, k.data, k.len) == 0) {
-          k = d_to_bytes(d_get(t2, K_VALUE));
-          if (!k.data) return EVM_ERROR_INVALID_ENV;
-          *out_data = k.data;
-          return k.len;
-        }
-      }
-      return EVM_ERROR_INVALID_ENV;
+      *out_data = b->data;
+      return b->len;
 
     case EVM_ENV_BLOCKHASH:
       return EVM_ERROR_UNSUPPORTED_CALL_OPCODE;
@@ -110,7 +317,7 @@ int in3_get_env(void* evm_ptr, uint16_t evm_key, uint8_t* in_data, int in_len, u
     case EVM_ENV_CODE_SIZE: {
       if (in_len != 20) return EVM_ERROR_INVALID_ENV;
       cache_entry_t* entry = NULL;
-      ret                  = in3_get_code(vc, in_data, &entry);
+      ret                  = get_code(vc, index, in_data, &entry);
       if (ret < 0) return ret;
       if (!entry) return EVM_ERROR_INVALID_ENV;
       *out_data = entry->buffer;
@@ -118,17 +325,25 @@ int in3_get_env(void* evm_ptr, uint16_t evm_key, uint8_t* in_data, int in_len, u
     }
     case EVM_ENV_CODE_HASH: {
       if (in_len != 20) return EVM_ERROR_INVALID_ENV;
-      if (!(t = get_account(vc, d_get(vc->proof, K_ACCOUNTS), evm->address)) || !(t = d_get(t, K_STORAGE_PROOF)))
+      if (!(ac = get_account(vc, index, in_data)) || !ac->code_hash)
         return EVM_ERROR_INVALID_ENV;
-      t = d_getl(t, K_CODE_HASH, 32);
-      if (!t) return EVM_ERROR_INVALID_ENV;
-      *out_data = t->data;
+      *out_data = ac->code_hash->data;
       return 32;
     }
+    case EVM_ENV_JUMPDESTS: {
+      if (in_len != 20) return EVM_ERROR_INVALID_ENV;
+      cache_entry_t* entry = NULL;
+      ret                  = get_code(vc, index, in_data, &entry);
+      if (ret < 0) return ret;
+      // only if the evm is running this code, we can share the analysis
+      if (!entry || !entry->value.len || entry->value.data != evm->code.data) return EVM_ERROR_INVALID_ENV;
+      *out_data = in3_get_jumpdests(vc, entry);
+      return (entry->value.len + 7) / 8;
+    }
     case EVM_ENV_CODE_COPY: {
       if (in_len != 20) return EVM_ERROR_INVALID_ENV;
       cache_entry_t* entry = NULL;
-      ret                  = in3_get_code(vc, in_data, &entry);
+      ret                  = get_code(vc, index, in_data, &entry);
       if (ret < 0) return ret;
       if (!entry) return EVM_ERROR_INVALID_ENV;
       *out_data = entry->value.data + offset;
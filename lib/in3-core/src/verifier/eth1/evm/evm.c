@@ -47,6 +47,91 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef EVM_WORD_STACK
+
+int evm_stack_push(evm_t* evm, uint8_t* data, uint8_t len) {
+  word_t* w;
+  uint8_t tmp[32];
+  if (len > 32) return EVM_ERROR_STACK_LIMIT;
+  if (data >= evm->stack.b.data && data < evm->stack.b.data + evm->stack.bsize) {
+    // the data is part of a popped slot, which may be the one we push to
+    memcpy(tmp, data, len);
+    data = tmp;
+  }
+  int res = evm_stack_push_word(evm, &w);
+  if (res) return res;
+  word_from_bytes(w, data, len);
+  return 0;
+}
+
+int evm_stack_push_int(evm_t* evm, uint32_t val) {
+  return evm_stack_push_long(evm, val);
+}
+
+int evm_stack_push_long(evm_t* evm, uint64_t val) {
+  word_t* w;
+  int     res = evm_stack_push_word(evm, &w);
+  if (res) return res;
+  word_set(w, val);
+  return 0;
+}
+
+// converts the popped slot to big endian bytes, so it can be used as ref and returns the length without leading zeros.
+static int word_to_ref(word_t* w, uint8_t** dst) {
+  uint8_t tmp[32], l = 32, *p = tmp;
+  word_to_bytes(w, tmp);
+  optimize_len(p, l);
+  *dst = ((uint8_t*) w) + 32 - l;
+  memcpy(*dst, p, l);
+  return l;
+}
+
+int evm_stack_pop(evm_t* evm, uint8_t* dst, uint8_t len) {
+  word_t* w;
+  if (evm_stack_pop_word(evm, &w)) return EVM_ERROR_EMPTY_STACK;
+  if (!dst) {
+    wlen_t l = word_bytes(w);
+    return l ? l : 1;
+  }
+  uint8_t* p;
+  int      l = word_to_ref(w, &p);
+  if (l <= len) {
+    memset(dst, 0, len - l);
+    memcpy(dst + len - l, p, l);
+  } else
+    memcpy(dst, p + l - len, len);
+  return l;
+}
+
+int evm_stack_pop_ref(evm_t* evm, uint8_t** dst) {
+  word_t* w;
+  if (evm_stack_pop_word(evm, &w)) return EVM_ERROR_EMPTY_STACK;
+  return word_to_ref(w, dst);
+}
+
+int evm_stack_pop_byte(evm_t* evm, uint8_t* dst) {
+  word_t* w;
+  if (evm_stack_pop_word(evm, &w)) return EVM_ERROR_EMPTY_STACK;
+  if (!word_fits(w, 0xFF)) return -3;
+  *dst = w->limbs[0] & 0xFF;
+  return 1;
+}
+
+int evm_stack_peek_len(evm_t* evm) {
+  word_t* w = evm_stack_peek_word(evm, 1);
+  if (!w) return EVM_ERROR_EMPTY_STACK;
+  wlen_t l = word_bytes(w);
+  return l ? l : 1;
+}
+
+int32_t evm_stack_pop_int(evm_t* evm) {
+  word_t* w;
+  if (evm_stack_pop_word(evm, &w)) return EVM_ERROR_EMPTY_STACK;
+  return word_fits(w, 0xFFFFFFF) ? (int32_t) w->limbs[0] : 0xFFFFFFF;
+}
+
+#else
+
 int evm_stack_push(evm_t* evm, uint8_t* data, uint8_t len) {
   if (evm->stack_size == EVM_STACK_LIMIT || len > 32) return EVM_ERROR_STACK_LIMIT;
   if (&evm->stack.b.len + len > &evm->stack.bsize) {
@@ -201,6 +286,8 @@ int evm_stack_push_bn(evm_t* evm, bignum256* val) {
   evm->stack_size++;
   return 0;
 }
+#endif
+
 /*
 I:79338654 267     3 63 : PUSH4      [ 364087e | 1 | 945304eb96065b2a98b57a48a06ae28d285a71b5 | ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff | ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff | ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff | 
 P:79338654 267     3 63 : PUSH4      [ 364087e | 1 | 945304eb96065b2a98b57a48a06ae28d285a71b5 | ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff | ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff | ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff |
@@ -329,7 +416,13 @@ void evm_print_stack(evm_t* evm, uint64_t last_gas, uint32_t pos) {
   in3_log_trace(" [ ");
   for (int i = 0; i < evm->stack_size; i++) {
     uint8_t* dst = NULL;
-    int      l   = evm_stack_get_ref(evm, i + 1, &dst);
+#ifdef EVM_WORD_STACK
+    uint8_t tmp[32];
+    int     l = 32;
+    word_to_bytes(evm_stack_peek_word(evm, i + 1), dst = tmp);
+#else
+    int l = evm_stack_get_ref(evm, i + 1, &dst);
+#endif
     optimize_len(dst, l);
     for (int j = 0; j < l; j++) {
       if (j == 0 && dst[j] < 16) {
@@ -513,22 +606,16 @@ int evm_execute(evm_t* evm) {
   }
 }
 
-int evm_run(evm_t* evm, address_t code_address) {
-
-  INIT_GAS(evm);
-
-  // for precompiled we simply execute it there
-  if (evm_is_precompiled(evm, code_address))
-    return evm_run_precompiled(evm, code_address);
-  // timeout is simply used in case we don't use gas to make sure we don't run a infite loop.
-  uint32_t timeout = 0xFFFFFFFF;
-  int      res     = 0;
+/**
+ * executes the opcodes one by one through evm_execute.
+ *
+ * This is the portable interpreter and also takes over from the threaded core, whenever the gas left is not enough for a full block.
+ */
+static int evm_run_switch(evm_t* evm, int res, uint32_t timeout) {
 #ifdef DEBUG
   uint32_t last     = 0;
   uint64_t last_gas = 0;
 #endif
-  // inital state
-  evm->state = EVM_STATE_RUNNING;
 
   // loop opcodes
   while (res >= 0 && evm->state == EVM_STATE_RUNNING && evm->pos < evm->code.len) {
@@ -546,6 +633,305 @@ int evm_run(evm_t* evm, address_t code_address) {
 #endif
     if ((timeout--) == 0) return EVM_ERROR_TIMEOUT;
   }
+  return res;
+}
+
+#if defined(__GNUC__) && !defined(EVM_NO_THREADING)
+#define EVM_THREADED
+#endif
+
+#ifdef EVM_THREADED
+
+#ifdef EVM_GAS
+/**
+ * static gas of the opcodes, the threaded core executes inline.
+ * All other opcodes (marked with 0) are passed to evm_execute, which also charges their gas.
+ */
+static const uint8_t hot_gas[256] = {
+    [0x01]          = G_VERY_LOW, // ADD
+    [0x02]          = G_LOW,      // MUL
+    [0x03]          = G_VERY_LOW, // SUB
+    [0x04]          = G_LOW,      // DIV
+    [0x05]          = G_LOW,      // SDIV
+    [0x06]          = G_LOW,      // MOD
+    [0x07]          = G_LOW,      // SMOD
+    [0x08]          = G_MID,      // ADDMOD
+    [0x09]          = G_MID,      // MULMOD
+    [0x0B]          = G_LOW,      // SIGNEXTEND
+    [0x10 ... 0x1D] = G_VERY_LOW, // LT ... SAR
+    [0x30]          = G_BASE,     // ADDRESS
+    [0x32]          = G_BASE,     // ORIGIN
+    [0x33]          = G_BASE,     // CALLER
+    [0x34]          = G_BASE,     // CALLVALUE
+    [0x35]          = G_VERY_LOW, // CALLDATALOAD
+    [0x36]          = G_BASE,     // CALLDATASIZE
+    [0x38]          = G_BASE,     // CODESIZE
+    [0x50]          = G_BASE,     // POP
+    [0x56]          = G_MID,      // JUMP
+    [0x57]          = G_HIGH,     // JUMPI
+    [0x58]          = G_BASE,     // PC
+    [0x5B]          = G_JUMPDEST, // JUMPDEST
+    [0x60 ... 0x7F] = G_VERY_LOW, // PUSH
+    [0x80 ... 0x8F] = G_VERY_LOW, // DUP
+    [0x90 ... 0x9F] = G_VERY_LOW, // SWAP
+};
+
+/**
+ * creates a table holding the static gas for each basic block, stored at the position of its first opcode.
+ *
+ * A block starts at the beginning of the code, at each JUMPDEST and after each JUMP, JUMPI or cold opcode.
+ */
+static uint32_t* evm_block_gas(bytes_t* code) {
+  uint32_t* blocks = _calloc(code->len + 1, sizeof(uint32_t));
+  uint32_t  start  = 0;
+  for (uint32_t i = 0; i < code->len; i++) {
+    uint8_t op = code->data[i];
+    if (!hot_gas[op]) {
+      start = i + 1;
+      continue;
+    }
+    if (op == 0x5B) start = i;
+    blocks[start] += hot_gas[op];
+    if (op >= 0x60 && op <= 0x7F)
+      i += op - 0x5F;
+    else if (op == 0x56 || op == 0x57)
+      start = i + 1;
+  }
+  return blocks;
+}
+
+// charges the block starting at p or hands over to the switch core, if the gas is not enough.
+#define CHARGE_BLOCK(p)            \
+  {                                \
+    uint32_t _p = (p);             \
+    if (blocks[_p]) {              \
+      if (evm->gas < blocks[_p]) { \
+        evm->pos = _p;             \
+        goto fallback;             \
+      }                            \
+      evm->gas -= blocks[_p];      \
+    }                              \
+  }
+// enters the block at the current position, unless it starts with a JUMPDEST, which charges its block itself.
+#define ENTER_BLOCK()                                                 \
+  {                                                                   \
+    if (evm->pos < evm->code.len && evm->code.data[evm->pos] != 0x5B) \
+      CHARGE_BLOCK(evm->pos)                                          \
+  }
+#else
+#define ENTER_BLOCK() \
+  {}
+#endif
+
+#define NEXT_OP()                             \
+  {                                           \
+    if (evm->pos >= evm->code.len) goto done; \
+    op = evm->code.data[evm->pos++];          \
+    goto* ops[op];                            \
+  }
+#define HOT_OP(m)                   \
+  {                                 \
+    if ((res = (m)) < 0) goto done; \
+    NEXT_OP()                       \
+  }
+#define CHECK_TIMEOUT()      \
+  if ((timeout--) == 0) {    \
+    res = EVM_ERROR_TIMEOUT; \
+    goto done;               \
+  }
+
+/**
+ * executes the code with computed goto dispatch.
+ *
+ * The opcodes listed in hot_gas are executed inline, while their static gas is charged once per basic block.
+ */
+static int evm_run_threaded(evm_t* evm, uint32_t timeout) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+  static const void* const ops[256] = {
+      [0x00 ... 0xFF] = &&do_cold,
+      [0x01]          = &&do_add,
+      [0x02]          = &&do_mul,
+      [0x03]          = &&do_sub,
+      [0x04]          = &&do_div,
+      [0x05]          = &&do_sdiv,
+      [0x06]          = &&do_mod,
+      [0x07]          = &&do_smod,
+      [0x08]          = &&do_addmod,
+      [0x09]          = &&do_mulmod,
+      [0x0B]          = &&do_signextend,
+      [0x10]          = &&do_lt,
+      [0x11]          = &&do_gt,
+      [0x12]          = &&do_slt,
+      [0x13]          = &&do_sgt,
+      [0x14]          = &&do_eq,
+      [0x15]          = &&do_iszero,
+      [0x16]          = &&do_and,
+      [0x17]          = &&do_or,
+      [0x18]          = &&do_xor,
+      [0x19]          = &&do_not,
+      [0x1A]          = &&do_byte,
+      [0x1B]          = &&do_shl,
+      [0x1C]          = &&do_shr,
+      [0x1D]          = &&do_sar,
+      [0x30]          = &&do_address,
+      [0x32]          = &&do_origin,
+      [0x33]          = &&do_caller,
+      [0x34]          = &&do_callvalue,
+      [0x35]          = &&do_calldataload,
+      [0x36]          = &&do_calldatasize,
+      [0x38]          = &&do_codesize,
+      [0x50]          = &&do_pop,
+      [0x56]          = &&do_jump,
+      [0x57]          = &&do_jumpi,
+      [0x58]          = &&do_pc,
+      [0x5B]          = &&do_jumpdest,
+      [0x60 ... 0x7F] = &&do_push,
+      [0x80 ... 0x8F] = &&do_dup,
+      [0x90 ... 0x9F] = &&do_swap,
+  };
+#pragma GCC diagnostic pop
+
+  int      res  = 0;
+  uint8_t  op   = 0;
+  uint32_t next = 0;
+#ifdef EVM_GAS
+  uint32_t* blocks = evm_block_gas(&evm->code);
+#endif
+
+  ENTER_BLOCK()
+  NEXT_OP()
+
+do_push:
+  HOT_OP(op_push(evm, op - 0x5F))
+do_dup:
+  HOT_OP(op_dup(evm, op - 0x7F))
+do_swap:
+  HOT_OP(op_swap(evm, op - 0x8E))
+do_add:
+  HOT_OP(op_math(evm, MATH_ADD, 0))
+do_mul:
+  HOT_OP(op_math(evm, MATH_MUL, 0))
+do_sub:
+  HOT_OP(op_math(evm, MATH_SUB, 0))
+do_div:
+  HOT_OP(op_math(evm, MATH_DIV, 0))
+do_sdiv:
+  HOT_OP(op_math(evm, MATH_SDIV, 0))
+do_mod:
+  HOT_OP(op_math(evm, MATH_MOD, 0))
+do_smod:
+  HOT_OP(op_math(evm, MATH_SMOD, 0))
+do_addmod:
+  HOT_OP(op_math(evm, MATH_ADD, 1))
+do_mulmod:
+  HOT_OP(op_math(evm, MATH_MUL, 1))
+do_signextend:
+  HOT_OP(op_signextend(evm))
+do_lt:
+  HOT_OP(op_cmp(evm, -1, 0))
+do_gt:
+  HOT_OP(op_cmp(evm, 1, 0))
+do_slt:
+  HOT_OP(op_cmp(evm, -1, 1))
+do_sgt:
+  HOT_OP(op_cmp(evm, 1, 1))
+do_eq:
+  HOT_OP(op_cmp(evm, 0, 0))
+do_iszero:
+  HOT_OP(op_is_zero(evm))
+do_and:
+  HOT_OP(op_bit(evm, OP_AND))
+do_or:
+  HOT_OP(op_bit(evm, OP_OR))
+do_xor:
+  HOT_OP(op_bit(evm, OP_XOR))
+do_not:
+  HOT_OP(op_not(evm))
+do_byte:
+  HOT_OP(op_byte(evm))
+do_shl:
+  HOT_OP(op_shift(evm, 1))
+do_shr:
+  HOT_OP(op_shift(evm, 0))
+do_sar:
+  HOT_OP(op_shift(evm, 2))
+do_address:
+  HOT_OP(evm_stack_push(evm, evm->address, 20))
+do_origin:
+  HOT_OP(evm_stack_push(evm, evm->origin, 20))
+do_caller:
+  HOT_OP(evm_stack_push(evm, evm->caller, 20))
+do_callvalue:
+  HOT_OP(evm_stack_push(evm, evm->call_value.data, evm->call_value.len))
+do_calldataload:
+  HOT_OP(op_dataload(evm))
+do_calldatasize:
+  HOT_OP(evm_stack_push_int(evm, evm->call_data.len))
+do_codesize:
+  HOT_OP(evm_stack_push_int(evm, evm->code.len))
+do_pop:
+  HOT_OP(evm_stack_pop(evm, NULL, 0))
+do_pc:
+  HOT_OP(evm_stack_push_int(evm, evm->pos - 1))
+do_jump:
+  // a valid destination is always a JUMPDEST, which charges its block
+  CHECK_TIMEOUT()
+  HOT_OP(op_jump(evm, 0))
+do_jumpi:
+  // only the fallthrough enters the next block here
+  next = evm->pos;
+  CHECK_TIMEOUT()
+  if ((res = op_jump(evm, 1)) < 0) goto done;
+  if (evm->pos == next) ENTER_BLOCK()
+  NEXT_OP()
+do_jumpdest:
+#ifdef EVM_GAS
+  CHARGE_BLOCK(evm->pos - 1)
+#endif
+  res = 0;
+  NEXT_OP()
+do_cold:
+  evm->pos--;
+  if ((res = evm_execute(evm)) < 0 || evm->state != EVM_STATE_RUNNING) goto done;
+  CHECK_TIMEOUT()
+  ENTER_BLOCK()
+  NEXT_OP()
+
+#ifdef EVM_GAS
+fallback:
+  res = evm_run_switch(evm, res, timeout);
+#endif
+done:
+#ifdef EVM_GAS
+  _free(blocks);
+#endif
+  return res;
+}
+#endif
+
+int evm_run(evm_t* evm, address_t code_address) {
+
+  INIT_GAS(evm);
+
+  // for precompiled we simply execute it there
+  if (evm_is_precompiled(evm, code_address))
+    return evm_run_precompiled(evm, code_address);
+  // timeout is simply used in case we don't use gas to make sure we don't run a infite loop.
+  uint32_t timeout = 0xFFFFFFFF;
+  int      res     = 0;
+
+  // inital state
+  evm->state = EVM_STATE_RUNNING;
+
+#ifdef EVM_THREADED
+  // tracing needs to see every single opcode, so it only works with the switch core.
+  bool use_switch = (evm->properties & EVM_PROP_SWITCH_DISPATCH) != 0;
+  EVM_DEBUG_BLOCK({ use_switch = true; });
+  res = use_switch ? evm_run_switch(evm, res, timeout) : evm_run_threaded(evm, timeout);
+#else
+  res = evm_run_switch(evm, res, timeout);
+#endif
   // done...
 
 #ifdef EVM_GAS
@@ -37,6 +37,9 @@
  * */
 
 #include "../../../core/util/bytes.h"
+#ifdef EVM_WORD_STACK
+#include "word.h"
+#endif
 #ifndef evm_h__
 #define evm_h__
 
@@ -50,13 +53,15 @@ typedef enum evm_state {
 } evm_state_t;
 
 #ifdef EVM_GAS
-#define gas_options       \
-  struct {                \
-    account_t*  accounts; \
-    struct evm* parent;   \
-    logs_t*     logs;     \
-    uint64_t    refund;   \
-    uint64_t    init_gas; \
+#define gas_options                                                                                 \
+  struct {                                                                                          \
+    struct evm_accounts* accounts;    /**< the state shared with all subcalls */                    \
+    struct evm*          parent;      /**< the calling evm or NULL */                               \
+    logs_t*              logs;                                                                      \
+    uint64_t             refund;                                                                    \
+    uint64_t             init_gas;                                                                  \
+    uint32_t             checkpoint;  /**< the checkpoint of the state while this evm is running */ \
+    uint32_t             journal_pos; /**< the length of the journal when this evm started */       \
   }
 #else
 #define gas_options
@@ -83,6 +88,7 @@ typedef enum evm_state {
 #define EVM_PROP_ISTANBUL 32
 #define EVM_PROP_NO_FINALIZE 32768
 #define EVM_PROP_STATIC 256
+#define EVM_PROP_SWITCH_DISPATCH 512 /**< executes the code with the portable switch-based core, even if computed goto is supported */
 
 #define EVM_ENV_BALANCE 1
 #define EVM_ENV_CODE_SIZE 2
@@ -92,6 +98,7 @@ typedef enum evm_state {
 #define EVM_ENV_BLOCKHEADER 6
 #define EVM_ENV_CODE_HASH 7
 #define EVM_ENV_NONCE 8
+#define EVM_ENV_JUMPDESTS 9
 
 #define MATH_ADD 1
 #define MATH_SUB 2
@@ -207,7 +214,10 @@ typedef int (*evm_get_env)(void* evm, uint16_t evm_key, uint8_t* in_data, int in
 typedef struct account_storage {
   bytes32_t               key;
   bytes32_t               value;
-  struct account_storage* next;
+  struct account_storage* next;       /**< the next storage of the same account */
+  struct account_storage* hash_next;  /**< the next storage in the same bucket of the storage map */
+  struct account*         account;    /**< the account owning this storage */
+  uint32_t                checkpoint; /**< the checkpoint, which recorded the last change in the journal */
 } storage_t;
 typedef struct logs {
   bytes_t      topics;
@@ -221,9 +231,43 @@ typedef struct account {
   bytes32_t       nonce;
   bytes_t         code;
   storage_t*      storage;
-  struct account* next;
+  struct account* next;       /**< the next account of the state */
+  struct account* hash_next;  /**< the next account in the same bucket of the account map */
+  uint32_t        checkpoint; /**< the checkpoint, which recorded the last change in the journal */
 } account_t;
 
+/** a entry of the journal holding the values of a account or storage before it was changed. */
+typedef struct journal_entry {
+  account_t* account;    /**< the account */
+  storage_t* storage;    /**< the storage or NULL if the entry is about the account */
+  uint32_t   checkpoint; /**< the checkpoint of the account or storage before */
+  bool       created;    /**< true if it did not exist before, so reverting removes it */
+  bytes32_t  value;      /**< the balance or storage value */
+  bytes32_t  nonce;      /**< the nonce */
+  bytes_t    code;       /**< the code */
+} journal_entry_t;
+
+/**
+ * the accounts of a evm and all its subcalls.
+ *
+ * accounts and storage are found with hash maps. Changes made within a subcall are recorded in the journal,
+ * so reverting a call only needs to restore the values changed since its checkpoint.
+ */
+typedef struct evm_accounts {
+  account_t*       list;          /**< all accounts (the latest first) */
+  account_t**      account_map;   /**< the buckets of the account map */
+  storage_t**      storage_map;   /**< the buckets of the storage map (by account and key) */
+  uint32_t         account_mask;  /**< number of account buckets - 1 */
+  uint32_t         storage_mask;  /**< number of storage buckets - 1 */
+  uint32_t         accounts_len;  /**< number of accounts */
+  uint32_t         storage_len;   /**< number of storage entries */
+  journal_entry_t* journal;       /**< the changes since the first checkpoint */
+  uint32_t         journal_len;   /**< number of entries in the journal */
+  uint32_t         journal_size;  /**< number of allocated entries */
+  uint32_t         checkpoint;    /**< the current checkpoint (0 = no subcall running) */
+  uint32_t         checkpoints;   /**< number of checkpoints created */
+} evm_accounts_t;
+
 typedef struct evm {
   // internal data
   bytes_builder_t stack;
@@ -235,7 +279,8 @@ typedef struct evm {
   evm_state_t     state;
   bytes_t         last_returned;
   bytes_t         return_data;
-  uint32_t*       invalid_jumpdest;
+  uint8_t*        jumpdests;     /**< bitmap of the valid jump destinations, created with the first jump */
+  bool            own_jumpdests; /**< true if the bitmap was created by this evm and must be freed */
 
   // set properties as to which EIPs to use.
   uint32_t properties;
@@ -254,16 +299,52 @@ typedef struct evm {
   bytes_t  call_data;  /**< data send in the tx */
   bytes_t  gas_price;  /**< current gasprice */
   uint64_t gas;
+  uint32_t depth; /**< the call depth, 0 for the root call */
   gas_options;
 
 } evm_t;
 
 int evm_stack_push(evm_t* evm, uint8_t* data, uint8_t len);
-int evm_stack_push_ref(evm_t* evm, uint8_t** dst, uint8_t len);
 int evm_stack_push_int(evm_t* evm, uint32_t val);
 int evm_stack_push_long(evm_t* evm, uint64_t val);
 
-int     evm_stack_get_ref(evm_t* evm, uint8_t pos, uint8_t** dst);
+#define EVM_STACK_LIMIT 1024      /**< max elements of the stack*/
+#define EVM_CALL_DEPTH_LIMIT 1024 /**< max depth of nested calls */
+
+#ifdef EVM_WORD_STACK
+/*
+ * with the word stack each item is a fixed slot of 4 64-bit limbs.
+ * The ref-functions convert the popped slot in place to big endian bytes, 
+ * so the returned pointer is only valid until the next push.
+ */
+#define EVM_STACK_WORDS(evm) ((word_t*) (evm)->stack.b.data)
+
+/** reserves a new slot on top of the stack */
+static inline int evm_stack_push_word(evm_t* evm, word_t** dst) {
+  if (evm->stack_size == EVM_STACK_LIMIT) return EVM_ERROR_STACK_LIMIT;
+  if (evm->stack.b.len + sizeof(word_t) >= evm->stack.bsize && bb_check_size(&evm->stack, sizeof(word_t))) return EVM_ERROR_EMPTY_STACK;
+  *dst = EVM_STACK_WORDS(evm) + evm->stack_size++;
+  evm->stack.b.len += sizeof(word_t);
+  return 0;
+}
+
+/** pops the top slot, which stays valid until the next push */
+static inline int evm_stack_pop_word(evm_t* evm, word_t** dst) {
+  if (evm->stack_size == 0) return EVM_ERROR_EMPTY_STACK;
+  *dst = EVM_STACK_WORDS(evm) + --evm->stack_size;
+  evm->stack.b.len -= sizeof(word_t);
+  return 0;
+}
+
+/** returns the slot at pos (1 = top) or NULL if the stack is too small */
+static inline word_t* evm_stack_peek_word(evm_t* evm, int pos) {
+  return (pos < 1 || pos > evm->stack_size) ? NULL : EVM_STACK_WORDS(evm) + evm->stack_size - pos;
+}
+#else
+int evm_stack_push_ref(evm_t* evm, uint8_t** dst, uint8_t len);
+int evm_stack_get_ref(evm_t* evm, uint8_t pos, uint8_t** dst);
+#endif
+
 int     evm_stack_pop(evm_t* evm, uint8_t* dst, uint8_t len);
 int     evm_stack_pop_ref(evm_t* evm, uint8_t** dst);
 int     evm_stack_pop_byte(evm_t* evm, uint8_t* dst);
@@ -276,6 +357,18 @@ int evm_run(evm_t* evm, address_t code_address);
 #define EVM_CALL_MODE_CALLCODE 3
 #define EVM_CALL_MODE_CALL 4
 
+/**
+ * initializes the evm and fetches the code of the account from the enviroment.
+ */
+int evm_prepare_evm(evm_t*      evm,
+                    address_t   address,
+                    address_t   account,
+                    address_t   origin,
+                    address_t   caller,
+                    evm_get_env env,
+                    void*       env_ptr,
+                    wlen_t      mode);
+
 int evm_sub_call(evm_t*   parent,
                  uint8_t  address[20],
                  uint8_t  account[20],
@@ -289,6 +382,7 @@ int evm_sub_call(evm_t*   parent,
 
 int  evm_ensure_memory(evm_t* evm, uint32_t max_pos);
 int  in3_get_env(void* evm_ptr, uint16_t evm_key, uint8_t* in_data, int in_len, uint8_t** out_data, int offset, int len);
+int  in3_finish_env(void* vc); /**< requests all code, which was missing during the run, with one batch and frees the index of the proof created by in3_get_env. returns IN3_WAITING if the evm needs to run again. */
 int  evm_call(void*    vc,
               uint8_t  address[20],
               uint8_t* value, wlen_t l_value,
@@ -300,6 +394,13 @@ int  evm_call(void*    vc,
 void evm_print_stack(evm_t* evm, uint64_t last_gas, uint32_t pos);
 void evm_free(evm_t* evm);
 
+/**
+ * marks all valid jump destinations of the code in the bitmap.
+ * 
+ * The bitmap must hold (code.len+7)/8 zeroed bytes.
+ */
+void evm_analyse_jumpdests(bytes_t code, uint8_t* jumpdests);
+
 int evm_execute(evm_t* evm);
 
 int evm_run(evm_t* evm, address_t code_address);
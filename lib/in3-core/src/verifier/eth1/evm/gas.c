@@ -48,12 +48,14 @@ void update_account_code(evm_t* evm, account_t* new_account) {
 }
 
 void evm_init(evm_t* evm) {
-  evm->accounts = NULL;
-  evm->gas      = 0;
-  evm->logs     = NULL;
-  evm->parent   = NULL;
-  evm->refund   = 0;
-  evm->init_gas = 0;
+  evm->accounts    = NULL;
+  evm->gas         = 0;
+  evm->logs        = NULL;
+  evm->parent      = NULL;
+  evm->refund      = 0;
+  evm->init_gas    = 0;
+  evm->checkpoint  = 0;
+  evm->journal_pos = 0;
 }
 
 void finalize_and_refund_gas(evm_t* evm) {
@@ -70,9 +72,11 @@ void finalize_and_refund_gas(evm_t* evm) {
 }
 
 void finalize_subcall_gas(evm_t* evm, int success, evm_t* parent) {
-  // if it was successfull we copy the new state to the parent
+  // if it was successfull we keep the new state, otherwise all changes of the call are reverted
   if ((success == 0 || success == EVM_ERROR_SUCCESS_CONSUME_GAS) && evm->state != EVM_STATE_REVERTED)
-    copy_state(parent, evm);
+    evm_commit(evm, parent);
+  else
+    evm_revert(evm, parent);
   // if we have gas left and it was successfull we returen it to the parent process.
   if (success == 0 || success == EVM_ERROR_SUCCESS_CONSUME_GAS) parent->gas += evm->gas;
 }
@@ -97,12 +101,7 @@ int selfdestruct_gas(evm_t* evm) {
   memset(self_account->balance, 0, 32);
   memset(self_account->nonce, 0, 32);
   self_account->code.len = 0;
-  storage_t* s           = NULL;
-  while (self_account->storage) {
-    s                     = self_account->storage;
-    self_account->storage = s->next;
-    _free(s);
-  }
+  evm_clear_storage(evm, self_account);
   evm->state = EVM_STATE_STOPPED;
   return 0;
 }
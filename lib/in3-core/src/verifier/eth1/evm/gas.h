@@ -117,7 +117,6 @@
 #define G_PRE_ECPAIRING 100000        /**< Base gas costs for curve pairing precompile*/
 #define G_PRE_ECPAIRING_WORD 80000    /**< Gas costs regarding curve pairing precompile input length*/
 
-#define EVM_STACK_LIMIT 1024    /**< max elements of the stack*/
 #define EVM_MAX_CODE_SIZE 24576 /**< max size of the code*/
 
 ///  fork values
@@ -147,6 +146,7 @@ void update_account_code(evm_t* evm, account_t* new_account);
 #define UPDATE_SUBCALL_GAS(evm, parent, address, code_address, caller, gas, mode, value, l_value)          \
   do {                                                                                                     \
     evm.parent                = parent;                                                                    \
+    evm_checkpoint(&evm, parent);                                                                          \
     uint64_t max_gas_provided = parent->gas - (parent->gas >> 6);                                          \
     if (!address) {                                                                                        \
       new_account = evm_create_account(&evm, evm.call_data.data, evm.call_data.len, code_address, caller); \
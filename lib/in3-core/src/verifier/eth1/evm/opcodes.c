@@ -49,6 +49,137 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef EVM_WORD_STACK
+
+int op_math(evm_t* evm, uint8_t op, uint8_t mod) {
+  word_t *a, *b, *m = NULL, r;
+  if (evm_stack_pop_word(evm, &a) || evm_stack_pop_word(evm, &b) || (mod && evm_stack_pop_word(evm, &m))) return EVM_ERROR_EMPTY_STACK;
+  switch (op) {
+    case MATH_ADD:
+      if (m)
+        word_addmod(a, b, m, &r);
+      else
+        word_add(a, b, &r);
+      break;
+    case MATH_SUB:
+      word_sub(a, b, &r);
+      break;
+    case MATH_MUL:
+      if (m)
+        word_mulmod(a, b, m, &r);
+      else
+        word_mul(a, b, &r);
+      break;
+    case MATH_DIV:
+      word_divmod(a, b, &r, NULL);
+      break;
+    case MATH_SDIV:
+      word_sdivmod(a, b, &r, NULL);
+      break;
+    case MATH_MOD:
+      word_divmod(a, b, NULL, &r);
+      break;
+    case MATH_SMOD:
+      word_sdivmod(a, b, NULL, &r);
+      break;
+    case MATH_EXP:
+      subgas((evm->properties & EVM_PROP_FRONTIER ? FRONTIER_G_EXPBYTE : G_EXPBYTE) * word_bytes(b));
+      word_exp(a, b, &r);
+      break;
+    default:
+      return EVM_ERROR_INVALID_OPCODE;
+  }
+
+  // the slot of the last popped operand is reused for the result
+  evm_stack_push_word(evm, &a);
+  *a = r;
+  return 0;
+}
+
+int op_signextend(evm_t* evm) {
+  int32_t k = evm_stack_pop_int(evm);
+  if (k < 0) return k;
+  if (k > 31) return 0;
+  word_t* val = evm_stack_peek_word(evm, 1);
+  if (!val) return EVM_ERROR_EMPTY_STACK;
+  word_signextend(val, k, val);
+  return 0;
+}
+
+int op_is_zero(evm_t* evm) {
+  word_t* a = evm_stack_peek_word(evm, 1);
+  if (!a) return EVM_ERROR_EMPTY_STACK;
+  word_set(a, word_is_zero(a));
+  return 0;
+}
+
+int op_not(evm_t* evm) {
+  word_t* a = evm_stack_peek_word(evm, 1);
+  if (!a) return EVM_ERROR_EMPTY_STACK;
+  for (int i = 0; i < 4; i++) a->limbs[i] = ~a->limbs[i];
+  return 0;
+}
+
+int op_bit(evm_t* evm, uint8_t op) {
+  word_t *a, *b;
+  if (evm_stack_pop_word(evm, &a) || !(b = evm_stack_peek_word(evm, 1))) return EVM_ERROR_EMPTY_STACK;
+  for (int i = 0; i < 4; i++) {
+    switch (op) {
+      case OP_AND:
+        b->limbs[i] &= a->limbs[i];
+        break;
+      case OP_OR:
+        b->limbs[i] |= a->limbs[i];
+        break;
+      case OP_XOR:
+        b->limbs[i] ^= a->limbs[i];
+        break;
+      default:
+        return -1;
+    }
+  }
+  return 0;
+}
+
+int op_byte(evm_t* evm) {
+  word_t *pos, *b;
+  if (evm_stack_pop_word(evm, &pos) || !(b = evm_stack_peek_word(evm, 1))) return EVM_ERROR_EMPTY_STACK;
+  if (word_fits(pos, 31)) {
+    // the position counts from the most significant byte
+    uint32_t i = 31 - (uint32_t) pos->limbs[0];
+    word_set(b, (b->limbs[i >> 3] >> ((i & 7) << 3)) & 0xFF);
+  } else
+    word_set(b, 0);
+  return 0;
+}
+
+int op_cmp(evm_t* evm, int8_t eq, uint8_t sig) {
+  word_t *a, *b;
+  if (evm_stack_pop_word(evm, &a) || !(b = evm_stack_peek_word(evm, 1))) return EVM_ERROR_EMPTY_STACK;
+  int c = sig ? word_scmp(a, b) : word_cmp(a, b);
+  word_set(b, eq < 0 ? c < 0 : (eq > 0 ? c > 0 : c == 0));
+  return 0;
+}
+
+int op_shift(evm_t* evm, uint8_t left) {
+  word_t *shift, *b;
+  if ((evm->properties & EVM_PROP_CONSTANTINOPL) == 0) return EVM_ERROR_INVALID_OPCODE;
+  if (evm_stack_pop_word(evm, &shift) || !(b = evm_stack_peek_word(evm, 1))) return EVM_ERROR_EMPTY_STACK;
+  if (!word_fits(shift, 255)) {
+    // the number is out of range, so only the sign of a signed shift remains
+    bool neg = left == 2 && word_is_neg(b);
+    for (int i = 0; i < 4; i++) b->limbs[i] = neg ? UINT64_MAX : 0;
+  } else if (left == 1)
+    word_shl(b, shift->limbs[0], b);
+  else if (left == 0)
+    word_shr(b, shift->limbs[0], b);
+  else
+    word_sar(b, shift->limbs[0], b);
+  return 0;
+}
+
+#else
+
 int op_math(evm_t* evm, uint8_t op, uint8_t mod) {
   uint8_t *a, *b, res[65], *r = res;
   int      la = evm_stack_pop_ref(evm, &a), lb = evm_stack_pop_ref(evm, &b), l;
@@ -275,6 +406,8 @@ int op_shift(evm_t* evm, uint8_t left) {
   return evm_stack_push(evm, b, pos);
 }
 
+#endif
+
 int op_sha3(evm_t* evm) {
   int offset = evm_stack_pop_int(evm);
   if (offset < 0) return offset;
@@ -382,14 +515,26 @@ int op_header(evm_t* evm, uint8_t index) {
 }
 
 int op_mload(evm_t* evm) {
+#ifdef EVM_WORD_STACK
+  uint8_t* off;
+#else
   uint8_t *off, *dst;
+#endif
   int      off_len = evm_stack_pop_ref(evm, &off);
   if (off_len < 0) return off_len;
 
   uint8_t tmp[32] = {0};
   memcpy(tmp + 32 - off_len, off, off_len);
+#ifdef EVM_WORD_STACK
+  // the slots can not be written as bytes, so we read the value first
+  uint8_t val[32];
+  int     res = evm_mem_read(evm, bytes(tmp, 32), val, 32);
+  if (res >= 0 && evm_stack_push(evm, val, 32)) return EVM_ERROR_ILLEGAL_MEMORY_ACCESS;
+  return res;
+#else
   if (evm_stack_push_ref(evm, &dst, 32)) return EVM_ERROR_ILLEGAL_MEMORY_ACCESS;
   return evm_mem_read(evm, bytes(tmp, 32), dst, 32);
+#endif
 }
 
 int op_mstore(evm_t* evm, uint8_t len) {
@@ -418,6 +563,29 @@ int op_sload(evm_t* evm) {
   return evm_stack_push(evm, value, l);
 }
 
+void evm_analyse_jumpdests(bytes_t code, uint8_t* jumpdests) {
+  // all JUMPDEST-opcodes are valid, unless they are part of the data of a PUSH
+  for (uint32_t i = 0; i < code.len; i++) {
+    uint8_t op = code.data[i];
+    if (op == 0x5B)
+      jumpdests[i >> 3] |= 1 << (i & 7);
+    else if (op >= 0x60 && op <= 0x7F) // PUSH
+      i += op - 0x5F;
+  }
+}
+
+static void prepare_jumpdests(evm_t* evm) {
+  // the environment may share the analysis of the code with other evms, so it is only done once per contract.
+  uint8_t* shared = NULL;
+  if (evm->account && evm->env(evm, EVM_ENV_JUMPDESTS, evm->account, 20, &shared, 0, 0) >= 0 && shared) {
+    evm->jumpdests = shared;
+    return;
+  }
+  evm->jumpdests     = _calloc((evm->code.len + 7) / 8, 1);
+  evm->own_jumpdests = true;
+  evm_analyse_jumpdests(evm->code, evm->jumpdests);
+}
+
 int op_jump(evm_t* evm, uint8_t cond) {
   int pos = evm_stack_pop_int(evm);
   if (pos < 0) return pos;
@@ -427,36 +595,9 @@ int op_jump(evm_t* evm, uint8_t cond) {
     if (ret == EVM_ERROR_EMPTY_STACK) return EVM_ERROR_EMPTY_STACK;
     if (!c && ret >= 0) return 0; // the condition was false
   }
-  if ((uint32_t) pos > evm->code.len || evm->code.data[pos] != 0x5B) return EVM_ERROR_INVALID_JUMPDEST;
-
-  // check if this is a invalid jumpdest
-  if (evm->invalid_jumpdest == NULL) {
-    uint32_t size = 8, p = 0, *list = _malloc(8 * sizeof(uint32_t)), i, cl = evm->code.len;
-    uint8_t  op, jumpl = 0;
-    for (i = 0; i < cl; i++) {
-      op = evm->code.data[i];
-      if (jumpl) {
-        if (op == 0x5B) {
-          // add it
-          if (p == size - 2) {
-            list = _realloc(list, (size + 8) * sizeof(uint32_t), size * sizeof(uint32_t));
-            size = size + 8;
-          }
-          list[p++] = i;
-        }
-        jumpl--;
-      } else if (op >= 0x60 && op <= 0x7F) // PUSH
-        jumpl = op - 0x5F;
-    }
-    list[p]               = 0xFFFFFFFF;
-    evm->invalid_jumpdest = list;
-  }
-
-  // check if our dest contains the pos as invalid
-  for (int i = 0;; i++) {
-    if (evm->invalid_jumpdest[i] == 0xFFFFFFFF) break;
-    if (evm->invalid_jumpdest[i] == (uint32_t) pos) return EVM_ERROR_INVALID_JUMPDEST;
-  }
+  if ((uint32_t) pos >= evm->code.len) return EVM_ERROR_INVALID_JUMPDEST;
+  if (!evm->jumpdests) prepare_jumpdests(evm);
+  if (!(evm->jumpdests[pos >> 3] & (1 << (pos & 7)))) return EVM_ERROR_INVALID_JUMPDEST;
 
   evm->pos = pos;
   return 0;
@@ -476,6 +617,28 @@ int op_push(evm_t* evm, wlen_t len) {
   return 0;
 }
 
+#ifdef EVM_WORD_STACK
+
+int op_dup(evm_t* evm, uint8_t pos) {
+  word_t* dst;
+  if (pos > evm->stack_size) return EVM_ERROR_EMPTY_STACK;
+  int res = evm_stack_push_word(evm, &dst);
+  if (res) return res;
+  *dst = *evm_stack_peek_word(evm, pos + 1);
+  return 0;
+}
+
+int op_swap(evm_t* evm, uint8_t pos) {
+  word_t *a = evm_stack_peek_word(evm, 1), *b = evm_stack_peek_word(evm, pos), tmp;
+  if (!a || !b) return EVM_ERROR_EMPTY_STACK;
+  tmp = *a;
+  *a  = *b;
+  *b  = tmp;
+  return 0;
+}
+
+#else
+
 int op_dup(evm_t* evm, uint8_t pos) {
   uint8_t* data = NULL;
   int      l    = evm_stack_get_ref(evm, pos, &data);
@@ -507,6 +670,8 @@ int op_swap(evm_t* evm, uint8_t pos) {
   return 0;
 }
 
+#endif
+
 int op_return(evm_t* evm, uint8_t revert) {
   int offset, len;
   if ((offset = evm_stack_pop_int(evm)) < 0) return offset;
@@ -644,12 +809,7 @@ int op_selfdestruct(evm_t* evm) {
   memset(self_account->balance, 0, 32);
   memset(self_account->nonce, 0, 32);
   self_account->code.len = 0;
-  storage_t* s           = NULL;
-  while (self_account->storage) {
-    s                     = self_account->storage;
-    self_account->storage = s->next;
-    _free(s);
-  }
+  evm_clear_storage(evm, self_account);
   evm->state = EVM_STATE_STOPPED;
   return 0;
 }
@@ -39,7 +39,7 @@
 #include "../../../third-party/crypto/ripemd160.h"
 #include "../../../third-party/crypto/secp256k1.h"
 #include "../../../third-party/crypto/sha2.h"
-#include "../../../third-party/tommath/tommath.h"
+#include "big.h"
 #include "evm.h"
 #include "gas.h"
 #ifndef MAX
@@ -106,7 +106,6 @@ int pre_identity(evm_t* evm) {
 
 int pre_modexp(evm_t* evm) {
   if (evm->call_data.len < 96) return -1;
-  uint8_t      res[64];
   uint_fast8_t hp     = 0;
   uint32_t     l_base = bytes_to_int(evm->call_data.data + 28, 4);
   uint32_t     l_exp  = bytes_to_int(evm->call_data.data + 28 + 32, 4);
@@ -150,30 +149,10 @@ int pre_modexp(evm_t* evm) {
   subgas(lm * MAX(1, ael) / G_PRE_MODEXP_GQUAD_DIVISOR);
 
 #endif
-  // we use gmp for now
-  mp_int m_base, m_exp, m_mod, m_res;
-  mp_init(&m_base);
-  mp_init(&m_exp);
-  mp_init(&m_mod);
-  mp_init(&m_res);
-
-  mp_import(&m_base, b_base.len, 1, sizeof(uint8_t), 1, 0, b_base.data);
-  mp_import(&m_exp, b_exp.len, 1, sizeof(uint8_t), 1, 0, b_exp.data);
-  mp_import(&m_mod, b_mod.len, 1, sizeof(uint8_t), 1, 0, b_mod.data);
-
-  m_base.sign = m_exp.sign = m_mod.sign = 0;
-  mp_exptmod(&m_base, &m_exp, &m_mod, &m_res);
-  size_t ml;
-  mp_export(res, &ml, 1, sizeof(uint8_t), 1, 0, &m_res);
-
-  mp_clear(&m_base);
-  mp_clear(&m_exp);
-  mp_clear(&m_mod);
-  mp_clear(&m_res);
-
-  evm->return_data.data = _malloc(ml);
-  evm->return_data.len  = ml;
-  memcpy(evm->return_data.data, res, ml);
+  // the result is never longer than the modulus
+  uint8_t* res          = _malloc(l_mod ? l_mod : 1);
+  evm->return_data.data = res;
+  evm->return_data.len  = big_modexp(b_base.data, l_base, b_exp.data, l_exp, b_mod.data, l_mod, res);
   return 0;
 }
 
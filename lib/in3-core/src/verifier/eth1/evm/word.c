@@ -0,0 +1,527 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#include "word.h"
+#include <string.h>
+
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 uint128_t;
+#endif
+
+// full 64x64 -> 128 bit product
+static inline void mul64(uint64_t a, uint64_t b, uint64_t* hi, uint64_t* lo) {
+#ifdef __SIZEOF_INT128__
+  uint128_t p = (uint128_t) a * b;
+  *lo         = (uint64_t) p;
+  *hi         = (uint64_t)(p >> 64);
+#else
+  uint64_t al = a & 0xFFFFFFFF, ah = a >> 32, bl = b & 0xFFFFFFFF, bh = b >> 32;
+  uint64_t ll = al * bl, lh = al * bh, hl = ah * bl;
+  uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+  *lo          = (ll & 0xFFFFFFFF) | (mid << 32);
+  *hi          = ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+static inline uint64_t read_be64(const uint8_t* p) {
+  return ((uint64_t) p[0] << 56) | ((uint64_t) p[1] << 48) | ((uint64_t) p[2] << 40) | ((uint64_t) p[3] << 32) |
+         ((uint64_t) p[4] << 24) | ((uint64_t) p[5] << 16) | ((uint64_t) p[6] << 8) | (uint64_t) p[7];
+}
+
+static inline void write_be64(uint64_t v, uint8_t* p) {
+  p[0] = v >> 56;
+  p[1] = v >> 48;
+  p[2] = v >> 40;
+  p[3] = v >> 32;
+  p[4] = v >> 24;
+  p[5] = v >> 16;
+  p[6] = v >> 8;
+  p[7] = v;
+}
+
+void word_from_bytes(word_t* w, const uint8_t* data, wlen_t len) {
+  const uint8_t* p = data + len;
+  int            i = 0;
+  for (; len >= 8; i++, len -= 8) w->limbs[i] = read_be64(p -= 8);
+  if (i < 4) {
+    uint64_t v = 0;
+    for (wlen_t j = 0; j < len; j++) v = (v << 8) | data[j];
+    w->limbs[i++] = v;
+    for (; i < 4; i++) w->limbs[i] = 0;
+  }
+}
+
+void word_to_bytes(const word_t* w, uint8_t* dst) {
+  for (int i = 0; i < 4; i++) write_be64(w->limbs[3 - i], dst + i * 8);
+}
+
+wlen_t word_bytes(const word_t* w) {
+  for (int i = 3; i >= 0; i--) {
+    uint64_t v = w->limbs[i];
+    if (!v) continue;
+    wlen_t l = i * 8;
+    while (v) {
+      l++;
+      v >>= 8;
+    }
+    return l;
+  }
+  return 0;
+}
+
+int word_cmp(const word_t* a, const word_t* b) {
+  for (int i = 3; i >= 0; i--) {
+    if (a->limbs[i] != b->limbs[i]) return a->limbs[i] < b->limbs[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+int word_scmp(const word_t* a, const word_t* b) {
+  bool na = word_is_neg(a), nb = word_is_neg(b);
+  if (na != nb) return na ? -1 : 1;
+  return word_cmp(a, b);
+}
+
+void word_add(const word_t* a, const word_t* b, word_t* r) {
+  uint64_t carry = 0;
+  for (int i = 0; i < 4; i++) {
+    uint64_t s = a->limbs[i] + carry;
+    carry      = s < carry;
+    s += b->limbs[i];
+    carry += s < b->limbs[i];
+    r->limbs[i] = s;
+  }
+}
+
+void word_sub(const word_t* a, const word_t* b, word_t* r) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) {
+    uint64_t x = a->limbs[i], d = x - b->limbs[i];
+    uint64_t c = x < b->limbs[i];
+    r->limbs[i] = d - borrow;
+    borrow      = c | (d < borrow);
+  }
+}
+
+void word_neg(const word_t* a, word_t* r) {
+  word_t zero = {{0, 0, 0, 0}};
+  word_sub(&zero, a, r);
+}
+
+// multiplies a with b and stores the lowest n limbs in r (n is 4 or 8)
+static void mul_limbs(const uint64_t* a, const uint64_t* b, uint64_t* r, int n) {
+  uint64_t res[8] = {0};
+  for (int i = 0; i < 4; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < 4 && i + j < n; j++) {
+      uint64_t hi, lo;
+      mul64(a[i], b[j], &hi, &lo);
+      lo += carry;
+      hi += lo < carry;
+      lo += res[i + j];
+      hi += lo < res[i + j];
+      res[i + j] = lo;
+      carry      = hi;
+    }
+    if (i + 4 < n) res[i + 4] = carry;
+  }
+  memcpy(r, res, n * sizeof(uint64_t));
+}
+
+void word_mul(const word_t* a, const word_t* b, word_t* r) {
+  mul_limbs(a->limbs, b->limbs, r->limbs, 4);
+}
+
+/**
+ * divides u (m digits) by v (n digits, v[n-1] != 0, m >= n) using 32-bit digits (Knuth, Algorithm D).
+ *
+ * q receives m-n+1 digits and r n digits, both may be NULL.
+ */
+static void divmod_digits(const uint32_t* u, int m, const uint32_t* v, int n, uint32_t* q, uint32_t* r) {
+  uint32_t un[17], vn[8];
+  int      i, j;
+
+  if (n == 1) {
+    uint64_t k = 0;
+    for (j = m - 1; j >= 0; j--) {
+      uint64_t t = (k << 32) | u[j];
+      if (q) q[j] = (uint32_t)(t / v[0]);
+      k = t % v[0];
+    }
+    if (r) r[0] = (uint32_t) k;
+    return;
+  }
+
+  // normalize, so the highest digit of the divisor has its highest bit set
+  int s = 0;
+  for (uint32_t top = v[n - 1]; (top & 0x80000000) == 0; top <<= 1) s++;
+  for (i = n - 1; i > 0; i--) vn[i] = (v[i] << s) | (uint32_t)((uint64_t) v[i - 1] >> (32 - s));
+  vn[0] = v[0] << s;
+  un[m] = (uint32_t)((uint64_t) u[m - 1] >> (32 - s));
+  for (i = m - 1; i > 0; i--) un[i] = (u[i] << s) | (uint32_t)((uint64_t) u[i - 1] >> (32 - s));
+  un[0] = u[0] << s;
+
+  for (j = m - n; j >= 0; j--) {
+    // estimate the quotient digit
+    uint64_t num  = ((uint64_t) un[j + n] << 32) | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+    while (qhat >> 32 || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      qhat--;
+      rhat += vn[n - 1];
+      if (rhat >> 32) break;
+    }
+
+    // multiply and subtract
+    int64_t k = 0, t;
+    for (i = 0; i < n; i++) {
+      uint64_t p = qhat * vn[i];
+      t          = (int64_t) un[i + j] - k - (int64_t)(p & 0xFFFFFFFF);
+      un[i + j]  = (uint32_t) t;
+      k          = (int64_t)(p >> 32) - (t >> 32);
+    }
+    t         = (int64_t) un[j + n] - k;
+    un[j + n] = (uint32_t) t;
+
+    // we subtracted too much, so add it back
+    if (t < 0) {
+      qhat--;
+      uint64_t c = 0;
+      for (i = 0; i < n; i++) {
+        c         = (uint64_t) un[i + j] + vn[i] + c;
+        un[i + j] = (uint32_t) c;
+        c >>= 32;
+      }
+      un[j + n] += (uint32_t) c;
+    }
+    if (q) q[j] = (uint32_t) qhat;
+  }
+
+  if (r) {
+    for (i = 0; i < n; i++) r[i] = (un[i] >> s) | (uint32_t)(((uint64_t) un[i + 1] << 32) >> s);
+  }
+}
+
+// splits n limbs into 32-bit digits and returns the number of significant digits
+static int to_digits(const uint64_t* limbs, int n, uint32_t* digits) {
+  int l = 0;
+  for (int i = 0; i < n; i++) {
+    digits[i * 2]     = (uint32_t) limbs[i];
+    digits[i * 2 + 1] = (uint32_t)(limbs[i] >> 32);
+    if (limbs[i]) l = (limbs[i] >> 32) ? i * 2 + 2 : i * 2 + 1;
+  }
+  return l;
+}
+
+// joins the 32-bit digits into n limbs
+static void from_digits(const uint32_t* digits, int count, uint64_t* limbs, int n) {
+  memset(limbs, 0, n * sizeof(uint64_t));
+  for (int i = 0; i < count && i < n * 2; i++) limbs[i >> 1] |= ((uint64_t) digits[i]) << ((i & 1) << 5);
+}
+
+#ifdef __SIZEOF_INT128__
+// divides n limbs by a 64-bit divisor and returns the remainder
+static uint64_t div_limbs64(const uint64_t* a, int n, uint64_t d, uint64_t* q) {
+  uint64_t rem = 0;
+  for (int i = n - 1; i >= 0; i--) {
+    uint128_t t = ((uint128_t) rem << 64) | a[i];
+    uint64_t  x = (uint64_t)(t / d);
+    rem         = a[i] - x * d;
+    if (q) q[i] = x;
+  }
+  return rem;
+}
+#endif
+
+// divides the number of n limbs (n <= 8) by d, which must not be zero. q receives n limbs.
+static void divmod_limbs(const uint64_t* a, int n, const word_t* d, uint64_t* q, word_t* r) {
+#ifdef __SIZEOF_INT128__
+  if ((d->limbs[1] | d->limbs[2] | d->limbs[3]) == 0) {
+    uint64_t rem = div_limbs64(a, n, d->limbs[0], q);
+    if (r) word_set(r, rem);
+    return;
+  }
+#endif
+  uint32_t u[16], v[8], qd[17], rd[8];
+  int      m = to_digits(a, n, u), l = to_digits(d->limbs, 4, v);
+  if (m < l) {
+    if (q) memset(q, 0, n * sizeof(uint64_t));
+    if (r) from_digits(u, m, r->limbs, 4);
+    return;
+  }
+  divmod_digits(u, m, v, l, q ? qd : NULL, r ? rd : NULL);
+  if (q) from_digits(qd, m - l + 1, q, n);
+  if (r) from_digits(rd, l, r->limbs, 4);
+}
+
+void word_divmod(const word_t* a, const word_t* b, word_t* q, word_t* r) {
+  if (word_is_zero(b)) {
+    if (q) word_set(q, 0);
+    if (r) word_set(r, 0);
+    return;
+  }
+  if ((a->limbs[1] | a->limbs[2] | a->limbs[3] | b->limbs[1] | b->limbs[2] | b->limbs[3]) == 0) {
+    // both fit into 64 bits
+    uint64_t x = a->limbs[0], y = b->limbs[0];
+    if (q) word_set(q, x / y);
+    if (r) word_set(r, x % y);
+    return;
+  }
+  divmod_limbs(a->limbs, 4, b, q ? q->limbs : NULL, r);
+}
+
+void word_sdivmod(const word_t* a, const word_t* b, word_t* q, word_t* r) {
+  bool   na = word_is_neg(a), nb = word_is_neg(b);
+  word_t x, y;
+  if (na)
+    word_neg(a, &x);
+  else
+    x = *a;
+  if (nb)
+    word_neg(b, &y);
+  else
+    y = *b;
+  word_divmod(&x, &y, q, r);
+  if (q && na != nb) word_neg(q, q);
+  if (r && na) word_neg(r, r);
+}
+
+void word_addmod(const word_t* a, const word_t* b, const word_t* m, word_t* r) {
+  if (word_is_zero(m)) {
+    word_set(r, 0);
+    return;
+  }
+  uint64_t sum[5];
+  word_t   s;
+  word_add(a, b, &s);
+  memcpy(sum, s.limbs, sizeof(s.limbs));
+  sum[4] = word_cmp(&s, a) < 0;
+  divmod_limbs(sum, 5, m, NULL, r);
+}
+
+void word_mulmod(const word_t* a, const word_t* b, const word_t* m, word_t* r) {
+  if (word_is_zero(m)) {
+    word_set(r, 0);
+    return;
+  }
+  uint64_t p[8];
+  mul_limbs(a->limbs, b->limbs, p, 8);
+  divmod_limbs(p, 8, m, NULL, r);
+}
+
+void word_exp(const word_t* a, const word_t* e, word_t* r) {
+  word_t base = *a, res = {{1, 0, 0, 0}};
+  int    bits = word_bytes(e) * 8;
+  for (int i = 0; i < bits; i++) {
+    if ((e->limbs[i >> 6] >> (i & 63)) & 1) word_mul(&res, &base, &res);
+    if (i + 1 < bits) word_mul(&base, &base, &base);
+  }
+  *r = res;
+}
+
+void word_mul_wide(const word_t* a, const word_t* b, uint64_t* r) {
+  mul_limbs(a->limbs, b->limbs, r, 8);
+}
+
+void word_divmod_wide(const uint64_t* a, int n, const word_t* d, uint64_t* q, word_t* r) {
+  if (word_is_zero(d)) {
+    if (q) memset(q, 0, n * sizeof(uint64_t));
+    if (r) word_set(r, 0);
+    return;
+  }
+  divmod_limbs(a, n, d, q, r);
+}
+
+/**
+ * montgomery multiplication (CIOS) of n limbs: r = a * b / 2^(64n) mod m.
+ *
+ * a and b must be less than m, minv is -m^-1 mod 2^64.
+ */
+static void mont_mul(const uint64_t* a, const uint64_t* b, const uint64_t* m, uint64_t minv, int n, uint64_t* r) {
+  uint64_t t[6] = {0}, hi, lo, c;
+  int      i, j;
+  for (i = 0; i < n; i++) {
+    // t += a[i] * b
+    for (c = 0, j = 0; j < n; j++) {
+      mul64(a[i], b[j], &hi, &lo);
+      lo += c;
+      hi += lo < c;
+      lo += t[j];
+      hi += lo < t[j];
+      t[j] = lo;
+      c    = hi;
+    }
+    t[n] += c;
+    t[n + 1] = t[n] < c;
+
+    // t = (t + u * m) / 2^64, which clears the lowest limb
+    uint64_t u = t[0] * minv;
+    mul64(u, m[0], &hi, &lo);
+    lo += t[0];
+    c = hi + (lo < t[0]);
+    for (j = 1; j < n; j++) {
+      mul64(u, m[j], &hi, &lo);
+      lo += c;
+      hi += lo < c;
+      lo += t[j];
+      hi += lo < t[j];
+      t[j - 1] = lo;
+      c        = hi;
+    }
+    t[n - 1] = t[n] + c;
+    t[n]     = t[n + 1] + (t[n - 1] < c);
+  }
+
+  // t < 2m, so one subtraction is enough
+  uint64_t d[4], borrow = 0;
+  for (j = 0; j < n; j++) {
+    uint64_t x = t[j] - m[j];
+    uint64_t b = t[j] < m[j];
+    d[j]       = x - borrow;
+    borrow     = b | (x < borrow);
+  }
+  memcpy(r, (t[n] || !borrow) ? d : t, n * sizeof(uint64_t));
+}
+
+// r = b ^ exp % m with square and multiply, used for even moduli
+static void modexp_plain(const word_t* b, const uint8_t* exp, uint32_t exp_len, const word_t* m, word_t* r) {
+  word_t base, res = {{1, 0, 0, 0}};
+  word_divmod(b, m, NULL, &base);
+  word_divmod(&res, m, NULL, &res);
+  for (uint32_t i = 0; i < exp_len; i++) {
+    for (int bit = 7; bit >= 0; bit--) {
+      word_mulmod(&res, &res, m, &res);
+      if ((exp[i] >> bit) & 1) word_mulmod(&res, &base, m, &res);
+    }
+  }
+  *r = res;
+}
+
+void word_modexp(const word_t* b, const uint8_t* exp, uint32_t exp_len, const word_t* m, word_t* r) {
+  if (word_is_zero(m)) {
+    word_set(r, 0);
+    return;
+  }
+  while (exp_len && !*exp) {
+    exp++;
+    exp_len--;
+  }
+  if ((m->limbs[0] & 1) == 0) {
+    modexp_plain(b, exp, exp_len, m, r);
+    return;
+  }
+
+  // we only use as many limbs as the modulus needs
+  int n = 4;
+  while (!m->limbs[n - 1]) n--;
+
+  // -m^-1 mod 2^64 with newton iterations, each doubling the correct bits starting with 3
+  uint64_t inv = m->limbs[0];
+  for (int i = 0; i < 5; i++) inv *= 2 - m->limbs[0] * inv;
+  uint64_t minv = -inv;
+
+  // one = 2^(64n) mod m and r2 = 2^(128n) mod m to convert into the montgomery domain
+  uint64_t p[8] = {0};
+  word_t   one, r2, base;
+  p[n] = 1;
+  divmod_limbs(p, n + 1, m, NULL, &one);
+  mul_limbs(one.limbs, one.limbs, p, 8);
+  divmod_limbs(p, 8, m, NULL, &r2);
+  divmod_limbs(b->limbs, 4, m, NULL, &base);
+
+  // fixed window of 4 bits
+  uint64_t table[16][4], acc[4];
+  memcpy(table[0], one.limbs, sizeof(acc));
+  mont_mul(base.limbs, r2.limbs, m->limbs, minv, n, table[1]);
+  for (int i = 2; i < 16; i++) mont_mul(table[i - 1], table[1], m->limbs, minv, n, table[i]);
+  memcpy(acc, one.limbs, sizeof(acc));
+
+  for (uint32_t i = 0; i < exp_len * 2; i++) {
+    uint8_t nibble = (i & 1) ? (exp[i >> 1] & 0xF) : (exp[i >> 1] >> 4);
+    if (i) {
+      for (int k = 0; k < 4; k++) mont_mul(acc, acc, m->limbs, minv, n, acc);
+    }
+    if (nibble) mont_mul(acc, table[nibble], m->limbs, minv, n, acc);
+  }
+
+  // convert back by multiplying with 1
+  uint64_t unit[4] = {1, 0, 0, 0};
+  word_set(r, 0);
+  mont_mul(acc, unit, m->limbs, minv, n, r->limbs);
+}
+
+void word_shl(const word_t* a, unsigned int shift, word_t* r) {
+  unsigned int limbs = shift >> 6, bits = shift & 63;
+  word_t       res;
+  for (int i = 3; i >= 0; i--) {
+    int      src = i - (int) limbs;
+    uint64_t v   = src >= 0 ? a->limbs[src] << bits : 0;
+    if (bits && src > 0) v |= a->limbs[src - 1] >> (64 - bits);
+    res.limbs[i] = v;
+  }
+  *r = res;
+}
+
+void word_shr(const word_t* a, unsigned int shift, word_t* r) {
+  unsigned int limbs = shift >> 6, bits = shift & 63;
+  word_t       res;
+  for (int i = 0; i < 4; i++) {
+    unsigned int src = i + limbs;
+    uint64_t     v   = src < 4 ? a->limbs[src] >> bits : 0;
+    if (bits && src + 1 < 4) v |= a->limbs[src + 1] << (64 - bits);
+    res.limbs[i] = v;
+  }
+  *r = res;
+}
+
+void word_sar(const word_t* a, unsigned int shift, word_t* r) {
+  bool neg = word_is_neg(a);
+  word_shr(a, shift, r);
+  if (neg && shift) {
+    // fill the upper bits with ones
+    word_t ones = {{UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX}};
+    word_shl(&ones, 256 - shift, &ones);
+    for (int i = 0; i < 4; i++) r->limbs[i] |= ones.limbs[i];
+  }
+}
+
+void word_signextend(const word_t* a, unsigned int k, word_t* r) {
+  unsigned int bit   = k * 8 + 7;
+  uint64_t     mask  = ((uint64_t) 1 << (bit & 63)) - 1;
+  int          limb  = bit >> 6;
+  bool         neg   = (a->limbs[limb] >> (bit & 63)) & 1;
+  word_t       res   = *a;
+  res.limbs[limb]    = neg ? (res.limbs[limb] | ~mask) : (res.limbs[limb] & (mask | ((uint64_t) 1 << (bit & 63))));
+  for (int i = limb + 1; i < 4; i++) res.limbs[i] = neg ? UINT64_MAX : 0;
+  *r = res;
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+/** @file 
+ * 256-bit words with 64-bit limbs as used by the word stack of the evm.
+ * */
+
+#ifndef in3_word_h__
+#define in3_word_h__
+
+#include "../../../core/util/bytes.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/** a 256-bit unsigned integer */
+typedef struct {
+  uint64_t limbs[4]; /**< the limbs, least significant first */
+} word_t;
+
+/** reads a big endian value of up to 32 bytes */
+void word_from_bytes(word_t* w, const uint8_t* data, wlen_t len);
+/** writes the word as 32 bytes big endian */
+void word_to_bytes(const word_t* w, uint8_t* dst);
+/** number of bytes without leading zeros (0 for the value 0) */
+wlen_t word_bytes(const word_t* w);
+
+/** true if the value is 0 */
+static inline bool word_is_zero(const word_t* w) { return (w->limbs[0] | w->limbs[1] | w->limbs[2] | w->limbs[3]) == 0; }
+/** true if the highest bit is set, which makes it negative as signed value */
+static inline bool word_is_neg(const word_t* w) { return (w->limbs[3] >> 63) != 0; }
+/** true if the value is not greater than max */
+static inline bool word_fits(const word_t* w, uint64_t max) { return (w->limbs[1] | w->limbs[2] | w->limbs[3]) == 0 && w->limbs[0] <= max; }
+/** sets the word to a 64-bit value */
+static inline void word_set(word_t* w, uint64_t val) {
+  w->limbs[0] = val;
+  w->limbs[1] = w->limbs[2] = w->limbs[3] = 0;
+}
+
+int  word_cmp(const word_t* a, const word_t* b);                                                     /**< compares 2 unsigned words, returns -1, 0 or 1 */
+int  word_scmp(const word_t* a, const word_t* b);                                                    /**< compares 2 signed words, returns -1, 0 or 1 */
+void word_add(const word_t* a, const word_t* b, word_t* r);                                          /**< r = a + b mod 2^256 */
+void word_sub(const word_t* a, const word_t* b, word_t* r);                                          /**< r = a - b mod 2^256 */
+void word_mul(const word_t* a, const word_t* b, word_t* r);                                          /**< r = a * b mod 2^256 */
+void word_neg(const word_t* a, word_t* r);                                                           /**< r = -a mod 2^256 */
+void word_divmod(const word_t* a, const word_t* b, word_t* q, word_t* r);                            /**< q = a / b and r = a % b, both are 0 if b is 0. q or r may be NULL */
+void word_sdivmod(const word_t* a, const word_t* b, word_t* q, word_t* r);                           /**< signed division, the remainder takes the sign of a. q or r may be NULL */
+void word_addmod(const word_t* a, const word_t* b, const word_t* m, word_t* r);                      /**< r = (a + b) % m without overflow, 0 if m is 0 */
+void word_mulmod(const word_t* a, const word_t* b, const word_t* m, word_t* r);                      /**< r = (a * b) % m without overflow, 0 if m is 0 */
+void word_exp(const word_t* a, const word_t* e, word_t* r);                                          /**< r = a ^ e mod 2^256 */
+void word_mul_wide(const word_t* a, const word_t* b, uint64_t* r);                                   /**< r = a * b as full product of 8 limbs */
+void word_divmod_wide(const uint64_t* a, int n, const word_t* d, uint64_t* q, word_t* r);            /**< divides a number of n limbs (n <= 8) by d. q receives n limbs, both are 0 if d is 0. q or r may be NULL */
+void word_modexp(const word_t* b, const uint8_t* exp, uint32_t exp_len, const word_t* m, word_t* r); /**< r = b ^ exp % m with the big endian exponent exp, using montgomery multiplication for odd moduli. 0 if m is 0 */
+void word_shl(const word_t* a, unsigned int shift, word_t* r);                                       /**< shifts left, shift must be less than 256 */
+void word_shr(const word_t* a, unsigned int shift, word_t* r);                                       /**< shifts right, shift must be less than 256 */
+void word_sar(const word_t* a, unsigned int shift, word_t* r);                                       /**< arithmetic shift right, shift must be less than 256 */
+void word_signextend(const word_t* a, unsigned int k, word_t* r);                                    /**< extends the sign of the byte k (counted from the lowest), k must be less than 32 */
+
+#endif
@@ -32,6 +32,7 @@
  * with this program. If not, see <https://www.gnu.org/licenses/>.
  *******************************************************************************/
 
+#include "../../../core/client/cache.h"
 #include "../../../core/client/context.h"
 #include "../../../core/client/keys.h"
 #include "../../../core/util/mem.h"
@@ -44,17 +45,28 @@
 #include "../../../verifier/eth1/nano/vhist.h"
 #include <string.h>
 
+#define BLOCKHEADER_MAX_FIELDS (BLOCKHEADER_SEALED_FIELD3 + 1)
+
+/** decodes all fields of a blockheader with one pass and returns the number of fields or -1 if the header is invalid. */
+static int decode_header(bytes_t* header, bytes_t* list, bytes_t* fields) {
+  uint8_t types[BLOCKHEADER_MAX_FIELDS];
+  if (rlp_decode(header, 0, list) != 2) return -1;
+  const int len = rlp_decode_items(list, fields, types, BLOCKHEADER_MAX_FIELDS);
+  return len > BLOCKHEADER_NUMBER && types[BLOCKHEADER_PARENT_HASH] == 1 && types[BLOCKHEADER_NUMBER] == 1 ? len : -1;
+}
+
 #ifdef POA
-/** gets the signer from a blockheader in a aura chain.*/
-static in3_ret_t get_aura_signer(in3_vctx_t* vc, bytes_t* header, uint8_t* dst) {
-  bytes_t         sig, bare;
+/** gets the signer from the decoded fields of a blockheader in a aura chain.*/
+static in3_ret_t get_aura_signer(in3_vctx_t* vc, bytes_t bare, bytes_t* fields, int len, uint8_t* dst) {
+  bytes_t         sig;
   uint8_t         d[4], bare_hash[32], pub_key[65];
   bytes_builder_t ll = {.bsize = 4, .b = {.len = 0, .data = (uint8_t*) &d}};
   struct SHA3_CTX ctx;
 
+  if (len <= BLOCKHEADER_SEALED_FIELD2) return vc_err(vc, "invalid blockheader");
+
   // get the raw data without the sealed field
-  rlp_decode(header, 0, &bare);
-  rlp_decode(&bare, 12, &sig);
+  sig      = fields[BLOCKHEADER_EXTRA_DATA];
   bare.len = sig.len + sig.data - bare.data;
 
   // calculate the list prefix
@@ -66,11 +78,9 @@ static in3_ret_t get_aura_signer(in3_vctx_t* vc, bytes_t* header, uint8_t* dst)
   sha3_Update(&ctx, bare.data, bare.len);
   keccak_Final(&ctx, bare_hash);
 
-  // copy the whole header
-  rlp_decode(header, 0, &bare);
-
   // we have 3 sealed fields the messagehash is calculated hash = sha3( concat ( bare_hash | rlp_encode ( sealed_fields[2] ) ) )
-  if (rlp_decode(&bare, BLOCKHEADER_SEALED_FIELD3, &sig) == 1) {
+  if (len > BLOCKHEADER_SEALED_FIELD3) {
+    sig = fields[BLOCKHEADER_SEALED_FIELD3];
     bb_clear(&ll);
     rlp_add_length(&ll, sig.len, 0xc0);
 
@@ -81,7 +91,7 @@ static in3_ret_t get_aura_signer(in3_vctx_t* vc, bytes_t* header, uint8_t* dst)
     keccak_Final(&ctx, bare_hash);
   }
   // get the signature
-  rlp_decode(&bare, BLOCKHEADER_SEALED_FIELD2, &sig);
+  sig = fields[BLOCKHEADER_SEALED_FIELD2];
 
   // recover signature
   if (ecdsa_recover_pub_from_sig(&secp256k1, pub_key, sig.data, bare_hash, sig.data[64]))
@@ -143,20 +153,33 @@ static in3_ret_t add_aura_validators(in3_vctx_t* vc, vhist_t** vhp) {
     blocks[sig ? d_len(sig) : 1] = NULL;
 
     bytes_t*         fblk = blocks[0];
+    bytes_t          list, header[BLOCKHEADER_MAX_FIELDS];
     uint8_t          hash[32], signer[20];
-    int              passed   = 0;
+    int              passed = 0, header_len;
     uint8_t*         proposer = NULL;
     bytes_builder_t* curr     = vh_get_validators_for_block(vh, prf_blkno);
     size_t           currl    = curr->b.len / 20;
     i                         = 0;
 
     while (fblk) {
+      // each block is decoded once, all checks read their fields from the table.
+      if ((header_len = decode_header(fblk, &list, header)) < 0) {
+        _free(blocks);
+        return vc_err(vc, "invalid blockheader");
+      }
+
+      // check if the parent hash matches the previous block
+      if (i && (header[BLOCKHEADER_PARENT_HASH].len != 32 || memcmp(hash, header[BLOCKHEADER_PARENT_HASH].data, 32) != 0)) {
+        _free(blocks);
+        return vc_err(vc, "The parent hashes of the finality blocks don't match");
+      }
+
       // check signature of proposer
-      if (get_aura_signer(vc, fblk, signer))
+      if (get_aura_signer(vc, list, header, header_len, signer))
         return vc_err(vc, "could not get the signer");
 
       // check if it was signed by the right validator
-      rlp_decode_in_list(fblk, BLOCKHEADER_SEALED_FIELD1, &tmp);
+      tmp      = header[BLOCKHEADER_SEALED_FIELD1];
       proposer = &curr->b.data[(bytes_to_long(tmp.data, tmp.len) % currl) * 20];
       bb_free(curr);
       if (memcmp(signer, proposer, 20) != 0) {
@@ -169,13 +192,6 @@ static in3_ret_t add_aura_validators(in3_vctx_t* vc, vhist_t** vhp) {
 
       // next block
       fblk = blocks[++i];
-
-      // check if the next blocks parent_hash matches
-      if (fblk && (rlp_decode_in_list(fblk, BLOCKHEADER_PARENT_HASH, &tmp) != 1 || memcmp(hash, tmp.data, 32) != 0)) {
-        _free(blocks);
-        return vc_err(vc, "The parent hashes of the finality blocks don't match");
-      }
-
       passed++;
     }
     _free(blocks);
@@ -197,22 +213,22 @@ static in3_ret_t add_aura_validators(in3_vctx_t* vc, vhist_t** vhp) {
 
     rlp_decode(&raw_receipt, 0, &raw_receipt);
 
-    bytes_t log_data;
-    rlp_decode(&raw_receipt, rlp_decode_len(&raw_receipt) - 1, &log_data);
-    rlp_decode(&log_data, d_get_intk(prf, K_LOG_INDEX), &log_data);
+    // the logs are the last field of the receipt
+    bytes_t log_data, fields[4];
+    int     len = rlp_decode_items(&raw_receipt, fields, NULL, 4);
+    if (len < 1 || len > 4 || rlp_decode(fields + len - 1, d_get_intk(prf, K_LOG_INDEX), &log_data) != 2 || rlp_decode_items(&log_data, fields, NULL, 3) != 3)
+      return vc_err(vc, "invalid log in receipt");
 
-    rlp_decode(&log_data, 0, &tmp);
-    if (!b_cmp(&tmp, d_get_bytesk(vc->chain->spec->result, K_VALIDATOR_CONTRACT)))
+    if (!b_cmp(fields, d_get_bytesk(vc->chain->spec->result, K_VALIDATOR_CONTRACT)))
       return vc_err(vc, "Wrong address in log");
 
-    rlp_decode(&log_data, 1, &tmp);
-    rlp_decode_in_list(&tmp, 0, &tmp);
+    rlp_decode_in_list(fields + 1, 0, &tmp);
     bytes_t* t = hex_to_new_bytes("55252fa6eee4741b4e24a74a70e9c11fd2c2281df8d6ea13126ff845f7825c89", 64);
     if (!bytes_cmp(tmp, *t))
       return vc_err(vc, "Wrong topic in log");
     b_free(t);
 
-    rlp_decode(&log_data, 2, &tmp);
+    tmp = fields[2];
 
     bytes_t*         b;
     bytes_builder_t* vbb     = bb_new();
@@ -246,9 +262,7 @@ static in3_ret_t add_aura_validators(in3_vctx_t* vc, vhist_t** vhp) {
   return res;
 }
 
-static vhist_engine_t eth_get_engine(in3_vctx_t* vc, bytes_t* header, d_token_t* spec, vhist_t** vh) {
-  bytes_t b;
-
+static vhist_engine_t eth_get_engine(in3_vctx_t* vc, uint64_t block_number, d_token_t* spec, vhist_t** vh) {
   // try to get from cache
   *vh = vh_cache_retrieve(vc->ctx->client);
 
@@ -268,20 +282,19 @@ static vhist_engine_t eth_get_engine(in3_vctx_t* vc, bytes_t* header, d_token_t*
     vh_cache_save(*vh, vc->ctx->client);
   }
 
-  rlp_decode_in_list(header, BLOCKHEADER_NUMBER, &b);
-  return vh_get_engine_for_block(*vh, bytes_to_long(b.data, b.len));
+  return vh_get_engine_for_block(*vh, block_number);
 }
 
-static bytes_t* eth_get_validator(bytes_t* header, int* val_len, vhist_t* vh) {
+static bytes_t* eth_get_validator(bytes_t* fields, int len, int* val_len, vhist_t* vh) {
   bytes_builder_t* validators = NULL;
   bytes_t *        proposer, b;
 
-  rlp_decode_in_list(header, BLOCKHEADER_NUMBER, &b);
-  validators = vh_get_validators_for_block(vh, bytes_to_long(b.data, b.len));
+  if (len <= BLOCKHEADER_SEALED_FIELD1) return NULL;
+  validators = vh_get_validators_for_block(vh, bytes_to_long(fields[BLOCKHEADER_NUMBER].data, fields[BLOCKHEADER_NUMBER].len));
   if (val_len) *val_len = validators->b.len / 20;
 
   // the nonce used to find out who's turn it is to sign.
-  rlp_decode_in_list(header, BLOCKHEADER_SEALED_FIELD1, &b);
+  b = fields[BLOCKHEADER_SEALED_FIELD1];
 
   b.data   = &validators->b.data[(bytes_to_long(b.data, b.len) % (validators->b.len / 20)) * 20];
   b.len    = 20;
@@ -291,36 +304,41 @@ static bytes_t* eth_get_validator(bytes_t* header, int* val_len, vhist_t* vh) {
 }
 
 in3_ret_t eth_verify_authority(in3_vctx_t* vc, bytes_t** blocks, uint16_t needed_finality, vhist_t* vh) {
-  bytes_t tmp, *proposer, *b = blocks[0];
+  bytes_t list, fields[BLOCKHEADER_MAX_FIELDS], *proposer, *b = blocks[0];
   uint8_t hash[32], signer[20];
-  int     val_len = 0, passed = 0, i = 0, ret = 0;
+  int     val_len = 0, passed = 0, i = 0, ret = 0, len;
 
-  // check if the parent hashes match
   while (b) {
-    // find the validator with permission to sign this block.
-    if ((proposer = eth_get_validator(b, b == blocks[0] ? &val_len : NULL, vh)) == NULL)
-      return vc_err(vc, "could not find the validator for the block");
+    // each block is decoded once, all checks read their fields from the table.
+    if ((len = decode_header(b, &list, fields)) < 0)
+      return vc_err(vc, "invalid blockheader");
+
+    // check if the parent hash matches the previous block
+    if (i && (fields[BLOCKHEADER_PARENT_HASH].len != 32 || memcmp(hash, fields[BLOCKHEADER_PARENT_HASH].data, 32) != 0))
+      return vc_err(vc, "The parent hashes of the finality blocks don't match");
 
-    // check signature of proposer
-    if (get_aura_signer(vc, b, signer))
-      return vc_err(vc, "could not get the signer");
+    // finality blocks we already verified don't need to be checked again, only their parent hash.
+    if (b == blocks[0] || !in3_cache_is_verified_header(vc->ctx->client, vc->chain, b, bytes_to_long(fields[BLOCKHEADER_NUMBER].data, fields[BLOCKHEADER_NUMBER].len), NULL, 0, 0)) {
+      // find the validator with permission to sign this block.
+      if ((proposer = eth_get_validator(fields, len, b == blocks[0] ? &val_len : NULL, vh)) == NULL)
+        return vc_err(vc, "could not find the validator for the block");
 
-    // check if it was signed by the right validator
-    ret = memcmp(signer, proposer->data, 20);
-    b_free(proposer);
-    if (ret != 0)
-      return vc_err(vc, "the block was signed by the wrong key");
+      // check signature of proposer
+      if (get_aura_signer(vc, list, fields, len, signer))
+        return vc_err(vc, "could not get the signer");
+
+      // check if it was signed by the right validator
+      ret = memcmp(signer, proposer->data, 20);
+      b_free(proposer);
+      if (ret != 0)
+        return vc_err(vc, "the block was signed by the wrong key");
+    }
 
     // calculate the blockhash
     sha3_to(b, &hash);
 
     // next block
     b = blocks[++i];
-
-    // check if the next blocks parent_hash matches
-    if (b && (rlp_decode_in_list(b, BLOCKHEADER_PARENT_HASH, &tmp) != 1 || memcmp(hash, tmp.data, 32) != 0))
-      return vc_err(vc, "The parent hashes of the finality blocks don't match");
-
     passed++;
   }
 
@@ -332,6 +350,13 @@ in3_ret_t eth_verify_authority(in3_vctx_t* vc, bytes_t** blocks, uint16_t needed
 }
 #endif
 /** verify the header */
+bytes_t* eth_get_proof_header(in3_vctx_t* vc, d_token_t* block, bytes_t* expected_blockhash) {
+  // a real blockheader is always longer than a blocknumber
+  if (d_type(block) == T_INTEGER || (d_type(block) == T_BYTES && d_len(block) <= 8))
+    return in3_cache_get_header(vc->ctx->client, vc->chain, d_long(block), expected_blockhash);
+  return d_bytes(block);
+}
+
 in3_ret_t eth_verify_blockheader(in3_vctx_t* vc, bytes_t* header, bytes_t* expected_blockhash) {
 
   if (!header)
@@ -341,18 +366,22 @@ in3_ret_t eth_verify_blockheader(in3_vctx_t* vc, bytes_t* header, bytes_t* expec
   int        i;
   uint8_t    block_hash[32];
   uint64_t   header_number = 0;
+  bool       trusted       = false; // true if the header was verified by signatures or validators and can be cached.
   d_token_t *sig, *signatures;
-  bytes_t    temp, *sig_hash;
+  bytes_t    list, fields[BLOCKHEADER_MAX_FIELDS], *sig_hash;
+
+  // decode all fields with one pass, the blocknumber is the 8th field in the BlockHeader
+  if (decode_header(header, &list, fields) < 0)
+    return vc_err(vc, "Could not rlpdecode the blocknumber");
+  header_number = bytes_to_long(fields[BLOCKHEADER_NUMBER].data, fields[BLOCKHEADER_NUMBER].len);
+
+  // a header we verified before only needs to be compared.
+  if (in3_cache_is_verified_header(vc->ctx->client, vc->chain, header, header_number, expected_blockhash, vc->config->signers_length, vc->config->finality))
+    return IN3_OK;
 
   // generate the blockhash;
   sha3_to(header, &block_hash);
 
-  // if we expect a certain blocknumber, it must match the 8th field in the BlockHeader
-  if (res == IN3_OK && (rlp_decode_in_list(header, BLOCKHEADER_NUMBER, &temp) == 1))
-    header_number = bytes_to_long(temp.data, temp.len);
-  else
-    res = vc_err(vc, "Could not rlpdecode the blocknumber");
-
   // if we have a blockhash we verify it
   if (res == IN3_OK && expected_blockhash && memcmp(block_hash, expected_blockhash->data, 32))
     res = vc_err(vc, "wrong blockhash");
@@ -362,7 +391,7 @@ in3_ret_t eth_verify_blockheader(in3_vctx_t* vc, bytes_t* header, bytes_t* expec
 #ifdef POA
     vhist_t* vh = NULL;
     // ... and the chain is a authority chain....
-    if (vc->chain && vc->chain->spec && eth_get_engine(vc, header, vc->chain->spec->result, &vh) == ENGINE_AURA) {
+    if (vc->chain && vc->chain->spec && eth_get_engine(vc, header_number, vc->chain->spec->result, &vh) == ENGINE_AURA) {
       // we merge the current header + finality blocks
       sig              = d_get(vc->proof, K_FINALITY_BLOCKS);
       bytes_t** blocks = _malloc((sig ? d_len(sig) + 1 : 2) * sizeof(bytes_t*));
@@ -372,7 +401,8 @@ in3_ret_t eth_verify_blockheader(in3_vctx_t* vc, bytes_t* header, bytes_t* expec
       }
       blocks[sig ? d_len(sig) : 1] = NULL;
       // now we verify these block headers
-      res = eth_verify_authority(vc, blocks, vc->config->finality, vh);
+      res     = eth_verify_authority(vc, blocks, vc->config->finality, vh);
+      trusted = res == IN3_OK;
       _free(blocks);
     } else {
       res = IN3_OK; // we didn't request signatures so blockheader should be ok.
@@ -410,7 +440,10 @@ in3_ret_t eth_verify_blockheader(in3_vctx_t* vc, bytes_t* header, bytes_t* expec
 
     if (confirmed != (1 << vc->config->signers_length) - 1) // we must collect all signatures!
       res = vc_err(vc, "missing signatures");
+    else
+      trusted = true;
   }
 
+  if (trusted) in3_cache_add_header(vc->ctx->client, vc->chain, header, header_number, block_hash, vc->config->signers_length, vc->config->finality);
   return res;
 }
@@ -258,24 +258,26 @@ chainspec_t* chainspec_from_bin(void* raw) {
   if (rlp_decode(&data, 3, &tmp) != 2) return log_error("Invalid eips");
   spec->eip_transitions_len = rlp_decode_len(&tmp) >> 1;
   spec->eip_transitions     = _malloc(sizeof(eip_transition_t) * spec->eip_transitions_len);
+  rlp_iterator_t iter       = rlp_iter(&tmp);
   for (n = 0; n < spec->eip_transitions_len; n++) {
-    if (rlp_decode(&tmp, n * 2, &t2) != 1) return log_error("Invalid block");
+    if (rlp_iter_next(&iter, &t2) != 1) return log_error("Invalid block");
     spec->eip_transitions[n].transition_block = bytes_to_long(t2.data, t2.len);
-    if (rlp_decode(&tmp, n * 2 + 1, &t2) != 1) return log_error("Invalid eips");
+    if (rlp_iter_next(&iter, &t2) != 1) return log_error("Invalid eips");
     memcpy(&spec->eip_transitions[n].eips, t2.data, sizeof(eip_t));
   }
   if (rlp_decode(&data, 4, &tmp) != 2) return log_error("Invalid consensus list");
   spec->consensus_transitions_len = rlp_decode_len(&tmp) / 4;
   spec->consensus_transitions     = _malloc(sizeof(consensus_transition_t) * spec->consensus_transitions_len);
+  iter                            = rlp_iter(&tmp);
   for (n = 0; n < spec->consensus_transitions_len; n++) {
     consensus_transition_t* tr = spec->consensus_transitions + n;
-    if (rlp_decode(&tmp, n * 4, &t2) != 1) return log_error("Invalid block");
+    if (rlp_iter_next(&iter, &t2) != 1) return log_error("Invalid block");
     tr->transition_block = bytes_to_long(t2.data, t2.len);
-    if (rlp_decode(&tmp, n * 4 + 1, &t2) != 1) return log_error("Invalid type");
+    if (rlp_iter_next(&iter, &t2) != 1) return log_error("Invalid type");
     tr->type = bytes_to_int(t2.data, t2.len);
-    if (rlp_decode(&tmp, n * 4 + 2, &t2) != 1) return log_error("Invalid validators");
+    if (rlp_iter_next(&iter, &t2) != 1) return log_error("Invalid validators");
     tr->validators = t2;
-    if (rlp_decode(&tmp, n * 4 + 3, &t2) != 1) return log_error("Invalid contract");
+    if (rlp_iter_next(&iter, &t2) != 1) return log_error("Invalid contract");
     tr->contract = t2.len == 0 ? NULL : t2.data;
   }
 
@@ -48,6 +48,14 @@ in3_ret_t in3_verify_eth_nano(in3_vctx_t* v);
 /** verifies a blockheader. */
 in3_ret_t eth_verify_blockheader(in3_vctx_t* vc, bytes_t* header, bytes_t* expected_blockhash);
 
+/**
+ * returns the blockheader of a proof.
+ * 
+ * For blocks sent as `verifiedHashes`, the server only returns the blocknumber, so the header is taken from the block cache.
+ * If the expected blockhash is known, only the header with this hash is taken.
+ */
+bytes_t* eth_get_proof_header(in3_vctx_t* vc, d_token_t* block, bytes_t* expected_blockhash);
+
 /** 
  * verifies a single signature blockheader.
  * 
@@ -73,35 +73,34 @@ uint8_t* trie_path_to_nibbles(bytes_t path, int use_prefix) {
 }
 
 static int check_node(bytes_t* raw_node, uint8_t** key, bytes_t* expectedValue, int is_last_node, bytes_t* last_value, uint8_t* next_hash, size_t* depth) {
-  bytes_t node, val;
+  bytes_t node, val, items[17];
+  uint8_t types[17];
   (*depth)++;
   if (*depth > MERKLE_DEPTH_MAX)
     return 0;
 
-  // decode the list into war values
-  rlp_decode(raw_node, 0, &node);
-  switch (rlp_decode_len(&node)) {
+  // decode the list into raw values
+  if (rlp_decode(raw_node, 0, &node) < 1) return 0;
+  switch (rlp_decode_items(&node, items, types, 17)) {
 
     case 17: // branch
       if (**key == 0xFF) {
 
         // if this is no the last node or the value is an embedded, which means more to come.
-        if (!is_last_node || rlp_decode(&node, 16, &node) != 1)
+        if (!is_last_node || types[16] != 1)
           return 0;
 
-        last_value->data = node.data;
-        last_value->len  = node.len;
+        *last_value = items[16];
         return 1;
       }
 
-      if (rlp_decode(&node, **key, &val) == 2) {
-        rlp_decode(&node, (**key) - 1, &node);
+      val = items[**key];
+      if (types[**key] == 2) {
+        // we have an embedded node as next, which starts right after the previous item.
+        node.data = **key ? items[**key - 1].data + items[**key - 1].len : node.data;
+        node.len  = val.data + val.len - node.data;
         *key += 1;
 
-        // we have an embedded node as next
-        node.data += node.len;
-        node.len = val.data + val.len - node.data;
-
         // check the embedded
         return check_node(&node, key, expectedValue, *(*key + 1) == 0xFF, last_value, next_hash, depth);
 
@@ -113,9 +112,10 @@ static int check_node(bytes_t* raw_node, uint8_t** key, bytes_t* expectedValue,
       return 1;
 
     case 2: // leaf or extension
-      if (rlp_decode(&node, 0, &val) != 1)
+      if (types[0] != 1 || !items[0].len)
         return 0;
       else {
+        val = items[0];
         uint8_t* path_nibbles  = trie_path_to_nibbles(val, 1);
         int      matching      = trie_matching_nibbles(path_nibbles, *key);
         int      node_path_len = nibble_len(path_nibbles);
@@ -129,10 +129,10 @@ static int check_node(bytes_t* raw_node, uint8_t** key, bytes_t* expectedValue,
           return expectedValue == NULL && is_last_node;
 
         *key += node_path_len;
-        if (rlp_decode(&node, 1, &val) == 2) { // this is an embedded node
-          rlp_decode(&node, 0, &node);
-          node.data += node.len;
-          node.len = val.data + val.len - node.data;
+        val = items[1];
+        if (types[1] == 2) { // this is an embedded node
+          node.data = items[0].data + items[0].len;
+          node.len  = val.data + val.len - node.data;
 
           // check the embedded node
           return check_node(&node, key, expectedValue, *(key + 1) == NULL, last_value, next_hash, depth);
@@ -164,16 +164,22 @@ static int check_node(bytes_t* raw_node, uint8_t** key, bytes_t* expectedValue,
 int trie_verify_proof(bytes_t* rootHash, bytes_t* path, bytes_t** proof, bytes_t* expectedValue) {
   int      res        = 1;
   uint8_t* full_key   = trie_path_to_nibbles(*path, 0);
-  uint8_t *key        = full_key, expected_hash[32], node_hash[32];
+  uint8_t *key        = full_key, expected_hash[32];
   bytes_t  last_value = {.data = NULL, .len = 0};
 
   // start with root hash
   memcpy(expected_hash, rootHash->data, 32);
 
+  // the nodes are independent of each other, so we hash all of them at once.
+  int len = 0;
+  while (proof[len]) len++;
+  uint8_t *node_hashes = len ? _malloc(len * 32) : NULL, *node_hash = node_hashes;
+  sha3_multi(proof, len, node_hashes);
+
   size_t depth = 0;
-  for (; *proof; proof += 1) {
-    // create and check the hash of node
-    if (!(res = sha3_to(*proof, node_hash) == 0 && memcmp(expected_hash, node_hash, 32) == 0)) break;
+  for (; *proof; proof += 1, node_hash += 32) {
+    // check the hash of node
+    if (!(res = memcmp(expected_hash, node_hash, 32) == 0)) break;
     // check embedded nodes and find the next expected hash
     if (!(res = check_node(*proof, &key, expectedValue, *(proof + 1) == NULL, &last_value, expected_hash, &depth))) break;
   }
@@ -192,6 +198,7 @@ int trie_verify_proof(bytes_t* rootHash, bytes_t* path, bytes_t** proof, bytes_t
   }
 
   if (full_key) _free(full_key);
+  if (node_hashes) _free(node_hashes);
   return res;
 }
 
@@ -216,7 +216,7 @@ in3_ret_t eth_verify_in3_nodelist(in3_vctx_t* vc, uint32_t node_limit, bytes_t*
   if (d_type(vc->result) != T_OBJECT || !vc->proof || !server_list) return vc_err(vc, "Invalid nodeList response!");
 
   // verify the header
-  bytes_t* blockHeader = d_get_bytesk(vc->proof, K_BLOCK);
+  bytes_t* blockHeader = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), NULL);
   if (!blockHeader) return vc_err(vc, "No Block-Proof!");
   TRY(eth_verify_blockheader(vc, blockHeader, NULL));
 
@@ -308,7 +308,7 @@ in3_ret_t eth_verify_in3_whitelist(in3_vctx_t* vc) {
   if (d_type(vc->result) != T_OBJECT || !vc->proof || !server_list) return vc_err(vc, "Invalid whitelist response!");
 
   // verify the header
-  bytes_t* blockHeader = d_get_bytesk(vc->proof, K_BLOCK);
+  bytes_t* blockHeader = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), NULL);
   if (!blockHeader) return vc_err(vc, "No Block-Proof in whitelist!");
   TRY(eth_verify_blockheader(vc, blockHeader, NULL));
 
@@ -100,6 +100,55 @@ int rlp_decode_len(bytes_t* b) {
   return rlp_decode(b, -1, NULL);
 }
 
+// decodes the item at p and returns its type (or -1 if it exceeds the left bytes) and the size of the whole encoding.
+static inline int decode_next(uint8_t* p, uint32_t left, bytes_t* dst, uint32_t* size) {
+  uint8_t  c = *p;
+  uint32_t l, hl = 1, n;
+  if (c < 0x80) { // single byte-item
+    dst->data = p;
+    dst->len  = *size = 1;
+    return 1;
+  } else if (c < 0xb8) // 0-55 length-item
+    l = c - 0x80;
+  else if (c >= 0xc0 && c < 0xf8) // 0-55 byte long list
+    l = c - 0xc0;
+  else {
+    // the length is stored in the next bytes, but more than 4 bytes can never fit in memory.
+    hl += (n = c - (c < 0xc0 ? 0xb7 : 0xf7));
+    if (n > 4 || hl > left) return -1;
+    for (l = 0, n = 1; n < hl; n++) l = l << 8 | p[n];
+  }
+  if (l > left - hl) return -1;
+  dst->data = p + hl;
+  dst->len  = l;
+  *size     = hl + l;
+  return c < 0xc0 ? 1 : 2;
+}
+
+rlp_iterator_t rlp_iter(bytes_t* b) {
+  rlp_iterator_t iter = {.b = *b, .pos = 0};
+  return iter;
+}
+
+int rlp_iter_next(rlp_iterator_t* iter, bytes_t* dst) {
+  if (iter->pos >= iter->b.len) return 0;
+  uint32_t size;
+  int      type = decode_next(iter->b.data + iter->pos, iter->b.len - iter->pos, dst, &size);
+  if (type > 0) iter->pos += size;
+  return type;
+}
+
+int rlp_decode_items(bytes_t* b, bytes_t* items, uint8_t* types, int max) {
+  bytes_t  item;
+  uint32_t pos = 0, size;
+  int      n   = 0, type;
+  for (; pos < b->len; pos += size, n++) {
+    if ((type = decode_next(b->data + pos, b->len - pos, n < max ? items + n : &item, &size)) < 0) return -1;
+    if (types && n < max) types[n] = type;
+  }
+  return n;
+}
+
 void rlp_encode_item(bytes_builder_t* bb, bytes_t* val) {
   if (val->len == 1 && val->data[0] < 0x80) {
   } else if (val->len < 56)
@@ -101,6 +101,55 @@ int rlp_decode_in_list(bytes_t* b, int index, bytes_t* dst);
  */
 int rlp_decode_len(bytes_t* b);
 
+/**
+ * a cursor to read the items of a rlp-encoded list one after the other.
+ *
+ * ```c
+ * bytes_t        item;
+ * rlp_iterator_t iter = rlp_iter(&list);
+ * while (rlp_iter_next(&iter, &item) > 0) {
+ *   // use item
+ * }
+ * ```
+ */
+typedef struct rlp_iterator {
+  bytes_t  b;   /**< the encoded items */
+  uint32_t pos; /**< offset of the next item */
+} rlp_iterator_t;
+
+/**
+ * creates a cursor pointing to the first item in b.
+ */
+rlp_iterator_t rlp_iter(bytes_t* b);
+
+/**
+ * decodes the next item and moves the cursor behind it.
+ *
+ * \param iter the cursor
+ * \param dst the bytes to store the range found.
+ *
+ * \return
+ * - 0 : no more items
+ * - 1 : item found
+ * - 2 : list found
+ * - -1 : the encoding is invalid
+ */
+int rlp_iter_next(rlp_iterator_t* iter, bytes_t* dst);
+
+/**
+ * decodes all items of b with one pass, so each item can be accessed directly afterwards.
+ *
+ * Like with rlp_decode the items only hold references into b.
+ *
+ * \param b the ptr to the incoming bytes to decode.
+ * \param items the table receiving the first max items.
+ * \param types if not NULL, receives the type of each item (1 = item, 2 = list).
+ * \param max the size of the tables.
+ *
+ * \return the number of items found (which may be more than max) or -1 if the encoding is invalid.
+ */
+int rlp_decode_items(bytes_t* b, bytes_t* items, uint8_t* types, int max);
+
 /**
  * encode a item as single string and add it to the bytes_builder.
  * 
@@ -78,7 +78,7 @@ in3_ret_t eth_verify_eth_getTransactionReceipt(in3_vctx_t* vc, bytes_t* tx_hash)
   if (!vc->proof)
     return vc_err(vc, "Proof is missing!");
 
-  bytes_t* blockHeader = d_get_bytesk(vc->proof, K_BLOCK);
+  bytes_t* blockHeader = eth_get_proof_header(vc, d_get(vc->proof, K_BLOCK), d_bytes(block_hash));
   if (!blockHeader)
     return vc_err(vc, "No Block-Proof!");
 
@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+/**
+ * measures the operations per second of the 256-bit kernels in big.c against the same operation done with tommath.
+ *
+ * usage: bench_big [iterations]
+ */
+#include "../src/core/util/bytes.h"
+#include "../src/core/util/utils.h"
+#include "../src/third-party/tommath/tommath.h"
+#include "../src/verifier/eth1/evm/big.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef enum {
+  KERNEL_MUL,
+  KERNEL_DIV,
+  KERNEL_DIV64,
+  KERNEL_EXP,
+  KERNEL_MODEXP
+} kernel_t;
+
+typedef struct {
+  char*    name; /**< name of the kernel */
+  kernel_t kernel;
+  wlen_t   la; /**< length of the first operand */
+  wlen_t   lb; /**< length of the second operand */
+} bench_kernel_t;
+
+static bench_kernel_t kernels[] = {
+    {.name = "mul", .kernel = KERNEL_MUL, .la = 32, .lb = 32},
+    {.name = "div", .kernel = KERNEL_DIV, .la = 64, .lb = 32},
+    {.name = "div64", .kernel = KERNEL_DIV64, .la = 32, .lb = 8},
+    {.name = "exp", .kernel = KERNEL_EXP, .la = 32, .lb = 32},
+    {.name = "modexp", .kernel = KERNEL_MODEXP, .la = 32, .lb = 32},
+};
+
+static uint8_t a[64], b[64], m[32], res[66];
+
+static void run_big(bench_kernel_t* k) {
+  wlen_t l, rl;
+  switch (k->kernel) {
+    case KERNEL_MUL:
+      big_mul(a, k->la, b, k->lb, res, 64);
+      break;
+    case KERNEL_DIV:
+    case KERNEL_DIV64:
+      big_divmod(a, k->la, b, k->lb, res, &l, res + 64 - k->lb, &rl);
+      break;
+    case KERNEL_EXP:
+      big_exp(a, k->la, b, k->lb, res);
+      break;
+    case KERNEL_MODEXP:
+      big_modexp(a, k->la, b, k->lb, m, 32, res);
+      break;
+  }
+}
+
+static void run_tommath(bench_kernel_t* k) {
+  mp_int ma, mb, mm, mr;
+  size_t l;
+  mp_init_multi(&ma, &mb, &mm, &mr, NULL);
+  mp_import(&ma, k->la, 1, sizeof(uint8_t), 1, 0, a);
+  mp_import(&mb, k->lb, 1, sizeof(uint8_t), 1, 0, b);
+  switch (k->kernel) {
+    case KERNEL_MUL:
+      mp_mul(&ma, &mb, &mr);
+      break;
+    case KERNEL_DIV:
+    case KERNEL_DIV64:
+      mp_div(&ma, &mb, &mr, &mm);
+      break;
+    case KERNEL_EXP:
+      mp_2expt(&mm, 256);
+      mp_exptmod(&ma, &mb, &mm, &mr);
+      break;
+    case KERNEL_MODEXP:
+      mp_import(&mm, 32, 1, sizeof(uint8_t), 1, 0, m);
+      mp_exptmod(&ma, &mb, &mm, &mr);
+      break;
+  }
+  mp_export(res, &l, 1, sizeof(uint8_t), 1, 0, &mr);
+  mp_clear_multi(&ma, &mb, &mm, &mr, NULL);
+}
+
+static double measure(bench_kernel_t* k, void (*fn)(bench_kernel_t*), uint32_t iterations) {
+  clock_t start = clock();
+  for (uint32_t i = 0; i < iterations; i++) fn(k);
+  double secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+  return iterations / (secs > 0 ? secs : 1e-9);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iterations = argc > 1 ? (uint32_t) atol(argv[1]) : 100000;
+
+  // fixed pseudo random operands with the highest byte set, so the full length is used
+  srand(1);
+  for (int i = 0; i < 64; i++) a[i] = rand(), b[i] = rand();
+  for (int i = 0; i < 32; i++) m[i] = rand();
+  a[0] |= 0x80;
+  b[0] |= 0x80;
+  m[0] |= 0x80;
+  m[31] |= 1;
+
+  printf("%-12s %16s %16s %8s\n", "kernel", "tommath ops/s", "big ops/s", "speedup");
+  for (unsigned int i = 0; i < sizeof(kernels) / sizeof(bench_kernel_t); i++) {
+    // the exponentiations are much slower, so we use less iterations
+    uint32_t n           = kernels[i].kernel >= KERNEL_EXP ? iterations / 100 + 1 : iterations;
+    double   tommath_ops = measure(kernels + i, run_tommath, n);
+    double   big_ops     = measure(kernels + i, run_big, n);
+    printf("%-12s %16.0f %16.0f %7.2fx\n", kernels[i].name, tommath_ops, big_ops, tommath_ops ? big_ops / tommath_ops : 0);
+  }
+  return 0;
+}
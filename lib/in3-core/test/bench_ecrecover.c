@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+/**
+ * measures the public key recoveries per second of the 64bit secp256k1 implementation against the point multiplication of bignum.c.
+ *
+ * usage: bench_ecrecover [iterations]
+ */
+#include "../src/third-party/crypto/bignum.h"
+#include "../src/third-party/crypto/ecdsa.h"
+#include "../src/third-party/crypto/secp256k1.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLES 16
+
+static uint8_t keys[SAMPLES][32], digests[SAMPLES][32], sigs[SAMPLES][64], recids[SAMPLES];
+
+// the recovery as done by ecdsa_recover_pub_from_sig without SECP256K1_64BIT
+static int recover_bignum(uint8_t* pub_key, const uint8_t* sig, const uint8_t* digest, int recid) {
+  const ecdsa_curve* curve = &secp256k1;
+  bignum256          r, s, e;
+  curve_point        cp, cp2;
+  bn_read_be(sig, &r);
+  bn_read_be(sig + 32, &s);
+  memcpy(&cp.x, &r, sizeof(bignum256));
+  if (recid & 2) bn_add(&cp.x, &curve->order);
+  uncompress_coords(curve, recid & 1, &cp.x, &cp.y);
+  if (!ecdsa_validate_pubkey(curve, &cp)) return 1;
+  bn_read_be(digest, &e);
+  bn_subtractmod(&curve->order, &e, &e, &curve->order);
+  bn_fast_mod(&e, &curve->order);
+  bn_mod(&e, &curve->order);
+  bn_inverse(&r, &curve->order);
+  point_multiply(curve, &s, &cp, &cp);
+  scalar_multiply(curve, &e, &cp2);
+  point_add(curve, &cp2, &cp);
+  point_multiply(curve, &r, &cp, &cp);
+  pub_key[0] = 0x04;
+  bn_write_be(&cp.x, pub_key + 1);
+  bn_write_be(&cp.y, pub_key + 33);
+  return 0;
+}
+
+static int recover_fast(uint8_t* pub_key, const uint8_t* sig, const uint8_t* digest, int recid) {
+  return ecdsa_recover_pub_from_sig(&secp256k1, pub_key, sig, digest, recid);
+}
+
+static double measure(int (*fn)(uint8_t*, const uint8_t*, const uint8_t*, int), uint32_t iterations) {
+  uint8_t pub[65];
+  clock_t start = clock();
+  for (uint32_t i = 0; i < iterations; i++) fn(pub, sigs[i % SAMPLES], digests[i % SAMPLES], recids[i % SAMPLES]);
+  double secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+  return iterations / (secs > 0 ? secs : 1e-9);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iterations = argc > 1 ? (uint32_t) atol(argv[1]) : 2000;
+  uint8_t  a[65], b[65];
+
+  // fixed pseudo random keys and digests
+  srand(1);
+  for (int i = 0; i < SAMPLES; i++) {
+    for (int j = 0; j < 32; j++) keys[i][j] = rand(), digests[i][j] = rand();
+    if (ecdsa_sign_digest(&secp256k1, keys[i], digests[i], sigs[i], recids + i, NULL)) return 1;
+    if (recover_bignum(a, sigs[i], digests[i], recids[i]) || recover_fast(b, sigs[i], digests[i], recids[i]) || memcmp(a, b, 65)) {
+      printf("the recovered public keys do not match!\n");
+      return 1;
+    }
+  }
+
+  double bignum_ops = measure(recover_bignum, iterations / 10 + 1);
+  double fast_ops   = measure(recover_fast, iterations);
+#ifdef SECP256K1_64BIT
+  printf("%-12s %16s %16s %8s\n", "", "bignum ops/s", "64bit ops/s", "speedup");
+#else
+  printf("%-12s %16s %16s %8s\n", "", "bignum ops/s", "current ops/s", "speedup");
+#endif
+  printf("%-12s %16.0f %16.0f %7.2fx\n", "ecrecover", bignum_ops, fast_ops, bignum_ops ? fast_ops / bignum_ops : 0);
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+/**
+ * measures the instructions per second of the evm for both interpreter cores.
+ *
+ * usage: bench_evm [iterations]
+ */
+#include "../src/core/util/bytes.h"
+#include "../src/core/util/mem.h"
+#include "../src/core/util/utils.h"
+#include "../src/verifier/eth1/evm/evm.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  char*    name;         /**< name of the program */
+  char*    code;         /**< the bytecode as hex, which expects the number of iterations on the stack */
+  uint32_t ops_per_loop; /**< number of instructions executed in each iteration */
+} bench_program_t;
+
+static bench_program_t programs[] = {
+    // JUMPDEST PUSH1 1 SWAP1 SUB DUP1 PUSH1 7 MUL PUSH1 3 ADD POP DUP1 PUSH1 5 JUMPI
+    {.name = "arithmetic", .code = "5b60019003806007026003015080600557", .ops_per_loop = 13},
+    // JUMPDEST PUSH1 1 SWAP1 SUB DUP1 DUP1 PUSH1 0 MSTORE PUSH1 0 MLOAD EQ POP DUP1 PUSH1 5 JUMPI
+    {.name = "memory", .code = "5b600190038080600052600051145080600557", .ops_per_loop = 15},
+    // JUMPDEST PUSH1 1 SWAP1 SUB DUP1 PUSH32 0x7f..ff MUL PUSH32 0x0102..20 ADD PUSH20 0xff..ff SWAP1 DIV POP DUP1 PUSH1 5 JUMPI
+    {.name = "wide", .code = "5b60019003807f7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff027f0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f200173ffffffffffffffffffffffffffffffffffffffff90045080600557", .ops_per_loop = 16},
+};
+
+static bytes_t bench_code;
+
+static int bench_env(void* evm, uint16_t evm_key, uint8_t* in_data, int in_len, uint8_t** out_data, int offset, int len) {
+  UNUSED_VAR(evm);
+  UNUSED_VAR(in_data);
+  UNUSED_VAR(in_len);
+  UNUSED_VAR(offset);
+  UNUSED_VAR(len);
+  static uint8_t size[4];
+  switch (evm_key) {
+    case EVM_ENV_CODE_SIZE:
+      int_to_bytes(bench_code.len, size);
+      *out_data = size;
+      return 4;
+    case EVM_ENV_CODE_COPY:
+      *out_data = bench_code.data;
+      return bench_code.len;
+    default:
+      return -2;
+  }
+}
+
+static double run_program(bench_program_t* program, uint32_t iterations, uint32_t props) {
+  uint8_t address[20], caller[20];
+  memset(address, 0x11, 20);
+  memset(caller, 0x22, 20);
+
+  // the program is wrapped in a PUSH4 of the number of iterations and a final STOP, so the loop starts at 5
+  bytes_t* code      = hex_to_new_bytes(program->code, strlen(program->code));
+  bench_code         = bytes(_malloc(code->len + 6), code->len + 6);
+  bench_code.data[0] = 0x63;
+  int_to_bytes(iterations, bench_code.data + 1);
+  memcpy(bench_code.data + 5, code->data, code->len);
+  bench_code.data[code->len + 5] = 0x00;
+  b_free(code);
+
+  evm_t evm;
+  int   res = evm_prepare_evm(&evm, address, address, caller, caller, bench_env, NULL, 0);
+  evm.properties |= props | EVM_PROP_NO_FINALIZE;
+#ifdef EVM_GAS
+  evm.gas = 0xFFFFFFFFFFFF;
+#endif
+
+  clock_t start = clock();
+  if (res == 0) res = evm_run(&evm, address);
+  double secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  evm_free(&evm);
+  _free(bench_code.data);
+  if (res < 0) {
+    printf("%-12s failed with %i\n", program->name, res);
+    return 0;
+  }
+  // the PUSH4 and STOP are executed once
+  return (((double) iterations) * program->ops_per_loop + 2) / (secs > 0 ? secs : 1e-9);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iterations = argc > 1 ? (uint32_t) atol(argv[1]) : 1000000;
+
+  printf("%-12s %16s %16s %8s\n", "program", "switch ops/s", "threaded ops/s", "speedup");
+  for (unsigned int i = 0; i < sizeof(programs) / sizeof(bench_program_t); i++) {
+    double switch_ops   = run_program(programs + i, iterations, EVM_PROP_SWITCH_DISPATCH);
+    double threaded_ops = run_program(programs + i, iterations, 0);
+    printf("%-12s %16.0f %16.0f %7.2fx\n", programs[i].name, switch_ops, threaded_ops, switch_ops ? threaded_ops / switch_ops : 0);
+  }
+  return 0;
+}
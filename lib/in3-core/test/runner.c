@@ -209,8 +209,10 @@ int execRequest(in3_t* c, d_token_t* test, int must_fail) {
   char       params[10000];
 
   // configure in3
-  c->request_count = (t = d_get(config, key("requestCount"))) ? d_int(t) : 1;
-  method           = d_get_string(request, "method");
+  c->request_count    = (t = d_get(config, key("requestCount"))) ? d_int(t) : 1;
+  c->verify_threads   = (t = d_get(config, key("verifyThreads"))) ? d_int(t) : 0;
+  c->max_sender_cache = (t = d_get(config, key("maxSenderCache"))) ? d_int(t) : 0;
+  method              = d_get_string(request, "method");
 
   str_range_t s = d_to_json(d_get(request, key("params")));
   if (!method) {
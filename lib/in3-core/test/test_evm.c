@@ -354,7 +354,7 @@ int generate_state_root(evm_t* evm, uint8_t* dst) {
   });
 
   //
-  account_t* ac = evm->accounts;
+  account_t* ac = evm->accounts ? evm->accounts->list : NULL;
   while (ac) {
     if (num_bytes(ac->nonce, 32) == 0 && num_bytes(ac->balance, 32) == 0 && ac->code.len == 0) {
       ac = ac->next;
@@ -442,11 +442,13 @@ int run_evm(d_token_t* test, uint32_t props, uint64_t* ms, char* fork_name, int
   evm.memory.b.len  = 0;
   evm.memory.bsize  = 32;
 
-  evm.invalid_jumpdest = NULL;
+  evm.jumpdests     = NULL;
+  evm.own_jumpdests = false;
 
   evm.stack_size = 0;
 
   evm.pos   = 0;
+  evm.depth = 0;
   evm.state = EVM_STATE_INIT;
 
   evm.last_returned.data = NULL;
@@ -602,22 +604,9 @@ int run_evm(d_token_t* test, uint32_t props, uint64_t* ms, char* fork_name, int
       total_gas = d_long(get_test_val(transaction, "gasLimit", indexes));
       evm.gas   = 0;
       fail      = 0;
-      uint8_t    gas_tmp[32], gas_tmp2[32];
-      account_t* ac = NULL;
-      storage_t* s  = NULL;
+      uint8_t gas_tmp[32], gas_tmp2[32];
       // reset all accounts except the sender
-      while (evm.accounts) {
-        ac = evm.accounts;
-        //    if (ac->code.data) _free(ac->code.data);
-        s = NULL;
-        while (ac->storage) {
-          s           = ac->storage;
-          ac->storage = s->next;
-          _free(s);
-        }
-        evm.accounts = ac->next;
-        _free(ac);
-      }
+      evm_free_accounts(&evm);
 
       // read the accounts from pre-state
       read_accounts(&evm, d_get(test, key("pre")));
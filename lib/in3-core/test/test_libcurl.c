@@ -101,20 +101,44 @@ static const char* test_urls[] = {
  */
 extern int  send_curl_blocking(const char** urls, int urls_len, char* payload, in3_response_t* result);
 extern int  send_curl_nonblocking(const char** urls, int urls_len, char* payload, in3_response_t* result);
+extern void* curl_pool_new();
+extern void  curl_pool_free(void* pool);
+extern int   send_curl_pool(void* pool, in3_request_t* req);
 static void test_send_curl_blocking();
 static void test_send_curl_nonblocking();
 static void test_send_curl_match_responses();
 static void test_send_curl_timing();
+static void test_send_curl_pool();
+
+/*
+ * the tests send requests to real urls, so without network access they are skipped.
+ */
+#define SKIP_NO_NETWORK 77
+
+static bool has_network() {
+  in3_response_t response;
+  sb_init(&response.error);
+  sb_init(&response.result);
+  const bool ok = send_curl_blocking(test_urls, 1, "[]", &response) == 0 && !response.error.len;
+  _free(response.error.data);
+  _free(response.result.data);
+  return ok;
+}
 
 /*
  * Main
  */
 int main() {
+  if (!has_network()) {
+    printf("no network access, skipping the libcurl tests\n");
+    return SKIP_NO_NETWORK;
+  }
   TESTS_BEGIN();
   RUN_TIMED_TEST(test_send_curl_blocking);
   RUN_TIMED_TEST(test_send_curl_nonblocking);
   RUN_TEST(test_send_curl_match_responses);
   RUN_TEST(test_send_curl_timing);
+  RUN_TIMED_TEST(test_send_curl_pool);
   return TESTS_END();
 }
 
@@ -223,3 +247,34 @@ void test_send_curl_timing() {
   _free(response2);
   _free(ips);
 }
+
+void test_send_curl_pool() {
+  void*           pool     = curl_pool_new();
+  in3_response_t* response = _malloc(sizeof(*response) * 2);
+
+  // sending the same request twice should reuse the connection.
+  for (int i = 0; i < 2; i++) {
+    sb_init(&response[i].error);
+    sb_init(&response[i].result);
+    in3_request_t req = {.payload = "{ name: \"in3\", tests: [\"libcurl\"] }", .urls = (char**) test_urls, .urls_len = 1, .results = response + i, .ctx = NULL};
+    TEST_ASSERT_EQUAL(0, send_curl_pool(pool, &req));
+  }
+  TEST_ASSERT_EQUAL(response[0].result.len, response[1].result.len);
+
+  in3_curl_stats_t stats;
+  in3_t*           c = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  TEST_ASSERT_EQUAL(IN3_EFIND, in3_curl_pool_stats(c, &stats));
+  c->transport_data = pool;
+  c->transport_free = curl_pool_free;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_curl_pool_stats(c, &stats));
+  TEST_ASSERT_EQUAL(2, stats.requests);
+  TEST_ASSERT_EQUAL(1, stats.connections);
+  TEST_ASSERT_EQUAL(1, stats.reused);
+
+  for (int i = 0; i < 2; i++) {
+    _free(response[i].error.data);
+    _free(response[i].result.data);
+  }
+  _free(response);
+  in3_free(c);
+}
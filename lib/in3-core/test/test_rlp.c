@@ -62,6 +62,22 @@ void append_rlp(bytes_builder_t* bb, d_token_t* in) {
   rlp_encode_item(bb, &b);
 }
 
+// decodes the item with the cursor and compares it with the input.
+static int check_decoded(bytes_t* item, int type, d_token_t* in) {
+  if (d_type(in) != T_ARRAY) {
+    bytes_t b = d_to_bytes(in);
+    return type == 1 && b_cmp(item, &b);
+  }
+  if (type != 2 || rlp_decode_items(item, NULL, NULL, 0) != d_len(in)) return 0;
+
+  bytes_t        child;
+  rlp_iterator_t iter = rlp_iter(item);
+  for (d_iterator_t it = d_iter(in); it.left; d_iter_next(&it)) {
+    if (!check_decoded(&child, rlp_iter_next(&iter, &child), it.token)) return 0;
+  }
+  return rlp_iter_next(&iter, &child) == 0;
+}
+
 int test_rlp(d_token_t* test, uint32_t props, uint64_t* ms) {
   uint64_t   start = clock();
   int        res   = 0;
@@ -80,6 +96,13 @@ int test_rlp(d_token_t* test, uint32_t props, uint64_t* ms) {
   }
   bb_free(bb);
 
+  bytes_t        item;
+  rlp_iterator_t iter = rlp_iter(&out);
+  if (res == 0 && (!check_decoded(&item, rlp_iter_next(&iter, &item), in) || rlp_iter_next(&iter, &item) != 0)) {
+    print_error("Wrong decoded result");
+    res = -1;
+  }
+
   *ms = (clock() - start) / 1000;
   return res;
 }
\ No newline at end of file
@@ -41,10 +41,17 @@
 
 #include "../../src/core/client/cache.h"
 #include "../../src/core/client/context.h"
+#include "../../src/core/client/keys.h"
 #include "../../src/core/client/nodelist.h"
 #include "../../src/core/util/data.h"
 #include "../../src/core/util/log.h"
 #include "../../src/core/util/scache.h"
+#include "../../src/third-party/crypto/ecdsa.h"
+#include "../../src/third-party/crypto/secp256k1.h"
+#include "../../src/verifier/eth1/basic/eth_basic.h"
+#include "../../src/verifier/eth1/evm/code.h"
+#include "../../src/verifier/eth1/evm/evm.h"
+#include "../../src/verifier/eth1/full/eth_full.h"
 #include "../../src/verifier/eth1/nano/eth_nano.h"
 #include "../test_utils.h"
 #include <stdio.h>
@@ -287,6 +294,507 @@ static void test_whitelist_cache() {
   in3_free(c);
 }
 
+static int response_calls = 0;
+
+static in3_ret_t test_response_transport(in3_request_t* req) {
+  response_calls++;
+  json_ctx_t* payload = parse_json(req->payload);
+  sb_t*       sb      = &req->results->result;
+  sb_add_char(sb, '[');
+  for (d_iterator_t it = d_iter(payload->result); it.left; d_iter_next(&it)) {
+    char* method = d_get_stringk(it.token, K_METHOD);
+    if (sb->len > 1) sb_add_char(sb, ',');
+    // eth_gasPrice is delivered without proof
+    sb_add_chars(sb, "{\"id\":1,\"jsonrpc\":\"2.0\",\"in3\":{\"currentBlock\":\"0x100\"");
+    if (strcmp(method, "eth_gasPrice")) sb_add_chars(sb, ",\"proof\":{}");
+    sb_add_chars(sb, "},\"result\":");
+    if (strcmp(method, "eth_getBlockByHash") == 0)
+      sb_add_chars(sb, "{\"number\":\"0x10\"}");
+    else if (strcmp(method, "eth_getTransactionByHash") == 0)
+      sb_add_chars(sb, "null");
+    else
+      sb_add_chars(sb, "\"0x10\"");
+    sb_add_char(sb, '}');
+  }
+  sb_add_char(sb, ']');
+  json_free(payload);
+  return IN3_OK;
+}
+
+// accepts all results, so we can check which of them are cached.
+static in3_ret_t accept_response(in3_vctx_t* vc) {
+  (void) vc;
+  return IN3_OK;
+}
+
+static void assert_response(in3_t* c, char* method, char* params, char* expected, int calls) {
+  char *result = NULL, *error = NULL;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_rpc(c, method, params, &result, &error));
+  TEST_ASSERT_EQUAL_STRING(expected, result);
+  TEST_ASSERT_EQUAL_INT(calls, response_calls);
+  _free(result);
+}
+
+static void test_response_cache() {
+  in3_register_eth_nano();
+  in3_verifier_t*   verifier = in3_get_verifier(CHAIN_ETH);
+  in3_verify        verify   = verifier->verify;
+  in3_t*            c        = in3_for_chain(0x1);
+  verifier->verify           = accept_response;
+  c->transport               = test_response_transport;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_configure(c, "{\"autoUpdateList\":false,\"proof\":\"standard\",\"maxAttempts\":1,\"maxResponseCache\":2}"));
+  for (int i = 0; i < c->chains_length; i++) c->chains[i].needs_update = false;
+
+  // immutable results are cached even without cache_timeout
+  response_calls = 0;
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 1);
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 1);
+
+  // results which may change require a cache_timeout
+  assert_response(c, "eth_blockNumber", "[]", "\"0x10\"", 2);
+  assert_response(c, "eth_blockNumber", "[]", "\"0x10\"", 3);
+  assert_response(c, "eth_getBalance", "[\"0x1234567890123456789012345678901234567890\",\"latest\"]", "\"0x10\"", 4);
+  assert_response(c, "eth_getBalance", "[\"0x1234567890123456789012345678901234567890\",\"latest\"]", "\"0x10\"", 5);
+
+  // null is never cached
+  assert_response(c, "eth_getTransactionByHash", "[\"0x1234\"]", "null", 6);
+  assert_response(c, "eth_getTransactionByHash", "[\"0x1234\"]", "null", 7);
+
+  in3_response_cache_stats_t stats;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_response_cache_stats(c, &stats));
+  TEST_ASSERT_EQUAL_UINT64(1, stats.hits);
+  TEST_ASSERT_EQUAL_UINT64(7, stats.misses);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.entries);
+
+  // a final block is immutable, latest only lives until the timeout
+  c->cache_timeout = 10;
+  assert_response(c, "eth_getBalance", "[\"0x1234567890123456789012345678901234567890\",\"0x10\"]", "\"0x10\"", 8);
+  assert_response(c, "eth_getBalance", "[\"0x1234567890123456789012345678901234567890\",\"0x10\"]", "\"0x10\"", 8);
+  TEST_ASSERT_EQUAL_UINT64(0, c->response_cache->head->expires);
+  assert_response(c, "eth_blockNumber", "[]", "\"0x10\"", 9);
+  assert_response(c, "eth_blockNumber", "[]", "\"0x10\"", 9);
+  TEST_ASSERT_TRUE(c->response_cache->head->expires > 0);
+
+  // expired entries are removed
+  c->response_cache->head->expires = 1;
+  assert_response(c, "eth_blockNumber", "[]", "\"0x10\"", 10);
+
+  // the least recently used entry (the block) was evicted
+  in3_client_response_cache_stats(c, &stats);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.entries);
+  assert_response(c, "eth_getBalance", "[\"0x1234567890123456789012345678901234567890\",\"0x10\"]", "\"0x10\"", 10);
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 11);
+
+  // disabled as long as the in3-section is kept
+  c->keep_in3 = true;
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 12);
+
+  in3_client_response_cache_stats(c, &stats);
+  TEST_ASSERT_EQUAL_UINT64(4, stats.hits);
+  TEST_ASSERT_EQUAL_UINT64(11, stats.misses);
+  c->keep_in3 = false;
+
+  // responses without proof are never cached
+  assert_response(c, "eth_gasPrice", "[]", "\"0x10\"", 13);
+  assert_response(c, "eth_gasPrice", "[]", "\"0x10\"", 14);
+
+  // cached responses are only served to requests with the same proof-level
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 14);
+  c->proof = PROOF_FULL;
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 15);
+
+  // if only some requests of a batch are found, all are sent, but only the missing one is counted as miss
+  c->proof = PROOF_STANDARD;
+  in3_client_response_cache_stats(c, &stats);
+  const uint64_t hits = stats.hits, misses = stats.misses;
+  in3_ctx_t*     ctx  = ctx_new(c, "[{\"method\":\"eth_getBlockByHash\",\"params\":[\"0x1234\",false]},{\"method\":\"eth_getBlockByHash\",\"params\":[\"0x5678\",false]}]");
+  TEST_ASSERT_EQUAL(IN3_OK, in3_send_ctx(ctx));
+  TEST_ASSERT_EQUAL_INT(16, response_calls);
+  ctx_free(ctx);
+  in3_client_response_cache_stats(c, &stats);
+  TEST_ASSERT_EQUAL_UINT64(hits, stats.hits);
+  TEST_ASSERT_EQUAL_UINT64(misses + 1, stats.misses);
+
+  // a response verified with a lower finality is not served
+  c->finality = 10;
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 17);
+  c->finality = 0;
+
+  // without proof the cache is not used at all
+  c->proof = PROOF_NONE;
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 18);
+  assert_response(c, "eth_getBlockByHash", "[\"0x1234\",false]", "{\"number\":\"0x10\"}", 19);
+
+  verifier->verify = verify;
+  in3_free(c);
+}
+
+static void test_block_cache() {
+  in3_t*       c          = in3_for_chain(0x1);
+  in3_chain_t* chain      = c->chains;
+  uint8_t      data[3][4] = {{0xc3, 1, 2, 3}, {0xc3, 1, 2, 4}, {0xc3, 1, 2, 5}};
+  bytes_t      headers[3] = {bytes(data[0], 4), bytes(data[1], 4), bytes(data[2], 4)};
+  bytes32_t    hashes[3];
+  for (int i = 0; i < 3; i++) memset(hashes[i], i + 1, 32);
+  bytes_t hash = bytes(hashes[0], 32);
+
+  // disabled without max_block_cache
+  in3_cache_add_header(c, chain, headers, 1, hashes[0], 2, 0);
+  TEST_ASSERT_NULL(chain->block_cache);
+
+  c->max_block_cache = 2;
+  in3_cache_add_header(c, chain, headers, 1, hashes[0], 2, 0);
+  TEST_ASSERT_TRUE(in3_cache_is_verified_header(c, chain, headers, 1, &hash, 2, 0));
+  TEST_ASSERT_TRUE(in3_cache_is_verified_header(c, chain, headers, 1, NULL, 1, 0));
+
+  // more signatures or a higher finality must be verified again
+  TEST_ASSERT_FALSE(in3_cache_is_verified_header(c, chain, headers, 1, NULL, 3, 0));
+  TEST_ASSERT_FALSE(in3_cache_is_verified_header(c, chain, headers, 1, NULL, 2, 50));
+
+  // a different header with the same number or hash is not verified
+  TEST_ASSERT_FALSE(in3_cache_is_verified_header(c, chain, headers + 1, 1, NULL, 0, 0));
+  TEST_ASSERT_FALSE(in3_cache_is_verified_header(c, chain, headers + 1, 1, &hash, 0, 0));
+
+  // the least recently used header is replaced
+  in3_cache_add_header(c, chain, headers + 1, 2, hashes[1], 2, 0);
+  TEST_ASSERT_TRUE(in3_cache_is_verified_header(c, chain, headers, 1, NULL, 2, 0));
+  in3_cache_add_header(c, chain, headers + 2, 3, hashes[2], 2, 0);
+  TEST_ASSERT_EQUAL_UINT32(2, chain->block_cache->len);
+  TEST_ASSERT_TRUE(in3_cache_is_verified_header(c, chain, headers, 1, NULL, 2, 0));
+  TEST_ASSERT_FALSE(in3_cache_is_verified_header(c, chain, headers + 1, 2, NULL, 2, 0));
+  TEST_ASSERT_TRUE(in3_cache_is_verified_header(c, chain, headers + 2, 3, NULL, 2, 0));
+
+  // headers sent only as blocknumber are taken from the cache
+  bytes_t hash3 = bytes(hashes[2], 32);
+  TEST_ASSERT_TRUE(b_cmp(headers + 2, in3_cache_get_header(c, chain, 3, NULL)));
+  TEST_ASSERT_TRUE(b_cmp(headers + 2, in3_cache_get_header(c, chain, 3, &hash3)));
+  TEST_ASSERT_NULL(in3_cache_get_header(c, chain, 2, NULL));
+
+  // if the blockhash is known, it must match
+  TEST_ASSERT_NULL(in3_cache_get_header(c, chain, 3, &hash));
+
+  // the verified hashes are only sent, if they match the requested signatures
+  bytes_t* verified = NULL;
+  TEST_ASSERT_EQUAL_INT(2, in3_cache_verified_hashes(c, chain, 2, 0, &verified));
+  TEST_ASSERT_EQUAL_MEMORY(hashes[0], verified[0].data, 32);
+  TEST_ASSERT_EQUAL_MEMORY(hashes[2], verified[1].data, 32);
+  _free(verified);
+  TEST_ASSERT_EQUAL_INT(0, in3_cache_verified_hashes(c, chain, 3, 0, &verified));
+  TEST_ASSERT_NULL(verified);
+
+  in3_free(c);
+}
+
+static void test_block_cache_index() {
+  in3_t*       c     = in3_for_chain(0x1);
+  in3_chain_t* chain = c->chains;
+  uint8_t      data[4], hash_data[32];
+  bytes_t      header = bytes(data, 4);
+  memset(hash_data, 0, 32);
+  bytes_t hash = bytes(hash_data, 32);
+  data[0]      = 0xc3;
+
+  // more headers than buckets with the same number in different forks
+  c->max_block_cache = 64;
+  for (int i = 0; i < 100; i++) {
+    data[1] = data[2] = data[3] = hash_data[0] = hash_data[31] = (uint8_t) i;
+    in3_cache_add_header(c, chain, &header, i / 2, hash_data, 1, 0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(64, chain->block_cache->len);
+
+  for (int i = 0; i < 100; i++) {
+    data[1] = data[2] = data[3] = hash_data[0] = hash_data[31] = (uint8_t) i;
+    TEST_ASSERT_EQUAL(i >= 36, in3_cache_is_verified_header(c, chain, &header, i / 2, &hash, 1, 0));
+    TEST_ASSERT_EQUAL(i >= 36, in3_cache_is_verified_header(c, chain, &header, i / 2, NULL, 1, 0));
+    TEST_ASSERT_FALSE(in3_cache_is_verified_header(c, chain, &header, i / 2 + 1, &hash, 1, 0));
+  }
+
+  // the blocknumber alone finds the most recently added header
+  data[1] = data[2] = data[3] = 99;
+  bytes_t* found                = in3_cache_get_header(c, chain, 49, NULL);
+  TEST_ASSERT_TRUE(b_cmp(&header, found));
+
+  // with the blockhash the header of the other fork is found
+  data[1] = data[2] = data[3] = hash_data[0] = hash_data[31] = 98;
+  TEST_ASSERT_TRUE(b_cmp(&header, in3_cache_get_header(c, chain, 49, &hash)));
+
+  // the cached headers don't move when other headers are added or removed
+  for (int i = 100; i < 150; i++) {
+    data[1] = data[2] = data[3] = hash_data[0] = hash_data[31] = (uint8_t) i;
+    in3_cache_add_header(c, chain, &header, i, hash_data, 1, 0);
+  }
+  TEST_ASSERT_EQUAL_PTR(found, in3_cache_get_header(c, chain, 49, NULL));
+  TEST_ASSERT_EQUAL_UINT32(64, chain->block_cache->len);
+
+  in3_free(c);
+}
+
+static void test_code_cache() {
+  in3_t*    c       = in3_for_chain(0x1);
+  uint8_t   data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  bytes32_t hashes[3];
+  for (int i = 0; i < 3; i++) memset(hashes[i], i + 1, 32);
+
+  // disabled without max_code_cache
+  TEST_ASSERT_NULL(in3_cache_add_code(c, hashes[0], bytes(data, 4)));
+
+  c->max_code_cache             = 8;
+  in3_code_cache_entry_t* entry = in3_cache_add_code(c, hashes[0], bytes(data, 4));
+  TEST_ASSERT_NOT_NULL(entry);
+  TEST_ASSERT_EQUAL_MEMORY(data, entry->code.data, 4);
+  TEST_ASSERT_EQUAL_PTR(entry, in3_cache_get_code(c, hashes[0]));
+  TEST_ASSERT_NULL(in3_cache_add_code(c, hashes[1], bytes(data, 9)));
+
+  // a context is using the first entry, while it gets evicted
+  cache_entry_t* ctx_cache = NULL;
+  in3_cache_use_code(&ctx_cache, bytes(NULL, 0), entry);
+  TEST_ASSERT_NOT_NULL(in3_cache_add_code(c, hashes[1], bytes(data, 4)));
+  TEST_ASSERT_NOT_NULL(in3_cache_add_code(c, hashes[2], bytes(data + 4, 4)));
+  TEST_ASSERT_NULL(in3_cache_get_code(c, hashes[0]));
+  TEST_ASSERT_EQUAL_UINT32(8, c->code_cache->size);
+  TEST_ASSERT_TRUE(entry->evicted);
+  TEST_ASSERT_EQUAL_MEMORY(data, ctx_cache->value.data, 4);
+  in3_cache_free(ctx_cache);
+
+  in3_free(c);
+}
+
+static char* read_file(char* path) {
+  FILE* f = fopen(path, "r");
+  TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+  fseek(f, 0, SEEK_END);
+  long length = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* buffer = _malloc(length + 1);
+  fread(buffer, 1, length, f);
+  buffer[length] = 0;
+  fclose(f);
+  return buffer;
+}
+
+static char* block_response = NULL;
+
+static in3_ret_t block_transport(in3_request_t* req) {
+  for (int i = 0; i < req->urls_len; i++) sb_add_chars(&req->results[i].result, block_response);
+  return IN3_OK;
+}
+
+static void test_sender_cache() {
+  in3_t*         c = in3_for_chain(0x1);
+  tx_signature_t sig;
+  bytes32_t      pk, hash;
+  uint8_t        pub[65];
+  memset(&sig, 0, sizeof(sig));
+  memset(pk, 0x11, 32);
+  ecdsa_get_public_key65(&secp256k1, pk, pub);
+  sig.public_key = bytes(pub + 1, 64);
+  memset(sig.hash, 0x22, 32);
+  TEST_ASSERT_EQUAL_INT(0, ecdsa_sign_digest(&secp256k1, pk, sig.hash, sig.sig, sig.sig + 64, NULL));
+
+  // disabled without max_sender_cache
+  TEST_ASSERT_NULL(in3_cache_senders(c));
+
+  c->max_sender_cache = 4;
+  sig.cache           = in3_cache_senders(c);
+  TEST_ASSERT_NOT_NULL(sig.cache);
+  eth_recover_tx_signature(&sig);
+  TEST_ASSERT_NULL(sig.error);
+  eth_recover_tx_signature(&sig);
+  TEST_ASSERT_NULL(sig.error);
+
+  in3_sender_cache_stats_t stats;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_sender_cache_stats(c, &stats));
+  TEST_ASSERT_EQUAL_UINT64(1, stats.hits);
+  TEST_ASSERT_EQUAL_UINT64(1, stats.misses);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.entries);
+
+  // the public key is taken from the cache, as long as hash and signature match
+  in3_sender_cache_entry_t* e = c->sender_cache->entries + bytes_to_int(sig.hash, 4) % 4;
+  e->public_key[0] ^= 1;
+  eth_recover_tx_signature(&sig);
+  TEST_ASSERT_EQUAL_STRING("invalid public Key", sig.error);
+  memcpy(hash, sig.hash, 32);
+  sig.hash[31] ^= 1;
+  TEST_ASSERT_FALSE(in3_cache_get_sender(sig.cache, sig.hash, sig.sig, pub + 1));
+  memcpy(sig.hash, hash, 32);
+  sig.sig[64] ^= 1;
+  TEST_ASSERT_FALSE(in3_cache_get_sender(sig.cache, sig.hash, sig.sig, pub + 1));
+
+  // a new size starts with an empty cache
+  c->max_sender_cache = 8;
+  TEST_ASSERT_EQUAL_UINT32(8, in3_cache_senders(c)->len);
+  in3_client_sender_cache_stats(c, &stats);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.entries);
+
+  // verifying the same block twice only recovers the senders of its transactions once
+  char*       content = read_file("../test/testdata/requests/eth_getBlockByNumber.json");
+  json_ctx_t* tests   = parse_json(content);
+  str_range_t json    = d_to_json(d_get(d_get_at(tests->result, 0), key("response")));
+  block_response      = _malloc(json.len + 1);
+  memcpy(block_response, json.data, json.len);
+  block_response[json.len] = 0;
+  json_free(tests);
+  _free(content);
+
+  in3_register_eth_full();
+  c->transport        = block_transport;
+  c->max_attempts     = 1;
+  c->auto_update_list = false;
+  c->proof            = PROOF_STANDARD;
+  for (int i = 0; i < c->chains_length; i++) c->chains[i].needs_update = false;
+
+  for (int i = 0; i < 2; i++) {
+    char *result = NULL, *error = NULL;
+    TEST_ASSERT_EQUAL_INT(IN3_OK, in3_client_rpc(c, "eth_getBlockByNumber", "[\"0x6a5c56\",true]", &result, &error));
+    TEST_ASSERT_NULL(error);
+    _free(result);
+  }
+  in3_client_sender_cache_stats(c, &stats);
+  TEST_ASSERT_EQUAL_UINT64(2, stats.hits);
+  TEST_ASSERT_EQUAL_UINT64(2, stats.misses);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.entries);
+
+  _free(block_response);
+  in3_free(c);
+}
+
+static char* call_response = NULL;
+static char* call_code     = NULL;
+static int   call_count    = 0;
+
+static in3_ret_t code_transport(in3_request_t* req) {
+  json_ctx_t* r       = parse_json(req->payload);
+  d_token_t*  request = d_type(r->result) == T_ARRAY ? r->result + 1 : r->result;
+  char*       res     = call_response;
+  char        tmp[strlen(call_code) + 50];
+  if (call_count++) {
+    // all missing code is fetched with one batch after the evm has run
+    TEST_ASSERT_EQUAL_INT(2, call_count);
+    TEST_ASSERT_EQUAL_INT(1, d_len(r->result));
+    TEST_ASSERT_EQUAL_STRING("eth_getCode", d_get_string(request, "method"));
+    bytes_t* address = hex_to_new_bytes("27a37a1210df14f7e058393d026e2fb53b7cf8c1", 40);
+    TEST_ASSERT_TRUE(b_cmp(address, d_get_bytes_at(d_get(request, key("params")), 0)));
+    b_free(address);
+    sprintf(tmp, "[{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":\"%s\"}]", call_code);
+    res = tmp;
+  } else
+    TEST_ASSERT_EQUAL_STRING("eth_call", d_get_string(request, "method"));
+  json_free(r);
+  for (int i = 0; i < req->urls_len; i++) sb_add_chars(&req->results[i].result, res);
+  return IN3_OK;
+}
+
+// runs a verified eth_call, but without the code of the contract in the response.
+static void run_code_request(uint32_t max_code_cache) {
+  char*       content = read_file("../test/testdata/requests/eth_call.json");
+  json_ctx_t* tests   = parse_json(content);
+  str_range_t json    = d_to_json(d_get(d_get_at(tests->result, 1), key("response")));
+  call_response       = _malloc(json.len + 1);
+  memcpy(call_response, json.data, json.len);
+  call_response[json.len] = 0;
+
+  char *code = strstr(call_response, "\"code\""), *start = strchr(code + 6, '"') + 1, *end = strchr(start, '"');
+  call_code = _malloc(end - start + 1);
+  memcpy(call_code, start, end - start);
+  call_code[end - start] = 0;
+  while (*code != ',') code--;
+  memmove(code, end + 1, strlen(end + 1) + 1);
+  json_free(tests);
+  _free(content);
+
+  in3_register_eth_full();
+  in3_t* c           = in3_for_chain(0x2a);
+  c->transport       = code_transport;
+  c->max_attempts     = 1;
+  c->auto_update_list = false;
+  c->proof            = PROOF_STANDARD;
+  c->max_code_cache   = max_code_cache;
+  c->cache            = NULL; // the code must not be taken from the storage of the other tests
+  call_count          = 0;
+  for (int i = 0; i < c->chains_length; i++) c->chains[i].needs_update = false;
+
+  char *result = NULL, *error = NULL;
+  in3_ret_t res = in3_client_rpc(c, "eth_call", "[{\"to\":\"0x27a37a1210df14f7e058393d026e2fb53b7cf8c1\",\"data\":\"0x15625c5e\"}]", &result, &error);
+  TEST_ASSERT_EQUAL_INT(IN3_OK, res);
+  TEST_ASSERT_NULL(error);
+  TEST_ASSERT_EQUAL_STRING("\"0x0000000000000000000000000000000000000000000000000000000000000005\"", result);
+  TEST_ASSERT_EQUAL_INT(2, call_count);
+
+  _free(result);
+  _free(call_response);
+  _free(call_code);
+  in3_free(c);
+}
+
+static void test_code_request() {
+  run_code_request(0);
+}
+
+static void test_code_request_cached() {
+  run_code_request(8);
+}
+
+static void test_code_without_address() {
+  // accounts without address in the proof are skipped, when looking for the code or the codehash.
+  in3_t*    c          = in3_for_chain(0x2a);
+  uint8_t   code[12]   = {0x60, 0x01, 0x60, 0x02, 0x60, 0x03, 0x60, 0x04, 0x60, 0x05, 0x60, 0x06};
+  bytes_t   code_bytes = bytes(code, 12);
+  bytes32_t code_hash;
+  char      hash_hex[65], json[400];
+  sha3_to(&code_bytes, code_hash);
+  bytes_to_hex(code_hash, 32, hash_hex);
+  sprintf(json, "{\"accounts\":{\"0x0\":{\"balance\":\"0x0\"},"
+                "\"0x27a37a1210df14f7e058393d026e2fb53b7cf8c1\":{\"address\":\"0x27a37a1210df14f7e058393d026e2fb53b7cf8c1\",\"codeHash\":\"0x%s\",\"code\":\"0x600160026003600460056006\"}}}",
+          hash_hex);
+  c->max_code_cache = 8;
+  c->cache          = NULL;
+
+  json_ctx_t*    proof  = parse_json(json);
+  in3_ctx_t*     ctx    = ctx_new(c, "{\"method\":\"eth_call\",\"params\":[]}");
+  in3_vctx_t     vc     = {.ctx = ctx, .proof = proof->result};
+  bytes_t*       adr    = hex_to_new_bytes("27a37a1210df14f7e058393d026e2fb53b7cf8c1", 40);
+  cache_entry_t* target = NULL;
+  TEST_ASSERT_EQUAL_INT(IN3_OK, in3_get_code(&vc, adr->data, &target));
+  TEST_ASSERT_TRUE(b_cmp(&code_bytes, &target->value));
+
+  b_free(adr);
+  ctx_free(ctx);
+  json_free(proof);
+  in3_free(c);
+}
+
+static void test_code_missing_errors() {
+  // errors of a run with missing code are removed, since the real code may never take these branches.
+  in3_t* c          = in3_for_chain(0x2a);
+  c->max_code_cache = 0;
+  c->cache          = NULL;
+
+  json_ctx_t* proof   = parse_json("{\"accounts\":{\"0x27a37a1210df14f7e058393d026e2fb53b7cf8c1\":{\"address\":\"0x27a37a1210df14f7e058393d026e2fb53b7cf8c1\",\"balance\":\"0x0\",\"codeHash\":\"0x1234\"}}}");
+  in3_ctx_t*  ctx     = ctx_new(c, "{\"method\":\"eth_call\",\"params\":[]}");
+  in3_vctx_t  vc      = {.ctx = ctx, .proof = proof->result};
+  bytes_t*    adr     = hex_to_new_bytes("27a37a1210df14f7e058393d026e2fb53b7cf8c1", 40);
+  bytes_t*    unknown = hex_to_new_bytes("1111111111111111111111111111111111111111", 40);
+  evm_t       evm;
+  uint8_t*    out = NULL;
+  memset(&evm, 0, sizeof(evm));
+  evm.env_ptr = &vc;
+  evm.address = adr->data;
+
+  // an error set before the evm started is kept
+  ctx_set_error(ctx, "before", IN3_EUNKNOWN);
+  TEST_ASSERT_EQUAL_INT(4, in3_get_env(&evm, EVM_ENV_CODE_SIZE, adr->data, 20, &out, 0, 0));
+  TEST_ASSERT_TRUE(in3_get_env(&evm, EVM_ENV_BALANCE, unknown->data, 20, &out, 0, 0) < 0);
+  TEST_ASSERT_TRUE(strlen(ctx->error) > strlen("before"));
+  TEST_ASSERT_EQUAL_INT(IN3_WAITING, in3_finish_env(&vc));
+  TEST_ASSERT_EQUAL_STRING("before", ctx->error);
+
+  b_free(adr);
+  b_free(unknown);
+  ctx_free(ctx);
+  json_free(proof);
+  in3_free(c);
+}
+
 /*
  * Main
  */
@@ -305,5 +813,14 @@ int main() {
   RUN_TEST(test_cache);
   RUN_TEST(test_newchain);
   RUN_TEST(test_whitelist_cache);
+  RUN_TEST(test_response_cache);
+  RUN_TEST(test_block_cache);
+  RUN_TEST(test_block_cache_index);
+  RUN_TEST(test_code_cache);
+  RUN_TEST(test_sender_cache);
+  RUN_TEST(test_code_request);
+  RUN_TEST(test_code_request_cached);
+  RUN_TEST(test_code_without_address);
+  RUN_TEST(test_code_missing_errors);
   return TESTS_END();
 }
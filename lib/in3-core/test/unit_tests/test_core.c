@@ -139,6 +139,27 @@ static void test_utils() {
   TEST_ASSERT_TRUE(memiszero(mem, 20));
 }
 
+static void test_sha3_multi() {
+  // lengths around the block size of 136 bytes need an additional block for the padding.
+  bytes_t  buffers[70], *ptr[70];
+  uint8_t  data[500], hashes[70 * 32], expected[32];
+  uint32_t lens[] = {0, 1, 135, 136, 137, 271, 272, 273};
+  for (int i = 0; i < 500; i++) data[i] = i * 7;
+  for (int i = 0; i < 70; i++) {
+    buffers[i] = bytes(data + (i % 3), i < 8 ? lens[i] : i * 7);
+    ptr[i]     = buffers + i;
+  }
+  sha3_multi(ptr, 70, hashes);
+  for (int i = 0; i < 70; i++) {
+    sha3_to(ptr[i], expected);
+    TEST_ASSERT_EQUAL_MEMORY(expected, hashes + i * 32, 32);
+  }
+
+  bytes_t* empty = hex_to_new_bytes("c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470", 64);
+  TEST_ASSERT_EQUAL_MEMORY(empty->data, hashes, 32);
+  b_free(empty);
+}
+
 /*
  * Main
  */
@@ -152,5 +173,6 @@ int main() {
   RUN_TEST(test_json);
   RUN_TEST(test_str_replace);
   RUN_TEST(test_utils);
+  RUN_TEST(test_sha3_multi);
   return TESTS_END();
 }
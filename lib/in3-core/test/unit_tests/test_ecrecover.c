@@ -0,0 +1,127 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#ifndef TEST
+#define TEST
+#endif
+#ifndef TEST
+#define DEBUG
+#endif
+
+#include "../../src/core/util/utils.h"
+#include "../../src/third-party/crypto/ecdsa.h"
+#include "../../src/third-party/crypto/secp256k1.h"
+#include "../test_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ORDER "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141"
+#define PRIME_MINUS_ORDER "000000000000000000000000000000014551231950b75fc4402da1722fc9baee"
+
+static void random_bytes(uint8_t* dst, int len) {
+  for (int i = 0; i < len; i++) dst[i] = rand();
+}
+
+static int recover(char* r, char* s, int recid) {
+  uint8_t sig[64], digest[32], pub[65];
+  hex_to_bytes(r, -1, sig, 32);
+  hex_to_bytes(s, -1, sig + 32, 32);
+  memset(digest, 0x12, 32);
+  return ecdsa_recover_pub_from_sig(&secp256k1, pub, sig, digest, recid);
+}
+
+static void test_recover_signed() {
+  uint8_t key[32], digest[32], sig[64], recid, expected[65], pub[65];
+  srand(1);
+  for (int i = 0; i < 200; i++) {
+    random_bytes(key, 32);
+    random_bytes(digest, 32);
+    // digests which are 0 or not below the order must work as well
+    if (i == 1) memset(digest, 0, 32);
+    if (i == 2) memset(digest, 0xff, 32);
+    if (i == 3) hex_to_bytes(ORDER, -1, digest, 32);
+    TEST_ASSERT_EQUAL_INT(0, ecdsa_sign_digest(&secp256k1, key, digest, sig, &recid, NULL));
+    ecdsa_get_public_key65(&secp256k1, key, expected);
+    TEST_ASSERT_EQUAL_INT(0, ecdsa_recover_pub_from_sig(&secp256k1, pub, sig, digest, recid));
+    TEST_ASSERT_EQUAL_MEMORY(expected, pub, 65);
+
+    // the other parity results in a different key
+    TEST_ASSERT_EQUAL_INT(0, ecdsa_recover_pub_from_sig(&secp256k1, pub, sig, digest, recid ^ 1));
+    TEST_ASSERT_TRUE(memcmp(expected, pub, 65));
+  }
+}
+
+static void test_recover_random() {
+  uint8_t sig[64], digest[32], pub[65];
+  int     recovered = 0;
+  srand(2);
+  // whatever is recovered from a random signature must be the key verifying it.
+  for (int i = 0; i < 100; i++) {
+    random_bytes(sig, 64);
+    random_bytes(digest, 32);
+    for (int recid = 0; recid < 4; recid++) {
+      if (ecdsa_recover_pub_from_sig(&secp256k1, pub, sig, digest, recid)) continue;
+      TEST_ASSERT_EQUAL_INT(0, ecdsa_verify_digest(&secp256k1, pub, sig, digest));
+      recovered++;
+    }
+  }
+  // about half of the x-values are on the curve
+  TEST_ASSERT_TRUE(recovered > 50);
+}
+
+static void test_recover_invalid() {
+  char* one = "0000000000000000000000000000000000000000000000000000000000000001";
+  char* zero = "0000000000000000000000000000000000000000000000000000000000000000";
+  TEST_ASSERT_EQUAL_INT(0, recover(one, one, 0));
+  TEST_ASSERT_EQUAL_INT(1, recover(zero, one, 0));
+  TEST_ASSERT_EQUAL_INT(1, recover(one, zero, 0));
+  TEST_ASSERT_EQUAL_INT(1, recover(ORDER, one, 0));
+  TEST_ASSERT_EQUAL_INT(1, recover(one, ORDER, 0));
+
+  // 5^3 + 7 has no square root mod p
+  TEST_ASSERT_EQUAL_INT(1, recover("0000000000000000000000000000000000000000000000000000000000000005", one, 0));
+
+  // r + n must be below p
+  TEST_ASSERT_EQUAL_INT(0, recover("0000000000000000000000000000000000000000000000000000000000000002", one, 2));
+  TEST_ASSERT_EQUAL_INT(1, recover(PRIME_MINUS_ORDER, one, 2));
+  TEST_ASSERT_EQUAL_INT(1, recover("fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140", one, 3));
+}
+
+int main() {
+  TESTS_BEGIN();
+  RUN_TEST(test_recover_signed);
+  RUN_TEST(test_recover_random);
+  RUN_TEST(test_recover_invalid);
+  return TESTS_END();
+}
@@ -329,8 +329,8 @@ static void test_eth_getblock_number(void) {
   eth_block_t* block = eth_getBlockByNumber(in3, BLKNUM(1692767), true);
 
   // if the result is null there was an error an we can get the latest error message from eth_lat_error()
-  free(block);
   TEST_ASSERT_EQUAL_INT64(block->number, 1692767);
+  free(block);
   in3_free(in3);
 }
 
@@ -37,8 +37,11 @@
 #define DEBUG
 #endif
 
+#include "../../src/core/client/context.h"
 #include "../../src/core/client/nodelist.h"
+#include "../../src/verifier/eth1/nano/eth_nano.h"
 #include "../test_utils.h"
+#include <string.h>
 
 IN3_IMPORT_TEST bool in3_node_props_match(in3_node_props_t np_config, in3_node_props_t np);
 
@@ -121,11 +124,289 @@ static void test_capabilities(void) {
   TEST_ASSERT_EQUAL(in3_node_props_get(npclient, NODE_PROP_MIN_BLOCK_HEIGHT), 255);
 }
 
+static void test_response_times(void) {
+  in3_t*    c    = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  address_t fast = {1}, slow = {2};
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_clear_nodes(c, ETH_CHAIN_ID_MAINNET));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://fast.com", 0xFF, fast));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://slow.com", 0xFF, slow));
+  in3_chain_t* chain = in3_find_chain(c, ETH_CHAIN_ID_MAINNET);
+
+  // the first response sets the average, later responses only change it by 1/8.
+  in3_node_weight_add_response(chain->weights, 100);
+  in3_node_weight_add_response(chain->weights, 900);
+  in3_node_weight_add_response(chain->weights + 1, 1000);
+
+  in3_node_weight_t stats;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_node_stats(c, ETH_CHAIN_ID_MAINNET, fast, &stats));
+  TEST_ASSERT_EQUAL(2, stats.response_count);
+  TEST_ASSERT_EQUAL(1000, stats.total_response_time);
+  TEST_ASSERT_EQUAL_FLOAT(200.0f, stats.avg_response_time);
+  TEST_ASSERT_EQUAL(0, stats.failure_count);
+  TEST_ASSERT_EQUAL(IN3_EFIND, in3_client_node_stats(c, ETH_CHAIN_ID_GOERLI, fast, &stats));
+
+  // the faster node gets the higher weight, but slow nodes keep a weight > 0.
+  float          total = 0;
+  int            found = 0;
+  node_weight_t* nodes = in3_node_list_fill_weight(c, ETH_CHAIN_ID_MAINNET, chain->nodelist, chain->weights, chain->nodelist_length, _time(), &total, &found, 0xFF);
+  TEST_ASSERT_EQUAL(2, found);
+  TEST_ASSERT_EQUAL_FLOAT(2.5f, nodes->w);
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, nodes->next->w);
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, total);
+  in3_ctx_free_nodes(nodes);
+
+  in3_free(c);
+}
+
+static void test_pick_nodes(void) {
+  in3_t*    c          = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  address_t address[4] = {{1}, {2}, {3}, {4}};
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_clear_nodes(c, ETH_CHAIN_ID_MAINNET));
+  for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://test.com", 0xFF, address[i]));
+  in3_chain_t* chain  = in3_find_chain(c, ETH_CHAIN_ID_MAINNET);
+  chain->needs_update = false;
+  in3_ctx_t* ctx      = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+
+  // picking all nodes returns each node once
+  node_weight_t* nodes = NULL;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 4, 0));
+  TEST_ASSERT_EQUAL(4, ctx_nodes_len(nodes));
+  for (node_weight_t* n = nodes; n; n = n->next) {
+    for (node_weight_t* m = n->next; m; m = m->next) TEST_ASSERT_TRUE(n->node != m->node);
+  }
+  in3_ctx_free_nodes(nodes);
+
+  // blacklisted nodes will not be picked
+  chain->weights[1].blacklisted_until = _time() + 3600;
+  in3_nodelist_update_weight(c, chain, chain->weights + 1);
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 4, 0));
+  TEST_ASSERT_EQUAL(3, ctx_nodes_len(nodes));
+  for (node_weight_t* n = nodes; n; n = n->next) TEST_ASSERT_TRUE(n->node != chain->nodelist + 1);
+  in3_ctx_free_nodes(nodes);
+
+  // a rest of the blacklisted node left in the tree (as rounding errors may do) is skipped instead of ending the selection.
+  chain->sampler.tree[2] += 1000;
+  chain->sampler.tree[4] += 1000;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 4, 0));
+  TEST_ASSERT_EQUAL(3, ctx_nodes_len(nodes));
+  in3_ctx_free_nodes(nodes);
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, (float) chain->sampler.tree[4]);
+
+  // faster nodes are picked more often
+  int fast = 0;
+  in3_node_weight_add_response(chain->weights, 10);
+  in3_nodelist_update_weight(c, chain, chain->weights);
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 1, 0));
+    if (nodes->node == chain->nodelist) fast++;
+    in3_ctx_free_nodes(nodes);
+  }
+  TEST_ASSERT_GREATER_THAN(900, fast);
+
+  // after picking all weights are back in the tree
+  TEST_ASSERT_EQUAL_FLOAT(50.0f, chain->sampler.weights[0]);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, chain->sampler.weights[1]);
+  TEST_ASSERT_EQUAL_FLOAT(52.0f, (float) chain->sampler.tree[4]);
+
+  ctx_free(ctx);
+  in3_free(c);
+}
+
+static void test_circuit_breaker(void) {
+  in3_t*    c          = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  address_t address[2] = {{1}, {2}};
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_clear_nodes(c, ETH_CHAIN_ID_MAINNET));
+  for (int i = 0; i < 2; i++) TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://test.com", 0xFF, address[i]));
+  in3_chain_t* chain  = in3_find_chain(c, ETH_CHAIN_ID_MAINNET);
+  chain->needs_update = false;
+  in3_ctx_t*         ctx   = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  in3_node_weight_t* w     = chain->weights;
+  node_weight_t*     nodes = NULL;
+  uint64_t           now   = _time();
+
+  // the backoff is doubled with every failure in a row and is longer for invalid proofs.
+  in3_nodelist_node_failed(c, chain, w, NODE_ERROR_TRANSPORT);
+  TEST_ASSERT_EQUAL(NODE_STATE_OPEN, w->state);
+  TEST_ASSERT_UINT64_WITHIN(1, now + 10, w->blacklisted_until);
+  in3_nodelist_node_failed(c, chain, w, NODE_ERROR_TIMEOUT);
+  TEST_ASSERT_UINT64_WITHIN(1, now + 20, w->blacklisted_until);
+  in3_nodelist_node_failed(c, chain, w, NODE_ERROR_INVALID_PROOF);
+  TEST_ASSERT_UINT64_WITHIN(1, now + 3600 * 4, w->blacklisted_until);
+  TEST_ASSERT_EQUAL(3, w->failure_count);
+  TEST_ASSERT_EQUAL(1, w->transport_error_count);
+  TEST_ASSERT_EQUAL(1, w->timeout_count);
+  TEST_ASSERT_EQUAL(1, w->invalid_proof_count);
+  TEST_ASSERT_EQUAL(3, w->consecutive_failures);
+
+  // open nodes will not be picked
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 2, 0));
+  TEST_ASSERT_EQUAL(1, ctx_nodes_len(nodes));
+  TEST_ASSERT_TRUE(nodes->weight == w + 1);
+  in3_ctx_free_nodes(nodes);
+
+  // if all nodes are open, only the node with the shortest backoff is probed by one request.
+  in3_nodelist_node_failed(c, chain, w + 1, NODE_ERROR_TRANSPORT);
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 2, 0));
+  TEST_ASSERT_EQUAL(1, ctx_nodes_len(nodes));
+  TEST_ASSERT_TRUE(nodes->weight == w + 1);
+  TEST_ASSERT_EQUAL(NODE_STATE_HALF_OPEN, w[1].state);
+  in3_ctx_free_nodes(nodes);
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 2, 0));
+  TEST_ASSERT_TRUE(nodes->weight == w);
+  in3_ctx_free_nodes(nodes);
+  TEST_ASSERT_EQUAL(IN3_EFIND, in3_node_list_pick_nodes(ctx, &nodes, 2, 0));
+
+  // a verified response closes the circuit again.
+  in3_nodelist_node_verified(c, chain, w + 1);
+  TEST_ASSERT_EQUAL(NODE_STATE_CLOSED, w[1].state);
+  TEST_ASSERT_EQUAL(0, w[1].consecutive_failures);
+  TEST_ASSERT_EQUAL(IN3_OK, in3_node_list_pick_nodes(ctx, &nodes, 2, 0));
+  TEST_ASSERT_EQUAL(1, ctx_nodes_len(nodes));
+  TEST_ASSERT_TRUE(nodes->weight == w + 1);
+  in3_ctx_free_nodes(nodes);
+
+  ctx_free(ctx);
+  in3_free(c);
+}
+
+static int probe_requests = 0;
+
+static in3_ret_t probe_transport(in3_request_t* req) {
+  probe_requests++;
+  for (int i = 0; i < req->urls_len; i++) sb_add_chars(&req->results[i].result, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":\"0x10\"}");
+  return IN3_OK;
+}
+
+static void test_circuit_breaker_probe(void) {
+  in3_register_eth_nano();
+  in3_t*    c          = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  address_t address[2] = {{1}, {2}};
+  c->transport         = probe_transport;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_configure(c, "{\"autoUpdateList\":false,\"proof\":\"none\",\"requestCount\":2,\"maxAttempts\":1}"));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_clear_nodes(c, ETH_CHAIN_ID_MAINNET));
+  for (int i = 0; i < 2; i++) TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://test.com", 0xFF, address[i]));
+  in3_chain_t* chain  = in3_find_chain(c, ETH_CHAIN_ID_MAINNET);
+  chain->needs_update = false;
+  in3_node_weight_t* w = chain->weights + 1;
+
+  // the half open node is closed by its verified response, no matter whether it is the first one or not.
+  for (int i = 0; i < 8; i++) {
+    in3_nodelist_node_failed(c, chain, w, NODE_ERROR_TRANSPORT);
+    w->blacklisted_until = _time();
+    in3_nodelist_update_weight(c, chain, w);
+
+    char *result = NULL, *error = NULL;
+    TEST_ASSERT_EQUAL(IN3_OK, in3_client_rpc(c, "eth_blockNumber", "[]", &result, &error));
+    TEST_ASSERT_EQUAL_STRING("\"0x10\"", result);
+    _free(result);
+    TEST_ASSERT_EQUAL(NODE_STATE_CLOSED, w->state);
+    TEST_ASSERT_EQUAL(0, w->consecutive_failures);
+  }
+  TEST_ASSERT_EQUAL(8, probe_requests);
+
+  in3_free(c);
+}
+
+static in3_ret_t dead_node_transport(in3_request_t* req) {
+  for (int i = 0; i < req->urls_len; i++) {
+    if (strstr(req->urls[i], "dead"))
+      sb_add_chars(&req->results[i].error, "connection refused");
+    else
+      sb_add_chars(&req->results[i].result, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":\"0x10\"}");
+  }
+  return IN3_OK;
+}
+
+static void test_rejected_node_error(void) {
+  in3_register_eth_nano();
+  in3_t*    c          = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  address_t dead       = {1}, alive = {2};
+  int       dead_first = 0;
+  c->transport         = dead_node_transport;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_configure(c, "{\"autoUpdateList\":false,\"proof\":\"none\",\"requestCount\":2,\"maxAttempts\":1}"));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_clear_nodes(c, ETH_CHAIN_ID_MAINNET));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://alive.com", 0xFF, alive));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://dead.com", 0xFF, dead));
+  in3_chain_t* chain  = in3_find_chain(c, ETH_CHAIN_ID_MAINNET);
+  chain->needs_update = false;
+
+  // the error of a rejected node is not kept, once the response of the next node was verified (the order of the nodes is random).
+  for (int i = 0; i < 32; i++) {
+    in3_ctx_t* ctx = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+    TEST_ASSERT_EQUAL(IN3_OK, in3_send_ctx(ctx));
+    if (strstr(ctx->nodes->node->url, "dead")) dead_first++;
+    TEST_ASSERT_NULL(ctx->error);
+    TEST_ASSERT_EQUAL(CTX_SUCCESS, in3_ctx_state(ctx));
+    ctx_free(ctx);
+
+    // the dead node may be picked again
+    memset(chain->weights + 1, 0, sizeof(in3_node_weight_t));
+    chain->weights[1].weight = 1;
+    in3_nodelist_update_weight(c, chain, chain->weights + 1);
+  }
+  TEST_ASSERT_GREATER_THAN(0, dead_first);
+  in3_free(c);
+}
+
+// simulates a transport, which cancels the running request of the slow node after the fast node was verified.
+static in3_ret_t cancel_transport(in3_request_t* req) {
+  for (int i = 0; i < req->urls_len; i++) {
+    if (strstr(req->urls[i], "fast")) {
+      sb_add_chars(&req->results[i].result, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":\"0x10\"}");
+      req->results[i].time = 10;
+      TEST_ASSERT_EQUAL(IN3_OK, in3_req_check_response(req, i));
+    }
+  }
+  for (int i = 0; i < req->urls_len; i++) {
+    if (strstr(req->urls[i], "slow")) req->results[i].time = 50;
+  }
+  return IN3_OK;
+}
+
+static void test_cancelled_response_times(void) {
+  in3_register_eth_nano();
+  in3_t*    c    = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  address_t fast = {1}, slow = {2}, unused = {3};
+  c->transport   = cancel_transport;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_configure(c, "{\"autoUpdateList\":false,\"proof\":\"none\",\"requestCount\":3,\"maxAttempts\":1,\"useFirstResponse\":true}"));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_clear_nodes(c, ETH_CHAIN_ID_MAINNET));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://fast.com", 0xFF, fast));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://slow.com", 0xFF, slow));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_add_node(c, ETH_CHAIN_ID_MAINNET, "http://unused.com", 0xFF, unused));
+  in3_find_chain(c, ETH_CHAIN_ID_MAINNET)->needs_update = false;
+
+  char *result = NULL, *error = NULL;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_rpc(c, "eth_blockNumber", "[]", &result, &error));
+  TEST_ASSERT_EQUAL_STRING("\"0x10\"", result);
+  _free(result);
+
+  // the cancelled request is counted with the time it was running, a request which was never sent is not counted.
+  in3_node_weight_t stats;
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_node_stats(c, ETH_CHAIN_ID_MAINNET, fast, &stats));
+  TEST_ASSERT_EQUAL(1, stats.response_count);
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, stats.avg_response_time);
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_node_stats(c, ETH_CHAIN_ID_MAINNET, slow, &stats));
+  TEST_ASSERT_EQUAL(1, stats.response_count);
+  TEST_ASSERT_EQUAL_FLOAT(50.0f, stats.avg_response_time);
+  TEST_ASSERT_EQUAL(0, stats.failure_count);
+  TEST_ASSERT_EQUAL(IN3_OK, in3_client_node_stats(c, ETH_CHAIN_ID_MAINNET, unused, &stats));
+  TEST_ASSERT_EQUAL(0, stats.response_count);
+  TEST_ASSERT_EQUAL(0, stats.failure_count);
+
+  in3_free(c);
+}
+
 /*
  * Main
  */
 int main() {
   TESTS_BEGIN();
   RUN_TEST(test_capabilities);
+  RUN_TEST(test_response_times);
+  RUN_TEST(test_cancelled_response_times);
+  RUN_TEST(test_pick_nodes);
+  RUN_TEST(test_circuit_breaker);
+  RUN_TEST(test_circuit_breaker_probe);
+  RUN_TEST(test_rejected_node_error);
   return TESTS_END();
 }
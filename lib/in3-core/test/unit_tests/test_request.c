@@ -109,6 +109,85 @@ void test_exec_req() {
 
   in3_free(c);
 }
+void test_first_response() {
+  in3_register_eth_basic();
+
+  in3_t* c                = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  c->proof                = PROOF_NONE;
+  c->request_count        = 2;
+  c->use_first_response   = true;
+  c->chains->needs_update = false;
+
+  in3_ctx_t* ctx = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  TEST_ASSERT_EQUAL(IN3_WAITING, in3_ctx_execute(ctx));
+  in3_request_t* request = in3_create_request(ctx);
+  TEST_ASSERT_EQUAL(2, request->urls_len);
+
+  // an invalid response is rejected, but we keep on waiting
+  sb_add_chars(&request->results[0].result, "{no json}");
+  TEST_ASSERT_EQUAL(IN3_WAITING, in3_req_check_response(request, 0));
+  TEST_ASSERT_NULL(ctx->error);
+  TEST_ASSERT_NULL(ctx->nodes->weight);
+
+  // the first valid response finishes the context
+  sb_add_chars(&request->results[1].result, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":\"0x84b0ec\"}");
+  TEST_ASSERT_EQUAL(IN3_OK, in3_req_check_response(request, 1));
+  TEST_ASSERT_EQUAL(IN3_OK, in3_req_check_response(request, 1));
+  request_free(request, ctx, false);
+
+  TEST_ASSERT_EQUAL(IN3_OK, in3_ctx_execute(ctx));
+  TEST_ASSERT_EQUAL(0x84b0ec, d_get_longk(ctx->responses[0], K_RESULT));
+  ctx_free(ctx);
+
+  in3_free(c);
+}
+
+void test_timeout() {
+  in3_register_eth_basic();
+
+  in3_t* c                = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  c->proof                = PROOF_NONE;
+  c->request_count        = 1;
+  c->max_attempts         = 3;
+  c->timeout              = 10000;
+  c->chains->needs_update = false;
+
+  // the request only gets the time left
+  in3_ctx_t* ctx = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  TEST_ASSERT_TRUE(ctx->deadline > 0);
+  TEST_ASSERT_EQUAL(IN3_WAITING, in3_ctx_execute(ctx));
+  in3_request_t* request = in3_create_request(ctx);
+  TEST_ASSERT_TRUE(request->timeout > 0 && request->timeout <= c->timeout);
+
+  // a timeout of the transport is reported and no further attempts are made once the deadline has passed
+  sb_add_chars(&request->results[0].error, "timeout while reading the response from http://localhost after 10000 ms");
+  request->results[0].timed_out = true;
+  ctx->deadline = current_ms() - 1;
+  request_free(request, ctx, false);
+  TEST_ASSERT_EQUAL(IN3_ETIMEOUT, in3_ctx_execute(ctx));
+  TEST_ASSERT_NOT_NULL(strstr(ctx->error, "timeout while reading the response"));
+  ctx_free(ctx);
+
+  // without a response the context fails as soon as the deadline is reached
+  ctx = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  TEST_ASSERT_EQUAL(IN3_WAITING, in3_ctx_execute(ctx));
+  ctx->deadline = current_ms() - 1;
+  TEST_ASSERT_EQUAL(IN3_ETIMEOUT, in3_ctx_execute(ctx));
+  ctx_free(ctx);
+
+  // a timeout of 0 disables the deadline
+  c->timeout = 0;
+  ctx        = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  TEST_ASSERT_EQUAL(0, ctx->deadline);
+  TEST_ASSERT_EQUAL(IN3_WAITING, in3_ctx_execute(ctx));
+  request = in3_create_request(ctx);
+  TEST_ASSERT_EQUAL(0, request->timeout);
+  request_free(request, ctx, false);
+  ctx_free(ctx);
+
+  in3_free(c);
+}
+
 /*
  * Main
  */
@@ -119,5 +198,7 @@ int main() {
   TESTS_BEGIN();
   RUN_TEST(test_configure_request);
   RUN_TEST(test_exec_req);
+  RUN_TEST(test_first_response);
+  RUN_TEST(test_timeout);
   return TESTS_END();
 }
@@ -70,6 +70,7 @@ static void test_in3_config() {
      \"maxAttempts\":99,\
      \"maxBlockCache\":98,\
      \"maxCodeCache\":97,\
+     \"maxSenderCache\":91,\
      \"minDeposit\":96,\
      \"keepIn3\":true,\
      \"nodeLimit\":95,\
@@ -77,6 +78,7 @@ static void test_in3_config() {
      \"replaceLatestBlock\":94,\
      \"requestCount\":93,\
      \"signatureCount\":92,\
+     \"verifyThreads\":4,\
      \"nodes\":{\
         \"0x7\":{\
            \"contract\":\"0x1234567890123456789012345678901234567890\",\
@@ -103,11 +105,13 @@ static void test_in3_config() {
   TEST_ASSERT_EQUAL(99, c->max_attempts);
   TEST_ASSERT_EQUAL(98, c->max_block_cache);
   TEST_ASSERT_EQUAL(97, c->max_code_cache);
+  TEST_ASSERT_EQUAL(91, c->max_sender_cache);
   TEST_ASSERT_EQUAL(96, c->min_deposit);
   TEST_ASSERT_EQUAL(PROOF_FULL, c->proof);
   TEST_ASSERT_EQUAL(95, c->node_limit);
   TEST_ASSERT_EQUAL(94, c->replace_latest_block);
   TEST_ASSERT_EQUAL(93, c->request_count);
+  TEST_ASSERT_EQUAL(4, c->verify_threads);
   TEST_ASSERT_EQUAL(92, c->signature_count);
   TEST_ASSERT_EQUAL(1, c->keep_in3);
 
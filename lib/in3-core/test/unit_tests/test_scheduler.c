@@ -0,0 +1,285 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#ifndef TEST
+#define TEST
+#endif
+#ifndef TEST
+#define DEBUG
+#endif
+
+#include "../../src/api/eth1/eth_api.h"
+#include "../../src/core/client/context.h"
+#include "../../src/core/client/keys.h"
+#include "../../src/core/client/scheduler.h"
+#include "../../src/core/util/data.h"
+#include "../../src/core/util/utils.h"
+#include "../../src/verifier/eth1/basic/eth_basic.h"
+#include "../test_utils.h"
+#include <stdio.h>
+
+#define CTX_COUNT 5
+
+// a fake async transport, which answers the requests in reverse order.
+typedef struct {
+  in3_request_t* pending[CTX_COUNT];
+  int            len;
+  int            cancelled;
+  bool           respond;
+  in3_ctx_t**    ctxs;
+  int            sent;
+} fake_transport_t;
+
+static in3_ret_t fake_send(void* data, in3_request_t* req) {
+  fake_transport_t* t   = data;
+  t->pending[t->len++] = req;
+  t->sent++;
+  return IN3_OK;
+}
+
+static in3_request_t* fake_wait(void* data, uint32_t timeout) {
+  (void) timeout;
+  fake_transport_t* t = data;
+  if (!t->len || !t->respond) return NULL;
+  in3_request_t* req = t->pending[--t->len];
+  char           response[100];
+
+  // the result is the index of the context, so we can check the responses are delivered to the right context.
+  if (t->ctxs) {
+    int index = 0;
+    while (t->ctxs[index] != req->ctx) index++;
+    sprintf(response, "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":\"0x%x\"}", index + 1);
+    sb_add_chars(&req->results[0].result, response);
+    return req;
+  }
+
+  // for batches, the result is the index within the batch.
+  sb_add_char(&req->results[0].result, '[');
+  for (int i = 0; i < req->ctx->len; i++) {
+    sprintf(response, "%s{\"id\":%i,\"jsonrpc\":\"2.0\",\"result\":\"0x%x\"}", i ? "," : "", i + 1, i + 1);
+    sb_add_chars(&req->results[0].result, response);
+  }
+  sb_add_char(&req->results[0].result, ']');
+  return req;
+}
+
+static void fake_cancel(void* data, in3_request_t* req) {
+  fake_transport_t* t = data;
+  for (int i = 0; i < t->len; i++) {
+    if (t->pending[i] == req) t->pending[i] = t->pending[--t->len];
+  }
+  t->cancelled++;
+}
+
+static int finished = 0;
+
+static void on_done(in3_ctx_t* ctx, in3_ret_t res, void* data) {
+  (void) ctx;
+  TEST_ASSERT_EQUAL(*((in3_ret_t*) data), res);
+  finished++;
+}
+
+static in3_t* create_client() {
+  in3_register_eth_basic();
+  in3_t* c                = in3_for_chain(ETH_CHAIN_ID_MAINNET);
+  c->proof                = PROOF_NONE;
+  c->request_count        = 1;
+  c->max_attempts         = 1;
+  c->chains->needs_update = false;
+  return c;
+}
+
+void test_scheduler() {
+  in3_t*                c         = create_client();
+  in3_ctx_t*            ctxs[CTX_COUNT];
+  fake_transport_t      fake      = {.respond = false, .ctxs = ctxs};
+  in3_ret_t             expected  = IN3_OK;
+  in3_async_transport_t transport = {.send = fake_send, .wait = fake_wait, .cancel = fake_cancel, .data = &fake};
+
+  in3_scheduler_t* scheduler = in3_scheduler_new(&transport);
+  scheduler->done            = on_done;
+  scheduler->data            = &expected;
+  finished                   = 0;
+  for (int i = 0; i < CTX_COUNT; i++) {
+    ctxs[i] = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+    TEST_ASSERT_EQUAL(IN3_OK, in3_scheduler_add(scheduler, ctxs[i]));
+  }
+
+  // all requests are sent before the first response is received
+  TEST_ASSERT_EQUAL(CTX_COUNT, in3_scheduler_execute(scheduler, 0));
+  TEST_ASSERT_EQUAL(CTX_COUNT, fake.len);
+
+  // the responses are delivered in reverse order
+  fake.respond = true;
+  in3_scheduler_run(scheduler);
+  TEST_ASSERT_EQUAL(CTX_COUNT, finished);
+  TEST_ASSERT_EQUAL(0, scheduler->len);
+  for (int i = 0; i < CTX_COUNT; i++) {
+    TEST_ASSERT_EQUAL(CTX_SUCCESS, in3_ctx_state(ctxs[i]));
+    TEST_ASSERT_EQUAL(i + 1, d_get_longk(ctxs[i]->responses[0], K_RESULT));
+    ctx_free(ctxs[i]);
+  }
+
+  in3_scheduler_free(scheduler);
+  in3_free(c);
+}
+
+void test_scheduler_timeout() {
+  in3_t*                c         = create_client();
+  in3_ctx_t*            ctxs[1];
+  fake_transport_t      fake      = {.respond = false, .ctxs = ctxs};
+  in3_ret_t             expected  = IN3_ETIMEOUT;
+  in3_async_transport_t transport = {.send = fake_send, .wait = fake_wait, .cancel = fake_cancel, .data = &fake};
+
+  in3_scheduler_t* scheduler = in3_scheduler_new(&transport);
+  scheduler->done            = on_done;
+  scheduler->data            = &expected;
+  finished                   = 0;
+  ctxs[0]                    = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  in3_scheduler_add(scheduler, ctxs[0]);
+
+  // the transport does not respond, so the request is cancelled once the deadline is reached.
+  TEST_ASSERT_EQUAL(1, in3_scheduler_execute(scheduler, 0));
+  TEST_ASSERT_EQUAL(1, fake.len);
+  ctxs[0]->deadline = current_ms() - 1;
+  TEST_ASSERT_EQUAL(0, in3_scheduler_execute(scheduler, 0));
+  TEST_ASSERT_EQUAL(1, fake.cancelled);
+  TEST_ASSERT_EQUAL(1, finished);
+  TEST_ASSERT_EQUAL(CTX_ERROR, in3_ctx_state(ctxs[0]));
+
+  // pending requests are cancelled when freeing the scheduler
+  ctx_free(ctxs[0]);
+  ctxs[0] = ctx_new(c, "{\"method\":\"eth_blockNumber\",\"params\":[]}");
+  in3_scheduler_add(scheduler, ctxs[0]);
+  TEST_ASSERT_EQUAL(1, in3_scheduler_execute(scheduler, 0));
+  in3_scheduler_free(scheduler);
+  TEST_ASSERT_EQUAL(2, fake.cancelled);
+  ctx_free(ctxs[0]);
+
+  in3_free(c);
+}
+
+static int results = 0, errors = 0;
+
+static void on_result(d_token_t* result, char* error, void* data) {
+  if (error) {
+    TEST_ASSERT_NULL(result);
+    errors++;
+    return;
+  }
+  TEST_ASSERT_EQUAL(*((int*) data), d_long(result));
+  results++;
+}
+
+void test_scheduler_batch() {
+  in3_t*                c          = create_client();
+  fake_transport_t      fake       = {.respond = false, .ctxs = NULL};
+  in3_async_transport_t transport  = {.send = fake_send, .wait = fake_wait, .cancel = fake_cancel, .data = &fake};
+  int                   expected[] = {1, 2, 3, 1, 2};
+
+  in3_scheduler_t* scheduler = in3_scheduler_new(&transport);
+  scheduler->batch_size      = 3;
+  scheduler->batch_window    = 10000;
+  results = errors = 0;
+
+  // the first batch is sent as soon as it is full, the second one waits for more calls
+  for (int i = 0; i < 5; i++) TEST_ASSERT_EQUAL(IN3_OK, in3_scheduler_call(scheduler, c, "eth_blockNumber", NULL, on_result, expected + i));
+  TEST_ASSERT_EQUAL(2, in3_scheduler_execute(scheduler, 0));
+  TEST_ASSERT_EQUAL(1, fake.sent);
+
+  // without running contexts, the second batch is sent without waiting for the window
+  fake.respond = true;
+  in3_scheduler_run(scheduler);
+  TEST_ASSERT_EQUAL(2, fake.sent);
+  TEST_ASSERT_EQUAL(5, results);
+  TEST_ASSERT_EQUAL(0, errors);
+
+  // calls still collected are reported as error when freeing the scheduler
+  in3_scheduler_call(scheduler, c, "eth_blockNumber", "[]", on_result, expected);
+  in3_scheduler_free(scheduler);
+  TEST_ASSERT_EQUAL(1, errors);
+
+  in3_free(c);
+}
+
+static void on_sha3(d_token_t* result, char* error, void* data) {
+  (void) data;
+  TEST_ASSERT_NULL(error);
+  bytes_t* expected = hex_to_new_bytes("c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470", 64);
+  TEST_ASSERT_TRUE(b_cmp(expected, d_bytes(result)));
+  b_free(expected);
+  results++;
+}
+
+void test_scheduler_batch_intern() {
+  in3_t*                c          = create_client();
+  fake_transport_t      fake       = {.respond = true, .ctxs = NULL};
+  in3_async_transport_t transport  = {.send = fake_send, .wait = fake_wait, .cancel = fake_cancel, .data = &fake};
+  int                   expected[] = {1};
+  in3_register_eth_api();
+
+  // a batch with a method handled by the client must not be sent, since the wrong answer of the node ("0x1") would be accepted.
+  in3_ctx_t* ctx = ctx_new(c, "[{\"method\":\"web3_sha3\",\"params\":[\"0x\"]},{\"method\":\"eth_blockNumber\",\"params\":[]}]");
+  TEST_ASSERT_EQUAL(IN3_ENOTSUP, in3_ctx_execute(ctx));
+  TEST_ASSERT_EQUAL(CTX_ERROR, in3_ctx_state(ctx));
+  ctx_free(ctx);
+
+  // the scheduler runs each call of such a batch as its own context.
+  in3_scheduler_t* scheduler = in3_scheduler_new(&transport);
+  scheduler->batch_size      = 2;
+  results = errors = 0;
+  in3_scheduler_call(scheduler, c, "web3_sha3", "[\"0x\"]", on_sha3, NULL);
+  in3_scheduler_call(scheduler, c, "eth_blockNumber", NULL, on_result, expected);
+  in3_scheduler_run(scheduler);
+  TEST_ASSERT_EQUAL(2, results);
+  TEST_ASSERT_EQUAL(0, errors);
+
+  // only eth_blockNumber was sent to the node
+  TEST_ASSERT_EQUAL(1, fake.sent);
+
+  in3_scheduler_free(scheduler);
+  in3_free(c);
+}
+
+/*
+ * Main
+ */
+int main() {
+  TESTS_BEGIN();
+  RUN_TEST(test_scheduler);
+  RUN_TEST(test_scheduler_timeout);
+  RUN_TEST(test_scheduler_batch);
+  RUN_TEST(test_scheduler_batch_intern);
+  return TESTS_END();
+}
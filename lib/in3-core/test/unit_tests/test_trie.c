@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#ifndef TEST
+#define TEST
+#endif
+#ifndef TEST
+#define DEBUG
+#endif
+
+#include "../../src/core/util/mem.h"
+#include "../../src/core/util/utils.h"
+#include "../../src/verifier/eth1/basic/trie.h"
+#include "../../src/verifier/eth1/nano/eth_nano.h"
+#include "../test_utils.h"
+#include <stdlib.h>
+
+static int compare_keys(const void* a, const void* b) {
+  const bytes_t *ka = a, *kb = b;
+  int            r  = memcmp(ka->data, kb->data, ka->len < kb->len ? ka->len : kb->len);
+  return r ? r : (int) ka->len - (int) kb->len;
+}
+
+// builds the root with the trie and with the builder and compares them.
+static void check_builder(bytes_t* keys, bytes_t* values, int len) {
+  trie_t*         trie    = trie_new();
+  trie_builder_t* builder = trie_builder_new();
+  bytes32_t       root;
+  for (int i = 0; i < len; i++) trie_set_value(trie, keys + i, values + i);
+
+  // the builder needs sorted keys, so we sort them together with the values.
+  bytes_t* pairs = _malloc(sizeof(bytes_t) * 2 * len);
+  for (int i = 0; i < len; i++) {
+    pairs[i * 2]     = keys[i];
+    pairs[i * 2 + 1] = values[i];
+  }
+  qsort(pairs, len, sizeof(bytes_t) * 2, compare_keys);
+  for (int i = 0; i < len; i++) TEST_ASSERT_EQUAL(0, trie_builder_add(builder, pairs + i * 2, pairs + i * 2 + 1));
+  trie_builder_root(builder, root);
+  TEST_ASSERT_EQUAL_MEMORY(trie->root, root, 32);
+
+  _free(pairs);
+  trie_builder_free(builder);
+  trie_free(trie);
+}
+
+static void test_builder_empty() {
+  trie_t*         trie    = trie_new();
+  trie_builder_t* builder = trie_builder_new();
+  bytes32_t       root;
+  trie_builder_root(builder, root);
+  TEST_ASSERT_EQUAL_MEMORY(trie->root, root, 32);
+  trie_builder_free(builder);
+  trie_free(trie);
+}
+
+static void test_builder_prefixed_keys() {
+  char*   k[] = {"do", "dog", "doge", "horse", "d", "dogecoin"};
+  char*   v[] = {"verb", "puppy", "coin", "stallion", "x", "a value which is long enough to not be embedded"};
+  bytes_t keys[6], values[6];
+  for (int i = 0; i < 6; i++) {
+    keys[i]   = bytes((uint8_t*) k[i], strlen(k[i]));
+    values[i] = bytes((uint8_t*) v[i], strlen(v[i]));
+  }
+  for (int n = 1; n <= 6; n++) check_builder(keys, values, n);
+}
+
+static void test_builder_hashed_keys() {
+  bytes_t  keys[300], values[300];
+  uint8_t  data[300][32];
+  uint32_t i;
+  for (i = 0; i < 300; i++) {
+    bytes_t tmp = bytes((uint8_t*) &i, 4);
+    sha3_to(&tmp, data[i]);
+    keys[i]   = bytes(data[i], 32);
+    values[i] = bytes(data[i], 1 + i % 32);
+  }
+  check_builder(keys, values, 1);
+  check_builder(keys, values, 2);
+  check_builder(keys, values, 17);
+  check_builder(keys, values, 300);
+}
+
+static void test_builder_tx_index() {
+  bytes_t* paths[300];
+  bytes_t  keys[300], values[300];
+  uint8_t  data[300][40];
+  for (int i = 0; i < 300; i++) {
+    paths[i] = create_tx_path(i);
+    keys[i]  = *paths[i];
+    memset(data[i], i & 0xFF, 40);
+    values[i] = bytes(data[i], 40);
+  }
+  check_builder(keys, values, 1);
+  check_builder(keys, values, 128);
+  check_builder(keys, values, 129);
+  check_builder(keys, values, 300);
+  for (int i = 0; i < 300; i++) b_free(paths[i]);
+}
+
+static void test_builder_unsorted() {
+  trie_builder_t* builder = trie_builder_new();
+  bytes_t         a = bytes((uint8_t*) "b", 1), b = bytes((uint8_t*) "a", 1), value = bytes((uint8_t*) "v", 1);
+  TEST_ASSERT_EQUAL(0, trie_builder_add(builder, &a, &value));
+  TEST_ASSERT_EQUAL(-1, trie_builder_add(builder, &b, &value));
+  TEST_ASSERT_EQUAL(-1, trie_builder_add(builder, &a, &value));
+  trie_builder_free(builder);
+}
+
+/*
+ * Main
+ */
+int main() {
+  TESTS_BEGIN();
+  RUN_TEST(test_builder_empty);
+  RUN_TEST(test_builder_prefixed_keys);
+  RUN_TEST(test_builder_hashed_keys);
+  RUN_TEST(test_builder_tx_index);
+  RUN_TEST(test_builder_unsorted);
+  return TESTS_END();
+}
@@ -0,0 +1,315 @@
+/*******************************************************************************
+ * This file is part of the Incubed project.
+ * Sources: https://github.com/slockit/in3-c
+ * 
+ * Copyright (C) 2018-2019 slock.it GmbH, Blockchains LLC
+ * 
+ * 
+ * COMMERCIAL LICENSE USAGE
+ * 
+ * Licensees holding a valid commercial license may use this file in accordance 
+ * with the commercial license agreement provided with the Software or, alternatively, 
+ * in accordance with the terms contained in a written agreement between you and 
+ * slock.it GmbH/Blockchains LLC. For licensing terms and conditions or further 
+ * information please contact slock.it at in3@slock.it.
+ * 	
+ * Alternatively, this file may be used under the AGPL license as follows:
+ *    
+ * AGPL LICENSE USAGE
+ * 
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *  
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+ * [Permissions of this strong copyleft license are conditioned on making available 
+ * complete source code of licensed works and modifications, which include larger 
+ * works using a licensed work, under the same license. Copyright and license notices 
+ * must be preserved. Contributors provide an express grant of patent rights.]
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ *******************************************************************************/
+
+#ifndef TEST
+#define TEST
+#endif
+#ifndef TEST
+#define DEBUG
+#endif
+
+#include "../../src/core/util/utils.h"
+#include "../../src/third-party/tommath/tommath.h"
+#include "../../src/verifier/eth1/evm/big.h"
+#include "../../src/verifier/eth1/evm/word.h"
+#include "../test_utils.h"
+#include <string.h>
+
+#define MAX "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+#define MIN_SIGNED "8000000000000000000000000000000000000000000000000000000000000000"
+
+static word_t w(char* hex) {
+  uint8_t data[32];
+  word_t  res;
+  int     l = hex_to_bytes(hex, -1, data, 32);
+  word_from_bytes(&res, data, l);
+  return res;
+}
+
+static void assert_word(char* expected, word_t val) {
+  word_t  e = w(expected);
+  uint8_t a[32], b[32];
+  word_to_bytes(&e, a);
+  word_to_bytes(&val, b);
+  TEST_ASSERT_EQUAL_MEMORY(a, b, 32);
+}
+
+// simple xorshift to create reproducable random words
+static uint64_t rnd_state = 88172645463325252ULL;
+static word_t   rnd_word() {
+  word_t res;
+  for (int i = 0; i < 4; i++) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    res.limbs[i] = rnd_state;
+  }
+  // also test smaller numbers
+  int bits = rnd_state % 257;
+  if (bits < 256) word_shr(&res, 256 - bits, &res);
+  return res;
+}
+
+static void test_word_bytes() {
+  uint8_t data[32];
+  word_t  a = w("0102030405060708090a0b0c0d0e0f10111213");
+  TEST_ASSERT_EQUAL(19, word_bytes(&a));
+  TEST_ASSERT_EQUAL(0x0c0d0e0f10111213ULL, a.limbs[0]);
+  TEST_ASSERT_EQUAL(0x0405060708090a0bULL, a.limbs[1]);
+  TEST_ASSERT_EQUAL(0x010203ULL, a.limbs[2]);
+  word_to_bytes(&a, data);
+  TEST_ASSERT_EQUAL(0, data[12]);
+  TEST_ASSERT_EQUAL(1, data[13]);
+  TEST_ASSERT_EQUAL(0x13, data[31]);
+  a = w("00");
+  TEST_ASSERT_EQUAL(0, word_bytes(&a));
+  TEST_ASSERT_TRUE(word_is_zero(&a));
+}
+
+static void test_word_add_sub_mul() {
+  word_t a = w(MAX), b = w("02"), r;
+  word_add(&a, &b, &r);
+  assert_word("01", r);
+  word_sub(&b, &a, &r);
+  assert_word("03", r);
+  word_sub(&r, &r, &r);
+  assert_word("00", r);
+  word_mul(&a, &a, &r);
+  assert_word("01", r);
+  a = w("ffffffffffffffffffffffffffffffff");
+  word_mul(&a, &a, &r);
+  assert_word("fffffffffffffffffffffffffffffffe00000000000000000000000000000001", r);
+  word_neg(&b, &r);
+  assert_word("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe", r);
+}
+
+static void test_word_divmod() {
+  word_t a = w("fffffffffffffffffffffffffffffffe00000000000000000000000000000001"), b = w("ffffffffffffffffffffffffffffffff"), q, r;
+  word_divmod(&a, &b, &q, &r);
+  assert_word("ffffffffffffffffffffffffffffffff", q);
+  assert_word("00", r);
+
+  b = w("00");
+  word_divmod(&a, &b, &q, &r);
+  assert_word("00", q);
+  assert_word("00", r);
+
+  // signed
+  a = w(MIN_SIGNED);
+  b = w(MAX);
+  word_sdivmod(&a, &b, &q, &r);
+  assert_word(MIN_SIGNED, q);
+  assert_word("00", r);
+  a = w("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff8"); // -8
+  b = w("03");
+  word_sdivmod(&a, &b, &q, &r);
+  assert_word("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe", q); // -2
+  assert_word("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe", r); // -2
+
+  // random numbers must always satisfy a = q * b + r with r < b
+  for (int i = 0; i < 2000; i++) {
+    word_t x = rnd_word(), y = rnd_word(), t;
+    if (word_is_zero(&y)) continue;
+    word_divmod(&x, &y, &q, &r);
+    TEST_ASSERT_TRUE(word_cmp(&r, &y) < 0);
+    word_mul(&q, &y, &t);
+    word_add(&t, &r, &t);
+    TEST_ASSERT_EQUAL(0, word_cmp(&t, &x));
+  }
+}
+
+static void test_word_modular() {
+  word_t a = w(MAX), b = w(MAX), m = w("0c"), r;
+  word_addmod(&a, &b, &m, &r);
+  assert_word("06", r); // (2^257 - 2) % 12
+  word_mulmod(&a, &b, &m, &r);
+  assert_word("09", r); // (2^256 - 1)^2 % 12
+  m = w("00");
+  word_mulmod(&a, &b, &m, &r);
+  assert_word("00", r);
+  m = w(MAX);
+  word_mulmod(&a, &b, &m, &r);
+  assert_word("00", r);
+
+  a = w("02");
+  b = w("ff");
+  word_exp(&a, &b, &r);
+  assert_word(MIN_SIGNED, r);
+  b = w("0100");
+  word_exp(&a, &b, &r);
+  assert_word("00", r);
+  a = w("03");
+  b = w("00");
+  word_exp(&a, &b, &r);
+  assert_word("01", r);
+}
+
+// converts n limbs into a tommath number as reference
+static void to_mp(const uint64_t* limbs, int n, mp_int* m) {
+  uint8_t data[64];
+  for (int i = 0; i < n * 8; i++) data[n * 8 - 1 - i] = limbs[i >> 3] >> ((i & 7) << 3);
+  mp_init(m);
+  mp_import(m, n * 8, 1, sizeof(uint8_t), 1, 0, data);
+}
+
+static void assert_mp(mp_int* expected, const uint64_t* limbs, int n) {
+  mp_int val;
+  to_mp(limbs, n, &val);
+  TEST_ASSERT_EQUAL(MP_EQ, mp_cmp(expected, &val));
+  mp_clear(&val);
+}
+
+static void test_word_wide() {
+  for (int i = 0; i < 1000; i++) {
+    word_t   x = rnd_word(), y = rnd_word(), d = rnd_word(), r;
+    uint64_t p[8], q[8];
+    mp_int   mx, my, md, mp, mq, mr;
+    to_mp(x.limbs, 4, &mx);
+    to_mp(y.limbs, 4, &my);
+    to_mp(d.limbs, 4, &md);
+    mp_init_multi(&mp, &mq, &mr, NULL);
+
+    word_mul_wide(&x, &y, p);
+    mp_mul(&mx, &my, &mp);
+    assert_mp(&mp, p, 8);
+
+    if (!word_is_zero(&d)) {
+      word_divmod_wide(p, 8, &d, q, &r);
+      mp_div(&mp, &md, &mq, &mr);
+      assert_mp(&mq, q, 8);
+      assert_mp(&mr, r.limbs, 4);
+    }
+    mp_clear_multi(&mx, &my, &md, &mp, &mq, &mr, NULL);
+  }
+}
+
+static void test_word_modexp() {
+  uint8_t exp[40];
+  for (int i = 0; i < 500; i++) {
+    word_t b = rnd_word(), m = rnd_word(), e = rnd_word(), r;
+    if (i & 1) m.limbs[0] |= 1; // odd moduli use montgomery
+    word_to_bytes(&e, exp);
+    memset(exp + 32, i, 8);
+    int l = i % 41;
+
+    mp_int mb, mm, me, mr;
+    to_mp(b.limbs, 4, &mb);
+    to_mp(m.limbs, 4, &mm);
+    mp_init_multi(&me, &mr, NULL);
+    mp_import(&me, l, 1, sizeof(uint8_t), 1, 0, exp);
+
+    word_modexp(&b, exp, l, &m, &r);
+    if (word_is_zero(&m)) {
+      TEST_ASSERT_TRUE(word_is_zero(&r));
+    } else {
+      mp_exptmod(&mb, &me, &mm, &mr);
+      if (mp_cmp_d(&mm, 1) == MP_EQ) mp_zero(&mr);
+      assert_mp(&mr, r.limbs, 4);
+    }
+    mp_clear_multi(&mb, &mm, &me, &mr, NULL);
+  }
+
+  // the precompile reduces bases of up to 64 bytes and uses tommath for larger moduli
+  uint8_t base[64], mod[40], res[40], expected[40];
+  for (int i = 0; i < 200; i++) {
+    for (int k = 0; k < 64; k++) base[k] = rnd_word().limbs[0];
+    for (int k = 0; k < 40; k++) mod[k] = rnd_word().limbs[0];
+    for (int k = 0; k < 8; k++) exp[k] = rnd_word().limbs[0];
+    uint32_t lm = 1 + i % 40, lb = i % 65;
+
+    mp_int mb, mm, me, mr;
+    mp_init_multi(&mb, &mm, &me, &mr, NULL);
+    mp_import(&mb, lb, 1, sizeof(uint8_t), 1, 0, base);
+    mp_import(&mm, lm, 1, sizeof(uint8_t), 1, 0, mod);
+    mp_import(&me, 8, 1, sizeof(uint8_t), 1, 0, exp);
+    mp_exptmod(&mb, &me, &mm, &mr);
+    size_t l;
+    mp_export(expected, &l, 1, sizeof(uint8_t), 1, 0, &mr);
+    mp_clear_multi(&mb, &mm, &me, &mr, NULL);
+
+    TEST_ASSERT_EQUAL(l, big_modexp(base, lb, exp, 8, mod, lm, res));
+    if (l) TEST_ASSERT_EQUAL_MEMORY(expected, res, l);
+  }
+}
+
+static void test_word_shift() {
+  word_t a = w(MIN_SIGNED), r;
+  word_shr(&a, 255, &r);
+  assert_word("01", r);
+  word_sar(&a, 254, &r);
+  assert_word("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe", r);
+  word_shl(&r, 65, &r);
+  assert_word("fffffffffffffffffffffffffffffffffffffffffffffffc0000000000000000", r);
+  a = w("0102030405060708090a");
+  word_shr(&a, 68, &r);
+  assert_word("10", r);
+  word_sar(&a, 4, &r);
+  assert_word("00102030405060708090", r);
+
+  a = w("ff");
+  word_signextend(&a, 0, &r);
+  assert_word(MAX, r);
+  a = w("01ff7f");
+  word_signextend(&a, 1, &r);
+  assert_word("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f", r);
+  word_signextend(&a, 0, &r);
+  assert_word("7f", r);
+  word_signextend(&a, 31, &r);
+  assert_word("01ff7f", r);
+}
+
+static void test_word_cmp() {
+  word_t a = w(MAX), b = w("01");
+  TEST_ASSERT_EQUAL(1, word_cmp(&a, &b));
+  TEST_ASSERT_EQUAL(-1, word_scmp(&a, &b));
+  TEST_ASSERT_EQUAL(0, word_scmp(&a, &a));
+  TEST_ASSERT_TRUE(word_fits(&b, 1));
+  TEST_ASSERT_FALSE(word_fits(&a, UINT64_MAX));
+}
+
+/*
+ * Main
+ */
+int main() {
+  TESTS_BEGIN();
+  RUN_TEST(test_word_bytes);
+  RUN_TEST(test_word_add_sub_mul);
+  RUN_TEST(test_word_divmod);
+  RUN_TEST(test_word_modular);
+  RUN_TEST(test_word_wide);
+  RUN_TEST(test_word_modexp);
+  RUN_TEST(test_word_shift);
+  RUN_TEST(test_word_cmp);
+  return TESTS_END();
+}
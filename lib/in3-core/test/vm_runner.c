@@ -217,6 +217,8 @@ int main(int argc, char* argv[]) {
       in3_log_set_level(LOG_TRACE);
     else if (strcmp(argv[i], "-c") == 0)
       props |= EVM_PROP_CONSTANTINOPL;
+    else if (strcmp(argv[i], "-s") == 0)
+      props |= EVM_PROP_SWITCH_DISPATCH;
     else if (strlen(argv[i])) {
       //      if (strstr(argv[i], "exp") || strstr(argv[i], "loop-mulmod")) {
       //        printf("\nskipping %s\n", argv[i]);